@@ -0,0 +1,93 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "FBClassChainQueryParser.h"
+
+static const NSUInteger ITERATIONS_COUNT = 1000;
+
+@interface AMClassChainParserBenchmarkTests : XCTestCase
+@property (nonatomic) NSArray<NSString *> *queries;
+@end
+
+@implementation AMClassChainParserBenchmarkTests
+
+- (void)setUp
+{
+  [super setUp];
+  self.queries = @[
+    @"XCUIElementTypeWindow/XCUIElementTypeButton",
+    @"**/XCUIElementTypeButton[`title == \"Ok\"`]",
+    @"XCUIElementTypeWindow[2]/**/XCUIElementTypeTextField[`value BEGINSWITH \"abc\" AND enabled == 1`][-1]",
+    @"**/XCUIElementTypeOutline/XCUIElementTypeOutlineRow[$type == 'XCUIElementTypeStaticText' AND value == 'Item'$]",
+    @"XCUIElementTypeWindow/*/*[`identifier == 'toolbar'`]/XCUIElementTypeButton[3]",
+  ];
+}
+
+- (void)testCachedParseResultIsEqualToUncachedOne
+{
+  for (NSString *query in self.queries) {
+    NSError *error;
+    FBClassChain *cached = [FBClassChainQueryParser parseQuery:query error:&error];
+    XCTAssertNotNil(cached);
+    XCTAssertNil(error);
+    XCTAssertEqual(cached, [FBClassChainQueryParser parseQuery:query error:nil]);
+    FBClassChain *uncached = [FBClassChainQueryParser parseQueryWithoutCache:query error:&error];
+    XCTAssertNotNil(uncached);
+    XCTAssertEqual(cached.elements.count, uncached.elements.count);
+    for (NSUInteger i = 0; i < cached.elements.count; i++) {
+      XCTAssertEqual(cached.elements[i].type, uncached.elements[i].type);
+      XCTAssertEqualObjects(cached.elements[i].position, uncached.elements[i].position);
+      XCTAssertEqual(cached.elements[i].isDescendant, uncached.elements[i].isDescendant);
+      XCTAssertEqual(cached.elements[i].predicates.count, uncached.elements[i].predicates.count);
+    }
+  }
+}
+
+- (void)testInvalidQueryIsNotCached
+{
+  NSError *error;
+  XCTAssertNil([FBClassChainQueryParser parseQuery:@"XCUIElementTypeWindow[" error:&error]);
+  XCTAssertNotNil(error);
+  error = nil;
+  XCTAssertNil([FBClassChainQueryParser parseQuery:@"XCUIElementTypeWindow[" error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testParsingPerformanceWithoutCache
+{
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (NSString *query in self.queries) {
+        [FBClassChainQueryParser parseQueryWithoutCache:query error:nil];
+      }
+    }
+  }];
+}
+
+- (void)testParsingPerformanceWithCache
+{
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (NSString *query in self.queries) {
+        [FBClassChainQueryParser parseQuery:query error:nil];
+      }
+    }
+  }];
+}
+
+@end
@@ -0,0 +1,152 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "NSData+AMCompression.h"
+
+// gzip member header without optional fields and its CRC32 + ISIZE trailer
+static const NSUInteger GZIP_HEADER_LENGTH = 10;
+static const NSUInteger GZIP_TRAILER_LENGTH = 8;
+// zlib CMF/FLG header and its Adler-32 trailer
+static const NSUInteger ZLIB_HEADER_LENGTH = 2;
+static const NSUInteger ZLIB_TRAILER_LENGTH = 4;
+static const uint8_t DEFLATE_COMPRESSION_METHOD = 8;
+static const uint8_t GZIP_MAGIC[] = {0x1f, 0x8b};
+
+@interface AMCompressionTests : XCTestCase
+@end
+
+@implementation AMCompressionTests
+
++ (NSData *)sampleData
+{
+  NSMutableString *result = [NSMutableString string];
+  for (NSUInteger i = 0; i < 10000; i++) {
+    [result appendFormat:@"{\"element-%lu\": \"value\"},", (unsigned long)i];
+  }
+  return [result dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (NSData *)inflatedDataWithDeflateStream:(NSData *)data
+                             headerLength:(NSUInteger)headerLength
+                            trailerLength:(NSUInteger)trailerLength
+{
+  XCTAssertGreaterThan(data.length, headerLength + trailerLength);
+  NSData *stream = [data subdataWithRange:NSMakeRange(headerLength, data.length - headerLength - trailerLength)];
+  NSError *error;
+  NSData *result = [stream decompressedDataUsingAlgorithm:NSDataCompressionAlgorithmZlib error:&error];
+  XCTAssertNotNil(result, @"%@", error);
+  return result;
+}
+
+- (void)testGzipRoundTrip
+{
+  NSData *data = self.class.sampleData;
+  NSData *compressed = [data am_compressedDataWithContentEncoding:AM_CONTENT_ENCODING_GZIP];
+  XCTAssertNotNil(compressed);
+  XCTAssertLessThan(compressed.length, data.length);
+  const uint8_t *bytes = compressed.bytes;
+  XCTAssertEqual(bytes[0], GZIP_MAGIC[0]);
+  XCTAssertEqual(bytes[1], GZIP_MAGIC[1]);
+  XCTAssertEqual(bytes[2], DEFLATE_COMPRESSION_METHOD);
+  // ISIZE is the length of the original data modulo 2^32 in little endian order
+  const uint8_t *isize = bytes + compressed.length - 4;
+  uint32_t originalLength = isize[0] | (isize[1] << 8) | (isize[2] << 16) | ((uint32_t)isize[3] << 24);
+  XCTAssertEqual((NSUInteger)originalLength, data.length);
+  XCTAssertEqualObjects([self inflatedDataWithDeflateStream:compressed
+                                               headerLength:GZIP_HEADER_LENGTH
+                                              trailerLength:GZIP_TRAILER_LENGTH], data);
+}
+
+- (void)testDeflateRoundTrip
+{
+  NSData *data = self.class.sampleData;
+  NSData *compressed = [data am_compressedDataWithContentEncoding:AM_CONTENT_ENCODING_DEFLATE];
+  XCTAssertNotNil(compressed);
+  XCTAssertLessThan(compressed.length, data.length);
+  const uint8_t *bytes = compressed.bytes;
+  // HTTP deflate encoding is the zlib format, so the stream must start with a valid zlib header
+  XCTAssertEqual((uint8_t)(bytes[0] & 0x0f), DEFLATE_COMPRESSION_METHOD);
+  XCTAssertEqual(((bytes[0] << 8) | bytes[1]) % 31, 0);
+  XCTAssertEqualObjects([self inflatedDataWithDeflateStream:compressed
+                                               headerLength:ZLIB_HEADER_LENGTH
+                                              trailerLength:ZLIB_TRAILER_LENGTH], data);
+}
+
+- (void)testEmptyDataRoundTrip
+{
+  NSData *compressed = [NSData.data am_compressedDataWithContentEncoding:AM_CONTENT_ENCODING_GZIP];
+  XCTAssertNotNil(compressed);
+  XCTAssertEqual(compressed.length, GZIP_HEADER_LENGTH + GZIP_TRAILER_LENGTH + 2);
+}
+
+- (void)testUnsupportedEncodingIsNotCompressed
+{
+  XCTAssertNil([self.class.sampleData am_compressedDataWithContentEncoding:@"br"]);
+  XCTAssertNil([self.class.sampleData am_compressedDataWithContentEncoding:@"identity"]);
+  XCTAssertEqual(AMZlibWindowBitsForContentEncoding(@"br"), 0);
+  XCTAssertNotEqual(AMZlibWindowBitsForContentEncoding(AM_CONTENT_ENCODING_GZIP),
+                    AMZlibWindowBitsForContentEncoding(AM_CONTENT_ENCODING_DEFLATE));
+}
+
+- (void)testPreferredEncodingIsSelectedByQuality
+{
+  NSDictionary<NSString *, NSString *> *expectations = @{
+    @"gzip": AM_CONTENT_ENCODING_GZIP,
+    @"deflate": AM_CONTENT_ENCODING_DEFLATE,
+    @"gzip, deflate": AM_CONTENT_ENCODING_GZIP,
+    @"deflate, gzip": AM_CONTENT_ENCODING_GZIP,
+    @"gzip;q=0.5, deflate": AM_CONTENT_ENCODING_DEFLATE,
+    @"deflate;q=0.4, gzip;q=0.3": AM_CONTENT_ENCODING_DEFLATE,
+    @"br, gzip;q=0.1": AM_CONTENT_ENCODING_GZIP,
+    @"  GZIP ; Q=0.8 ": AM_CONTENT_ENCODING_GZIP,
+  };
+  for (NSString *acceptEncoding in expectations) {
+    XCTAssertEqualObjects([NSData am_preferredContentEncodingWithAcceptEncoding:acceptEncoding],
+                          expectations[acceptEncoding], @"%@", acceptEncoding);
+  }
+}
+
+- (void)testZeroQualityEncodingsAreExcluded
+{
+  XCTAssertNil([NSData am_preferredContentEncodingWithAcceptEncoding:@"gzip;q=0"]);
+  XCTAssertNil([NSData am_preferredContentEncodingWithAcceptEncoding:@"gzip;q=0.000, deflate;q=0"]);
+  XCTAssertEqualObjects([NSData am_preferredContentEncodingWithAcceptEncoding:@"gzip;q=0, deflate"],
+                        AM_CONTENT_ENCODING_DEFLATE);
+}
+
+- (void)testIdentityIsUsedIfNoEncodingIsAcceptable
+{
+  for (NSString *acceptEncoding in @[@"", @"identity", @"br", @"br, identity;q=0.5", @"*"]) {
+    XCTAssertNil([NSData am_preferredContentEncodingWithAcceptEncoding:acceptEncoding], @"%@", acceptEncoding);
+  }
+  XCTAssertNil([NSData am_preferredContentEncodingWithAcceptEncoding:nil]);
+}
+
+- (void)testMalformedHeadersAreIgnored
+{
+  for (NSString *acceptEncoding in @[@",,;", @";q=1", @"gzip;q=", @"gzip;q=abc", @"gzip;q=-1", @"gzipdeflate"]) {
+    XCTAssertNil([NSData am_preferredContentEncodingWithAcceptEncoding:acceptEncoding], @"%@", acceptEncoding);
+  }
+  // Unknown parameters do not affect the quality
+  XCTAssertEqualObjects([NSData am_preferredContentEncodingWithAcceptEncoding:@"gzip;level=9, deflate;q=0.5"],
+                        AM_CONTENT_ENCODING_GZIP);
+  // Broken items do not prevent other ones from being selected
+  XCTAssertEqualObjects([NSData am_preferredContentEncodingWithAcceptEncoding:@";;, deflate;q=abc, gzip"],
+                        AM_CONTENT_ENCODING_GZIP);
+}
+
+@end
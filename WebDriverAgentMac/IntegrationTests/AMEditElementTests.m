@@ -17,6 +17,8 @@
 #import <XCTest/XCTest.h>
 
 #import "AMIntegrationTestCase.h"
+#import "AMPasteboard.h"
+#import "FBConfiguration.h"
 #import "XCUIElement+AMAttributes.h"
 #import "XCUIElement+AMEditable.h"
 
@@ -60,6 +62,53 @@
   XCTAssertEqualObjects(value, edit.am_text);
 }
 
+- (void)testPastingTextIntoEdit
+{
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  NSData *clipboardContent = [@"clipboard" dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertTrue([AMPasteboard setData:clipboardContent forType:@"plaintext" error:nil]);
+  NSString *text = [@"" stringByPaddingToLength:2048 withString:@"yolo😎" startingAtIndex:0];
+  [edit am_setValue:text inputMode:AM_TEXT_INPUT_MODE_PASTE];
+  XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], text);
+  XCTAssertEqualObjects([AMPasteboard dataForType:@"plaintext" error:nil], clipboardContent);
+}
+
+- (void)testAssigningTextValueToEdit
+{
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  NSString *text = [@"" stringByPaddingToLength:2048 withString:@"yolo😎" startingAtIndex:0];
+  [edit am_setValue:text inputMode:AM_TEXT_INPUT_MODE_VALUE];
+  XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], text);
+}
+
+- (void)testTypingTextAtMaximumSpeed
+{
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  NSUInteger typingFrequency = FBConfiguration.sharedConfiguration.typingFrequency;
+  FBConfiguration.sharedConfiguration.typingFrequency = 0;
+  @try {
+    NSString *text = [@"" stringByPaddingToLength:512 withString:@"yolo😎" startingAtIndex:0];
+    [edit am_setValue:text inputMode:AM_TEXT_INPUT_MODE_TYPING];
+    XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], text);
+  } @finally {
+    FBConfiguration.sharedConfiguration.typingFrequency = typingFrequency;
+  }
+}
+
+- (void)testTypingKeys
+{
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  NSError *error = nil;
+  XCTAssertTrue([edit am_clearTextWithError:&error]);
+  XCTAssertTrue([edit am_typeKeys:@[@"a", @"b", XCUIKeyboardKeyDelete]
+                    modifierFlags:@[@(XCUIKeyModifierNone), @(XCUIKeyModifierShift), @(XCUIKeyModifierNone)]
+                            error:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], @"a");
+  XCTAssertFalse([edit am_typeKeys:@[@"a"] modifierFlags:@[] error:&error]);
+  XCTAssertNotNil(error);
+}
+
 - (void)testClearingTextField
 {
   XCUIElement *edit = self.testedApplication.textFields.firstMatch;
@@ -72,4 +121,19 @@
   XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], @"");
 }
 
+- (void)testClearingLongTextPerformance
+{
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  NSString *text = [@"" stringByPaddingToLength:4096 withString:@"yolo😎 " startingAtIndex:0];
+  [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+    [edit am_setValue:text inputMode:AM_TEXT_INPUT_MODE_PASTE];
+    NSError *error = nil;
+    [self startMeasuring];
+    XCTAssertTrue([edit am_clearTextWithError:&error]);
+    [self stopMeasuring];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects([edit am_wdAttributeValueWithName:@"value"], @"");
+  }];
+}
+
 @end
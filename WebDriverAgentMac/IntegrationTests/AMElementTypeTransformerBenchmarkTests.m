@@ -0,0 +1,85 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "FBElementTypeTransformer.h"
+#import "FBExceptions.h"
+
+static const NSUInteger ITERATIONS_COUNT = 10000;
+// XCUIElementTypeStatusItem is the last known type
+static const XCUIElementType LAST_KNOWN_ELEMENT_TYPE = 82;
+
+@interface AMElementTypeTransformerBenchmarkTests : XCTestCase
+@end
+
+@implementation AMElementTypeTransformerBenchmarkTests
+
+- (void)testAllKnownTypesRoundTrip
+{
+  NSMutableSet<NSString *> *names = [NSMutableSet set];
+  for (XCUIElementType type = 0; type <= LAST_KNOWN_ELEMENT_TYPE; type++) {
+    NSString *name = [FBElementTypeTransformer stringWithElementType:type];
+    XCTAssertTrue([name hasPrefix:@"XCUIElementType"]);
+    [names addObject:name];
+    // Make sure the lookup does not rely on the string instance identity
+    NSString *copiedName = [NSMutableString stringWithString:name];
+    XCTAssertEqual([FBElementTypeTransformer elementTypeWithTypeName:copiedName], type);
+  }
+  XCTAssertEqual(names.count, LAST_KNOWN_ELEMENT_TYPE + 1);
+}
+
+- (void)testUnknownTypes
+{
+  XCTAssertEqualObjects([FBElementTypeTransformer stringWithElementType:LAST_KNOWN_ELEMENT_TYPE + 1],
+                        @"XCUIElementTypeOther");
+  XCTAssertEqual([FBElementTypeTransformer elementTypeWithTypeName:@"XCUIElementTypeSomethingNew"],
+                 XCUIElementTypeOther);
+  XCTAssertEqual([FBElementTypeTransformer elementTypeWithTypeName:@"XCUIElementTypeButtonWithAVeryLongNameThatIsNotKnown"],
+                 XCUIElementTypeOther);
+  XCTAssertThrowsSpecificNamed([FBElementTypeTransformer elementTypeWithTypeName:@"Button"],
+                               NSException, FBInvalidArgumentException);
+  XCTAssertThrowsSpecificNamed([FBElementTypeTransformer elementTypeWithTypeName:@"XCUIElementType"],
+                               NSException, FBInvalidArgumentException);
+}
+
+- (void)testTypeToNamePerformance
+{
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (XCUIElementType type = 0; type <= LAST_KNOWN_ELEMENT_TYPE; type++) {
+        [FBElementTypeTransformer stringWithElementType:type];
+      }
+    }
+  }];
+}
+
+- (void)testNameToTypePerformance
+{
+  NSMutableArray<NSString *> *names = [NSMutableArray array];
+  for (XCUIElementType type = 0; type <= LAST_KNOWN_ELEMENT_TYPE; type++) {
+    // Locators come from JSON, so the names are never the same instances as the table ones
+    [names addObject:[NSMutableString stringWithString:[FBElementTypeTransformer stringWithElementType:type]]];
+  }
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (NSString *name in names) {
+        [FBElementTypeTransformer elementTypeWithTypeName:name];
+      }
+    }
+  }];
+}
+
+@end
@@ -124,4 +124,20 @@
   XCTAssertEqualObjects([matches objectAtIndex:2].identifier, @"_XCUI:MinimizeWindow");
 }
 
+- (void)testDescendantsWithIndexedIntermediateClassChainItem
+{
+  NSString *query = @"XCUIElementTypeWindow[1]/**/XCUIElementTypeButton[`identifier BEGINSWITH '_XCUI:'`]";
+  NSArray<XCUIElement *> *matches = [self.testedApplication fb_descendantsMatchingClassChain:query
+                                                                 shouldReturnAfterFirstMatch:NO];
+  XCTAssertTrue(matches.count >= 3);
+  XCTAssertEqualObjects(matches.firstObject.identifier, @"_XCUI:CloseWindow");
+  XCTAssertEqualObjects([matches objectAtIndex:2].identifier, @"_XCUI:MinimizeWindow");
+
+  NSString *lastButtonQuery = @"XCUIElementTypeWindow[1]/**/XCUIElementTypeButton[`identifier BEGINSWITH '_XCUI:'`][-1]";
+  NSArray<XCUIElement *> *lastMatch = [self.testedApplication fb_descendantsMatchingClassChain:lastButtonQuery
+                                                                   shouldReturnAfterFirstMatch:NO];
+  XCTAssertEqual(lastMatch.count, 1);
+  XCTAssertEqualObjects(lastMatch.firstObject.identifier, matches.lastObject.identifier);
+}
+
 @end
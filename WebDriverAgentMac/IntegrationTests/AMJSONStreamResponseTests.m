@@ -0,0 +1,104 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "AMJSONStreamResponse.h"
+
+@interface AMJSONStreamResponseTests : XCTestCase
+@end
+
+@implementation AMJSONStreamResponseTests
+
+- (NSData *)streamedDataWithJSONObject:(id)object
+{
+  AMJSONStreamResponse *response = [[AMJSONStreamResponse alloc] initWithJSONObject:object
+                                                                    contentEncoding:nil];
+  NSMutableData *result = [NSMutableData data];
+  while (!response.isDone) {
+    [result appendData:[response readDataOfLength:1024]];
+  }
+  return result.copy;
+}
+
+- (NSString *)streamedStringWithJSONObject:(id)object
+{
+  return [[NSString alloc] initWithData:[self streamedDataWithJSONObject:object] encoding:NSUTF8StringEncoding];
+}
+
+- (void)testControlCharactersAreEscaped
+{
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"a\n\r\tb"]], @"[\"a\\n\\r\\tb\"]");
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"\x01"]], @"[\"\\u0001\"]");
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"a\x1f"]], @"[\"a\\u001f\"]");
+}
+
+- (void)testQuotesAndBackslashesAreEscaped
+{
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"say \"hi\" \\ bye"]],
+                        @"[\"say \\\"hi\\\" \\\\ bye\"]");
+}
+
+- (void)testNonAsciiCharactersAreWrittenAsUTF8
+{
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"Überschrift – 日本"]],
+                        @"[\"Überschrift – 日本\"]");
+}
+
+- (void)testSurrogatePairsAreWrittenAsUTF8
+{
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[@"🙂👍"]], @"[\"🙂👍\"]");
+  NSString *loneSurrogate = [NSString stringWithCharacters:(unichar[]){0xD83D} length:1];
+  XCTAssertEqualObjects([self streamedStringWithJSONObject:@[loneSurrogate]], @"[\"\\ud83d\"]");
+}
+
+- (void)testEscapedStringsRoundTripAcrossSlices
+{
+  // Longer than a single serialization slice and ends with a character requiring the longest escape
+  NSMutableString *value = [NSMutableString string];
+  for (NSUInteger i = 0; i < 20000; i++) {
+    [value appendString:@"\"\\\x01ü🙂"];
+  }
+  [value appendString:@"\x01"];
+  NSData *streamed = [self streamedDataWithJSONObject:@{@"value": value}];
+  NSDictionary *parsed = [NSJSONSerialization JSONObjectWithData:streamed options:0 error:nil];
+  XCTAssertEqualObjects(parsed[@"value"], value);
+}
+
+- (void)testFractionalNumbersAreSerializedLikeNSJSONSerialization
+{
+  NSArray<NSNumber *> *numbers = @[@0.1, @0.2, @(0.1 + 0.2), @1.5, @-2.25, @(1.0 / 3.0),
+                                   @123456.789, @(M_PI)];
+  NSData *streamed = [self streamedDataWithJSONObject:numbers];
+  NSData *expected = [NSJSONSerialization dataWithJSONObject:numbers options:0 error:nil];
+  XCTAssertEqualObjects([[NSString alloc] initWithData:streamed encoding:NSUTF8StringEncoding],
+                        [[NSString alloc] initWithData:expected encoding:NSUTF8StringEncoding]);
+}
+
+- (void)testFractionalNumbersRoundTrip
+{
+  NSArray<NSNumber *> *numbers = @[@(0.1 + 0.2), @(1.0 / 3.0), @1e-7, @DBL_MAX, @DBL_MIN];
+  NSData *streamed = [self streamedDataWithJSONObject:numbers];
+  XCTAssertEqualObjects([NSJSONSerialization JSONObjectWithData:streamed options:0 error:nil], numbers);
+}
+
+- (void)testFloatNumbersAreSerializedInShortestForm
+{
+  NSData *streamed = [self streamedDataWithJSONObject:@[@0.1f, @1.5f, @3.14159f]];
+  XCTAssertEqualObjects([[NSString alloc] initWithData:streamed encoding:NSUTF8StringEncoding],
+                        @"[0.1,1.5,3.14159]");
+}
+
+@end
@@ -0,0 +1,131 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "FBLogger.h"
+
+// Must be in sync with the limits defined in FBLogger.m
+static const NSUInteger MAX_MESSAGE_LENGTH = 4096;
+static const NSUInteger RING_BUFFER_CAPACITY = 1000;
+static const NSUInteger MAX_PENDING_MESSAGES_COUNT = 10000;
+
+@interface AMLoggerTests : XCTestCase
+@end
+
+@implementation AMLoggerTests
+
+- (void)setUp
+{
+  [super setUp];
+  [FBLogger flush];
+}
+
++ (NSArray<NSString *> *)recentMessagesWithPrefix:(NSString *)prefix
+{
+  NSMutableArray<NSString *> *result = [NSMutableArray array];
+  for (NSDictionary<NSString *, id> *entry in FBLogger.recentEntries) {
+    NSString *message = entry[@"message"];
+    if ([message hasPrefix:prefix]) {
+      [result addObject:message];
+    }
+  }
+  return result.copy;
+}
+
+- (void)testRingBufferKeepsMostRecentEntriesInOrder
+{
+  NSString *prefix = NSUUID.UUID.UUIDString;
+  NSUInteger count = RING_BUFFER_CAPACITY + 250;
+  for (NSUInteger i = 0; i < count; i++) {
+    [FBLogger logFmt:@"%@ %lu", prefix, (unsigned long)i];
+  }
+
+  NSArray<NSDictionary<NSString *, id> *> *entries = FBLogger.recentEntries;
+  XCTAssertEqual(entries.count, RING_BUFFER_CAPACITY);
+  XCTAssertEqualObjects(entries.lastObject[@"message"],
+                        ([NSString stringWithFormat:@"%@ %lu", prefix, (unsigned long)(count - 1)]));
+  XCTAssertEqualObjects(entries.lastObject[@"level"], @"INFO");
+  XCTAssertNotNil(entries.lastObject[@"timestamp"]);
+  NSArray<NSString *> *messages = [self.class recentMessagesWithPrefix:prefix];
+  XCTAssertGreaterThan(messages.count, 0);
+  // Entries are ordered from the oldest to the newest one across the wraparound
+  NSInteger previousIndex = -1;
+  for (NSString *message in messages) {
+    NSInteger index = [[message substringFromIndex:prefix.length + 1] integerValue];
+    XCTAssertGreaterThan(index, previousIndex);
+    previousIndex = index;
+  }
+  XCTAssertGreaterThanOrEqual([[messages.firstObject substringFromIndex:prefix.length + 1] integerValue],
+                              (NSInteger)(count - RING_BUFFER_CAPACITY));
+}
+
+- (void)testLongMessagesAreTruncated
+{
+  NSString *prefix = NSUUID.UUID.UUIDString;
+  NSMutableString *message = [NSMutableString stringWithString:prefix];
+  while (message.length < MAX_MESSAGE_LENGTH - 1) {
+    [message appendString:@"a"];
+  }
+  // The surrogate pair spans the limit, so it must be cut as a whole
+  [message appendString:@"\U0001F600"];
+  for (NSUInteger i = 0; i < 1000; i++) {
+    [message appendString:@"b"];
+  }
+  [FBLogger log:message];
+  [FBLogger log:[prefix stringByAppendingString:@" short"]];
+
+  NSArray<NSString *> *messages = [self.class recentMessagesWithPrefix:prefix];
+  XCTAssertEqual(messages.count, 2);
+  NSString *expected = [NSString stringWithFormat:@"%@... (%lu characters truncated)",
+                        [message substringToIndex:MAX_MESSAGE_LENGTH - 1],
+                        (unsigned long)(message.length - MAX_MESSAGE_LENGTH + 1)];
+  XCTAssertEqualObjects(messages.firstObject, expected);
+  XCTAssertEqualObjects(messages.lastObject, [prefix stringByAppendingString:@" short"]);
+}
+
+- (void)testMessagesOverPendingLimitAreDropped
+{
+  NSString *prefix = NSUUID.UUID.UUIDString;
+  // Message blocks are evaluated on the logging queue, so this one holds it until released
+  dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+  [FBLogger logWithLevel:FBLogLevelInfo messageBlock:^NSString *{
+    dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(30 * NSEC_PER_SEC)));
+    return [prefix stringByAppendingString:@" blocker"];
+  }];
+  for (NSUInteger i = 1; i < MAX_PENDING_MESSAGES_COUNT; i++) {
+    [FBLogger logFmt:@"%@ accepted %lu", prefix, (unsigned long)i];
+  }
+  for (NSUInteger i = 0; i < 5; i++) {
+    [FBLogger logFmt:@"%@ dropped %lu", prefix, (unsigned long)i];
+  }
+  // Errors are never dropped
+  [FBLogger logWithLevel:FBLogLevelError message:[prefix stringByAppendingString:@" error"]];
+  dispatch_semaphore_signal(semaphore);
+  [FBLogger flush];
+  // The queue is drained, so new messages are accepted again
+  [FBLogger log:[prefix stringByAppendingString:@" next"]];
+
+  NSArray<NSString *> *messages = [self.class recentMessagesWithPrefix:prefix];
+  for (NSString *message in messages) {
+    XCTAssertFalse([message containsString:@" dropped "], @"%@", message);
+  }
+  XCTAssertEqualObjects(messages.lastObject, [prefix stringByAppendingString:@" next"]);
+  XCTAssertEqualObjects(messages[messages.count - 2], [prefix stringByAppendingString:@" error"]);
+  XCTAssertEqualObjects(messages[messages.count - 3],
+                        ([NSString stringWithFormat:@"%@ accepted %lu", prefix, (unsigned long)(MAX_PENDING_MESSAGES_COUNT - 1)]));
+}
+
+@end
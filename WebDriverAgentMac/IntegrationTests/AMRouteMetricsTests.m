@@ -0,0 +1,175 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "AMHistogram.h"
+#import "AMRouteMetrics.h"
+
+@interface AMRouteMetricsTests : XCTestCase
+@end
+
+@implementation AMRouteMetricsTests
+
+/**
+ Parses samples from Prometheus text exposition format
+
+ @return Dictionary, where keys are sample names with labels and values are sample values
+ */
++ (NSDictionary<NSString *, NSNumber *> *)samplesWithText:(NSString *)text
+{
+  NSMutableDictionary<NSString *, NSNumber *> *result = [NSMutableDictionary dictionary];
+  for (NSString *line in [text componentsSeparatedByString:@"\n"]) {
+    if (0 == line.length || [line hasPrefix:@"#"]) {
+      continue;
+    }
+    NSRange separator = [line rangeOfString:@" " options:NSBackwardsSearch];
+    [result setObject:@([line substringFromIndex:NSMaxRange(separator)].doubleValue)
+               forKey:[line substringToIndex:separator.location]];
+  }
+  return result.copy;
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)samplesWithHistogram:(AMHistogram *)histogram
+{
+  NSMutableString *output = [NSMutableString string];
+  [histogram appendPrometheusSamplesWithName:@"test" labels:@"" toString:output];
+  return [self samplesWithText:output];
+}
+
+/**
+ Estimates the quantile from cumulative bucket counts the same way as
+ Prometheus histogram_quantile() does, i.e. by linear interpolation inside the matching bucket
+ */
++ (double)quantile:(double)quantile
+       upperBounds:(NSArray<NSNumber *> *)upperBounds
+           samples:(NSDictionary<NSString *, NSNumber *> *)samples
+{
+  double rank = quantile * samples[@"test_count"].doubleValue;
+  double lowerBound = 0;
+  double previousCount = 0;
+  for (NSNumber *upperBound in upperBounds) {
+    NSString *key = [NSString stringWithFormat:@"test_bucket{le=\"%g\"}", upperBound.doubleValue];
+    double count = samples[key].doubleValue;
+    if (count >= rank) {
+      return lowerBound + (upperBound.doubleValue - lowerBound) * (rank - previousCount) / (count - previousCount);
+    }
+    lowerBound = upperBound.doubleValue;
+    previousCount = count;
+  }
+  return upperBounds.lastObject.doubleValue;
+}
+
+- (void)testBucketUpperBoundsAreInclusive
+{
+  AMHistogram *histogram = [[AMHistogram alloc] initWithUpperBounds:@[@1, @2, @5] unitScale:1];
+  for (NSNumber *value in @[@0, @1, @2, @3, @5, @6]) {
+    [histogram recordValue:value.unsignedLongLongValue];
+  }
+  XCTAssertEqual(histogram.count, 6ULL);
+
+  NSDictionary<NSString *, NSNumber *> *samples = [self.class samplesWithHistogram:histogram];
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"1\"}"], @2);
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"2\"}"], @3);
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"5\"}"], @5);
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"+Inf\"}"], @6);
+  XCTAssertEqualObjects(samples[@"test_sum"], @17);
+  XCTAssertEqualObjects(samples[@"test_count"], @6);
+}
+
+- (void)testRecordedValuesAreScaledToBaseUnits
+{
+  AMHistogram *histogram = [[AMHistogram alloc] initWithUpperBounds:@[@0.001, @0.01] unitScale:1e-9];
+  // Exactly 1ms still belongs to the first bucket, while a nanosecond more does not
+  [histogram recordValue:1000000];
+  [histogram recordValue:1000001];
+  [histogram recordValue:20000000];
+
+  NSDictionary<NSString *, NSNumber *> *samples = [self.class samplesWithHistogram:histogram];
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"0.001\"}"], @1);
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"0.01\"}"], @2);
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"+Inf\"}"], @3);
+  XCTAssertEqualWithAccuracy(samples[@"test_sum"].doubleValue, 0.022000001, 1e-12);
+}
+
+- (void)testQuantilesAreEstimatedFromBuckets
+{
+  NSArray<NSNumber *> *upperBounds = @[@1, @2, @5];
+  AMHistogram *histogram = [[AMHistogram alloc] initWithUpperBounds:upperBounds unitScale:1];
+  for (NSUInteger i = 0; i < 90; i++) {
+    [histogram recordValue:1];
+  }
+  for (NSUInteger i = 0; i < 10; i++) {
+    [histogram recordValue:4];
+  }
+
+  NSDictionary<NSString *, NSNumber *> *samples = [self.class samplesWithHistogram:histogram];
+  XCTAssertEqualWithAccuracy([self.class quantile:0.5 upperBounds:upperBounds samples:samples], 50.0 / 90, 1e-9);
+  XCTAssertEqualWithAccuracy([self.class quantile:0.9 upperBounds:upperBounds samples:samples], 1, 1e-9);
+  // The empty (1, 2] bucket is skipped, so p99 is interpolated inside (2, 5]
+  XCTAssertEqualWithAccuracy([self.class quantile:0.99 upperBounds:upperBounds samples:samples], 4.7, 1e-9);
+}
+
+- (void)testConcurrentRecordsAreNotLost
+{
+  AMHistogram *histogram = [[AMHistogram alloc] initWithUpperBounds:@[@10, @100] unitScale:1];
+  dispatch_apply(10000, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+    [histogram recordValue:index % 200];
+  });
+  XCTAssertEqual(histogram.count, 10000ULL);
+
+  NSDictionary<NSString *, NSNumber *> *samples = [self.class samplesWithHistogram:histogram];
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"10\"}"], @(11 * 50));
+  XCTAssertEqualObjects(samples[@"test_bucket{le=\"100\"}"], @(101 * 50));
+  XCTAssertEqualObjects(samples[@"test_sum"], @(199 * 100 * 50));
+}
+
+- (void)testMetricsAreAggregatedPerRoute
+{
+  NSString *path = [NSString stringWithFormat:@"/test/%@", NSUUID.UUID.UUIDString];
+  AMRouteMetrics *getMetrics = [AMRouteMetrics metricsForRouteWithVerb:@"GET" path:path];
+  XCTAssertEqual([AMRouteMetrics metricsForRouteWithVerb:@"GET" path:path], getMetrics);
+  AMRouteMetrics *postMetrics = [AMRouteMetrics metricsForRouteWithVerb:@"POST" path:path];
+  XCTAssertNotEqual(postMetrics, getMetrics);
+
+  [getMetrics.handler recordValue:1000000];
+  [[AMRouteMetrics metricsForRouteWithVerb:@"GET" path:path].handler recordValue:3000000];
+  [postMetrics.responseSize recordValue:2048];
+
+  NSDictionary<NSString *, NSNumber *> *samples = [self.class samplesWithText:AMRouteMetrics.prometheusText];
+  NSString *getLabels = [NSString stringWithFormat:@"{method=\"GET\",route=\"%@\"}", path];
+  NSString *postLabels = [NSString stringWithFormat:@"{method=\"POST\",route=\"%@\"}", path];
+  XCTAssertEqualObjects(samples[[@"wda_route_handler_seconds_count" stringByAppendingString:getLabels]], @2);
+  XCTAssertEqualWithAccuracy(samples[[@"wda_route_handler_seconds_sum" stringByAppendingString:getLabels]].doubleValue,
+                             0.004, 1e-9);
+  XCTAssertEqualObjects(samples[[@"wda_route_response_size_bytes_count" stringByAppendingString:postLabels]], @1);
+  // Histograms without records are not rendered
+  XCTAssertNil(samples[[@"wda_route_handler_seconds_count" stringByAppendingString:postLabels]]);
+  XCTAssertNil(samples[[@"wda_route_response_size_bytes_count" stringByAppendingString:getLabels]]);
+}
+
+- (void)testRouteLabelsAreEscaped
+{
+  NSString *path = [NSString stringWithFormat:@"/test/\"%@\\", NSUUID.UUID.UUIDString];
+  [[AMRouteMetrics metricsForRouteWithVerb:@"GET" path:path].handler recordValue:1];
+
+  NSString *escapedPath = [[path stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"]
+                           stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+  NSString *expectedLine = [NSString stringWithFormat:@"wda_route_handler_seconds_count{method=\"GET\",route=\"%@\"} 1\n",
+                            escapedPath];
+  XCTAssertTrue([AMRouteMetrics.prometheusText containsString:expectedLine]);
+}
+
+@end
@@ -0,0 +1,103 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "FBSession.h"
+
+// Must be in sync with the capacity defined in FBSession.m
+static const NSUInteger SEARCH_PREDICATES_CACHE_SIZE = 256;
+
+@interface AMSearchPredicatesCacheTests : XCTestCase
+@property (nonatomic) FBSession *session;
+@end
+
+@implementation AMSearchPredicatesCacheTests
+
+- (void)setUp
+{
+  [super setUp];
+  self.session = [FBSession initWithApplication:nil];
+}
+
+- (void)tearDown
+{
+  [self.session kill];
+  [FBSession waitForPendingTeardownsWithTimeout:10];
+  [super tearDown];
+}
+
++ (NSString *)formatWithIndex:(NSUInteger)index
+{
+  return [NSString stringWithFormat:@"label == 'item%lu'", (unsigned long)index];
+}
+
+- (void)testRepeatedFormatIsServedFromCache
+{
+  NSPredicate *predicate = [self.session searchPredicateWithFormat:@"label == 'item'"];
+  XCTAssertNotNil(predicate);
+  XCTAssertEqual([self.session searchPredicateWithFormat:@"label == 'item'"], predicate);
+  XCTAssertNotEqual([self.session searchPredicateWithFormat:@"label == 'other'"], predicate);
+}
+
+- (void)testEqualFormatsFromDistinctMutableStringsShareCacheEntry
+{
+  NSMutableString *format = [NSMutableString stringWithString:@"label == 'item'"];
+  NSPredicate *predicate = [self.session searchPredicateWithFormat:format];
+  XCTAssertEqual([self.session searchPredicateWithFormat:[NSMutableString stringWithString:@"label == 'item'"]],
+                 predicate);
+
+  // The cache keeps its own copy of the key, so mutating the original string does not affect it
+  [format setString:@"label == 'mutated'"];
+  XCTAssertEqual([self.session searchPredicateWithFormat:@"label == 'item'"], predicate);
+  NSPredicate *mutatedPredicate = [self.session searchPredicateWithFormat:format];
+  XCTAssertNotEqual(mutatedPredicate, predicate);
+  XCTAssertEqualObjects(mutatedPredicate, [self.session searchPredicateWithFormat:@"label == 'mutated'"]);
+}
+
+- (void)testLeastRecentlyUsedFormatIsEvicted
+{
+  NSPredicate *evicted = [self.session searchPredicateWithFormat:[self.class formatWithIndex:0]];
+  NSPredicate *retained = [self.session searchPredicateWithFormat:[self.class formatWithIndex:1]];
+  for (NSUInteger i = 2; i < SEARCH_PREDICATES_CACHE_SIZE; i++) {
+    [self.session searchPredicateWithFormat:[self.class formatWithIndex:i]];
+  }
+  // Bumps the second format, so the first one becomes the least recently used
+  XCTAssertEqual([self.session searchPredicateWithFormat:[self.class formatWithIndex:1]], retained);
+  [self.session searchPredicateWithFormat:[self.class formatWithIndex:SEARCH_PREDICATES_CACHE_SIZE]];
+
+  XCTAssertEqual([self.session searchPredicateWithFormat:[self.class formatWithIndex:1]], retained);
+  NSPredicate *recreated = [self.session searchPredicateWithFormat:[self.class formatWithIndex:0]];
+  XCTAssertNotEqual(recreated, evicted);
+  XCTAssertEqualObjects(recreated, evicted);
+}
+
+- (void)testInvalidFormatIsNotCached
+{
+  XCTAssertThrowsSpecificNamed([self.session searchPredicateWithFormat:@"label =="],
+                               NSException, NSInvalidArgumentException);
+  XCTAssertThrowsSpecificNamed([self.session searchPredicateWithFormat:@"label =="],
+                               NSException, NSInvalidArgumentException);
+}
+
+- (void)testCacheIsScopedToSession
+{
+  NSPredicate *predicate = [self.session searchPredicateWithFormat:@"label == 'item'"];
+  FBSession *nextSession = [FBSession initWithApplication:nil];
+  XCTAssertNotEqual([nextSession searchPredicateWithFormat:@"label == 'item'"], predicate);
+  self.session = nextSession;
+}
+
+@end
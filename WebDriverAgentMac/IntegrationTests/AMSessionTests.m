@@ -16,7 +16,9 @@
 
 #import <XCTest/XCTest.h>
 
+#import "AMApplicationPool.h"
 #import "AMIntegrationTestCase.h"
+#import "FBConfiguration.h"
 #import "FBSession.h"
 #import "FBTestMacros.h"
 #import "XCUIApplication+AMHelpers.h"
@@ -40,6 +42,7 @@ static NSString *const SETTINGS_BUNDLE_ID = @"com.apple.systempreferences";
 - (void)tearDown
 {
   [self.session kill];
+  [FBSession waitForPendingTeardownsWithTimeout:10];
   [super tearDown];
 }
 
@@ -100,4 +103,98 @@ static NSString *const SETTINGS_BUNDLE_ID = @"com.apple.systempreferences";
   XCTAssertEqualObjects(testedAppPath, self.session.currentApplication.am_path);
 }
 
+- (void)testConcurrentSessionsCanCoexist
+{
+  FBSession *concurrentSession = [FBSession initWithApplication:nil concurrent:YES];
+  XCTAssertEqual(FBSession.activeSession, concurrentSession);
+  XCTAssertEqual([FBSession sessionWithIdentifier:self.session.identifier], self.session);
+  XCTAssertEqual([FBSession sessionWithIdentifier:concurrentSession.identifier], concurrentSession);
+  XCTAssertEqual(FBSession.allSessions.count, 2);
+
+  [concurrentSession kill];
+  XCTAssertNil([FBSession sessionWithIdentifier:concurrentSession.identifier]);
+  XCTAssertEqual([FBSession sessionWithIdentifier:self.session.identifier], self.session);
+}
+
+- (void)testNewSessionReplacesExistingSessionsByDefault
+{
+  FBSession *concurrentSession = [FBSession initWithApplication:nil concurrent:YES];
+  FBSession *exclusiveSession = [FBSession initWithApplication:nil];
+  XCTAssertNil([FBSession sessionWithIdentifier:self.session.identifier]);
+  XCTAssertNil([FBSession sessionWithIdentifier:concurrentSession.identifier]);
+  XCTAssertEqualObjects(FBSession.allSessions, @[exclusiveSession]);
+  [exclusiveSession kill];
+}
+
+- (pid_t)recycleTestedApplicationIntoPool
+{
+  NSString *bundleId = self.testedApplication.am_bundleID;
+  pid_t recycledPid = self.testedApplication.am_processID;
+  XCTAssertTrue([AMApplicationPool.sharedPool recycleApplication:self.testedApplication]);
+  FBAssertWaitTillBecomesTrue([AMApplicationPool.sharedPool.toArray.firstObject[@"ready"] boolValue]);
+  NSRunningApplication *warmInstance = [NSRunningApplication runningApplicationsWithBundleIdentifier:bundleId].firstObject;
+  XCTAssertNotNil(warmInstance);
+  XCTAssertNotEqual(warmInstance.processIdentifier, recycledPid);
+  return warmInstance.processIdentifier;
+}
+
+- (void)testTerminatedApplicationIsRecycledIntoPool
+{
+  NSUInteger applicationPoolSize = FBConfiguration.sharedConfiguration.applicationPoolSize;
+  FBConfiguration.sharedConfiguration.applicationPoolSize = 1;
+  @try {
+    pid_t warmPid = [self recycleTestedApplicationIntoPool];
+
+    XCUIApplication *app = [self.session launchApplicationWithBundleId:self.testedApplication.am_bundleID
+                                                                  path:nil
+                                                             arguments:self.testedApplication.launchArguments
+                                                           environment:self.testedApplication.launchEnvironment];
+    XCTAssertEqual(app.state, XCUIApplicationStateRunningForeground);
+    XCTAssertEqual(app.am_processID, warmPid);
+    XCTAssertEqual(AMApplicationPool.sharedPool.toArray.count, 0);
+  } @finally {
+    FBConfiguration.sharedConfiguration.applicationPoolSize = applicationPoolSize;
+  }
+}
+
+- (void)testPooledApplicationIsReplacedIfLaunchOptionsDiffer
+{
+  NSUInteger applicationPoolSize = FBConfiguration.sharedConfiguration.applicationPoolSize;
+  FBConfiguration.sharedConfiguration.applicationPoolSize = 1;
+  @try {
+    pid_t warmPid = [self recycleTestedApplicationIntoPool];
+
+    NSArray<NSString *> *arguments = [self.testedApplication.launchArguments arrayByAddingObject:@"-AMPoolTest"];
+    XCUIApplication *app = [self.session launchApplicationWithBundleId:self.testedApplication.am_bundleID
+                                                                  path:nil
+                                                             arguments:arguments
+                                                           environment:self.testedApplication.launchEnvironment];
+    XCTAssertEqual(app.state, XCUIApplicationStateRunningForeground);
+    XCTAssertNotEqual(app.am_processID, warmPid);
+    XCTAssertEqualObjects(app.launchArguments, arguments);
+    XCTAssertEqual(AMApplicationPool.sharedPool.toArray.count, 0);
+  } @finally {
+    FBConfiguration.sharedConfiguration.applicationPoolSize = applicationPoolSize;
+  }
+}
+
+- (void)testApplicationIsTerminatedInBackgroundWhenSessionIsKilled
+{
+  [self.session kill];
+  XCTAssertNil([FBSession sessionWithIdentifier:self.session.identifier]);
+  XCTAssertTrue([FBSession waitForPendingTeardownsWithTimeout:10]);
+  XCTAssertEqual(self.testedApplication.state, XCUIApplicationStateNotRunning);
+}
+
+- (void)testApplicationIsNotTerminatedWhileUsedByConcurrentSession
+{
+  FBSession *concurrentSession = [FBSession initWithApplication:self.testedApplication concurrent:YES];
+  [self.session kill];
+  XCTAssertTrue([FBSession waitForPendingTeardownsWithTimeout:10]);
+  XCTAssertEqual(self.testedApplication.state, XCUIApplicationStateRunningForeground);
+  [concurrentSession kill];
+  XCTAssertTrue([FBSession waitForPendingTeardownsWithTimeout:10]);
+  XCTAssertEqual(self.testedApplication.state, XCUIApplicationStateNotRunning);
+}
+
 @end
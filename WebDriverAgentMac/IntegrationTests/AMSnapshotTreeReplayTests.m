@@ -0,0 +1,210 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "AMIntegrationTestCase.h"
+#import "AMSnapshotTree.h"
+#import "AMSnapshotTreeArchive.h"
+#import "AMSnapshotTreeRecorder.h"
+#import "AMXPathExpression.h"
+#import "FBXPath.h"
+
+/*!
+ The environment variable with the path to a folder containing recorded trees to replay.
+ Trees could be captured with the GET /wda/snapshotTree endpoint: archives must have
+ the .amtree extension (base64-decoded endpoint response) and JSON records must have the .json one.
+ The tree of the tested application is replayed if the variable is not set
+ */
+static NSString *const AM_RECORDED_TREES_PATH_ENV = @"AM_RECORDED_SNAPSHOT_TREES_PATH";
+
+@interface AMSnapshotTreeReplayTests : AMIntegrationTestCase
+@property (nonatomic) NSArray<NSString *> *treePaths;
+@property (nonatomic) NSArray<AMSnapshotTree *> *trees;
+@end
+
+/**
+ Replays recorded snapshot trees through lookup and serialization code,
+ so these could be profiled without reproducing the original application state
+ */
+@implementation AMSnapshotTreeReplayTests
+
+- (void)setUp
+{
+  [super setUp];
+  NSString *recordedTreesPath = NSProcessInfo.processInfo.environment[AM_RECORDED_TREES_PATH_ENV];
+  NSMutableArray<NSString *> *treePaths = [NSMutableArray array];
+  if (recordedTreesPath.length > 0) {
+    for (NSString *name in [NSFileManager.defaultManager contentsOfDirectoryAtPath:recordedTreesPath error:nil]) {
+      if ([name.pathExtension isEqualToString:AMSnapshotTreeArchiveFileExtension] || [name.pathExtension isEqualToString:@"json"]) {
+        [treePaths addObject:[recordedTreesPath stringByAppendingPathComponent:name]];
+      }
+    }
+  } else {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+      [self launchApplication];
+    });
+    [treePaths addObject:[self recordTestedApplicationTree]];
+  }
+  XCTAssertTrue(treePaths.count > 0);
+  self.treePaths = treePaths.copy;
+
+  NSMutableArray<AMSnapshotTree *> *trees = [NSMutableArray array];
+  for (NSString *path in self.treePaths) {
+    NSError *error;
+    AMSnapshotTree *tree = [self loadTreeAtPath:path error:&error];
+    XCTAssertNotNil(tree, @"%@ cannot be loaded: %@", path, error);
+    if (nil != tree) {
+      [trees addObject:tree];
+    }
+  }
+  self.trees = trees.copy;
+}
+
+- (NSString *)recordTestedApplicationTree
+{
+  NSError *error;
+  id<XCUIElementSnapshot> snapshot = [self.testedApplication snapshotWithError:&error];
+  XCTAssertNotNil(snapshot, @"%@", error);
+  AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithRootSnapshot:snapshot];
+  NSString *path = [[NSTemporaryDirectory() stringByAppendingPathComponent:@"AMSnapshotTreeReplayTests"]
+                    stringByAppendingPathExtension:AMSnapshotTreeArchiveFileExtension];
+  XCTAssertTrue([AMSnapshotTreeArchive writeTree:tree toFile:path error:&error], @"%@", error);
+  return path;
+}
+
+- (nullable AMSnapshotTree *)loadTreeAtPath:(NSString *)path error:(NSError **)error
+{
+  return [path.pathExtension isEqualToString:AMSnapshotTreeArchiveFileExtension]
+    ? [AMSnapshotTreeArchive treeWithContentsOfFile:path error:error]
+    : [AMSnapshotTreeRecorder treeWithContentsOfFile:path error:error];
+}
+
+- (NSArray<NSString *> *)queries
+{
+  return @[
+    @"//XCUIElementTypeButton",
+    @"//XCUIElementTypeButton[starts-with(@identifier, \"_XCUI:\")]",
+    @"//XCUIElementTypeWindow//*[@enabled='true' and @label != '']",
+    @"(//XCUIElementTypeStaticText)[last()]",
+    @"//XCUIElementTypeStaticText/ancestor::*[@width > 100][1]",
+    @"//*[contains(@title, 'a') or contains(@value, 'a')]/following-sibling::*",
+  ];
+}
+
+- (void)testArchivedTreeIsTheSameAsTheOriginalOne
+{
+  for (AMSnapshotTree *tree in self.trees) {
+    NSError *error;
+    AMSnapshotTree *unarchivedTree = [AMSnapshotTreeArchive treeWithData:[AMSnapshotTreeArchive dataWithTree:tree]
+                                                                   error:&error];
+    XCTAssertNotNil(unarchivedTree, @"%@", error);
+    XCTAssertEqual(unarchivedTree.count, tree.count);
+    XCTAssertEqual(unarchivedTree.stringsCount, tree.stringsCount);
+    XCTAssertEqualObjects([FBXPath xmlStringWithSnapshotTree:unarchivedTree], [FBXPath xmlStringWithSnapshotTree:tree]);
+    AMSnapshotTree *restoredTree = [AMSnapshotTreeRecorder treeWithRecord:[AMSnapshotTreeRecorder recordWithTree:tree]
+                                                                    error:&error];
+    XCTAssertNotNil(restoredTree, @"%@", error);
+    XCTAssertEqualObjects([FBXPath xmlStringWithSnapshotTree:restoredTree], [FBXPath xmlStringWithSnapshotTree:tree]);
+  }
+}
+
+- (void)testInvalidArchivesAreRejected
+{
+  NSData *data = [AMSnapshotTreeArchive dataWithTree:self.trees.firstObject];
+  NSError *error;
+  XCTAssertNil([AMSnapshotTreeArchive treeWithData:[data subdataWithRange:NSMakeRange(0, data.length - 1)] error:&error]);
+  XCTAssertNotNil(error);
+
+  NSMutableData *wrongVersion = data.mutableCopy;
+  uint32_t version = AMSnapshotTreeArchiveVersion + 1;
+  [wrongVersion replaceBytesInRange:NSMakeRange(8, sizeof(version)) withBytes:&version];
+  error = nil;
+  XCTAssertNil([AMSnapshotTreeArchive treeWithData:wrongVersion error:&error]);
+  XCTAssertNotNil(error);
+
+  error = nil;
+  XCTAssertNil([AMSnapshotTreeArchive treeWithData:[@"not an archive" dataUsingEncoding:NSUTF8StringEncoding] error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testReplayedXPathResultsConformToReference
+{
+  for (AMSnapshotTree *tree in self.trees) {
+    NSError *error;
+    NSXMLDocument *document = [[NSXMLDocument alloc] initWithXMLString:[FBXPath xmlStringWithSnapshotTree:tree]
+                                                               options:0
+                                                                 error:&error];
+    XCTAssertNotNil(document, @"%@", error);
+    for (NSString *query in self.queries) {
+      NSIndexSet *nodes = [[AMXPathExpression expressionWithQuery:query error:nil] matchingNodesInTree:tree error:&error];
+      XCTAssertNotNil(nodes, @"%@", error);
+      // The leading slash is evaluated relatively to the root element the same way FBXPath does it
+      NSString *fixedQuery = [query stringByReplacingOccurrencesOfString:@"^([(]*)(/)"
+                                                              withString:@"$1.$2"
+                                                                 options:NSRegularExpressionSearch
+                                                                   range:NSMakeRange(0, query.length)];
+      NSArray<NSXMLNode *> *expected = [document.rootElement nodesForXPath:fixedQuery error:&error];
+      XCTAssertNotNil(expected, @"%@", error);
+      XCTAssertEqual(nodes.count, expected.count, @"The result of '%@' differs from the reference", query);
+      __block NSUInteger index = 0;
+      [nodes enumerateIndexesUsingBlock:^(NSUInteger node, BOOL *stop) {
+        XCTAssertEqualObjects([tree typeNameOfNode:node], expected[index].name);
+        index++;
+        *stop = index >= expected.count;
+      }];
+    }
+  }
+}
+
+- (void)testReplayedArchiveLoadingPerformance
+{
+  [self measureBlock:^{
+    for (NSString *path in self.treePaths) {
+      for (NSUInteger i = 0; i < 100; i++) {
+        [self loadTreeAtPath:path error:nil];
+      }
+    }
+  }];
+}
+
+- (void)testReplayedXPathPerformance
+{
+  NSArray<NSString *> *queries = self.queries;
+  [self measureBlock:^{
+    for (AMSnapshotTree *tree in self.trees) {
+      for (NSUInteger i = 0; i < 100; i++) {
+        for (NSString *query in queries) {
+          [[AMXPathExpression expressionWithQuery:query error:nil] matchingNodesInTree:tree error:nil];
+        }
+      }
+    }
+  }];
+}
+
+- (void)testReplayedSourceSerializationPerformance
+{
+  [self measureBlock:^{
+    for (AMSnapshotTree *tree in self.trees) {
+      for (NSUInteger i = 0; i < 10; i++) {
+        [FBXPath xmlStringWithSnapshotTree:tree];
+      }
+    }
+  }];
+}
+
+@end
@@ -0,0 +1,142 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "AMIntegrationTestCase.h"
+#import "AMSnapshotTree.h"
+#import "AMSnapshotTreeRecorder.h"
+#import "AMXPathExpression.h"
+#import "FBXPath.h"
+
+@interface AMSnapshotTreeTests : AMIntegrationTestCase
+@property (nonatomic) AMSnapshotTree *tree;
+@end
+
+@implementation AMSnapshotTreeTests
+
+- (void)setUp
+{
+  [super setUp];
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    [self launchApplication];
+  });
+  NSError *error;
+  id<XCUIElementSnapshot> snapshot = [self.testedApplication snapshotWithError:&error];
+  XCTAssertNotNil(snapshot, @"%@", error);
+  self.tree = [[AMSnapshotTree alloc] initWithRootSnapshot:snapshot];
+}
+
+- (void)testTreeStructureIsConsistent
+{
+  XCTAssertTrue(self.tree.count > 1);
+  XCTAssertEqual([self.tree parentOfNode:0], AMSnapshotTreeNoNode);
+  XCTAssertEqual([self.tree subtreeEndOfNode:0], self.tree.count);
+  XCTAssertNotNil([self.tree snapshotOfNode:0]);
+  for (NSUInteger node = 1; node < self.tree.count; node++) {
+    NSUInteger parent = [self.tree parentOfNode:node];
+    XCTAssertTrue(parent < node);
+    XCTAssertTrue([self.tree subtreeEndOfNode:node] <= [self.tree subtreeEndOfNode:parent]);
+    NSUInteger previous = [self.tree previousSiblingOfNode:node];
+    if (previous == AMSnapshotTreeNoNode) {
+      XCTAssertEqual([self.tree firstChildOfNode:parent], node);
+    } else {
+      XCTAssertEqual([self.tree nextSiblingOfNode:previous], node);
+      XCTAssertEqual([self.tree subtreeEndOfNode:previous], node);
+    }
+  }
+}
+
+- (void)testStringsAreInterned
+{
+  NSMutableSet<NSString *> *uniqueStrings = [NSMutableSet set];
+  NSUInteger valuesCount = 0;
+  for (NSUInteger node = 0; node < self.tree.count; node++) {
+    for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+      NSString *value = [self.tree stringAttribute:attribute ofNode:node];
+      if (nil != value) {
+        [uniqueStrings addObject:value];
+        valuesCount++;
+      }
+    }
+  }
+  XCTAssertTrue(self.tree.stringsCount < valuesCount);
+  XCTAssertEqual(self.tree.stringsCount, uniqueStrings.count);
+}
+
+- (void)testTreeSourceMatchesLiveSource
+{
+  XCTAssertEqualObjects([FBXPath xmlStringWithSnapshotTree:self.tree],
+                        [FBXPath xmlStringWithRootElement:self.testedApplication]);
+}
+
+- (void)testRecordedTreeIsTheSameAfterReplay
+{
+  NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.json", NSUUID.UUID.UUIDString]];
+  NSError *error;
+  XCTAssertTrue([AMSnapshotTreeRecorder writeTree:self.tree toFile:path error:&error], @"%@", error);
+  AMSnapshotTree *replayedTree = [AMSnapshotTreeRecorder treeWithContentsOfFile:path error:&error];
+  [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+  XCTAssertNotNil(replayedTree, @"%@", error);
+
+  XCTAssertEqual(replayedTree.count, self.tree.count);
+  XCTAssertNil([replayedTree snapshotOfNode:0]);
+  XCTAssertEqualObjects([FBXPath xmlStringWithSnapshotTree:replayedTree],
+                        [FBXPath xmlStringWithSnapshotTree:self.tree]);
+  AMXPathExpression *expression = [AMXPathExpression expressionWithQuery:@"//XCUIElementTypeButton[starts-with(@identifier, '_XCUI:')]"
+                                                                   error:&error];
+  NSIndexSet *matches = [expression matchingNodesInTree:self.tree error:nil];
+  XCTAssertTrue(matches.count >= 3);
+  XCTAssertEqualObjects([expression matchingNodesInTree:replayedTree error:nil], matches);
+}
+
+- (void)testInvalidRecordsAreRejected
+{
+  NSDictionary *record = [AMSnapshotTreeRecorder recordWithTree:self.tree];
+  NSError *error;
+  XCTAssertNotNil([AMSnapshotTreeRecorder treeWithRecord:record error:&error], @"%@", error);
+
+  NSMutableDictionary *unsupportedVersion = record.mutableCopy;
+  unsupportedVersion[@"version"] = @(AMSnapshotTreeRecordVersion + 1);
+  XCTAssertNil([AMSnapshotTreeRecorder treeWithRecord:unsupportedVersion error:&error]);
+  XCTAssertNotNil(error);
+
+  NSMutableDictionary *truncatedColumn = record.mutableCopy;
+  NSArray *labels = record[@"label"];
+  truncatedColumn[@"label"] = [labels subarrayWithRange:NSMakeRange(0, labels.count - 1)];
+  error = nil;
+  XCTAssertNil([AMSnapshotTreeRecorder treeWithRecord:truncatedColumn error:&error]);
+  XCTAssertNotNil(error);
+
+  NSMutableDictionary *wrongOrder = record.mutableCopy;
+  NSMutableArray *parents = [record[@"parent"] mutableCopy];
+  parents[1] = @(parents.count - 1);
+  wrongOrder[@"parent"] = parents.copy;
+  error = nil;
+  XCTAssertNil([AMSnapshotTreeRecorder treeWithRecord:wrongOrder error:&error]);
+  XCTAssertNotNil(error);
+
+  NSMutableDictionary *unknownString = record.mutableCopy;
+  NSMutableArray *identifiers = [record[@"identifier"] mutableCopy];
+  identifiers[0] = @([record[@"strings"] count] + 1);
+  unknownString[@"identifier"] = identifiers.copy;
+  error = nil;
+  XCTAssertNil([AMSnapshotTreeRecorder treeWithRecord:unknownString error:&error]);
+  XCTAssertNotNil(error);
+}
+
+@end
@@ -46,4 +46,12 @@
   XCTAssertTrue(xml.length > 0);
 }
 
+- (void)testXmlRepresentationPerformance
+{
+  XCUIApplication *app = self.testedApplication;
+  [self measureWithMetrics:@[XCTClockMetric.new, XCTMemoryMetric.new] block:^{
+    XCTAssertTrue(app.am_xmlRepresentation.length > 0);
+  }];
+}
+
 @end
@@ -0,0 +1,221 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "FBSession.h"
+#import "FBW3CActionsSynthesizer.h"
+
+@interface AMW3CActionsBenchmarkTests : XCTestCase
+@property (nonatomic) XCUIApplication *application;
+@end
+
+@implementation AMW3CActionsBenchmarkTests
+
+- (void)setUp
+{
+  [super setUp];
+  // Synthesis does not interact with the application, so it does not need to be launched
+  self.application = [[XCUIApplication alloc] initWithBundleIdentifier:FINDER_BUNDLE_ID];
+}
+
++ (NSArray<NSDictionary<NSString *, id> *> *)keyActionsWithItemsCount:(NSUInteger)count
+{
+  NSMutableArray<NSDictionary<NSString *, id> *> *items = [NSMutableArray array];
+  [items addObject:@{@"type": @"keyDown", @"value": @"\uE008"}];
+  while (items.count + 3 <= count) {
+    NSString *value = [NSString stringWithFormat:@"%c", (char)('a' + items.count % 26)];
+    [items addObject:@{@"type": @"keyDown", @"value": value}];
+    [items addObject:@{@"type": @"keyUp", @"value": value}];
+  }
+  while (items.count + 1 < count) {
+    [items addObject:@{@"type": @"pause", @"duration": @0}];
+  }
+  [items addObject:@{@"type": @"keyUp", @"value": @"\uE008"}];
+  return @[@{@"type": @"key", @"id": @"keyboard", @"actions": items.copy}];
+}
+
++ (NSArray<NSDictionary<NSString *, id> *> *)pointerActionsWithItemsCount:(NSUInteger)count
+{
+  NSMutableArray<NSDictionary<NSString *, id> *> *items = [NSMutableArray array];
+  [items addObject:@{@"type": @"pointerMove", @"duration": @1, @"x": @10, @"y": @10}];
+  [items addObject:@{@"type": @"pointerDown"}];
+  while (items.count + 1 < count) {
+    [items addObject:@{@"type": @"pointerMove", @"duration": @1, @"x": @(10 + items.count % 100), @"y": @10}];
+  }
+  [items addObject:@{@"type": @"pointerUp"}];
+  return @[@{
+    @"type": @"pointer",
+    @"id": @"mouse",
+    @"parameters": @{@"pointerType": @"mouse"},
+    @"actions": items.copy,
+  }];
+}
+
+- (id)synthesizeActions:(NSArray *)actions error:(NSError **)error
+{
+  FBW3CActionsSynthesizer *synthesizer = [[FBW3CActionsSynthesizer alloc] initWithActions:actions
+                                                                           forApplication:self.application
+                                                                             elementCache:nil
+                                                                                    error:error];
+  return [synthesizer synthesizeWithError:error];
+}
+
+- (void)testLongChainsAreCompiled
+{
+  for (NSNumber *count in @[@10, @1000]) {
+    NSError *error;
+    XCTAssertNotNil([self synthesizeActions:[self.class keyActionsWithItemsCount:count.unsignedIntegerValue]
+                                      error:&error]);
+    XCTAssertNil(error);
+    XCTAssertNotNil([self synthesizeActions:[self.class pointerActionsWithItemsCount:count.unsignedIntegerValue]
+                                      error:&error]);
+    XCTAssertNil(error);
+  }
+}
+
+- (NSUInteger)pointerEventsCountWithActions:(NSArray *)actions tolerance:(double)tolerance
+{
+  FBW3CActionsSynthesizer *synthesizer = [[FBW3CActionsSynthesizer alloc] initWithActions:actions
+                                                                           forApplication:self.application
+                                                                             elementCache:nil
+                                                                                    error:nil];
+  synthesizer.pointerMoveTolerance = tolerance;
+  NSError *error;
+  id eventRecord = [synthesizer synthesizeWithError:&error];
+  XCTAssertNil(error);
+  NSUInteger result = 0;
+  for (id eventPath in [eventRecord valueForKey:@"eventPaths"]) {
+    result += [[eventPath valueForKey:@"pointerEvents"] count];
+  }
+  return result;
+}
+
+- (void)testCollinearPointerMovesAreCoalesced
+{
+  NSMutableArray<NSDictionary<NSString *, id> *> *items = [NSMutableArray array];
+  [items addObject:@{@"type": @"pointerMove", @"duration": @1, @"x": @10, @"y": @10}];
+  [items addObject:@{@"type": @"pointerDown"}];
+  for (NSUInteger i = 1; i <= 100; i++) {
+    [items addObject:@{@"type": @"pointerMove", @"duration": @10, @"x": @(10 + i), @"y": @(10 + i % 2)}];
+  }
+  [items addObject:@{@"type": @"pointerUp"}];
+  NSArray *actions = @[@{@"type": @"pointer", @"id": @"mouse", @"actions": items.copy}];
+
+  NSUInteger rawCount = [self pointerEventsCountWithActions:actions tolerance:0];
+  NSUInteger coalescedCount = [self pointerEventsCountWithActions:actions tolerance:2];
+  XCTAssertLessThan(coalescedCount, rawCount);
+  // A zigzag, which is larger than the tolerance, must not be flattened
+  XCTAssertEqual([self pointerEventsCountWithActions:actions tolerance:0.1], rawCount);
+}
+
+- (void)testLShapedDragIsNotCoalesced
+{
+  NSArray *items = @[
+    @{@"type": @"pointerMove", @"duration": @1, @"x": @10, @"y": @10},
+    @{@"type": @"pointerDown"},
+    @{@"type": @"pointerMove", @"duration": @1, @"x": @100, @"y": @10},
+    @{@"type": @"pointerMove", @"duration": @1, @"x": @100, @"y": @100},
+    @{@"type": @"pointerUp"},
+  ];
+  NSArray *actions = @[@{@"type": @"pointer", @"id": @"mouse", @"actions": items}];
+
+  XCTAssertEqual([self pointerEventsCountWithActions:actions tolerance:2],
+                 [self pointerEventsCountWithActions:actions tolerance:0]);
+}
+
+- (void)testCollinearMovesWithDifferentSpeedsAreNotCoalesced
+{
+  NSArray *items = @[
+    @{@"type": @"pointerMove", @"duration": @1, @"x": @10, @"y": @10},
+    @{@"type": @"pointerDown"},
+    @{@"type": @"pointerMove", @"duration": @1, @"x": @50, @"y": @10},
+    @{@"type": @"pointerMove", @"duration": @500, @"x": @100, @"y": @10},
+    @{@"type": @"pointerUp"},
+  ];
+  NSArray *actions = @[@{@"type": @"pointer", @"id": @"mouse", @"actions": items}];
+
+  // Merging would spread the fast first move over the whole duration
+  XCTAssertEqual([self pointerEventsCountWithActions:actions tolerance:2],
+                 [self pointerEventsCountWithActions:actions tolerance:0]);
+}
+
+- (void)testUnbalancedKeysAreRejected
+{
+  NSArray *unbalancedChains = @[
+    @[@{@"type": @"keyDown", @"value": @"a"}],
+    @[@{@"type": @"keyUp", @"value": @"a"}],
+    @[@{@"type": @"keyDown", @"value": @"a"},
+      @{@"type": @"keyUp", @"value": @"a"},
+      @{@"type": @"keyUp", @"value": @"a"}],
+    @[@{@"type": @"keyDown", @"value": @"a"},
+      @{@"type": @"keyDown", @"value": @"a"},
+      @{@"type": @"keyUp", @"value": @"a"}],
+  ];
+  for (NSArray *items in unbalancedChains) {
+    NSError *error;
+    XCTAssertNil([self synthesizeActions:@[@{@"type": @"key", @"id": @"keyboard", @"actions": items}]
+                                   error:&error]);
+    XCTAssertNotNil(error);
+  }
+}
+
+- (void)measureKeyChainWithItemsCount:(NSUInteger)count
+{
+  NSArray *actions = [self.class keyActionsWithItemsCount:count];
+  [self measureBlock:^{
+    XCTAssertNotNil([self synthesizeActions:actions error:nil]);
+  }];
+}
+
+- (void)measurePointerChainWithItemsCount:(NSUInteger)count
+{
+  NSArray *actions = [self.class pointerActionsWithItemsCount:count];
+  [self measureBlock:^{
+    XCTAssertNotNil([self synthesizeActions:actions error:nil]);
+  }];
+}
+
+- (void)testKeyChainOf10ItemsPerformance
+{
+  [self measureKeyChainWithItemsCount:10];
+}
+
+- (void)testKeyChainOf1000ItemsPerformance
+{
+  [self measureKeyChainWithItemsCount:1000];
+}
+
+- (void)testKeyChainOf10000ItemsPerformance
+{
+  [self measureKeyChainWithItemsCount:10000];
+}
+
+- (void)testPointerChainOf10ItemsPerformance
+{
+  [self measurePointerChainWithItemsCount:10];
+}
+
+- (void)testPointerChainOf1000ItemsPerformance
+{
+  [self measurePointerChainWithItemsCount:1000];
+}
+
+- (void)testPointerChainOf10000ItemsPerformance
+{
+  [self measurePointerChainWithItemsCount:10000];
+}
+
+@end
@@ -16,7 +16,10 @@
 
 #import <XCTest/XCTest.h>
 
+#import "AMActionsOperation.h"
 #import "AMIntegrationTestCase.h"
+#import "AMW3CActionsSequence.h"
+#import "FBSession.h"
 #import "XCUIApplication+FBW3CActions.h"
 
 
@@ -370,6 +373,182 @@
   XCTAssertEqualObjects(edit.value, @"NBA");
 }
 
+- (void)testRegisteredKeysSequence
+{
+  [self switchToEditsTab];
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  [edit click];
+
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+    @"type": @"key",
+    @"id": @"keyboard",
+    @"actions": @[
+      @{@"type": @"keyDown", @"value": @"a"},
+      @{@"type": @"keyUp", @"value": @"a"},
+      @{@"type": @"keyDown", @"value": @"b"},
+      @{@"type": @"keyUp", @"value": @"b"},
+    ],
+  },
+  ];
+  NSError *error;
+  AMW3CActionsSequence *sequence = [AMW3CActionsSequence sequenceWithActions:gesture
+                                                                 application:self.testedApplication
+                                                                       error:&error];
+  XCTAssertNotNil(sequence);
+  XCTAssertNil(error);
+  XCTAssertFalse(sequence.hasElementOrigins);
+  for (NSUInteger i = 0; i < 2; i++) {
+    XCTAssertTrue([self.testedApplication am_performW3CActionsSequence:sequence
+                                                          elementCache:nil
+                                                        positionOffset:CGVectorMake(0, 0)
+                                                                 error:&error]);
+    XCTAssertNil(error);
+  }
+  XCTAssertEqualObjects(edit.value, @"abab");
+}
+
+- (void)testRegisteredSequenceWithElementOriginIsCompiledOnce
+{
+  [self switchToButtonsTab];
+  XCUIElement *checkbox = self.testedApplication.checkBoxes.firstMatch;
+
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+      @"type": @"pointer",
+      @"id": @"finger1",
+      @"parameters": @{@"pointerType": @"mouse"},
+      @"actions": @[
+          @{@"type": @"pointerMove", @"duration": @10, @"origin": checkbox, @"x": @0, @"y": @0},
+          @{@"type": @"pointerDown"},
+          @{@"type": @"pointerUp"},
+      ],
+  },
+  ];
+  NSError *error;
+  AMW3CActionsSequence *sequence = [AMW3CActionsSequence sequenceWithActions:gesture
+                                                                 application:self.testedApplication
+                                                                       error:&error];
+  XCTAssertNotNil(sequence);
+  XCTAssertTrue(sequence.hasElementOrigins);
+  id eventRecord = [sequence eventRecordWithApplication:self.testedApplication
+                                           elementCache:nil
+                                         positionOffset:CGVectorMake(0, 0)
+                                                  error:&error];
+  XCTAssertNotNil(eventRecord, @"%@", error);
+  // The element has not moved, so the previously compiled record is reused
+  XCTAssertEqual([sequence eventRecordWithApplication:self.testedApplication
+                                         elementCache:nil
+                                       positionOffset:CGVectorMake(0, 0)
+                                                error:&error], eventRecord);
+  XCTAssertNotEqual([sequence eventRecordWithApplication:self.testedApplication
+                                            elementCache:nil
+                                          positionOffset:CGVectorMake(1, 1)
+                                                   error:&error], eventRecord);
+}
+
+- (void)testAsyncKeysActions
+{
+  [self switchToEditsTab];
+  XCUIElement *edit = self.testedApplication.textFields.firstMatch;
+  [edit click];
+
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+    @"type": @"key",
+    @"id": @"keyboard",
+    @"actions": @[
+      @{@"type": @"keyDown", @"value": @"a"},
+      @{@"type": @"pause", @"duration": @500},
+      @{@"type": @"keyUp", @"value": @"a"},
+    ],
+  },
+  ];
+  NSError *error;
+  AMActionsOperation *operation = [self.testedApplication am_startW3CActions:gesture
+                                                                elementCache:nil
+                                                                       error:&error];
+  XCTAssertNotNil(operation);
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(operation.toDictionary[@"id"], operation.identifier);
+  XCTAssertTrue([operation waitUntilFinishedWithTimeout:10]);
+  XCTAssertEqual(operation.state, AMActionsOperationStateSucceeded);
+  XCTAssertEqualObjects(operation.toDictionary[@"state"], @"succeeded");
+  XCTAssertEqualObjects(edit.value, @"a");
+}
+
+- (void)testTooLongAsyncActionsAreRejected
+{
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+    @"type": @"pointer",
+    @"id": @"mouse",
+    @"actions": @[
+      @{@"type": @"pointerMove", @"duration": @10, @"x": @10, @"y": @10},
+      @{@"type": @"pause", @"duration": @(301 * 1000)},
+    ],
+  },
+  ];
+  NSError *error;
+  XCTAssertNil([self.testedApplication am_startW3CActions:gesture
+                                             elementCache:nil
+                                                    error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testRunningAsyncActionsAreAbandonedWhenSessionIsKilled
+{
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+    @"type": @"pointer",
+    @"id": @"mouse",
+    @"actions": @[
+      @{@"type": @"pointerMove", @"duration": @10, @"x": @10, @"y": @10},
+      @{@"type": @"pause", @"duration": @1000},
+    ],
+  },
+  ];
+  FBSession *session = [FBSession initWithApplication:nil];
+  NSError *error;
+  AMActionsOperation *operation = [self.testedApplication am_startW3CActions:gesture
+                                                                elementCache:nil
+                                                                       error:&error];
+  XCTAssertNotNil(operation, @"%@", error);
+  [session registerActionsOperation:operation];
+  XCTAssertEqual(session.runningActionsOperation, operation);
+
+  // The session is detached right away, while the gesture is finished in background
+  [session kill];
+  XCTAssertEqual(operation.state, AMActionsOperationStateRunning);
+  FBSession *nextSession = [FBSession initWithApplication:nil];
+  XCTAssertEqual(nextSession.runningActionsOperation, operation);
+
+  XCTAssertTrue([FBSession waitForPendingTeardownsWithTimeout:10]);
+  XCTAssertEqual(operation.state, AMActionsOperationStateFailed);
+  XCTAssertNotNil(operation.error);
+  XCTAssertNil(session.runningActionsOperation);
+  XCTAssertNil(nextSession.runningActionsOperation);
+  [nextSession kill];
+}
+
+- (void)testInvalidSequenceIsNotRegistered
+{
+  NSArray<NSDictionary<NSString *, id> *> *gesture =
+  @[@{
+    @"type": @"key",
+    @"id": @"keyboard",
+    @"actions": @[
+      @{@"type": @"keyDown", @"value": @"a"},
+    ],
+  },
+  ];
+  NSError *error;
+  XCTAssertNil([AMW3CActionsSequence sequenceWithActions:gesture
+                                             application:self.testedApplication
+                                                   error:&error]);
+  XCTAssertNotNil(error);
+}
+
 - (void)testKeysWithEmptyActions
 {
   [self switchToEditsTab];
@@ -0,0 +1,119 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+#import "NSString+FBXMLSafeString.h"
+
+static const NSUInteger ITERATIONS_COUNT = 200;
+
+@interface AMXMLSafeStringBenchmarkTests : XCTestCase
+@property (nonatomic) NSArray<NSString *> *corpus;
+@end
+
+@implementation AMXMLSafeStringBenchmarkTests
+
+- (void)setUp
+{
+  [super setUp];
+  // Resembles attribute values of a large accessibility tree
+  NSMutableArray<NSString *> *corpus = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 1000; i++) {
+    [corpus addObject:@"true"];
+    [corpus addObject:@"false"];
+    [corpus addObject:[NSString stringWithFormat:@"%lu", (unsigned long)(i % 80)]];
+    [corpus addObject:[NSString stringWithFormat:@"Row %lu", (unsigned long)i]];
+    [corpus addObject:[NSString stringWithFormat:@"_NS:%lu", (unsigned long)(i * 7)]];
+    [corpus addObject:[NSString stringWithFormat:@"Überschrift – %lu 🙂", (unsigned long)i]];
+    if (0 == i % 20) {
+      [corpus addObject:[@"" stringByPaddingToLength:4000 withString:@"Lorem ipsum dolor sit amet\n" startingAtIndex:0]];
+    }
+    if (0 == i % 50) {
+      [corpus addObject:[NSString stringWithFormat:@"Broken\u0001value %lu\u001F", (unsigned long)i]];
+    }
+  }
+  self.corpus = corpus.copy;
+}
+
++ (NSString *)referenceXmlSafeStringWithString:(NSString *)str replacement:(NSString *)replacement
+{
+  static NSMutableCharacterSet *invalidSet;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    invalidSet = [NSMutableCharacterSet characterSetWithRange:NSMakeRange(0x9, 1)];
+    [invalidSet addCharactersInRange:NSMakeRange(0xA, 1)];
+    [invalidSet addCharactersInRange:NSMakeRange(0xD, 1)];
+    [invalidSet addCharactersInRange:NSMakeRange(0x20, 0xD7FF - 0x20 + 1)];
+    [invalidSet addCharactersInRange:NSMakeRange(0xE000, 0xFFFD - 0xE000 + 1)];
+    [invalidSet addCharactersInRange:NSMakeRange(0x10000, 0x10FFFF - 0x10000 + 1)];
+    [invalidSet invert];
+  });
+  return [[str componentsSeparatedByCharactersInSet:invalidSet] componentsJoinedByString:replacement];
+}
+
+- (void)testCleanStringIsReturnedAsIs
+{
+  NSString *value = [@"" stringByPaddingToLength:1000 withString:@"Clean value 🙂\t" startingAtIndex:0];
+  XCTAssertEqual([value fb_xmlSafeStringWithReplacement:@""], value);
+  XCTAssertEqualObjects([@"" fb_xmlSafeStringWithReplacement:@"?"], @"");
+}
+
+- (void)testInvalidCharactersAreReplaced
+{
+  XCTAssertEqualObjects([@"a\u0001b\u0002" fb_xmlSafeStringWithReplacement:@"?"], @"a?b?");
+  XCTAssertEqualObjects([@"\u0000\u0000" fb_xmlSafeStringWithReplacement:@""], @"");
+  unichar nonCharacters[] = {'a', 0xFFFE, 'b', 0xFFFF};
+  NSString *value = [NSString stringWithCharacters:nonCharacters length:4];
+  XCTAssertEqualObjects([value fb_xmlSafeStringWithReplacement:@"?"], @"a?b?");
+  unichar loneSurrogates[] = {'a', 0xD800, 'b', 0xDC00};
+  value = [NSString stringWithCharacters:loneSurrogates length:4];
+  XCTAssertEqualObjects([value fb_xmlSafeStringWithReplacement:@"?"], @"a?b?");
+  NSMutableString *longValue = [[@"" stringByPaddingToLength:100 withString:@"abc" startingAtIndex:0] mutableCopy];
+  [longValue appendString:@"\u0003"];
+  XCTAssertEqualObjects([longValue fb_xmlSafeStringWithReplacement:@"?"],
+                        [[longValue substringToIndex:100] stringByAppendingString:@"?"]);
+}
+
+- (void)testResultsMatchReferenceImplementation
+{
+  for (NSString *value in self.corpus) {
+    XCTAssertEqualObjects([value fb_xmlSafeStringWithReplacement:@"?"],
+                          [self.class referenceXmlSafeStringWithString:value replacement:@"?"]);
+  }
+}
+
+- (void)testSanitizationPerformance
+{
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (NSString *value in self.corpus) {
+        [value fb_xmlSafeStringWithReplacement:@""];
+      }
+    }
+  }];
+}
+
+- (void)testReferenceSanitizationPerformance
+{
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < ITERATIONS_COUNT; i++) {
+      for (NSString *value in self.corpus) {
+        [self.class referenceXmlSafeStringWithString:value replacement:@""];
+      }
+    }
+  }];
+}
+
+@end
@@ -0,0 +1,246 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "AMIntegrationTestCase.h"
+#import "AMSnapshotTree.h"
+#import "AMXPathExpression.h"
+#import "FBXPath.h"
+
+static NSString *const kNodeIndexAttribute = @"am_nodeIndex";
+
+@interface AMXPathEngineTests : AMIntegrationTestCase
+@property (nonatomic) id<XCUIElementSnapshot> snapshot;
+@property (nonatomic) AMSnapshotTree *tree;
+@property (nonatomic) NSXMLElement *xmlRoot;
+@end
+
+/**
+ Compares results of the native XPath engine with the reference NSXMLElement-based evaluation
+ over the same snapshot of the tested application
+ */
+@implementation AMXPathEngineTests
+
+- (void)setUp
+{
+  [super setUp];
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    [self launchApplication];
+  });
+  NSError *error;
+  self.snapshot = [self.testedApplication snapshotWithError:&error];
+  XCTAssertNotNil(self.snapshot, @"%@", error);
+  self.tree = [[AMSnapshotTree alloc] initWithRootSnapshot:self.snapshot];
+  self.xmlRoot = [self xmlElementWithTree:self.tree node:0 includeIndex:YES];
+}
+
+- (NSXMLElement *)xmlElementWithTree:(AMSnapshotTree *)tree node:(NSUInteger)node includeIndex:(BOOL)includeIndex
+{
+  NSXMLElement *element = [NSXMLElement elementWithName:[tree typeNameOfNode:node]];
+  for (NSString *name in AMSnapshotTree.attributeNames) {
+    NSString *value = [tree attributeValueWithName:name ofNode:node];
+    if (nil != value) {
+      [element addAttribute:[NSXMLNode attributeWithName:name stringValue:value]];
+    }
+  }
+  if (includeIndex) {
+    [element addAttribute:[NSXMLNode attributeWithName:kNodeIndexAttribute
+                                           stringValue:[NSString stringWithFormat:@"%lu", (unsigned long)node]]];
+  }
+  for (NSUInteger child = [tree firstChildOfNode:node];
+       child != AMSnapshotTreeNoNode;
+       child = [tree nextSiblingOfNode:child]) {
+    [element addChild:[self xmlElementWithTree:tree node:child includeIndex:includeIndex]];
+  }
+  return element;
+}
+
+- (nullable NSIndexSet *)referenceMatchesForQuery:(NSString *)query error:(NSError **)error
+{
+  // FBXPath evaluates the leading slash relatively to the root element
+  NSString *fixedQuery = [query stringByReplacingOccurrencesOfString:@"^([(]*)(/)"
+                                                          withString:@"$1.$2"
+                                                             options:NSRegularExpressionSearch
+                                                               range:NSMakeRange(0, query.length)];
+  NSArray<NSXMLNode *> *nodes = [self.xmlRoot nodesForXPath:fixedQuery error:error];
+  if (nil == nodes) {
+    return nil;
+  }
+  NSMutableIndexSet *result = [NSMutableIndexSet indexSet];
+  for (NSXMLNode *node in nodes) {
+    if ([node isKindOfClass:NSXMLElement.class]) {
+      [result addIndex:(NSUInteger)[[(NSXMLElement *)node attributeForName:kNodeIndexAttribute] stringValue].integerValue];
+    }
+  }
+  return result.copy;
+}
+
+- (void)testNativeResultsConformToReference
+{
+  NSArray<NSString *> *queries = @[
+    @"//XCUIElementTypeButton",
+    @"//XCUIElementTypeButton[1]",
+    @"(//XCUIElementTypeButton)[last()]",
+    @"(//XCUIElementTypeButton)[position() > 1 and position() < last()]",
+    @"//XCUIElementTypeButton[starts-with(@identifier, \"_XCUI:\")]",
+    @"*//XCUIElementTypeButton[matches(@identifier, \"_xcui:\", \"i\")]",
+    @"/*",
+    @"/XCUIElementTypeWindow/XCUIElementTypeButton",
+    @"//XCUIElementTypeWindow/*",
+    @"//XCUIElementTypeWindow[1]//XCUIElementTypeButton[2]",
+    @"descendant::XCUIElementTypeButton[3]",
+    @"//XCUIElementTypeWindow//*[@enabled='true' and @selected='false']",
+    @"//*[@width > 100 and @height < 50]",
+    @"//*[@x >= 0][position() <= 3]",
+    @"//*[@elementType = 9]",
+    @"//*[@elementType + 1 = 10]",
+    @"//*[-@width < -100]",
+    @"//XCUIElementTypeButton/..",
+    @"//XCUIElementTypeButton/parent::*/following-sibling::*",
+    @"//XCUIElementTypeButton[last()]/preceding-sibling::*[1]",
+    @"//XCUIElementTypeStaticText/ancestor::XCUIElementTypeWindow",
+    @"//XCUIElementTypeButton/ancestor-or-self::*[2]",
+    @"//XCUIElementTypeButton/self::node()",
+    @"//XCUIElementTypeTextField/following::XCUIElementTypeButton",
+    @"//XCUIElementTypeTextField/preceding::*[3]",
+    @"//*[contains(@label, 'a') or contains(@title, 'a')]",
+    @"//*[not(@identifier)]",
+    @"//*[@label='']",
+    @"//*[count(*) > 2]",
+    @"//*[count(.//XCUIElementTypeButton) = 1]",
+    @"//*[string-length(@title) > 3]",
+    @"//*[normalize-space(@label) != '']",
+    @"//*[translate(@identifier, 'abcdefghijklmnopqrstuvwxyz', 'ABCDEFGHIJKLMNOPQRSTUVWXYZ') = upper-case(@identifier)]",
+    @"//*[substring(@identifier, 1, 5) = '_XCUI']",
+    @"//*[substring-before(@identifier, ':') = '_XCUI']",
+    @"//*[substring-after(@identifier, ':') = 'CloseWindow']",
+    @"//*[ends-with(@identifier, 'Window')]",
+    @"//*[lower-case(@identifier) = '_xcui:closewindow']",
+    @"//*[concat(@elementType, '-', @enabled) = '9-true']",
+    @"//*[name() = 'XCUIElementTypeButton']",
+    @"//*[local-name(..) = 'XCUIElementTypeWindow']",
+    @"//XCUIElementTypeButton[@title][position() mod 2 = 1]",
+    @"//XCUIElementTypeButton[floor(@width div 10) > 2]",
+    @"//*[@*='_XCUI:CloseWindow']",
+    @"//XCUIElementTypeButton/@identifier",
+    @"//XCUIElementTypeButton/text()",
+    @"//XCUIElementTypeNonExisting",
+  ];
+  for (NSString *query in queries) {
+    NSError *error;
+    AMXPathExpression *expression = [AMXPathExpression expressionWithQuery:query error:&error];
+    XCTAssertNotNil(expression, @"%@", error);
+    NSIndexSet *actual = [expression matchingNodesInTree:self.tree error:&error];
+    XCTAssertNotNil(actual, @"%@", error);
+    NSIndexSet *expected = [self referenceMatchesForQuery:query error:&error];
+    XCTAssertNotNil(expected, @"%@", error);
+    XCTAssertEqualObjects(actual, expected, @"The result of '%@' differs from the reference", query);
+  }
+}
+
+- (void)testUnsupportedQueriesAreRejected
+{
+  NSArray<NSString *> *queries = @[
+    @"//XCUIElementTypeButton[@identifier = $id]",
+    @"//XCUIElementTypeButton | //XCUIElementTypeWindow",
+    @"//*[@label < 'b']",
+    @"//*[@identifier = 1]",
+    @"//XCUIElementTypeButton/@identifier/..",
+    @"//*[lang('en')]",
+    @"namespace::*",
+    @"count(//XCUIElementTypeButton)",
+  ];
+  for (NSString *query in queries) {
+    AMXPathExpression *expression = [AMXPathExpression expressionWithQuery:query error:nil];
+    NSError *error;
+    XCTAssertTrue(nil == expression || nil == [expression matchingNodesInTree:self.tree error:&error],
+                  @"'%@' must not be evaluated natively", query);
+  }
+}
+
+- (void)testInvalidQueriesAreRejected
+{
+  for (NSString *query in @[@"//XCUIElementTypeButton[", @"//*[@label = ]", @"//*[@label = 'a]", @"//#"]) {
+    NSError *error;
+    XCTAssertNil([AMXPathExpression expressionWithQuery:query error:&error]);
+    XCTAssertNotNil(error);
+  }
+}
+
+- (void)testMatchesAreTheSameWithBothEngines
+{
+  NSString *query = @"//XCUIElementTypeButton[starts-with(@identifier, \"_XCUI:\")]";
+  BOOL useNativeXPathEngine = FBConfiguration.sharedConfiguration.useNativeXPathEngine;
+  @try {
+    FBConfiguration.sharedConfiguration.useNativeXPathEngine = YES;
+    NSArray<XCUIElement *> *nativeMatches = [FBXPath matchesWithRootElement:self.testedApplication
+                                                                   forQuery:query
+                                                      includeOnlyFirstMatch:NO];
+    FBConfiguration.sharedConfiguration.useNativeXPathEngine = NO;
+    NSArray<XCUIElement *> *referenceMatches = [FBXPath matchesWithRootElement:self.testedApplication
+                                                                      forQuery:query
+                                                         includeOnlyFirstMatch:NO];
+    XCTAssertTrue(nativeMatches.count >= 3);
+    XCTAssertEqual(nativeMatches.count, referenceMatches.count);
+    for (NSUInteger i = 0; i < nativeMatches.count; i++) {
+      XCTAssertEqualObjects(nativeMatches[i].identifier, referenceMatches[i].identifier);
+    }
+  } @finally {
+    FBConfiguration.sharedConfiguration.useNativeXPathEngine = useNativeXPathEngine;
+  }
+}
+
+- (NSArray<NSString *> *)benchmarkQueries
+{
+  return @[
+    @"//XCUIElementTypeButton[starts-with(@identifier, \"_XCUI:\")]",
+    @"//XCUIElementTypeWindow//*[@enabled='true' and @label != '']",
+    @"(//XCUIElementTypeButton)[last()]",
+    @"//XCUIElementTypeStaticText/ancestor::XCUIElementTypeWindow",
+  ];
+}
+
+- (void)testNativeEvaluationPerformance
+{
+  NSArray<NSString *> *queries = self.benchmarkQueries;
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < 100; i++) {
+      // The tree is rebuilt for every query the same way FBXPath does it
+      for (NSString *query in queries) {
+        AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithRootSnapshot:self.snapshot];
+        [[AMXPathExpression expressionWithQuery:query error:nil] matchingNodesInTree:tree error:nil];
+      }
+    }
+  }];
+}
+
+- (void)testReferenceEvaluationPerformance
+{
+  NSArray<NSString *> *queries = self.benchmarkQueries;
+  [self measureBlock:^{
+    for (NSUInteger i = 0; i < 100; i++) {
+      for (NSString *query in queries) {
+        AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithRootSnapshot:self.snapshot];
+        self.xmlRoot = [self xmlElementWithTree:tree node:0 includeIndex:YES];
+        [self referenceMatchesForQuery:query error:nil];
+      }
+    }
+  }];
+}
+
+@end
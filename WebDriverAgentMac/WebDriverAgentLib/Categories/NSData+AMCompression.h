@@ -0,0 +1,58 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The name of gzip HTTP content encoding */
+extern NSString *const AM_CONTENT_ENCODING_GZIP;
+/*! The name of deflate (zlib) HTTP content encoding */
+extern NSString *const AM_CONTENT_ENCODING_DEFLATE;
+
+/**
+ Returns zlib window bits value, which makes deflate to produce the given HTTP content encoding
+
+ @param encoding Either AM_CONTENT_ENCODING_GZIP or AM_CONTENT_ENCODING_DEFLATE
+ @return The window bits value to be passed to deflateInit2 or zero if the encoding is not supported
+ */
+int AMZlibWindowBitsForContentEncoding(NSString *encoding);
+
+/*! zlib compression level used for HTTP responses */
+extern const int AM_HTTP_COMPRESSION_LEVEL;
+
+@interface NSData (AMCompression)
+
+/**
+ Compresses the data using the given HTTP content encoding
+
+ @param encoding Either AM_CONTENT_ENCODING_GZIP or AM_CONTENT_ENCODING_DEFLATE
+ @return Compressed data or nil if the encoding is not supported or the compression has failed
+ */
+- (nullable NSData *)am_compressedDataWithContentEncoding:(NSString *)encoding;
+
+/**
+ Selects the most preferred content encoding supported by the server
+ from the value of Accept-Encoding HTTP request header
+
+ @param acceptEncoding The value of Accept-Encoding header, for example 'gzip, deflate;q=0.5'
+ @return One of the supported content encoding names or nil if none of them is acceptable
+ */
++ (nullable NSString *)am_preferredContentEncodingWithAcceptEncoding:(nullable NSString *)acceptEncoding;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,105 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "NSData+AMCompression.h"
+
+#import <zlib.h>
+
+NSString *const AM_CONTENT_ENCODING_GZIP = @"gzip";
+NSString *const AM_CONTENT_ENCODING_DEFLATE = @"deflate";
+
+// Adding 16 to the default window bits makes zlib to write gzip header and trailer
+static const int AM_ZLIB_WINDOW_BITS = 15;
+static const int AM_GZIP_WINDOW_BITS = AM_ZLIB_WINDOW_BITS + 16;
+// Large payloads are mostly base64-encoded PNGs or repetitive XML/JSON,
+// so the fastest compression level already gives most of the size reduction
+const int AM_HTTP_COMPRESSION_LEVEL = Z_BEST_SPEED;
+
+int AMZlibWindowBitsForContentEncoding(NSString *encoding)
+{
+  if ([encoding isEqualToString:AM_CONTENT_ENCODING_GZIP]) {
+    return AM_GZIP_WINDOW_BITS;
+  }
+  if ([encoding isEqualToString:AM_CONTENT_ENCODING_DEFLATE]) {
+    return AM_ZLIB_WINDOW_BITS;
+  }
+  return 0;
+}
+
+@implementation NSData (AMCompression)
+
+- (NSData *)am_compressedDataWithContentEncoding:(NSString *)encoding
+{
+  int windowBits = AMZlibWindowBitsForContentEncoding(encoding);
+  if (0 == windowBits || self.length > UINT_MAX) {
+    return nil;
+  }
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, AM_HTTP_COMPRESSION_LEVEL, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return nil;
+  }
+  uLong bound = deflateBound(&stream, (uLong)self.length);
+  NSMutableData *result = [NSMutableData dataWithLength:bound];
+  stream.next_in = (Bytef *)self.bytes;
+  stream.avail_in = (uInt)self.length;
+  stream.next_out = (Bytef *)result.mutableBytes;
+  stream.avail_out = (uInt)bound;
+  int status = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    return nil;
+  }
+  result.length = stream.total_out;
+  return result.copy;
+}
+
++ (NSString *)am_preferredContentEncodingWithAcceptEncoding:(NSString *)acceptEncoding
+{
+  if (nil == acceptEncoding || 0 == acceptEncoding.length) {
+    return nil;
+  }
+
+  NSString *bestEncoding = nil;
+  double bestQuality = 0;
+  NSCharacterSet *whitespaces = NSCharacterSet.whitespaceCharacterSet;
+  for (NSString *item in [acceptEncoding componentsSeparatedByString:@","]) {
+    NSArray<NSString *> *parts = [item componentsSeparatedByString:@";"];
+    NSString *name = [[parts.firstObject stringByTrimmingCharactersInSet:whitespaces] lowercaseString];
+    double quality = 1;
+    for (NSUInteger i = 1; i < parts.count; i++) {
+      NSString *param = [[parts[i] stringByTrimmingCharactersInSet:whitespaces] lowercaseString];
+      if ([param hasPrefix:@"q="]) {
+        quality = [[param substringFromIndex:2] doubleValue];
+      }
+    }
+    if (![name isEqualToString:AM_CONTENT_ENCODING_GZIP]
+        && ![name isEqualToString:AM_CONTENT_ENCODING_DEFLATE]) {
+      continue;
+    }
+    // gzip wins over deflate if both have the same quality, since some clients
+    // incorrectly expect raw deflate streams without zlib headers
+    if (quality > bestQuality
+        || (quality == bestQuality && quality > 0 && [name isEqualToString:AM_CONTENT_ENCODING_GZIP])) {
+      bestEncoding = name;
+      bestQuality = quality;
+    }
+  }
+  return bestEncoding;
+}
+
+@end
@@ -19,7 +19,8 @@ NS_ASSUME_NONNULL_BEGIN
  @param replacement The string to be used as a replacement for invalid XML characters
  @return The string where all characters, which are not members of
          XML Character Range definition (http://www.w3.org/TR/2008/REC-xml-20081126/#charsets),
-         are replaced
+         are replaced. An immutable copy of the receiver is returned
+         if it does not contain invalid characters
  */
 - (NSString *)fb_xmlSafeStringWithReplacement:(NSString *)replacement;
 
@@ -9,23 +9,124 @@
 
 #import "NSString+FBXMLSafeString.h"
 
+#import <simd/simd.h>
+
+// Strings up to this length are copied to the stack if their storage is not directly accessible
+static const NSUInteger FBStackBufferLength = 256;
+
+/**
+ Checks the character against the most common part of the valid XML range [#x20-#xD7FF]
+ */
+static inline BOOL FBIsCommonXMLCharacter(unichar c)
+{
+  return c >= 0x20 && c < 0xD800;
+}
+
+/**
+ Returns the count of leading characters belonging to the common XML range.
+ Blocks of 16 characters are checked at once
+ */
+static NSUInteger FBCommonXMLCharactersPrefixLength(const unichar *chars, NSUInteger length)
+{
+  NSUInteger index = 0;
+  for (; index + 16 <= length; index += 16) {
+    simd_ushort16 block;
+    memcpy(&block, chars + index, sizeof(block));
+    if (simd_any((block < 0x20) | (block >= 0xD800))) {
+      break;
+    }
+  }
+  while (index < length && FBIsCommonXMLCharacter(chars[index])) {
+    index++;
+  }
+  return index;
+}
+
+/**
+ Returns the count of UTF-16 units occupied by the valid XML character at the given index
+ or zero if the character is not valid.
+ Char ::= #x9 | #xA | #xD | [#x20-#xD7FF] | [#xE000-#xFFFD] | [#x10000-#x10FFFF]
+ */
+static inline NSUInteger FBValidXMLCharacterLength(const unichar *chars, NSUInteger length, NSUInteger index)
+{
+  unichar c = chars[index];
+  if (FBIsCommonXMLCharacter(c) || 0x9 == c || 0xA == c || 0xD == c || (c >= 0xE000 && c <= 0xFFFD)) {
+    return 1;
+  }
+  if (CFStringIsSurrogateHighCharacter(c)
+      && index + 1 < length
+      && CFStringIsSurrogateLowCharacter(chars[index + 1])) {
+    return 2;
+  }
+  return 0;
+}
+
+/**
+ Replaces invalid characters in the given buffer
+
+ @return The sanitized string or nil if all characters are valid
+ */
+static NSString *FBXMLSafeStringWithCharacters(const unichar *chars, NSUInteger length, NSString *replacement)
+{
+  NSMutableString *result = nil;
+  NSUInteger copiedLength = 0;
+  NSUInteger index = 0;
+  while (index < length) {
+    index += FBCommonXMLCharactersPrefixLength(chars + index, length - index);
+    if (index >= length) {
+      break;
+    }
+    NSUInteger characterLength = FBValidXMLCharacterLength(chars, length, index);
+    if (characterLength > 0) {
+      index += characterLength;
+      continue;
+    }
+
+    if (nil == result) {
+      result = [NSMutableString stringWithCapacity:length];
+    }
+    CFStringAppendCharacters((__bridge CFMutableStringRef)result, chars + copiedLength, (CFIndex)(index - copiedLength));
+    [result appendString:replacement];
+    copiedLength = ++index;
+  }
+  if (nil == result) {
+    return nil;
+  }
+  CFStringAppendCharacters((__bridge CFMutableStringRef)result, chars + copiedLength, (CFIndex)(length - copiedLength));
+  return result.copy;
+}
+
 @implementation NSString (FBXMLSafeString)
 
 - (NSString *)fb_xmlSafeStringWithReplacement:(NSString *)replacement
 {
-  static NSMutableCharacterSet *invalidSet;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    // Char ::= #x9 | #xA | #xD | [#x20-#xD7FF] | [#xE000-#xFFFD] | [#x10000-#x10FFFF]
-    invalidSet = [NSMutableCharacterSet characterSetWithRange:NSMakeRange(0x9, 1)];
-    [invalidSet addCharactersInRange:NSMakeRange(0xA, 1)];
-    [invalidSet addCharactersInRange:NSMakeRange(0xD, 1)];
-    [invalidSet addCharactersInRange:NSMakeRange(0x20, 0xD7FF - 0x20 + 1)];
-    [invalidSet addCharactersInRange:NSMakeRange(0xE000, 0xFFFD - 0xE000 + 1)];
-    [invalidSet addCharactersInRange:NSMakeRange(0x10000, 0x10FFFF - 0x10000 + 1)];
-    [invalidSet invert];
-  });
-  return [[self componentsSeparatedByCharactersInSet:invalidSet] componentsJoinedByString:replacement];
+  NSUInteger length = self.length;
+  if (0 == length) {
+    return self.copy;
+  }
+
+  const unichar *chars = CFStringGetCharactersPtr((__bridge CFStringRef)self);
+  unichar stackBuffer[FBStackBufferLength];
+  unichar *heapBuffer = NULL;
+  if (NULL == chars) {
+    unichar *buffer = stackBuffer;
+    if (length > FBStackBufferLength) {
+      heapBuffer = malloc(length * sizeof(unichar));
+      if (NULL == heapBuffer) {
+        @throw [NSException exceptionWithName:NSMallocException
+                                       reason:@"Cannot allocate the buffer for XML string sanitization"
+                                     userInfo:nil];
+      }
+      buffer = heapBuffer;
+    }
+    [self getCharacters:buffer range:NSMakeRange(0, length)];
+    chars = buffer;
+  }
+
+  NSString *result = FBXMLSafeStringWithCharacters(chars, length, replacement);
+  free(heapBuffer);
+  // Clean strings are the overwhelmingly common case and are returned as is
+  return result ?: self.copy;
 }
 
 @end
@@ -35,6 +35,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSString *)am_path;
 
+/**
+ Retrieves the process identifier of the running app instance
+
+ @returns process identifier or zero if the app is not running
+ */
+- (pid_t)am_processID;
+
 /**
  Retrieves the main screen rect
  */
@@ -29,6 +29,11 @@
   return [[self valueForKey:@"_applicationImpl"] valueForKey:@"_path"];
 }
 
+- (pid_t)am_processID
+{
+  return [[self valueForKey:@"processID"] intValue];
+}
+
 - (CGRect)am_screenRect
 {
   return NSScreen.mainScreen.frame;
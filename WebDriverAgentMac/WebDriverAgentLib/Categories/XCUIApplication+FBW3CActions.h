@@ -9,7 +9,7 @@
 
 #import <XCTest/XCTest.h>
 
-@class FBElementCache;
+@class AMActionsOperation, AMW3CActionsSequence, FBElementCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -27,6 +27,33 @@ NS_ASSUME_NONNULL_BEGIN
                 elementCache:(nullable FBElementCache *)elementCache
                        error:(NSError **)error;
 
+/**
+ Perform the previously validated actions sequence in scope of the current application.
+
+ @param sequence The sequence to perform
+ @param elementCache Cached elements mapping to resolve element origins of the sequence with
+ @param positionOffset Offset to be added to coordinates of all pointer move items with the viewport origin
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return YES If the sequence has been successfully performed without errors
+ */
+- (BOOL)am_performW3CActionsSequence:(AMW3CActionsSequence *)sequence
+                        elementCache:(nullable FBElementCache *)elementCache
+                      positionOffset:(CGVector)positionOffset
+                               error:(NSError **)error;
+
+/**
+ Validate the given actions and start performing them in background.
+ Element origins are resolved before this method returns.
+
+ @param actions Array of dictionaries, whose format is described in W3C spec
+ @param elementCache Cached elements mapping for the current application
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return The started operation or nil if the actions are invalid
+ */
+- (nullable AMActionsOperation *)am_startW3CActions:(NSArray *)actions
+                                       elementCache:(nullable FBElementCache *)elementCache
+                                              error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,10 +9,13 @@
 
 #import "XCUIApplication+FBW3CActions.h"
 
+#import "AMActionsOperation.h"
+#import "AMW3CActionsSequence.h"
 #import "AMXCUIDeviceWrapper.h"
 #import "FBBaseActionsSynthesizer.h"
 #import "FBErrorBuilder.h"
 #import "FBW3CActionsSynthesizer.h"
+#import "XCSynthesizedEventRecord.h"
 
 #define MAX_ACTIONS_DURATION_SEC 300
 
@@ -33,4 +36,42 @@
   return nil == eventRecord ? NO : [AMXCUIDeviceWrapper.sharedDevice synthesizeEvent:eventRecord error:error];
 }
 
+- (BOOL)am_performW3CActionsSequence:(AMW3CActionsSequence *)sequence
+                        elementCache:(FBElementCache *)elementCache
+                      positionOffset:(CGVector)positionOffset
+                               error:(NSError **)error
+{
+  XCSynthesizedEventRecord *eventRecord = [sequence eventRecordWithApplication:self
+                                                                  elementCache:elementCache
+                                                                positionOffset:positionOffset
+                                                                         error:error];
+  return nil == eventRecord ? NO : [AMXCUIDeviceWrapper.sharedDevice synthesizeEvent:eventRecord error:error];
+}
+
+- (AMActionsOperation *)am_startW3CActions:(NSArray *)actions
+                              elementCache:(FBElementCache *)elementCache
+                                     error:(NSError **)error
+{
+  FBBaseActionsSynthesizer *synthesizer = [[FBW3CActionsSynthesizer alloc] initWithActions:actions
+                                                                            forApplication:self
+                                                                              elementCache:elementCache
+                                                                                     error:error];
+  if (nil == synthesizer) {
+    return nil;
+  }
+  XCSynthesizedEventRecord *eventRecord = [synthesizer synthesizeWithError:error];
+  if (nil == eventRecord) {
+    return nil;
+  }
+  // The synchronous synthesis gives up after the same time
+  if (eventRecord.maximumOffset > MAX_ACTIONS_DURATION_SEC) {
+    [[[FBErrorBuilder builder]
+      withDescriptionFormat:@"The actions chain must not last longer than %@ seconds. %.3f seconds are requested instead",
+      @(MAX_ACTIONS_DURATION_SEC), eventRecord.maximumOffset]
+     buildError:error];
+    return nil;
+  }
+  return [AMActionsOperation startedOperationWithEventRecord:eventRecord];
+}
+
 @end
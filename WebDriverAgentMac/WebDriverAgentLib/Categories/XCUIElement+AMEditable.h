@@ -18,10 +18,37 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/*! Types the text character by character. This is the slowest, but the most reliable mode */
+extern NSString *const AM_TEXT_INPUT_MODE_TYPING;
+/*! Puts the text to the pasteboard and pastes it with Cmd+V. The previous pasteboard content is restored afterwards */
+extern NSString *const AM_TEXT_INPUT_MODE_PASTE;
+/*! Assigns the accessibility value of the element directly. Falls back to typing if the value is not settable */
+extern NSString *const AM_TEXT_INPUT_MODE_VALUE;
+
+/**
+ @return The list of all supported text input modes
+ */
+NSArray<NSString *> *AMSupportedTextInputModes(void);
+
 @interface XCUIElement (AMEditable)
 
+/**
+ Sets the value of the element using the text input mode from the current configuration
+
+ @param value Either a string or an array of strings to be joined
+ @throws FBInvalidElementStateException if the value cannot be set
+ */
 - (void)am_setValue:(id)value;
 
+/**
+ Sets the value of the element using the given text input mode
+
+ @param value Either a string or an array of strings to be joined
+ @param inputMode One of the supported text input modes or nil to use the current configuration value
+ @throws FBInvalidElementStateException if the value cannot be set
+ */
+- (void)am_setValue:(id)value inputMode:(nullable NSString *)inputMode;
+
 /**
  Clears text on element.
  It will try to activate keyboard on element, if element has no keyboard focus.
@@ -31,6 +58,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)am_clearTextWithError:(NSError **)error;
 
+/**
+ Types the given keys within a single synthesized event respecting the typingFrequency setting.
+ The element is clicked first if it has no keyboard focus.
+
+ @param keys The list of key values to type. See XCUIKeyboardKey for special key values
+ @param modifierFlags The list of XCUIKeyModifierFlags to apply to the corresponding keys.
+ Must have the same length as keys
+ @param error If there is an error, upon return contains an NSError object that describes the problem.
+ @return YES if the operation succeeds, otherwise NO.
+ */
+- (BOOL)am_typeKeys:(NSArray<NSString *> *)keys
+      modifierFlags:(NSArray<NSNumber *> *)modifierFlags
+              error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
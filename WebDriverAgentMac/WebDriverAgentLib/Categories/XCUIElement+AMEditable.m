@@ -16,12 +16,34 @@
 
 #import "XCUIElement+AMEditable.h"
 
+#import <ApplicationServices/ApplicationServices.h>
+
+#import "AMKeyboardUtils.h"
+#import "AMPasteboard.h"
+#import "AMXCUIDeviceWrapper.h"
+#import "FBConfiguration.h"
 #import "FBErrorBuilder.h"
 #import "FBExceptions.h"
+#import "FBLogger.h"
+#import "FBRunLoopSpinner.h"
+#import "XCPointerEventPath.h"
+#import "XCSynthesizedEventRecord.h"
 #import "XCUIElement+AMAttributes.h"
 
 #define MAX_CLEAR_RETRIES 2
 
+static const NSTimeInterval PASTE_COMPLETION_TIMEOUT = 1.0;
+static const CGFloat AX_FRAME_TOLERANCE = 1.0;
+
+NSString *const AM_TEXT_INPUT_MODE_TYPING = @"typing";
+NSString *const AM_TEXT_INPUT_MODE_PASTE = @"paste";
+NSString *const AM_TEXT_INPUT_MODE_VALUE = @"value";
+
+NSArray<NSString *> *AMSupportedTextInputModes(void)
+{
+  return @[AM_TEXT_INPUT_MODE_TYPING, AM_TEXT_INPUT_MODE_PASTE, AM_TEXT_INPUT_MODE_VALUE];
+}
+
 @interface NSString (AMTyping)
 
 - (NSString *)am_repeatTimes:(NSUInteger)times;
@@ -47,20 +69,206 @@
 
 @implementation XCUIElement (AMEditable)
 
+- (void)am_focusIfNeeded
+{
+  // Applications receive keyboard events without being clicked
+  if (![self isKindOfClass:XCUIApplication.class] && !self.am_hasKeyboardInputFocus) {
+    [self click];
+  }
+}
+
+- (BOOL)am_synthesizeText:(NSString *)text error:(NSError **)error
+{
+  // XCUIElement's typeText: API always uses the default XCTest typing frequency
+  XCPointerEventPath *eventPath = [[XCPointerEventPath alloc] initForTextInput];
+  [eventPath typeText:text
+             atOffset:0.0
+          typingSpeed:AMTypingSpeed()
+         shouldRedact:self.elementType == XCUIElementTypeSecureTextField];
+  XCSynthesizedEventRecord *eventRecord = [[XCSynthesizedEventRecord alloc] initWithName:@"Type Text"];
+  [eventRecord addPointerEventPath:eventPath];
+  return [AMXCUIDeviceWrapper.sharedDevice synthesizeEvent:eventRecord error:error];
+}
+
 - (BOOL)am_typeText:(NSString *)text error:(NSError **)error
 {
   if (![self am_clearTextWithError:error]) {
     return NO;
   }
-  [self typeText:text];
+  return 0 == text.length || [self am_synthesizeText:text error:error];
+}
+
+- (BOOL)am_typeKeys:(NSArray<NSString *> *)keys
+      modifierFlags:(NSArray<NSNumber *> *)modifierFlags
+              error:(NSError **)error
+{
+  if (keys.count != modifierFlags.count) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"The amount of modifier flags (%lu) must match the amount of keys (%lu)",
+             (unsigned long)modifierFlags.count, (unsigned long)keys.count]
+            buildError:error];
+  }
+  if (0 == keys.count) {
+    return YES;
+  }
+
+  [self am_focusIfNeeded];
+  NSTimeInterval keystrokeInterval = 1.0 / AMTypingSpeed();
+  XCPointerEventPath *eventPath = [[XCPointerEventPath alloc] initForTextInput];
+  for (NSUInteger index = 0; index < keys.count; index++) {
+    [eventPath typeKey:keys[index]
+             modifiers:modifierFlags[index].unsignedIntegerValue
+              atOffset:index * keystrokeInterval];
+  }
+  XCSynthesizedEventRecord *eventRecord = [[XCSynthesizedEventRecord alloc] initWithName:@"Type Keys"];
+  [eventRecord addPointerEventPath:eventPath];
+  return [AMXCUIDeviceWrapper.sharedDevice synthesizeEvent:eventRecord error:error];
+}
+
+- (BOOL)am_pasteText:(NSString *)text error:(NSError **)error
+{
+  if (![self am_clearTextWithError:error]) {
+    return NO;
+  }
+  if (0 == text.length) {
+    return YES;
+  }
+
+  NSArray<NSPasteboardItem *> *backup = [AMPasteboard backupItems];
+  @try {
+    if (![AMPasteboard setData:(NSData *)[text dataUsingEncoding:NSUTF8StringEncoding]
+                       forType:@"plaintext"
+                         error:error]) {
+      return NO;
+    }
+    id valueBeforePaste = self.value;
+    BOOL isSecure = self.elementType == XCUIElementTypeSecureTextField;
+    [self typeKey:@"v" modifierFlags:XCUIKeyModifierCommand];
+    // Applications read the pasteboard asynchronously, so it cannot be restored right away
+    BOOL isPasted = [[[FBRunLoopSpinner new] timeout:PASTE_COMPLETION_TIMEOUT] spinUntilTrue:^BOOL{
+      id value = self.value;
+      // Secure fields never reveal their actual value, so any change is the best possible evidence
+      return isSecure
+        ? value != valueBeforePaste && ![value isEqual:valueBeforePaste]
+        : [value isEqual:text];
+    }];
+    if (!isPasted && !isSecure) {
+      return [[[FBErrorBuilder builder]
+               withDescriptionFormat:@"The text pasted into '%@' has been rejected by the application", self.description]
+              buildError:error];
+    }
+  } @finally {
+    [AMPasteboard restoreItems:backup];
+  }
   return YES;
 }
 
-- (BOOL)am_clearTextWithError:(NSError **)error
+- (BOOL)am_assignAccessibilityValue:(NSString *)text error:(NSError **)error
 {
-  if (!self.am_hasKeyboardInputFocus) {
-    [self click];
+  CGRect frame = self.frame;
+  if (CGRectIsEmpty(frame)) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"'%@' has no visible frame", self.description]
+            buildError:error];
+  }
+
+  // XCUIElement does not expose its accessibility element, although both XCTest
+  // and the accessibility API share the same top-left based screen coordinates,
+  // so the element could be hit-tested at its center
+  AXUIElementRef systemWide = AXUIElementCreateSystemWide();
+  AXUIElementRef axElement = NULL;
+  AXError axError = AXUIElementCopyElementAtPosition(systemWide,
+                                                     (float)CGRectGetMidX(frame),
+                                                     (float)CGRectGetMidY(frame),
+                                                     &axElement);
+  CFRelease(systemWide);
+  if (kAXErrorSuccess != axError || NULL == axElement) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"Cannot retrieve the accessibility element of '%@' (error %d)", self.description, axError]
+            buildError:error];
+  }
+
+  // The hit-tested element might be an overlay or a child of the expected one
+  if (![self am_matchesAccessibilityElement:axElement]) {
+    CFRelease(axElement);
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"The accessibility element at the center of '%@' is a different element", self.description]
+            buildError:error];
+  }
+
+  Boolean isSettable = false;
+  axError = AXUIElementIsAttributeSettable(axElement, kAXValueAttribute, &isSettable);
+  if (kAXErrorSuccess == axError && isSettable) {
+    axError = AXUIElementSetAttributeValue(axElement, kAXValueAttribute, (__bridge CFStringRef)text);
+  }
+  CFRelease(axElement);
+  if (!isSettable || kAXErrorSuccess != axError) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"The accessibility value of '%@' is not settable (error %d)", self.description, axError]
+            buildError:error];
+  }
+
+  // Secure fields never reveal their actual value
+  if (self.elementType != XCUIElementTypeSecureTextField && ![self.value isEqual:text]) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"The accessibility value of '%@' has been rejected by the application", self.description]
+            buildError:error];
+  }
+  return YES;
+}
+
+- (BOOL)am_matchesAccessibilityElement:(AXUIElementRef)axElement
+{
+  static NSDictionary<NSNumber *, NSString *> *rolesByElementType;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    rolesByElementType = @{
+      @(XCUIElementTypeTextField): (__bridge NSString *)kAXTextFieldRole,
+      @(XCUIElementTypeSecureTextField): (__bridge NSString *)kAXTextFieldRole,
+      @(XCUIElementTypeSearchField): (__bridge NSString *)kAXTextFieldRole,
+      @(XCUIElementTypeTextView): (__bridge NSString *)kAXTextAreaRole,
+      @(XCUIElementTypeComboBox): (__bridge NSString *)kAXComboBoxRole,
+    };
+  });
+
+  NSString *expectedRole = rolesByElementType[@(self.elementType)];
+  if (nil == expectedRole) {
+    return NO;
   }
+  CFTypeRef role = NULL;
+  if (kAXErrorSuccess != AXUIElementCopyAttributeValue(axElement, kAXRoleAttribute, &role)
+      || ![(__bridge_transfer id)role isEqual:expectedRole]) {
+    return NO;
+  }
+
+  CFTypeRef positionValue = NULL;
+  CFTypeRef sizeValue = NULL;
+  if (kAXErrorSuccess != AXUIElementCopyAttributeValue(axElement, kAXPositionAttribute, &positionValue)) {
+    return NO;
+  }
+  if (kAXErrorSuccess != AXUIElementCopyAttributeValue(axElement, kAXSizeAttribute, &sizeValue)) {
+    CFRelease(positionValue);
+    return NO;
+  }
+  CGPoint position = CGPointZero;
+  CGSize size = CGSizeZero;
+  BOOL hasFrame = AXValueGetValue((AXValueRef)positionValue, kAXValueCGPointType, &position)
+    && AXValueGetValue((AXValueRef)sizeValue, kAXValueCGSizeType, &size);
+  CFRelease(positionValue);
+  CFRelease(sizeValue);
+  if (!hasFrame) {
+    return NO;
+  }
+  CGRect frame = self.frame;
+  return fabs(position.x - frame.origin.x) <= AX_FRAME_TOLERANCE
+    && fabs(position.y - frame.origin.y) <= AX_FRAME_TOLERANCE
+    && fabs(size.width - frame.size.width) <= AX_FRAME_TOLERANCE
+    && fabs(size.height - frame.size.height) <= AX_FRAME_TOLERANCE;
+}
+
+- (BOOL)am_clearTextWithError:(NSError **)error
+{
+  [self am_focusIfNeeded];
 
   id currentValue = self.value;
   if (nil != currentValue && ![currentValue isKindOfClass:NSString.class]) {
@@ -74,6 +282,33 @@
     return YES;
   }
 
+  NSString *placeholderValue = self.placeholderValue;
+  if ([self am_clearTextBySelectingAllWithPlaceholderValue:placeholderValue]) {
+    return YES;
+  }
+  return [self am_clearTextByTypingWithValue:(NSString *)self.value
+                            placeholderValue:placeholderValue
+                                       error:error];
+}
+
+- (BOOL)am_clearTextBySelectingAllWithPlaceholderValue:(nullable NSString *)placeholderValue
+{
+  // Selecting the whole content and deleting it only costs two key events
+  // no matter how long the text is
+  [self typeKey:@"a" modifierFlags:XCUIKeyModifierCommand];
+  [self typeKey:XCUIKeyboardKeyDelete modifierFlags:XCUIKeyModifierNone];
+
+  id currentValue = self.value;
+  if (nil == currentValue || 0 == [currentValue am_visualLength]) {
+    return YES;
+  }
+  return nil != placeholderValue && [currentValue isEqual:placeholderValue];
+}
+
+- (BOOL)am_clearTextByTypingWithValue:(NSString *)currentValue
+                     placeholderValue:(nullable NSString *)placeholderValue
+                                error:(NSError **)error
+{
   static NSString *backspaceDeleteSequence;
   static dispatch_once_t onceToken;
   dispatch_once(&onceToken, ^{
@@ -82,18 +317,18 @@
   });
 
   NSUInteger retry = 0;
-  NSString *placeholderValue = self.placeholderValue;
   NSUInteger preClearTextLength = [currentValue am_visualLength];
   do {
     if (retry >= MAX_CLEAR_RETRIES - 1) {
       // Last chance retry. Double-click the field to select its content
       [self doubleClick];
-      [self typeText:backspaceDeleteSequence];
-      return YES;
+      return [self am_synthesizeText:backspaceDeleteSequence error:error];
     }
 
     NSString *textToType = [backspaceDeleteSequence am_repeatTimes:preClearTextLength];
-    [self typeText:textToType];
+    if (![self am_synthesizeText:textToType error:error]) {
+      return NO;
+    }
 
     currentValue = self.value;
     if (nil != placeholderValue && [currentValue isEqualToString:placeholderValue]) {
@@ -108,6 +343,11 @@
 }
 
 - (void)am_setValue:(id)value
+{
+  [self am_setValue:value inputMode:nil];
+}
+
+- (void)am_setValue:(id)value inputMode:(nullable NSString *)inputMode
 {
   NSString *textToType = [value isKindOfClass:NSArray.class]
     ? [value componentsJoinedByString:@""]
@@ -124,8 +364,22 @@
     [self adjustToNormalizedSliderPosition:sliderValue];
     return;
   }
+  NSString *mode = inputMode ?: FBConfiguration.sharedConfiguration.textInputMode;
   NSError *error;
-  if (![self am_typeText:textToType error:&error]) {
+  BOOL isSuccessful;
+  if ([mode isEqualToString:AM_TEXT_INPUT_MODE_VALUE]) {
+    isSuccessful = [self am_assignAccessibilityValue:textToType error:&error];
+    if (!isSuccessful) {
+      [FBLogger logFmt:@"Falling back to typing: %@", error.localizedDescription];
+      error = nil;
+      isSuccessful = [self am_typeText:textToType error:&error];
+    }
+  } else if ([mode isEqualToString:AM_TEXT_INPUT_MODE_PASTE]) {
+    isSuccessful = [self am_pasteText:textToType error:&error];
+  } else {
+    isSuccessful = [self am_typeText:textToType error:&error];
+  }
+  if (!isSuccessful) {
     @throw [NSException exceptionWithName:FBInvalidElementStateException
                                    reason:error.description
                                  userInfo:@{}];
@@ -32,7 +32,8 @@ NS_ASSUME_NONNULL_BEGIN
  Single backtick means the predicate expression is applied to the current children. It is the direct alternative of matchingPredicate: query selector.
  Single dollar sign means the predicate expression is applied to all the descendants of the current element(s). It is the direct alternative of containingPredicate: query selector.
  Predicate expression should be always put before the index, but never after it. All predicate expressions are executed in the same exact order, which is set in the chain query.
- It is not recommended to set explicit indexes for intermediate chain elements, because it slows down the lookup speed.
+ Chains with explicit indexes for intermediate elements are evaluated over a single snapshot of the element tree
+ and only the final matches are resolved, so their lookup speed does not degrade with the count of such indexes.
  
  Indirect descendant search requests are pretty similar to requests above:
  ** /XCUIElementTypeCell[`name BEGINSWITH "A"`][-1]/XCUIElementTypeButton[10] - select the 10-th child button of the very last cell in the tree, whose name starts with 'A'.
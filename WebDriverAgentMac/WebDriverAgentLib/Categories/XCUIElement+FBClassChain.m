@@ -9,6 +9,8 @@
 
 #import "XCUIElement+FBClassChain.h"
 
+#import "AMSnapshotUtils.h"
+#import "AMTrace.h"
 #import "FBClassChainQueryParser.h"
 #import "FBExceptions.h"
 #import "XCUIElementQuery+AMHelpers.h"
@@ -24,6 +26,10 @@
     @throw [NSException exceptionWithName:FBClassChainQueryParseException reason:error.localizedDescription userInfo:error.userInfo];
     return nil;
   }
+  if ([self.class fb_hasIndexedIntermediateItems:parsedChain]) {
+    return [self fb_descendantsMatchingClassChainInSnapshot:parsedChain
+                                shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
+  }
   NSMutableArray<FBClassChainItem *> *lookupChain = parsedChain.elements.mutableCopy;
   FBClassChainItem *chainItem = lookupChain.firstObject;
   XCUIElement *currentRoot = self;
@@ -80,6 +86,141 @@
   return query;
 }
 
+#pragma mark - Single snapshot evaluation
+
++ (BOOL)fb_hasIndexedIntermediateItems:(FBClassChain *)chain
+{
+  NSArray<FBClassChainItem *> *items = chain.elements;
+  for (NSUInteger i = 0; i + 1 < items.count; i++) {
+    if (nil != items[i].position && 0 != items[i].position.integerValue) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+/**
+ Evaluates the whole chain over a single snapshot of the current element's tree.
+ Each resolved intermediate index would otherwise require a separate query (and a separate snapshot).
+ Only the final matches are resolved to elements.
+ */
+- (NSArray<XCUIElement *> *)fb_descendantsMatchingClassChainInSnapshot:(FBClassChain *)chain
+                                           shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
+{
+  NSError *error;
+  AMTraceSpan *snapshotSpan = [AMTrace beginSpanWithName:@"snapshot"];
+  id<XCUIElementSnapshot> rootSnapshot = [self snapshotWithError:&error];
+  [snapshotSpan end];
+  if (nil == rootSnapshot) {
+    NSString *reason = [NSString stringWithFormat:@"Cannot take the snapshot of %@ to evaluate the class chain query. Original error: %@",
+                        self.description, error.description];
+    @throw [NSException exceptionWithName:FBStaleElementException reason:reason userInfo:@{}];
+  }
+
+  NSArray<id<XCUIElementSnapshot>> *matches = @[rootSnapshot];
+  for (FBClassChainItem *item in chain.elements) {
+    matches = [self.class fb_snapshotsMatchingItem:item inSnapshots:matches];
+    if (0 == matches.count) {
+      return @[];
+    }
+  }
+
+  NSMutableSet<NSString *> *hashes = [NSMutableSet setWithCapacity:matches.count];
+  for (id<XCUIElementSnapshot> snapshot in matches) {
+    NSString *hash = [AMSnapshotUtils hashWithSnapshot:snapshot];
+    if (nil != hash) {
+      [hashes addObject:hash];
+    }
+  }
+  NSPredicate *predicate = [NSPredicate predicateWithBlock:^BOOL(id snapshot, NSDictionary *bindings) {
+    return [hashes containsObject:[AMSnapshotUtils hashWithSnapshot:snapshot]];
+  }];
+  XCUIElementQuery *query = [[self descendantsMatchingType:XCUIElementTypeAny] matchingPredicate:predicate];
+  if (shouldReturnAfterFirstMatch) {
+    XCUIElement *result = query.am_firstMatch;
+    return result ? @[result] : @[];
+  }
+  return query.am_allMatches;
+}
+
++ (NSArray<id<XCUIElementSnapshot>> *)fb_snapshotsMatchingItem:(FBClassChainItem *)item
+                                                  inSnapshots:(NSArray<id<XCUIElementSnapshot>> *)roots
+{
+  NSMutableArray<id<XCUIElementSnapshot>> *result = [NSMutableArray array];
+  // Descendants of nested roots overlap, although each snapshot must only be matched once
+  NSHashTable *visited = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+  for (id<XCUIElementSnapshot> root in roots) {
+    [self fb_collectSnapshotsMatchingItem:item
+                                 inParent:root
+                             isDescendant:item.isDescendant
+                                  visited:visited
+                                   result:result];
+  }
+  NSInteger position = item.position.integerValue;
+  if (0 == position) {
+    return result.copy;
+  }
+  if (result.count < (NSUInteger)ABS(position)) {
+    return @[];
+  }
+  return position > 0
+    ? @[[result objectAtIndex:position - 1]]
+    : @[[result objectAtIndex:result.count + position]];
+}
+
++ (void)fb_collectSnapshotsMatchingItem:(FBClassChainItem *)item
+                               inParent:(id<XCUIElementSnapshot>)parent
+                           isDescendant:(BOOL)isDescendant
+                                visited:(NSHashTable *)visited
+                                 result:(NSMutableArray<id<XCUIElementSnapshot>> *)result
+{
+  for (id<XCUIElementSnapshot> child in parent.children) {
+    if (![visited containsObject:child]) {
+      [visited addObject:child];
+      if ([self fb_snapshot:child matchesItem:item]) {
+        [result addObject:child];
+      }
+    }
+    if (isDescendant) {
+      [self fb_collectSnapshotsMatchingItem:item
+                                   inParent:child
+                               isDescendant:YES
+                                    visited:visited
+                                     result:result];
+    }
+  }
+}
+
++ (BOOL)fb_snapshot:(id<XCUIElementSnapshot>)snapshot matchesItem:(FBClassChainItem *)item
+{
+  if (XCUIElementTypeAny != item.type && snapshot.elementType != item.type) {
+    return NO;
+  }
+  for (FBAbstractPredicateItem *predicate in item.predicates) {
+    if ([predicate isKindOfClass:FBSelfPredicateItem.class]) {
+      if (![predicate.value evaluateWithObject:snapshot]) {
+        return NO;
+      }
+    } else if ([predicate isKindOfClass:FBDescendantPredicateItem.class]) {
+      if (![self fb_snapshot:snapshot hasDescendantMatchingPredicate:predicate.value]) {
+        return NO;
+      }
+    }
+  }
+  return YES;
+}
+
++ (BOOL)fb_snapshot:(id<XCUIElementSnapshot>)snapshot hasDescendantMatchingPredicate:(NSPredicate *)predicate
+{
+  for (id<XCUIElementSnapshot> child in snapshot.children) {
+    if ([predicate evaluateWithObject:child]
+        || [self fb_snapshot:child hasDescendantMatchingPredicate:predicate]) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
 + (NSArray<XCUIElement *> *)fb_matchingElementsWithItem:(FBClassChainItem *)item
                                                   query:(XCUIElementQuery *)query
                             shouldReturnAfterFirstMatch:(nullable NSNumber *)shouldReturnAfterFirstMatch
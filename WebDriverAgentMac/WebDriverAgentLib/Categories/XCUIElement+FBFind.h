@@ -64,6 +64,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSArray<XCUIElement *> *)fb_descendantsMatchingPredicate:(NSPredicate *)predicate
                                 shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch;
 
+/**
+ Same as fb_descendantsMatchingPredicate:shouldReturnAfterFirstMatch:, but expects the predicate
+ to be already formatted with NSPredicate fb_formatSearchPredicate:
+
+ @param formattedPredicate requested predicate, which has already been formatted
+ @param shouldReturnAfterFirstMatch set it to YES if you want only the first found element to be
+ resolved and returned
+ @return an array of descendants matching given predicate
+ */
+- (NSArray<XCUIElement *> *)fb_descendantsMatchingFormattedPredicate:(NSPredicate *)formattedPredicate
+                                         shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -51,7 +51,13 @@
 - (NSArray<XCUIElement *> *)fb_descendantsMatchingPredicate:(NSPredicate *)predicate
                                 shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
 {
-  NSPredicate *formattedPredicate = [NSPredicate fb_formatSearchPredicate:predicate];
+  return [self fb_descendantsMatchingFormattedPredicate:[NSPredicate fb_formatSearchPredicate:predicate]
+                            shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
+}
+
+- (NSArray<XCUIElement *> *)fb_descendantsMatchingFormattedPredicate:(NSPredicate *)formattedPredicate
+                                         shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
+{
   NSMutableArray<XCUIElement *> *result = [NSMutableArray array];
   // Include self element into predicate search
   if ([formattedPredicate evaluateWithObject:self]) {
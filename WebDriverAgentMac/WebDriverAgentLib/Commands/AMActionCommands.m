@@ -9,11 +9,16 @@
 
 #import "AMActionCommands.h"
 
+#import "AMActionsOperation.h"
+#import "AMW3CActionsSequence.h"
 #import "FBRoute.h"
 #import "FBRouteRequest.h"
 #import "FBSession.h"
 #import "XCUIApplication+FBW3CActions.h"
 
+// Waiting blocks the route queue for all sessions, so clients are expected to poll instead
+#define MAX_OPERATION_WAIT_TIMEOUT_SEC 0.5
+
 @implementation AMActionCommands
 
 #pragma mark - <AMActionCommands>
@@ -22,8 +27,13 @@
 {
   return
   @[
-    [[FBRoute POST:@"/actions"] respondWithTarget:self action:@selector(handlePerformW3CActions:)],
+    [[FBRoute POST:@"/actions"].synthesizingInput respondWithTarget:self action:@selector(handlePerformW3CActions:)],
     [[FBRoute DELETE:@"/actions"] respondWithTarget:self action:@selector(handleReleaseW3CActions:)],
+    [[FBRoute POST:@"/wda/actions/sequences"] respondWithTarget:self action:@selector(handleRegisterW3CActionsSequence:)],
+    [[FBRoute POST:@"/wda/actions/sequences/:sequenceId"].synthesizingInput respondWithTarget:self action:@selector(handlePerformW3CActionsSequence:)],
+    [[FBRoute DELETE:@"/wda/actions/sequences/:sequenceId"] respondWithTarget:self action:@selector(handleUnregisterW3CActionsSequence:)],
+    [[FBRoute GET:@"/wda/actions/operations/:operationId"] respondWithTarget:self action:@selector(handleGetW3CActionsOperation:)],
+    [[FBRoute POST:@"/wda/actions/operations/:operationId/wait"] respondWithTarget:self action:@selector(handleWaitForW3CActionsOperation:)],
   ];
 }
 
@@ -35,22 +45,129 @@
   FBElementCache *cache = request.session.elementCache;
   NSArray *actions = (NSArray *)request.arguments[@"actions"];
   NSError *error;
+  if ([request.arguments[@"async"] boolValue]) {
+    AMActionsOperation *operation = [application am_startW3CActions:actions
+                                                       elementCache:cache
+                                                              error:&error];
+    if (nil == operation) {
+      return [self responseWithActionsError:error];
+    }
+    [request.session registerActionsOperation:operation];
+    return FBResponseWithObject(@{@"id": operation.identifier});
+  }
   if (![application fb_performW3CActions:actions
                             elementCache:cache
                                    error:&error]) {
-    if ([error.localizedDescription containsString:@"not visible"]) {
-      return FBResponseWithStatus([FBCommandStatus elementNotVisibleErrorWithMessage:error.localizedDescription
-                                                                           traceback:nil]);
+    return [self responseWithActionsError:error];
+  }
+  return FBResponseWithOK();
+}
+
++ (id<FBResponsePayload>)handleRegisterW3CActionsSequence:(FBRouteRequest *)request
+{
+  id actions = request.arguments[@"actions"];
+  if (![actions isKindOfClass:NSArray.class]) {
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:@"The 'actions' argument must be a valid array of W3C actions"
+                                                                       traceback:nil]);
+  }
+  NSError *error;
+  AMW3CActionsSequence *sequence = [AMW3CActionsSequence sequenceWithActions:(NSArray *)actions
+                                                                 application:request.session.currentApplication
+                                                                       error:&error];
+  if (nil == sequence) {
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:error.localizedDescription
+                                                                       traceback:nil]);
+  }
+  [request.session registerActionsSequence:sequence];
+  return FBResponseWithObject(@{@"id": sequence.identifier});
+}
+
++ (id<FBResponsePayload>)handlePerformW3CActionsSequence:(FBRouteRequest *)request
+{
+  NSString *sequenceId = (NSString *)request.parameters[@"sequenceId"];
+  AMW3CActionsSequence *sequence = [request.session actionsSequenceWithIdentifier:sequenceId];
+  if (nil == sequence) {
+    NSString *message = [NSString stringWithFormat:@"No actions sequence with id '%@' is registered", sequenceId];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  CGVector positionOffset = CGVectorMake(0, 0);
+  id offset = request.arguments[@"offset"];
+  if (nil != offset) {
+    id dx = [offset isKindOfClass:NSDictionary.class] ? [offset objectForKey:@"x"] : nil;
+    id dy = [offset isKindOfClass:NSDictionary.class] ? [offset objectForKey:@"y"] : nil;
+    if (![dx isKindOfClass:NSNumber.class] || ![dy isKindOfClass:NSNumber.class]) {
+      return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:@"The 'offset' argument must be a dictionary with numeric 'x' and 'y' entries"
+                                                                         traceback:nil]);
     }
-    return FBResponseWithUnknownError(error);
+    positionOffset = CGVectorMake([dx doubleValue], [dy doubleValue]);
+  }
+  NSError *error;
+  if (![request.session.currentApplication am_performW3CActionsSequence:sequence
+                                                           elementCache:request.session.elementCache
+                                                         positionOffset:positionOffset
+                                                                  error:&error]) {
+    return [self responseWithActionsError:error];
   }
   return FBResponseWithOK();
 }
 
++ (id<FBResponsePayload>)handleUnregisterW3CActionsSequence:(FBRouteRequest *)request
+{
+  NSString *sequenceId = (NSString *)request.parameters[@"sequenceId"];
+  if (![request.session unregisterActionsSequenceWithIdentifier:sequenceId]) {
+    NSString *message = [NSString stringWithFormat:@"No actions sequence with id '%@' is registered", sequenceId];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  return FBResponseWithOK();
+}
+
++ (id<FBResponsePayload>)handleGetW3CActionsOperation:(FBRouteRequest *)request
+{
+  NSString *operationId = (NSString *)request.parameters[@"operationId"];
+  AMActionsOperation *operation = [request.session actionsOperationWithIdentifier:operationId];
+  if (nil == operation) {
+    NSString *message = [NSString stringWithFormat:@"No actions operation with id '%@' is known", operationId];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  return FBResponseWithObject(operation.toDictionary);
+}
+
++ (id<FBResponsePayload>)handleWaitForW3CActionsOperation:(FBRouteRequest *)request
+{
+  NSString *operationId = (NSString *)request.parameters[@"operationId"];
+  AMActionsOperation *operation = [request.session actionsOperationWithIdentifier:operationId];
+  if (nil == operation) {
+    NSString *message = [NSString stringWithFormat:@"No actions operation with id '%@' is known", operationId];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  id timeout = request.arguments[@"timeout"] ?: @(MAX_OPERATION_WAIT_TIMEOUT_SEC);
+  if (![timeout isKindOfClass:NSNumber.class] || [timeout doubleValue] < 0) {
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:@"The 'timeout' argument must be a non-negative number of seconds"
+                                                                       traceback:nil]);
+  }
+  // The operation is still reported as running if it is not finished in time, so the client could poll again
+  [operation waitUntilFinishedWithTimeout:MIN([timeout doubleValue], MAX_OPERATION_WAIT_TIMEOUT_SEC)];
+  if (AMActionsOperationStateFailed == operation.state && nil != operation.error) {
+    return [self responseWithActionsError:(NSError *)operation.error];
+  }
+  return FBResponseWithObject(operation.toDictionary);
+}
+
 + (id<FBResponsePayload>)handleReleaseW3CActions:(FBRouteRequest *)request
 {
   // just a dummy call to avoid UnknownCommandError being thrown
   return FBResponseWithOK();
 }
 
+#pragma mark - Helpers
+
++ (id<FBResponsePayload>)responseWithActionsError:(NSError *)error
+{
+  if ([error.localizedDescription containsString:@"not visible"]) {
+    return FBResponseWithStatus([FBCommandStatus elementNotVisibleErrorWithMessage:error.localizedDescription
+                                                                         traceback:nil]);
+  }
+  return FBResponseWithUnknownError(error);
+}
+
 @end
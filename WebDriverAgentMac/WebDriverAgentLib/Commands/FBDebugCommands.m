@@ -10,6 +10,10 @@
 #import "FBDebugCommands.h"
 
 #import "AMScreenUtils.h"
+#import "AMSnapshotTree.h"
+#import "AMSnapshotTreeArchive.h"
+#import "AMSnapshotTreeRecorder.h"
+#import "FBLogger.h"
 #import "FBRouteRequest.h"
 #import "FBSession.h"
 #import "XCUIApplication+AMSource.h"
@@ -27,6 +31,12 @@
 
     [[FBRoute GET:@"/wda/displays/list"] respondWithTarget:self action:@selector(handleListDisplays:)],
     [[FBRoute GET:@"/wda/displays/list"].withoutSession respondWithTarget:self action:@selector(handleListDisplays:)],
+
+    [[FBRoute GET:@"/wda/logs"] respondWithTarget:self action:@selector(handleGetLogs:)],
+    [[FBRoute GET:@"/wda/logs"].withoutSession respondWithTarget:self action:@selector(handleGetLogs:)],
+
+    [[FBRoute GET:@"/wda/snapshotTree"] respondWithTarget:self action:@selector(handleGetSnapshotTree:)],
+    [[FBRoute GET:@"/wda/snapshotTree"].withoutSession respondWithTarget:self action:@selector(handleGetSnapshotTree:)],
   ];
 }
 
@@ -35,6 +45,8 @@
 
 static NSString *const SOURCE_FORMAT_XML = @"xml";
 static NSString *const SOURCE_FORMAT_DESCRIPTION = @"description";
+static NSString *const SNAPSHOT_TREE_FORMAT_ARCHIVE = @"archive";
+static NSString *const SNAPSHOT_TREE_FORMAT_JSON = @"json";
 
 + (id<FBResponsePayload>)handleGetSourceCommand:(FBRouteRequest *)request
 {
@@ -57,6 +69,28 @@ static NSString *const SOURCE_FORMAT_DESCRIPTION = @"description";
   return FBResponseWithObject(result);
 }
 
++ (id<FBResponsePayload>)handleGetSnapshotTree:(FBRouteRequest *)request
+{
+  // This method might be called without session
+  XCUIApplication *application = request.session.currentApplication
+    ?: [[XCUIApplication alloc] initWithBundleIdentifier:FINDER_BUNDLE_ID];
+  NSString *format = request.parameters[@"format"] ?: SNAPSHOT_TREE_FORMAT_ARCHIVE;
+  BOOL isArchive = [format caseInsensitiveCompare:SNAPSHOT_TREE_FORMAT_ARCHIVE] == NSOrderedSame;
+  if (!isArchive && [format caseInsensitiveCompare:SNAPSHOT_TREE_FORMAT_JSON] != NSOrderedSame) {
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:[NSString stringWithFormat:@"Unknown snapshot tree format '%@'. Only %@ formats are supported.",
+                                                                                  format, @[SNAPSHOT_TREE_FORMAT_ARCHIVE, SNAPSHOT_TREE_FORMAT_JSON]] traceback:nil]);
+  }
+  NSError *error;
+  id<XCUIElementSnapshot> snapshot = [application snapshotWithError:&error];
+  if (nil == snapshot) {
+    return FBResponseWithUnknownError(error);
+  }
+  AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithRootSnapshot:snapshot];
+  return isArchive
+    ? FBResponseWithObject([[AMSnapshotTreeArchive dataWithTree:tree] base64EncodedStringWithOptions:0])
+    : FBResponseWithObject([AMSnapshotTreeRecorder recordWithTree:tree]);
+}
+
 + (id<FBResponsePayload>)handleListDisplays:(FBRouteRequest *)request
 {
   NSArray<AMScreenProperties *> *screenInfos = AMListScreens();
@@ -70,4 +104,9 @@ static NSString *const SOURCE_FORMAT_DESCRIPTION = @"description";
   return FBResponseWithObject(result.copy);
 }
 
++ (id<FBResponsePayload>)handleGetLogs:(FBRouteRequest *)request
+{
+  return FBResponseWithObject(FBLogger.recentEntries);
+}
+
 @end
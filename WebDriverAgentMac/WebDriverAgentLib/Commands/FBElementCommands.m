@@ -54,55 +54,55 @@
     [[FBRoute GET:@"/element/:uuid/displayed"] respondWithTarget:self action:@selector(handleGetDisplayed:)],
     [[FBRoute GET:@"/element/:uuid/selected"] respondWithTarget:self action:@selector(handleGetSelected:)],
     [[FBRoute GET:@"/element/:uuid/name"] respondWithTarget:self action:@selector(handleGetName:)],
-    [[FBRoute POST:@"/element/:uuid/value"] respondWithTarget:self action:@selector(handleSetValue:)],
-    [[FBRoute POST:@"/element/:uuid/clear"] respondWithTarget:self action:@selector(handleClear:)],
+    [[FBRoute POST:@"/element/:uuid/value"].synthesizingInput respondWithTarget:self action:@selector(handleSetValue:)],
+    [[FBRoute POST:@"/element/:uuid/clear"].synthesizingInput respondWithTarget:self action:@selector(handleClear:)],
     // W3C element screenshot
     [[FBRoute GET:@"/element/:uuid/screenshot"] respondWithTarget:self action:@selector(handleElementScreenshot:)],
     // JSONWP element screenshot
     [[FBRoute GET:@"/screenshot/:uuid"] respondWithTarget:self action:@selector(handleElementScreenshot:)],
 
-    [[FBRoute POST:@"/element/:uuid/click"] respondWithTarget:self action:@selector(handleClick:)],
-    [[FBRoute POST:@"/wda/click"] respondWithTarget:self action:@selector(handleClickCoordinate:)],
+    [[FBRoute POST:@"/element/:uuid/click"].synthesizingInput respondWithTarget:self action:@selector(handleClick:)],
+    [[FBRoute POST:@"/wda/click"].synthesizingInput respondWithTarget:self action:@selector(handleClickCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/scroll"] respondWithTarget:self action:@selector(handleScroll:)],
-    [[FBRoute POST:@"/wda/scroll"] respondWithTarget:self action:@selector(handleScrollCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/scroll"].synthesizingInput respondWithTarget:self action:@selector(handleScroll:)],
+    [[FBRoute POST:@"/wda/scroll"].synthesizingInput respondWithTarget:self action:@selector(handleScrollCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/rightClick"] respondWithTarget:self action:@selector(handleRightClick:)],
-    [[FBRoute POST:@"/wda/rightClick"] respondWithTarget:self action:@selector(handleRightClickCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/rightClick"].synthesizingInput respondWithTarget:self action:@selector(handleRightClick:)],
+    [[FBRoute POST:@"/wda/rightClick"].synthesizingInput respondWithTarget:self action:@selector(handleRightClickCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/hover"] respondWithTarget:self action:@selector(handleHover:)],
-    [[FBRoute POST:@"/wda/hover"] respondWithTarget:self action:@selector(handleHoverCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/hover"].synthesizingInput respondWithTarget:self action:@selector(handleHover:)],
+    [[FBRoute POST:@"/wda/hover"].synthesizingInput respondWithTarget:self action:@selector(handleHoverCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/doubleClick"] respondWithTarget:self action:@selector(handleDoubleClick:)],
-    [[FBRoute POST:@"/wda/doubleClick"] respondWithTarget:self action:@selector(handleDoubleClickCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/doubleClick"].synthesizingInput respondWithTarget:self action:@selector(handleDoubleClick:)],
+    [[FBRoute POST:@"/wda/doubleClick"].synthesizingInput respondWithTarget:self action:@selector(handleDoubleClickCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/clickAndDrag"] respondWithTarget:self action:@selector(handleClickAndDrag:)],
-    [[FBRoute POST:@"/wda/clickAndDrag"] respondWithTarget:self action:@selector(handleClickAndDragCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/clickAndDrag"].synthesizingInput respondWithTarget:self action:@selector(handleClickAndDrag:)],
+    [[FBRoute POST:@"/wda/clickAndDrag"].synthesizingInput respondWithTarget:self action:@selector(handleClickAndDragCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/clickAndDragAndHold"] respondWithTarget:self action:@selector(handleClickAndDragAndHold:)],
-    [[FBRoute POST:@"/wda/clickAndDragAndHold"] respondWithTarget:self action:@selector(handleClickAndDragAndHoldCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/clickAndDragAndHold"].synthesizingInput respondWithTarget:self action:@selector(handleClickAndDragAndHold:)],
+    [[FBRoute POST:@"/wda/clickAndDragAndHold"].synthesizingInput respondWithTarget:self action:@selector(handleClickAndDragAndHoldCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/swipe"] respondWithTarget:self action:@selector(handleSwipe:)],
-    [[FBRoute POST:@"/wda/swipe"] respondWithTarget:self action:@selector(handleSwipeCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/swipe"].synthesizingInput respondWithTarget:self action:@selector(handleSwipe:)],
+    [[FBRoute POST:@"/wda/swipe"].synthesizingInput respondWithTarget:self action:@selector(handleSwipeCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/keys"] respondWithTarget:self action:@selector(handleKeys:)],
-    [[FBRoute POST:@"/wda/keys"] respondWithTarget:self action:@selector(handleKeys:)],
+    [[FBRoute POST:@"/wda/element/:uuid/keys"].synthesizingInput respondWithTarget:self action:@selector(handleKeys:)],
+    [[FBRoute POST:@"/wda/keys"].synthesizingInput respondWithTarget:self action:@selector(handleKeys:)],
 
     // Touch Bar
-    [[FBRoute POST:@"/wda/element/:uuid/tap"] respondWithTarget:self action:@selector(handleTap:)],
-    [[FBRoute POST:@"/wda/tap"] respondWithTarget:self action:@selector(handleTapCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/tap"].synthesizingInput respondWithTarget:self action:@selector(handleTap:)],
+    [[FBRoute POST:@"/wda/tap"].synthesizingInput respondWithTarget:self action:@selector(handleTapCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/doubleTap"] respondWithTarget:self action:@selector(handleDoubleTap:)],
-    [[FBRoute POST:@"/wda/doubleTap"] respondWithTarget:self action:@selector(handleDoubleTapCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/doubleTap"].synthesizingInput respondWithTarget:self action:@selector(handleDoubleTap:)],
+    [[FBRoute POST:@"/wda/doubleTap"].synthesizingInput respondWithTarget:self action:@selector(handleDoubleTapCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/press"] respondWithTarget:self action:@selector(handlePress:)],
-    [[FBRoute POST:@"/wda/press"] respondWithTarget:self action:@selector(handlePressCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/press"].synthesizingInput respondWithTarget:self action:@selector(handlePress:)],
+    [[FBRoute POST:@"/wda/press"].synthesizingInput respondWithTarget:self action:@selector(handlePressCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/pressAndDrag"] respondWithTarget:self action:@selector(handlePressAndDrag:)],
-    [[FBRoute POST:@"/wda/pressAndDrag"] respondWithTarget:self action:@selector(handlePressAndDragCoordinate:)],
+    [[FBRoute POST:@"/wda/element/:uuid/pressAndDrag"].synthesizingInput respondWithTarget:self action:@selector(handlePressAndDrag:)],
+    [[FBRoute POST:@"/wda/pressAndDrag"].synthesizingInput respondWithTarget:self action:@selector(handlePressAndDragCoordinate:)],
 
-    [[FBRoute POST:@"/wda/element/:uuid/pressAndDragAndHold"] respondWithTarget:self action:@selector(handlePressAndDragAndHold:)],
-    [[FBRoute POST:@"/wda/pressAndDragAndHold"] respondWithTarget:self action:@selector(handlePressAndDragAndHold:)],
+    [[FBRoute POST:@"/wda/element/:uuid/pressAndDragAndHold"].synthesizingInput respondWithTarget:self action:@selector(handlePressAndDragAndHold:)],
+    [[FBRoute POST:@"/wda/pressAndDragAndHold"].synthesizingInput respondWithTarget:self action:@selector(handlePressAndDragAndHold:)],
   ];
 }
 
@@ -168,9 +168,15 @@
     return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:@"Neither 'value' nor 'text' parameter is provided"
                                                                        traceback:nil]);
   }
+  id inputMode = request.arguments[@"textInputMode"];
+  if (nil != inputMode && ![AMSupportedTextInputModes() containsObject:inputMode]) {
+    NSString *message = [NSString stringWithFormat:@"The 'textInputMode' parameter must be one of %@. '%@' is given instead",
+                         AMSupportedTextInputModes(), inputMode];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
   [self.class excuteRespectingKeyModifiersWithRequest:request
                                                 block:^void() {
-    [element am_setValue:value];
+    [element am_setValue:value inputMode:inputMode];
   }];
   return FBResponseWithOK();
 }
@@ -505,10 +511,12 @@
     return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message
                                                                        traceback:nil]);
   }
+  NSMutableArray<NSString *> *keyValues = [NSMutableArray array];
+  NSMutableArray<NSNumber *> *keyModifierFlags = [NSMutableArray array];
   for (id item in (NSArray *)keys) {
     if ([item isKindOfClass:NSString.class]) {
-      NSString *keyValue = AMKeyValueForName(item) ?: item;
-      [destination typeKey:keyValue modifierFlags:XCUIKeyModifierNone];
+      [keyValues addObject:AMKeyValueForName(item) ?: item];
+      [keyModifierFlags addObject:@(XCUIKeyModifierNone)];
     } else if ([item isKindOfClass:NSDictionary.class]) {
       id key = [(NSDictionary *)item objectForKey:@"key"];
       if (![key isKindOfClass:NSString.class]) {
@@ -521,14 +529,18 @@
       if ([modifiers isKindOfClass:NSNumber.class]) {
         modifierFlags = [(NSNumber *)modifiers unsignedIntValue];
       }
-      NSString *keyValue = AMKeyValueForName(key) ?: key;
-      [destination typeKey:keyValue modifierFlags:modifierFlags];
+      [keyValues addObject:AMKeyValueForName(key) ?: key];
+      [keyModifierFlags addObject:@(modifierFlags)];
     } else {
       NSString *message = @"All items of the 'keys' array must be either dictionaries or strings";
       return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message
                                                                          traceback:nil]);
     }
   }
+  NSError *error;
+  if (![destination am_typeKeys:keyValues modifierFlags:keyModifierFlags error:&error]) {
+    return FBResponseWithUnknownError(error);
+  }
   return FBResponseWithOK();
 }
 
@@ -732,8 +744,7 @@
     return FBResponseWithStatus([FBCommandStatus unableToCaptureScreenErrorWithMessage:message
                                                                              traceback:nil]);
   }
-  NSString *screenshot = [screenshotData base64EncodedStringWithOptions:0];
-  return FBResponseWithObject(screenshot);
+  return FBResponseWithObject(screenshotData);
 }
 
 + (void)excuteRespectingKeyModifiersWithRequest:(FBRouteRequest *)request block:(void(^)(void))block
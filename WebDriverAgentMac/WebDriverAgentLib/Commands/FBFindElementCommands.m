@@ -9,6 +9,7 @@
 
 #import "FBFindElementCommands.h"
 
+#import "AMTrace.h"
 #import "FBConfiguration.h"
 #import "FBElementCache.h"
 #import "FBExceptions.h"
@@ -49,7 +50,8 @@ static id<FBResponsePayload> FBNoSuchElementErrorResponseForRequest(FBRouteReque
   FBSession *session = request.session;
   XCUIElement *element = [self.class elementUsing:request.arguments[@"using"]
                                         withValue:request.arguments[@"value"]
-                                            under:session.currentApplication];
+                                            under:session.currentApplication
+                                          session:session];
   return nil == element
     ? FBNoSuchElementErrorResponseForRequest(request)
     : FBResponseWithCachedElement(element, request.session.elementCache);
@@ -61,6 +63,7 @@ static id<FBResponsePayload> FBNoSuchElementErrorResponseForRequest(FBRouteReque
   NSArray *elements = [self.class elementsUsing:request.arguments[@"using"]
                                       withValue:request.arguments[@"value"]
                                           under:session.currentApplication
+                                        session:session
                     shouldReturnAfterFirstMatch:NO];
   return FBResponseWithCachedElements(elements, request.session.elementCache);
 }
@@ -71,7 +74,8 @@ static id<FBResponsePayload> FBNoSuchElementErrorResponseForRequest(FBRouteReque
   XCUIElement *element = [elementCache elementForUUID:(NSString *)request.parameters[@"uuid"]];
   XCUIElement *foundElement = [self.class elementUsing:request.arguments[@"using"]
                                              withValue:request.arguments[@"value"]
-                                                 under:element];
+                                                 under:element
+                                               session:request.session];
   return nil == foundElement
     ? FBNoSuchElementErrorResponseForRequest(request)
     : FBResponseWithCachedElement(foundElement, request.session.elementCache);
@@ -84,6 +88,7 @@ static id<FBResponsePayload> FBNoSuchElementErrorResponseForRequest(FBRouteReque
   NSArray *foundElements = [self.class elementsUsing:request.arguments[@"using"]
                                            withValue:request.arguments[@"value"]
                                                under:element
+                                             session:request.session
                          shouldReturnAfterFirstMatch:NO];
   return FBResponseWithCachedElements(foundElements, request.session.elementCache);
 }
@@ -98,18 +103,41 @@ static id<FBResponsePayload> FBNoSuchElementErrorResponseForRequest(FBRouteReque
 
 #pragma mark - Helpers
 
-+ (XCUIElement *)elementUsing:(NSString *)usingText withValue:(NSString *)value under:(XCUIElement *)element
++ (XCUIElement *)elementUsing:(NSString *)usingText
+                    withValue:(NSString *)value
+                        under:(XCUIElement *)element
+                      session:(FBSession *)session
 {
   return [[self elementsUsing:usingText
                     withValue:value
                         under:element
+                      session:session
   shouldReturnAfterFirstMatch:YES] firstObject];
 }
 
 + (NSArray *)elementsUsing:(NSString *)usingText
                  withValue:(NSString *)value
                      under:(XCUIElement *)element
+                   session:(FBSession *)session
 shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
+{
+  AMTraceSpan *querySpan = [AMTrace beginSpanWithName:[NSString stringWithFormat:@"query (%@)", usingText]];
+  @try {
+    return [self evaluateQueryUsing:usingText
+                          withValue:value
+                              under:element
+                            session:session
+        shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
+  } @finally {
+    [querySpan end];
+  }
+}
+
++ (NSArray *)evaluateQueryUsing:(NSString *)usingText
+                      withValue:(NSString *)value
+                          under:(XCUIElement *)element
+                        session:(FBSession *)session
+    shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
 {
   if ([usingText isEqualToString:@"class name"]) {
     return [element fb_descendantsMatchingClassName:value
@@ -121,9 +149,9 @@ shouldReturnAfterFirstMatch:(BOOL)shouldReturnAfterFirstMatch
     return [element fb_descendantsMatchingXPathQuery:value
                          shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
   } else if ([usingText isEqualToString:@"predicate string"]) {
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:value];
-    return [element fb_descendantsMatchingPredicate:predicate
-                        shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
+    NSPredicate *predicate = [session searchPredicateWithFormat:value];
+    return [element fb_descendantsMatchingFormattedPredicate:predicate
+                                 shouldReturnAfterFirstMatch:shouldReturnAfterFirstMatch];
   } else if ([usingText isEqualToString:@"name"]
              || [usingText isEqualToString:@"id"]
              || [usingText isEqualToString:@"accessibility id"]) {
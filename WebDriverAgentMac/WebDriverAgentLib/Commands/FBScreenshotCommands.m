@@ -39,8 +39,9 @@
     return FBResponseWithStatus([FBCommandStatus unableToCaptureScreenErrorWithMessage:message
                                                                              traceback:nil]);
   }
-  NSString *screenshot = [screenshotData base64EncodedStringWithOptions:0];
-  return FBResponseWithObject(screenshot);
+  // Binary data is base64-encoded by the response payload itself,
+  // which avoids keeping an extra encoded copy for large screenshots
+  return FBResponseWithObject(screenshotData);
 }
 
 + (id<FBResponsePayload>)handleGetScreenshots:(FBRouteRequest *)request
@@ -58,7 +59,7 @@
     result[[NSString stringWithFormat:@"%lld", currentScreenId]] = @{
       @"id": @(currentScreenId),
       @"isMain": @(AMIsMainScreen(screen)),
-      @"payload": [screen.screenshot.PNGRepresentation base64EncodedStringWithOptions:0] ?: NSNull.null
+      @"payload": screen.screenshot.PNGRepresentation ?: NSNull.null
     };
   }
   if (nil != desiredId && 0 == [result count]) {
@@ -9,6 +9,7 @@
 
 #import "FBSessionCommands.h"
 
+#import "AMApplicationPool.h"
 #import "AMSessionCapabilities.h"
 #import "AMSettings.h"
 #import "AMXCUIDeviceWrapper.h"
@@ -20,6 +21,7 @@
 #import "FBRuntimeUtils.h"
 #import "XCUIApplication+AMHelpers.h"
 #import "XCUIApplication+AMUIInterruptions.h"
+#import "XCUIElement+AMEditable.h"
 
 const static NSString *CAPABILITIES_KEY = @"capabilities";
 
@@ -37,6 +39,9 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
     [[FBRoute POST:@"/wda/apps/activate"] respondWithTarget:self action:@selector(handleSessionAppActivate:)],
     [[FBRoute POST:@"/wda/apps/terminate"] respondWithTarget:self action:@selector(handleSessionAppTerminate:)],
     [[FBRoute POST:@"/wda/apps/state"] respondWithTarget:self action:@selector(handleSessionAppState:)],
+    [[FBRoute GET:@"/wda/apps/pool"].withoutSession respondWithTarget:self action:@selector(handleGetApplicationPool:)],
+    [[FBRoute POST:@"/wda/apps/pool"].withoutSession respondWithTarget:self action:@selector(handleWarmUpApplication:)],
+    [[FBRoute DELETE:@"/wda/apps/pool"].withoutSession respondWithTarget:self action:@selector(handleDrainApplicationPool:)],
     [[FBRoute GET:@""] respondWithTarget:self action:@selector(handleGetActiveSession:)],
     [[FBRoute DELETE:@""] respondWithTarget:self action:@selector(handleDeleteSession:)],
     [[FBRoute GET:@"/status"].withoutSession respondWithTarget:self action:@selector(handleGetStatus:)],
@@ -99,9 +104,10 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
   NSString *appPath = requirements[AM_APP_PATH_CAPABILITY];
   NSString *deepLink = requirements[AM_INITIAL_DEEPLINK_URL_CAPABILITY];
   BOOL noReset = [requirements[AM_NO_RESET_CAPABILITY] boolValue];
+  BOOL concurrent = [requirements[AM_CONCURRENT_SESSIONS_CAPABILITY] boolValue];
   FBSession *session;
   if (nil == bundleID && nil == appPath && nil == deepLink) {
-    session = [FBSession initWithApplication:nil];
+    session = [FBSession initWithApplication:nil concurrent:concurrent];
   } else if (nil != deepLink) {
     NSURL *url = [NSURL URLWithString:deepLink];
     NSError *error;
@@ -113,14 +119,18 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
                                                                 traceback:nil]);
     }
     if (nil != bundleID) {
-      session = [FBSession initWithApplication:[[XCUIApplication alloc] initWithBundleIdentifier:bundleID]];
+      session = [FBSession initWithApplication:[[XCUIApplication alloc] initWithBundleIdentifier:bundleID]
+                                    concurrent:concurrent];
     }
   } else {
     XCUIApplication *app = nil != appPath 
       ? [[XCUIApplication alloc] initWithURL:[NSURL fileURLWithPath:appPath]]
       : [[XCUIApplication alloc] initWithBundleIdentifier:bundleID];
-    session = [FBSession initWithApplication:app];
-    if (noReset && app.state > XCUIApplicationStateNotRunning) {
+    session = [FBSession initWithApplication:app concurrent:concurrent];
+    // The previous session might still be terminating the same application in background
+    [FBSession waitForTerminationOfApplicationWithBundleId:app.am_bundleID];
+    if (noReset && app.state > XCUIApplicationStateNotRunning
+        && ![AMApplicationPool.sharedPool containsApplicationWithBundleId:app.am_bundleID]) {
       [app activate];
     } else {
       NSMutableArray<NSString *> *launchArguments = [NSMutableArray new];
@@ -139,7 +149,7 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
         launchEnv[@"TZ"] = requirements[AM_APP_TIME_ZONE_CAPABILITY];
       }
       app.launchEnvironment = [launchEnv copy];
-      [app launch];
+      [AMApplicationPool.sharedPool launchApplication:app];
       if (app.state <= XCUIApplicationStateNotRunning) {
         NSString *message = [NSString stringWithFormat:@"Failed to launch '%@' application", appPath ?: bundleID];
         return FBResponseWithStatus([FBCommandStatus sessionNotCreatedError:message
@@ -171,6 +181,10 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
 
 + (id<FBResponsePayload>)handleSessionAppLaunch:(FBRouteRequest *)request
 {
+  id<FBResponsePayload> validationError = [self.class validateLaunchOptions:request];
+  if (nil != validationError) {
+    return validationError;
+  }
   [request.session launchApplicationWithBundleId:request.arguments[@"bundleId"]
                                             path:request.arguments[@"path"]
                                        arguments:request.arguments[@"arguments"]
@@ -199,6 +213,46 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
   return FBResponseWithObject(@(state));
 }
 
++ (id<FBResponsePayload>)handleGetApplicationPool:(FBRouteRequest *)request
+{
+  return FBResponseWithObject(AMApplicationPool.sharedPool.toArray);
+}
+
++ (id<FBResponsePayload>)handleWarmUpApplication:(FBRouteRequest *)request
+{
+  NSString *bundleId = request.arguments[@"bundleId"];
+  NSString *path = request.arguments[@"path"];
+  if (nil == bundleId && nil == path) {
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:@"Either app bundle identifier or app path must be provided"
+                                                                       traceback:nil]);
+  }
+  if (0 == FBConfiguration.sharedConfiguration.applicationPoolSize) {
+    NSString *message = [NSString stringWithFormat:@"The application pool is disabled. Set the '%@' setting to a positive value first",
+                         AM_APPLICATION_POOL_SIZE];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  id<FBResponsePayload> validationError = [self.class validateLaunchOptions:request];
+  if (nil != validationError) {
+    return validationError;
+  }
+  XCUIApplication *app = nil != path
+    ? [[XCUIApplication alloc] initWithURL:[NSURL fileURLWithPath:path]]
+    : [[XCUIApplication alloc] initWithBundleIdentifier:bundleId];
+  app.launchArguments = request.arguments[@"arguments"] ?: @[];
+  app.launchEnvironment = request.arguments[@"environment"] ?: @{};
+  NSError *error;
+  if (![AMApplicationPool.sharedPool warmUpApplication:app error:&error]) {
+    return FBResponseWithUnknownError(error);
+  }
+  return FBResponseWithOK();
+}
+
++ (id<FBResponsePayload>)handleDrainApplicationPool:(FBRouteRequest *)request
+{
+  [AMApplicationPool.sharedPool drain];
+  return FBResponseWithOK();
+}
+
 + (id<FBResponsePayload>)handleGetActiveSession:(FBRouteRequest *)request
 {
   return FBResponseWithObject(FBSessionCommands.sessionInformation);
@@ -238,6 +292,12 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
       AM_BOUND_ELEMENTS_BY_INDEX_SETTING: @(FBSession.activeSession.boundElementsByIndex),
       AM_USE_DEFAULT_UI_INTERRUPTIONS_HANDLING_SETTING: @(!application.am_doesNotHandleUIInterruptions),
       AM_FETCH_FULL_TEXT: @(FBConfiguration.sharedConfiguration.fetchFullText),
+      AM_RESPONSE_COMPRESSION_THRESHOLD: @(FBConfiguration.sharedConfiguration.responseCompressionThreshold),
+      AM_USE_NATIVE_XPATH_ENGINE: @(FBConfiguration.sharedConfiguration.useNativeXPathEngine),
+      AM_TEXT_INPUT_MODE: FBConfiguration.sharedConfiguration.textInputMode,
+      AM_TYPING_FREQUENCY: @(FBConfiguration.sharedConfiguration.typingFrequency),
+      AM_POINTER_MOVE_TOLERANCE: @(FBConfiguration.sharedConfiguration.pointerMoveTolerance),
+      AM_APPLICATION_POOL_SIZE: @(FBConfiguration.sharedConfiguration.applicationPoolSize),
     }
   );
 }
@@ -256,6 +316,48 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
   if (nil != [settings objectForKey:AM_FETCH_FULL_TEXT]) {
     FBConfiguration.sharedConfiguration.fetchFullText = [settings objectForKey:AM_FETCH_FULL_TEXT];
   }
+  if (nil != [settings objectForKey:AM_RESPONSE_COMPRESSION_THRESHOLD]) {
+    FBConfiguration.sharedConfiguration.responseCompressionThreshold = [[settings objectForKey:AM_RESPONSE_COMPRESSION_THRESHOLD] integerValue];
+  }
+  if (nil != [settings objectForKey:AM_USE_NATIVE_XPATH_ENGINE]) {
+    FBConfiguration.sharedConfiguration.useNativeXPathEngine = [[settings objectForKey:AM_USE_NATIVE_XPATH_ENGINE] boolValue];
+  }
+  id textInputMode = [settings objectForKey:AM_TEXT_INPUT_MODE];
+  if (nil != textInputMode) {
+    if (![AMSupportedTextInputModes() containsObject:textInputMode]) {
+      NSString *message = [NSString stringWithFormat:@"The '%@' setting value must be one of %@. '%@' is given instead",
+                           AM_TEXT_INPUT_MODE, AMSupportedTextInputModes(), textInputMode];
+      return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+    }
+    FBConfiguration.sharedConfiguration.textInputMode = textInputMode;
+  }
+  id typingFrequency = [settings objectForKey:AM_TYPING_FREQUENCY];
+  if (nil != typingFrequency) {
+    if (![self.class isNonNegativeInteger:typingFrequency]) {
+      NSString *message = [NSString stringWithFormat:@"The '%@' setting value must be a non-negative integer. '%@' is given instead",
+                           AM_TYPING_FREQUENCY, typingFrequency];
+      return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+    }
+    FBConfiguration.sharedConfiguration.typingFrequency = [typingFrequency unsignedIntegerValue];
+  }
+  id pointerMoveTolerance = [settings objectForKey:AM_POINTER_MOVE_TOLERANCE];
+  if (nil != pointerMoveTolerance) {
+    if (![pointerMoveTolerance isKindOfClass:NSNumber.class] || [pointerMoveTolerance doubleValue] < 0) {
+      NSString *message = [NSString stringWithFormat:@"The '%@' setting value must be a non-negative number. '%@' is given instead",
+                           AM_POINTER_MOVE_TOLERANCE, pointerMoveTolerance];
+      return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+    }
+    FBConfiguration.sharedConfiguration.pointerMoveTolerance = [pointerMoveTolerance doubleValue];
+  }
+  id applicationPoolSize = [settings objectForKey:AM_APPLICATION_POOL_SIZE];
+  if (nil != applicationPoolSize) {
+    if (![self.class isNonNegativeInteger:applicationPoolSize]) {
+      NSString *message = [NSString stringWithFormat:@"The '%@' setting value must be a non-negative integer. '%@' is given instead",
+                           AM_APPLICATION_POOL_SIZE, applicationPoolSize];
+      return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+    }
+    FBConfiguration.sharedConfiguration.applicationPoolSize = [applicationPoolSize unsignedIntegerValue];
+  }
 
   return [self handleGetSettings:request];
 }
@@ -263,6 +365,39 @@ const static NSString *CAPABILITIES_KEY = @"capabilities";
 
 #pragma mark - Helpers
 
++ (BOOL)isNonNegativeInteger:(id)value
+{
+  if (![value isKindOfClass:NSNumber.class] || CFGetTypeID((__bridge CFTypeRef)value) == CFBooleanGetTypeID()) {
+    return NO;
+  }
+  double number = [value doubleValue];
+  return number >= 0 && number == floor(number);
+}
+
++ (nullable id<FBResponsePayload>)validateLaunchOptions:(FBRouteRequest *)request
+{
+  id arguments = request.arguments[@"arguments"];
+  BOOL isValid = nil == arguments || [arguments isKindOfClass:NSArray.class];
+  for (id item in isValid ? (NSArray *)arguments : @[]) {
+    isValid = isValid && [item isKindOfClass:NSString.class];
+  }
+  if (!isValid) {
+    NSString *message = [NSString stringWithFormat:@"App arguments must be an array of strings. '%@' is given instead", arguments];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  id environment = request.arguments[@"environment"];
+  isValid = nil == environment || [environment isKindOfClass:NSDictionary.class];
+  for (id key in isValid ? (NSDictionary *)environment : @{}) {
+    isValid = isValid && [key isKindOfClass:NSString.class]
+      && [[(NSDictionary *)environment objectForKey:key] isKindOfClass:NSString.class];
+  }
+  if (!isValid) {
+    NSString *message = [NSString stringWithFormat:@"App environment must be a dictionary of strings. '%@' is given instead", environment];
+    return FBResponseWithStatus([FBCommandStatus invalidArgumentErrorWithMessage:message traceback:nil]);
+  }
+  return nil;
+}
+
 + (NSString *)buildTimestamp
 {
   return [NSString stringWithFormat:@"%@ %@",
@@ -0,0 +1,66 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "HTTPResponse.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Chunked HTTP response, which serializes the given JSON object lazily
+ while the connection is requesting more data to send.
+ This keeps the memory usage bounded for huge payloads and allows the first bytes
+ to be sent before the whole document is serialized.
+
+ Unlike NSJSONSerialization, NSData values are supported and serialized
+ as base64-encoded strings, so there is no need to keep the encoded copy
+ of binary data (like screenshots) in memory.
+ */
+@interface AMJSONStreamResponse : NSObject <HTTPResponse>
+
+/*! The actual content encoding of the stream or nil if it is not compressed */
+@property (nonatomic, readonly, nullable) NSString *contentEncoding;
+
+/**
+ Optional block, which is called once the last chunk of the stream has been read.
+ The block receives the total amount of bytes sent over the connection
+ and is called on the connection queue
+ */
+@property (nonatomic, copy, nullable) void (^completionHandler)(UInt64 bytesSent);
+
+/**
+ Creates a new streaming response
+
+ @param object The JSON object to serialize. Must only contain NSDictionary, NSArray, NSString,
+ NSNumber, NSNull and NSData instances
+ @param contentEncoding Optional HTTP content encoding to compress the stream with on the fly.
+ See NSData+AMCompression for the list of supported encodings
+ */
+- (instancetype)initWithJSONObject:(id)object contentEncoding:(nullable NSString *)contentEncoding;
+
+/**
+ Calculates the approximate length of the serialized JSON object in bytes
+ without performing the actual serialization
+
+ @param object The JSON object to measure
+ @return The estimated length of the serialized representation
+ */
++ (NSUInteger)estimatedLengthOfJSONObject:(id)object;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,402 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMJSONStreamResponse.h"
+
+#import <float.h>
+#import <zlib.h>
+
+#import "NSData+AMCompression.h"
+
+// The maximum amount of UTF-16 characters or raw bytes serialized at once.
+// Must be divisible by 3 to keep base64 slices independent of each other
+static const NSUInteger AM_LEAF_SLICE_LENGTH = 48 * 1024;
+
+/**
+ Writes the six bytes of the \uXXXX escape of the given character without a trailing NUL
+
+ @return The new length of the output
+ */
+static NSUInteger AMAppendUnicodeEscape(uint8_t *out, NSUInteger outLength, unichar c)
+{
+  static const char hexDigits[] = "0123456789abcdef";
+  out[outLength++] = '\\';
+  out[outLength++] = 'u';
+  out[outLength++] = (uint8_t)hexDigits[(c >> 12) & 0xF];
+  out[outLength++] = (uint8_t)hexDigits[(c >> 8) & 0xF];
+  out[outLength++] = (uint8_t)hexDigits[(c >> 4) & 0xF];
+  out[outLength++] = (uint8_t)hexDigits[c & 0xF];
+  return outLength;
+}
+
+@interface AMJSONStreamFrame : NSObject
+@property (nonatomic) id container;
+@property (nonatomic, nullable) NSArray *keys;
+@property (nonatomic) NSUInteger index;
+@end
+
+@implementation AMJSONStreamFrame
+@end
+
+@interface AMJSONStreamResponse ()
+@property (nonatomic, nullable) id rootObject;
+@property (nonatomic, readonly) NSMutableArray<AMJSONStreamFrame *> *frames;
+@property (nonatomic, nullable) id pendingLeaf;
+@property (nonatomic) NSUInteger pendingLeafOffset;
+@property (nonatomic) BOOL isSerializationDone;
+@property (nonatomic) BOOL isCompressionEnabled;
+@property (nonatomic) BOOL isCompressionDone;
+@property (nonatomic) UInt64 bytesSent;
+@property (nonatomic, readwrite, nullable) NSString *contentEncoding;
+@end
+
+@implementation AMJSONStreamResponse
+{
+  z_stream _zStream;
+}
+
+- (instancetype)initWithJSONObject:(id)object contentEncoding:(NSString *)contentEncoding
+{
+  if ((self = [super init])) {
+    _rootObject = object;
+    _frames = [NSMutableArray array];
+    int windowBits = nil == contentEncoding ? 0 : AMZlibWindowBitsForContentEncoding(contentEncoding);
+    if (windowBits > 0) {
+      memset(&_zStream, 0, sizeof(_zStream));
+      _isCompressionEnabled = deflateInit2(&_zStream, AM_HTTP_COMPRESSION_LEVEL, Z_DEFLATED,
+                                           windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+      _contentEncoding = _isCompressionEnabled ? contentEncoding : nil;
+    }
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  if (self.isCompressionEnabled) {
+    deflateEnd(&_zStream);
+  }
+}
+
++ (NSUInteger)estimatedLengthOfJSONObject:(id)object
+{
+  if ([object isKindOfClass:NSString.class]) {
+    // Most of the characters are ASCII, which take one byte in UTF-8
+    return [(NSString *)object length] + 2;
+  }
+  if ([object isKindOfClass:NSData.class]) {
+    return ([(NSData *)object length] + 2) / 3 * 4 + 2;
+  }
+  if ([object isKindOfClass:NSDictionary.class]) {
+    NSDictionary *dictionary = (NSDictionary *)object;
+    __block NSUInteger result = 2;
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+      result += [self estimatedLengthOfJSONObject:key] + [self estimatedLengthOfJSONObject:value] + 2;
+    }];
+    return result;
+  }
+  if ([object isKindOfClass:NSArray.class]) {
+    NSUInteger result = 2;
+    for (id item in (NSArray *)object) {
+      result += [self estimatedLengthOfJSONObject:item] + 1;
+    }
+    return result;
+  }
+  return 8;
+}
+
+#pragma mark - HTTPResponse
+
+- (UInt64)contentLength
+{
+  // The length is unknown in advance for chunked responses
+  return 0;
+}
+
+- (UInt64)offset
+{
+  return self.bytesSent;
+}
+
+- (void)setOffset:(UInt64)offset
+{
+  // Range requests are not supported for chunked responses
+}
+
+- (BOOL)isChunked
+{
+  return YES;
+}
+
+- (BOOL)isDone
+{
+  return self.isCompressionEnabled ? self.isCompressionDone : self.isSerializationDone;
+}
+
+- (NSData *)readDataOfLength:(NSUInteger)length
+{
+  NSData *result = self.isCompressionEnabled
+    ? [self readCompressedDataOfLength:length]
+    : [self readSerializedDataOfLength:length];
+  self.bytesSent += result.length;
+  if (self.isDone && nil != self.completionHandler) {
+    void (^completionHandler)(UInt64) = self.completionHandler;
+    self.completionHandler = nil;
+    completionHandler(self.bytesSent);
+  }
+  return result;
+}
+
+#pragma mark - Compression
+
+- (NSData *)readCompressedDataOfLength:(NSUInteger)length
+{
+  NSUInteger chunkLength = MAX(length, (NSUInteger)1024);
+  NSMutableData *output = [NSMutableData dataWithLength:chunkLength];
+  _zStream.next_out = (Bytef *)output.mutableBytes;
+  _zStream.avail_out = (uInt)chunkLength;
+  // zlib may keep the input buffered without producing any output,
+  // although the connection expects some data unless the response is done
+  while (!self.isCompressionDone && (Bytef *)output.mutableBytes == _zStream.next_out) {
+    NSData *input = [self readSerializedDataOfLength:chunkLength];
+    _zStream.next_in = (Bytef *)input.bytes;
+    _zStream.avail_in = (uInt)input.length;
+    int flush = self.isSerializationDone ? Z_FINISH : Z_NO_FLUSH;
+    do {
+      if (0 == _zStream.avail_out) {
+        // Keep the rest of the output in the same chunk
+        NSUInteger producedLength = output.length;
+        [output increaseLengthBy:chunkLength];
+        _zStream.next_out = (Bytef *)output.mutableBytes + producedLength;
+        _zStream.avail_out = (uInt)chunkLength;
+      }
+      int status = deflate(&_zStream, flush);
+      if (Z_STREAM_END == status || (Z_OK != status && Z_BUF_ERROR != status)) {
+        // Errors should never happen for in-memory buffers
+        self.isCompressionDone = YES;
+      }
+    } while (!self.isCompressionDone && (_zStream.avail_in > 0 || 0 == _zStream.avail_out || Z_FINISH == flush));
+  }
+  output.length = (NSUInteger)(_zStream.next_out - (Bytef *)output.mutableBytes);
+  return output.copy;
+}
+
+#pragma mark - Serialization
+
+- (NSData *)readSerializedDataOfLength:(NSUInteger)length
+{
+  NSMutableData *buffer = [NSMutableData dataWithCapacity:length + 64];
+  while (!self.isSerializationDone && buffer.length < length) {
+    [self writeNextTokenToBuffer:buffer];
+  }
+  return buffer.copy;
+}
+
+- (void)writeNextTokenToBuffer:(NSMutableData *)buffer
+{
+  if (nil != self.pendingLeaf) {
+    [self writePendingLeafSliceToBuffer:buffer];
+    return;
+  }
+  if (nil != self.rootObject) {
+    id root = self.rootObject;
+    self.rootObject = nil;
+    [self writeValue:root toBuffer:buffer];
+    [self finishIfNoFramesLeft];
+    return;
+  }
+
+  AMJSONStreamFrame *frame = self.frames.lastObject;
+  BOOL isDictionary = nil != frame.keys;
+  NSUInteger count = isDictionary ? frame.keys.count : [(NSArray *)frame.container count];
+  if (frame.index >= count) {
+    [self appendCString:(isDictionary ? "}" : "]") toBuffer:buffer];
+    [self.frames removeLastObject];
+    [self finishIfNoFramesLeft];
+    return;
+  }
+  if (frame.index > 0) {
+    [self appendCString:"," toBuffer:buffer];
+  }
+  id value;
+  if (isDictionary) {
+    id key = frame.keys[frame.index];
+    [self writeString:[key isKindOfClass:NSString.class] ? key : [key description] toBuffer:buffer];
+    [self appendCString:":" toBuffer:buffer];
+    value = [(NSDictionary *)frame.container objectForKey:key];
+  } else {
+    value = [(NSArray *)frame.container objectAtIndex:frame.index];
+  }
+  frame.index++;
+  [self writeValue:value toBuffer:buffer];
+}
+
+- (void)finishIfNoFramesLeft
+{
+  if (0 == self.frames.count && nil == self.pendingLeaf) {
+    self.isSerializationDone = YES;
+  }
+}
+
+- (void)writeValue:(id)value toBuffer:(NSMutableData *)buffer
+{
+  if ([value isKindOfClass:NSDictionary.class] || [value isKindOfClass:NSArray.class]) {
+    AMJSONStreamFrame *frame = [AMJSONStreamFrame new];
+    frame.container = value;
+    if ([value isKindOfClass:NSDictionary.class]) {
+      frame.keys = [(NSDictionary *)value allKeys];
+      [self appendCString:"{" toBuffer:buffer];
+    } else {
+      [self appendCString:"[" toBuffer:buffer];
+    }
+    [self.frames addObject:frame];
+  } else if ([value isKindOfClass:NSString.class] || [value isKindOfClass:NSData.class]) {
+    [self appendCString:"\"" toBuffer:buffer];
+    self.pendingLeaf = value;
+    self.pendingLeafOffset = 0;
+    [self writePendingLeafSliceToBuffer:buffer];
+  } else if ([value isKindOfClass:NSNumber.class]) {
+    [self writeNumber:(NSNumber *)value toBuffer:buffer];
+  } else if (nil == value || [value isKindOfClass:NSNull.class]) {
+    [self appendCString:"null" toBuffer:buffer];
+  } else {
+    [self writeString:[value description] toBuffer:buffer];
+  }
+}
+
+- (void)writeNumber:(NSNumber *)number toBuffer:(NSMutableData *)buffer
+{
+  if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+    [self appendCString:(number.boolValue ? "true" : "false") toBuffer:buffer];
+    return;
+  }
+  const char *objCType = number.objCType;
+  BOOL isFloat = 0 == strcmp(objCType, @encode(float));
+  if (isFloat || 0 == strcmp(objCType, @encode(double))) {
+    double value = number.doubleValue;
+    if (isnan(value) || isinf(value)) {
+      [self appendCString:"null" toBuffer:buffer];
+      return;
+    }
+    // Use the shortest representation, which still parses back to the same value,
+    // so 0.1 is not written as 0.10000000000000001
+    char str[32];
+    int precision = isFloat ? FLT_DIG : DBL_DIG;
+    int maxPrecision = isFloat ? FLT_DECIMAL_DIG : DBL_DECIMAL_DIG;
+    for (; precision <= maxPrecision; precision++) {
+      snprintf(str, sizeof(str), "%.*g", precision, value);
+      if (isFloat ? strtof(str, NULL) == (float)value : strtod(str, NULL) == value) {
+        break;
+      }
+    }
+    [self appendCString:str toBuffer:buffer];
+    return;
+  }
+  [self appendCString:number.stringValue.UTF8String toBuffer:buffer];
+}
+
+- (void)writeString:(NSString *)string toBuffer:(NSMutableData *)buffer
+{
+  [self appendCString:"\"" toBuffer:buffer];
+  self.pendingLeaf = string;
+  self.pendingLeafOffset = 0;
+  while (nil != self.pendingLeaf) {
+    [self writePendingLeafSliceToBuffer:buffer];
+  }
+}
+
+- (void)writePendingLeafSliceToBuffer:(NSMutableData *)buffer
+{
+  id leaf = self.pendingLeaf;
+  NSUInteger total = [leaf length];
+  NSUInteger offset = self.pendingLeafOffset;
+  NSUInteger sliceLength = MIN(AM_LEAF_SLICE_LENGTH, total - offset);
+  if ([leaf isKindOfClass:NSData.class]) {
+    NSData *slice = [NSData dataWithBytesNoCopy:(void *)((const uint8_t *)[(NSData *)leaf bytes] + offset)
+                                         length:sliceLength
+                                   freeWhenDone:NO];
+    [buffer appendData:[slice base64EncodedDataWithOptions:0]];
+  } else {
+    NSString *string = (NSString *)leaf;
+    if (offset + sliceLength < total
+        && CFStringIsSurrogateHighCharacter([string characterAtIndex:offset + sliceLength - 1])) {
+      // Do not split surrogate pairs between slices
+      sliceLength--;
+    }
+    [self appendEscapedCharactersOfString:string range:NSMakeRange(offset, sliceLength) toBuffer:buffer];
+  }
+  self.pendingLeafOffset = offset + sliceLength;
+  if (self.pendingLeafOffset >= total) {
+    [self appendCString:"\"" toBuffer:buffer];
+    self.pendingLeaf = nil;
+    [self finishIfNoFramesLeft];
+  }
+}
+
+- (void)appendEscapedCharactersOfString:(NSString *)string range:(NSRange)range toBuffer:(NSMutableData *)buffer
+{
+  unichar *chars = malloc(range.length * sizeof(unichar));
+  [string getCharacters:chars range:range];
+  // The worst case is \uXXXX escape for every character
+  uint8_t *out = malloc(range.length * 6);
+  NSUInteger outLength = 0;
+  for (NSUInteger i = 0; i < range.length; i++) {
+    unichar c = chars[i];
+    if (c == '"' || c == '\\') {
+      out[outLength++] = '\\';
+      out[outLength++] = (uint8_t)c;
+    } else if (c < 0x20) {
+      switch (c) {
+        case '\n': out[outLength++] = '\\'; out[outLength++] = 'n'; break;
+        case '\r': out[outLength++] = '\\'; out[outLength++] = 'r'; break;
+        case '\t': out[outLength++] = '\\'; out[outLength++] = 't'; break;
+        default:
+          outLength = AMAppendUnicodeEscape(out, outLength, c);
+          break;
+      }
+    } else if (c < 0x80) {
+      out[outLength++] = (uint8_t)c;
+    } else if (c < 0x800) {
+      out[outLength++] = (uint8_t)(0xC0 | (c >> 6));
+      out[outLength++] = (uint8_t)(0x80 | (c & 0x3F));
+    } else if (CFStringIsSurrogateHighCharacter(c)
+               && i + 1 < range.length
+               && CFStringIsSurrogateLowCharacter(chars[i + 1])) {
+      UTF32Char codePoint = CFStringGetLongCharacterForSurrogatePair(c, chars[++i]);
+      out[outLength++] = (uint8_t)(0xF0 | (codePoint >> 18));
+      out[outLength++] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+      out[outLength++] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+      out[outLength++] = (uint8_t)(0x80 | (codePoint & 0x3F));
+    } else if (CFStringIsSurrogateHighCharacter(c) || CFStringIsSurrogateLowCharacter(c)) {
+      // Lone surrogates cannot be represented in UTF-8
+      outLength = AMAppendUnicodeEscape(out, outLength, c);
+    } else {
+      out[outLength++] = (uint8_t)(0xE0 | (c >> 12));
+      out[outLength++] = (uint8_t)(0x80 | ((c >> 6) & 0x3F));
+      out[outLength++] = (uint8_t)(0x80 | (c & 0x3F));
+    }
+  }
+  [buffer appendBytes:out length:outLength];
+  free(out);
+  free(chars);
+}
+
+- (void)appendCString:(const char *)str toBuffer:(NSMutableData *)buffer
+{
+  [buffer appendBytes:str length:strlen(str)];
+}
+
+@end
@@ -9,6 +9,7 @@
 
 #import "FBElementCache.h"
 
+#import "AMTrace.h"
 #import "FBExceptions.h"
 #import "FBLogger.h"
 #import "LRUCache.h"
@@ -90,7 +91,9 @@
     @throw [NSException exceptionWithName:FBStaleElementException reason:reason userInfo:@{}];
   }
   NSError *error;
+  AMTraceSpan *snapshotSpan = [AMTrace beginSpanWithName:@"snapshot"];
   id<XCUIElementSnapshot> snapshot = [element snapshotWithError:&error];
+  [snapshotSpan end];
   if (nil == snapshot) {
     NSString *reason = [NSString stringWithFormat:@"The element \"%@\" identified by \"%@\" is not present on the current view (%@). Make sure the current view is the expected one",
                         elementDescription, uuidStr, error.localizedDescription];
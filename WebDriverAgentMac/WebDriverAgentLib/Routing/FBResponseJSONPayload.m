@@ -11,6 +11,53 @@
 
 #import "RouteResponse.h"
 
+#import "AMJSONStreamResponse.h"
+#import "FBConfiguration.h"
+#import "FBRouteRequest.h"
+#import "NSData+AMCompression.h"
+
+// Payloads larger than this are serialized lazily while being sent,
+// so they are never held in memory as a whole
+static const NSUInteger FBStreamingResponseThreshold = 1024 * 1024;
+
+// Replaces NSData instances with base64 strings, since NSJSONSerialization does not support them.
+// Containers without binary data inside are returned as is to avoid needless copying
+static id FBJSONSerializableObject(id object)
+{
+  if ([object isKindOfClass:NSData.class]) {
+    return [(NSData *)object base64EncodedStringWithOptions:0];
+  }
+  if ([object isKindOfClass:NSDictionary.class]) {
+    __block NSMutableDictionary *result = nil;
+    NSDictionary *dictionary = (NSDictionary *)object;
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+      id serializableValue = FBJSONSerializableObject(value);
+      if (serializableValue != value && nil == result) {
+        result = dictionary.mutableCopy;
+      }
+      if (nil != result) {
+        result[key] = serializableValue;
+      }
+    }];
+    return nil == result ? object : result.copy;
+  }
+  if ([object isKindOfClass:NSArray.class]) {
+    NSMutableArray *result = nil;
+    NSArray *array = (NSArray *)object;
+    for (NSUInteger index = 0; index < array.count; index++) {
+      id serializableItem = FBJSONSerializableObject(array[index]);
+      if (serializableItem != array[index] && nil == result) {
+        result = array.mutableCopy;
+      }
+      if (nil != result) {
+        result[index] = serializableItem;
+      }
+    }
+    return nil == result ? object : result.copy;
+  }
+  return object;
+}
+
 @interface FBResponseJSONPayload ()
 
 @property (nonatomic, copy, readonly) NSDictionary *dictionary;
@@ -38,13 +85,50 @@
 
 - (void)dispatchWithResponse:(RouteResponse *)response
 {
+  [self dispatchWithResponse:response contentEncoding:nil];
+}
+
+- (void)dispatchWithResponse:(RouteResponse *)response forRequest:(FBRouteRequest *)request
+{
+  NSString *acceptEncoding = [request headerWithName:@"Accept-Encoding"];
+  [self dispatchWithResponse:response
+             contentEncoding:[NSData am_preferredContentEncodingWithAcceptEncoding:acceptEncoding]];
+}
+
+- (void)dispatchWithResponse:(RouteResponse *)response contentEncoding:(nullable NSString *)contentEncoding
+{
+  [response setHeader:@"Content-Type" value:@"application/json;charset=UTF-8"];
+  [response setStatusCode:self.httpStatusCode];
+
+  NSInteger threshold = FBConfiguration.sharedConfiguration.responseCompressionThreshold;
+  BOOL isCompressionEnabled = nil != contentEncoding && threshold > 0;
+  NSUInteger estimatedLength = [AMJSONStreamResponse estimatedLengthOfJSONObject:self.dictionary];
+  if (estimatedLength >= FBStreamingResponseThreshold) {
+    BOOL shouldCompress = isCompressionEnabled && estimatedLength >= (NSUInteger)threshold;
+    AMJSONStreamResponse *streamResponse = [[AMJSONStreamResponse alloc] initWithJSONObject:self.dictionary
+                                                                            contentEncoding:shouldCompress ? contentEncoding : nil];
+    if (nil != streamResponse.contentEncoding) {
+      [response setHeader:@"Content-Encoding" value:(NSString *)streamResponse.contentEncoding];
+      [response setHeader:@"Vary" value:@"Accept-Encoding"];
+    }
+    response.response = streamResponse;
+    return;
+  }
+
   NSError *error;
-  NSData *jsonData = [NSJSONSerialization dataWithJSONObject:self.dictionary
+  NSData *jsonData = [NSJSONSerialization dataWithJSONObject:FBJSONSerializableObject(self.dictionary)
                                                      options:NSJSONWritingPrettyPrinted
                                                        error:&error];
   NSCAssert(jsonData, @"Valid JSON must be responded, error of %@", error);
-  [response setHeader:@"Content-Type" value:@"application/json;charset=UTF-8"];
-  [response setStatusCode:self.httpStatusCode];
+  if (isCompressionEnabled && jsonData.length >= (NSUInteger)threshold) {
+    NSData *compressedData = [jsonData am_compressedDataWithContentEncoding:contentEncoding];
+    if (nil != compressedData) {
+      [response setHeader:@"Content-Encoding" value:contentEncoding];
+      [response setHeader:@"Vary" value:@"Accept-Encoding"];
+      [response respondWithData:compressedData];
+      return;
+    }
+  }
   [response respondWithData:jsonData];
 }
 
@@ -12,6 +12,7 @@
 #import <WebDriverAgentLib/FBCommandStatus.h>
 
 @class FBElementCache;
+@class FBRouteRequest;
 @class RouteResponse;
 @class XCUIElement;
 @protocol FBResponsePayload;
@@ -24,7 +25,8 @@ NS_ASSUME_NONNULL_BEGIN
 id<FBResponsePayload> FBResponseWithOK(void);
 
 /**
- Returns 'FBCommandStatusNoError' response payload with given 'object'
+ Returns 'FBCommandStatusNoError' response payload with given 'object'.
+ NSData instances inside of the object are serialized as base64-encoded strings
  */
 id<FBResponsePayload> FBResponseWithObject(id _Nullable object);
 
@@ -63,6 +65,12 @@ id<FBResponsePayload> FBResponseWithStatus(FBCommandStatus *status);
  */
 - (void)dispatchWithResponse:(RouteResponse *)response;
 
+/**
+ Dispatch constructed payload into given response taking into account
+ preferences of the given request, like accepted content encodings
+ */
+- (void)dispatchWithResponse:(RouteResponse *)response forRequest:(FBRouteRequest *)request;
+
 @end
 
 NS_ASSUME_NONNULL_END
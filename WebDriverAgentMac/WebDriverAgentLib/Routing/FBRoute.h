@@ -10,6 +10,7 @@
 #import <Foundation/Foundation.h>
 
 @protocol FBResponsePayload;
+@class AMRouteMetrics;
 @class FBRouteRequest;
 @class RouteResponse;
 
@@ -28,6 +29,9 @@ typedef __nonnull id<FBResponsePayload> (^FBRouteSyncHandler)(FBRouteRequest *re
 /*! Route's path */
 @property (nonatomic, copy, readonly) NSString *path;
 
+/*! Optional metrics to record handler and response timings to */
+@property (nonatomic, strong, nullable) AMRouteMetrics *metrics;
+
 /**
  Convenience constructor for GET route with given pathPattern
  */
@@ -68,6 +72,13 @@ typedef __nonnull id<FBResponsePayload> (^FBRouteSyncHandler)(FBRouteRequest *re
  */
 - (instancetype)withoutSession;
 
+/**
+ Chain-able constructor for route that synthesizes input events. Such routes are rejected
+ while an asynchronous actions operation of the same session is running,
+ so events of different commands never get mixed up
+ */
+- (instancetype)synthesizingInput;
+
 /**
  Dispatches response for request
  */
@@ -12,17 +12,28 @@
 
 #import <objc/message.h>
 
+#import "AMActionsOperation.h"
+#import "AMHistogram.h"
+#import "AMJSONStreamResponse.h"
+#import "AMRouteMetrics.h"
 #import "FBExceptionHandler.h"
 #import "FBExceptions.h"
 #import "FBResponsePayload.h"
 #import "FBSession.h"
+#import "FBSession-Private.h"
+#import "RouteResponse.h"
 
 @interface FBRoute ()
 @property (nonatomic, assign, readwrite) BOOL requiresSession;
+@property (nonatomic, assign, readwrite) BOOL synthesizesInput;
 @property (nonatomic, copy, readwrite) NSString *verb;
 @property (nonatomic, copy, readwrite) NSString *path;
 
 - (void)decorateRequest:(FBRouteRequest *)request;
+- (void)dispatchPayload:(id<FBResponsePayload>)payload
+             forRequest:(FBRouteRequest *)request
+           intoResponse:(RouteResponse *)response
+       handlerStartedAt:(uint64_t)handlerStartedAt;
 
 @end
 
@@ -39,9 +50,10 @@ static NSString *const FBRouteSessionPrefix = @"/session/:sessionID";
 - (void)mountRequest:(FBRouteRequest *)request intoResponse:(RouteResponse *)response
 {
   [self decorateRequest:request];
+  uint64_t handlerStartedAt = AMMonotonicTimestamp();
   id<FBResponsePayload> (*requestMsgSend)(id, SEL, FBRouteRequest *) = ((id<FBResponsePayload>(*)(id, SEL, FBRouteRequest *))objc_msgSend);
   id<FBResponsePayload> payload = requestMsgSend(self.target, self.action, request);
-  [payload dispatchWithResponse:response];
+  [self dispatchPayload:payload forRequest:request intoResponse:response handlerStartedAt:handlerStartedAt];
 }
 
 @end
@@ -57,8 +69,9 @@ static NSString *const FBRouteSessionPrefix = @"/session/:sessionID";
 - (void)mountRequest:(FBRouteRequest *)request intoResponse:(RouteResponse *)response
 {
   [self decorateRequest:request];
+  uint64_t handlerStartedAt = AMMonotonicTimestamp();
   id<FBResponsePayload> payload = self.handler(request);
-  [payload dispatchWithResponse:response];
+  [self dispatchPayload:payload forRequest:request intoResponse:response handlerStartedAt:handlerStartedAt];
 }
 
 @end
@@ -124,9 +137,16 @@ static NSString *const FBRouteSessionPrefix = @"/session/:sessionID";
   return self;
 }
 
+- (instancetype)synthesizingInput
+{
+  self.synthesizesInput = YES;
+  return self;
+}
+
 - (instancetype)respondWithBlock:(FBRouteSyncHandler)handler
 {
   FBRoute_Sync *route = [FBRoute_Sync withVerb:self.verb path:self.path requiresSession:self.requiresSession];
+  route.synthesizesInput = self.synthesizesInput;
   route.handler = handler;
   return route;
 }
@@ -134,6 +154,7 @@ static NSString *const FBRouteSessionPrefix = @"/session/:sessionID";
 - (instancetype)respondWithTarget:(id)target action:(SEL)action
 {
   FBRoute_TargetAction *route = [FBRoute_TargetAction withVerb:self.verb path:self.path requiresSession:self.requiresSession];
+  route.synthesizesInput = self.synthesizesInput;
   route.target = target;
   route.action = action;
   return route;
@@ -155,6 +176,41 @@ static NSString *const FBRouteSessionPrefix = @"/session/:sessionID";
     return;
   }
   request.session = session;
+  [FBSession markSessionActive:session];
+  AMActionsOperation *runningOperation = self.synthesizesInput ? session.runningActionsOperation : nil;
+  if (nil != runningOperation) {
+    NSString *reason = [NSString stringWithFormat:@"The actions operation '%@' is still synthesizing events. Wait until it is finished before sending more input",
+                        runningOperation.identifier];
+    [[NSException exceptionWithName:FBInvalidElementStateException reason:reason userInfo:nil] raise];
+  }
+}
+
+- (void)dispatchPayload:(id<FBResponsePayload>)payload
+             forRequest:(FBRouteRequest *)request
+           intoResponse:(RouteResponse *)response
+       handlerStartedAt:(uint64_t)handlerStartedAt
+{
+  AMRouteMetrics *metrics = self.metrics;
+  if (nil == metrics) {
+    [payload dispatchWithResponse:response forRequest:request];
+    return;
+  }
+
+  uint64_t serializationStartedAt = AMMonotonicTimestamp();
+  [metrics.handler recordValue:serializationStartedAt - handlerStartedAt];
+  [payload dispatchWithResponse:response forRequest:request];
+  [metrics.responseSerialization recordValue:AMMonotonicTimestamp() - serializationStartedAt];
+
+  NSObject<HTTPResponse> *httpResponse = response.response;
+  if ([httpResponse isKindOfClass:AMJSONStreamResponse.class]) {
+    // The size of streamed responses is only known after the last chunk is sent
+    AMHistogram *responseSize = metrics.responseSize;
+    ((AMJSONStreamResponse *)httpResponse).completionHandler = ^(UInt64 bytesSent) {
+      [responseSize recordValue:bytesSent];
+    };
+  } else if (nil != httpResponse) {
+    [metrics.responseSize recordValue:httpResponse.contentLength];
+  }
 }
 
 - (void)raiseNoSessionException
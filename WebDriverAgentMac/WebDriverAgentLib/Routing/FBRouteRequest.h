@@ -27,6 +27,9 @@ NS_ASSUME_NONNULL_BEGIN
 /*! Arguments sent with that request */
 @property (nonatomic, copy, readonly) NSDictionary *arguments;
 
+/*! HTTP headers sent with that request */
+@property (nonatomic, copy, readonly) NSDictionary<NSString *, NSString *> *headers;
+
 /*! Session associated with that request */
 @property (nonatomic, strong, readonly) FBSession *session;
 
@@ -35,6 +38,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (instancetype)routeRequestWithURL:(NSURL *)URL parameters:(NSDictionary *)parameters arguments:(NSDictionary *)arguments;
 
+/**
+ Convenience constructor for request with HTTP headers
+ */
++ (instancetype)routeRequestWithURL:(NSURL *)URL
+                         parameters:(NSDictionary *)parameters
+                          arguments:(NSDictionary *)arguments
+                            headers:(NSDictionary<NSString *, NSString *> *)headers;
+
+/**
+ Retrieves the value of the HTTP header with the given name
+
+ @param name the header name. The lookup is case-insensitive
+ @returns the header value or nil if no such header has been sent
+ */
+- (nullable NSString *)headerWithName:(NSString *)name;
+
 /**
  Retrieves request JSON body argument with the given name
 
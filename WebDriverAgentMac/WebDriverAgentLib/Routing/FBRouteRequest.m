@@ -14,11 +14,20 @@
 @implementation FBRouteRequest
 
 + (instancetype)routeRequestWithURL:(NSURL *)URL parameters:(NSDictionary *)parameters arguments:(NSDictionary *)arguments
+{
+  return [self routeRequestWithURL:URL parameters:parameters arguments:arguments headers:@{}];
+}
+
++ (instancetype)routeRequestWithURL:(NSURL *)URL
+                         parameters:(NSDictionary *)parameters
+                          arguments:(NSDictionary *)arguments
+                            headers:(NSDictionary<NSString *, NSString *> *)headers
 {
   FBRouteRequest *request = [self.class new];
   request.URL = URL;
   request.parameters = parameters;
   request.arguments = arguments;
+  request.headers = headers;
   return request;
 }
 
@@ -74,6 +83,20 @@
   return (NSString *)value;
 }
 
+- (NSString *)headerWithName:(NSString *)name
+{
+  NSString *value = self.headers[name];
+  if (nil != value) {
+    return value;
+  }
+  for (NSString *headerName in self.headers) {
+    if ([headerName caseInsensitiveCompare:name] == NSOrderedSame) {
+      return self.headers[headerName];
+    }
+  }
+  return nil;
+}
+
 - (NSString *)elementUuid
 {
   return (NSString *)self.parameters[@"uuid"];
@@ -18,7 +18,8 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readwrite) FBElementCache *elementCache;
 
 /**
- Sets session as current session
+ Sets session as current session, which the following commands are executed for.
+ The application under test of the session is only activated when the active session changes
  */
 + (void)markSessionActive:(FBSession *)session;
 
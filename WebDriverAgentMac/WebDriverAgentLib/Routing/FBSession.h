@@ -9,7 +9,7 @@
 
 #import <XCTest/XCTest.h>
 
-@class FBElementCache;
+@class AMActionsOperation, AMW3CActionsSequence, FBElementCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -41,11 +41,77 @@ extern NSString *const FINDER_BUNDLE_ID;
  */
 @property (nonatomic) BOOL boundElementsByIndex;
 
+/**
+ Parses the given predicate string and formats it for element lookup with NSPredicate fb_formatSearchPredicate:.
+ Results are memoized per session and keyed by the raw string, so repeated lookups
+ with the same predicate skip both parsing and formatting.
+
+ @param format The raw predicate string
+ @return The formatted search predicate
+ @throws NSInvalidArgumentException if the predicate string cannot be parsed
+ @throws FBUnknownPredicateKeyException if the predicate contains unknown attribute names
+ */
+- (NSPredicate *)searchPredicateWithFormat:(NSString *)format;
+
+/**
+ Stores the given actions sequence in scope of the session, so it could be replayed by its identifier.
+ Only a limited amount of the most recently used sequences is kept
+
+ @param sequence The sequence to store
+ */
+- (void)registerActionsSequence:(AMW3CActionsSequence *)sequence;
+
+/**
+ Fetches the actions sequence previously stored by registerActionsSequence:
+
+ @param identifier The sequence identifier
+ @return The sequence or nil if no sequence with the given identifier is registered
+ */
+- (nullable AMW3CActionsSequence *)actionsSequenceWithIdentifier:(NSString *)identifier;
+
+/**
+ Removes the actions sequence from the session
+
+ @param identifier The sequence identifier
+ @return YES if the sequence has been removed or NO if it was not registered
+ */
+- (BOOL)unregisterActionsSequenceWithIdentifier:(NSString *)identifier;
+
+/**
+ Stores the given asynchronous actions operation in scope of the session, so its status could be queried.
+ Only a limited amount of the most recent operations is kept
+
+ @param operation The operation to store. nil values are ignored
+ */
+- (void)registerActionsOperation:(AMActionsOperation *)operation;
+
+/**
+ Fetches the actions operation previously stored by registerActionsOperation:
+
+ @param identifier The operation identifier
+ @return The operation or nil if no operation with the given identifier is known
+ */
+- (nullable AMActionsOperation *)actionsOperationWithIdentifier:(NSString *)identifier;
+
+/**
+ @return The asynchronous actions operation of the session, which is still synthesizing events,
+ or an operation of a killed session, which is still finishing in background, or nil if there is none
+ */
+- (nullable AMActionsOperation *)runningActionsOperation;
+
+/**
+ The session the currently executed command belongs to.
+ This is the most recently created session if no command has been executed since then
+ */
 + (nullable instancetype)activeSession;
 
+/**
+ @return All sessions, which are currently registered
+ */
++ (NSArray<FBSession *> *)allSessions;
+
 /**
  Fetches session for given identifier.
- If identifier doesn't match activeSession identifier, will return nil.
 
  @param identifier Identifier for searched session
  @return session. Can return nil if session does not exists
@@ -53,7 +119,7 @@ extern NSString *const FINDER_BUNDLE_ID;
 + (nullable instancetype)sessionWithIdentifier:(NSString *)identifier;
 
 /**
- Creates and saves new session for application
+ Creates and saves new session for application. All other sessions are killed
 
  @param application The application that we want to create session for
  @return new session
@@ -61,7 +127,42 @@ extern NSString *const FINDER_BUNDLE_ID;
 + (instancetype)initWithApplication:(nullable XCUIApplication *)application;
 
 /**
- Kills application associated with that session and removes session
+ Creates and saves new session for application
+
+ @param application The application that we want to create session for
+ @param concurrent Whether to keep other registered sessions alive. If NO then all of them are killed
+ @return new session
+ */
++ (instancetype)initWithApplication:(nullable XCUIApplication *)application concurrent:(BOOL)concurrent;
+
+/**
+ Kills all registered sessions
+ */
++ (void)killAllSessions;
+
+/**
+ Waits until the background teardown of killed sessions is finished.
+ The main run loop is spinning while waiting
+
+ @param timeout The maximum amount of seconds to wait
+ @return YES if all pending teardowns have been finished within the given timeout
+ */
++ (BOOL)waitForPendingTeardownsWithTimeout:(NSTimeInterval)timeout;
+
+/**
+ Waits until the application with the given bundle identifier, which belonged to a killed session,
+ is terminated in background. Returns immediately if the application is not being terminated.
+ The main run loop is spinning while waiting
+
+ @param bundleId The bundle identifier of the application
+ */
++ (void)waitForTerminationOfApplicationWithBundleId:(nullable NSString *)bundleId;
+
+/**
+ Removes the session and detaches its state. The running actions operation of the session is abandoned.
+ The application associated with that session is terminated once the operation is finished,
+ and the active video recording is finalized in background,
+ so this method returns as soon as the session is removed
  */
 - (void)kill;
 
@@ -12,10 +12,16 @@
 
 #import <objc/runtime.h>
 
+#import "AMActionsOperation.h"
+#import "AMApplicationPool.h"
+#import "AMW3CActionsSequence.h"
 #import "FBConfiguration.h"
 #import "FBElementCache.h"
 #import "FBExceptions.h"
 #import "FBMacros.h"
+#import "FBRunLoopSpinner.h"
+#import "LRUCache.h"
+#import "NSPredicate+FBFormat.h"
 #import "XCUIApplication+AMHelpers.h"
 #import "FBScreenRecordingContainer.h"
 #import "FBScreenRecordingPromise.h"
@@ -23,23 +29,66 @@
 
 NSString *const FINDER_BUNDLE_ID = @"com.apple.finder";
 
+static const NSUInteger SEARCH_PREDICATES_CACHE_SIZE = 256;
+static const NSUInteger ACTIONS_OPERATIONS_CACHE_SIZE = 64;
+static const NSUInteger ACTIONS_SEQUENCES_CACHE_SIZE = 64;
+static const NSTimeInterval APP_TERMINATION_TIMEOUT = 10.0;
+static const useconds_t APP_TERMINATION_POLL_INTERVAL_USEC = 50000;
+static const NSTimeInterval ACTIONS_OPERATION_ABANDON_TIMEOUT = 60.0;
+
 @interface FBSession ()
 @property (nonatomic, nullable) XCUIApplication *testedApplication;
+@property (nonatomic) LRUCache *searchPredicatesCache;
+@property (nonatomic) LRUCache *actionsSequences;
+@property (nonatomic) LRUCache *actionsOperations;
+/*! The most recently started operation. Only one operation might be running at a time */
+@property (atomic, nullable) AMActionsOperation *lastActionsOperation;
 @end
 
 @implementation FBSession
 
 static FBSession *_activeSession = nil;
 
++ (NSMutableDictionary<NSString *, FBSession *> *)registry
+{
+  static NSMutableDictionary<NSString *, FBSession *> *sessions;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sessions = [NSMutableDictionary dictionary];
+  });
+  return sessions;
+}
+
 + (instancetype)activeSession
 {
-  return _activeSession;
+  @synchronized (self.registry) {
+    return _activeSession;
+  }
 }
 
 + (void)markSessionActive:(FBSession *)session
 {
-  [_activeSession kill];
-  _activeSession = session;
+  @synchronized (self.registry) {
+    if (_activeSession == session) {
+      // Most commands keep targeting the same session, which needs no XCTest roundtrips
+      return;
+    }
+    _activeSession = session;
+  }
+  // Keyboard and pointer events are always delivered to the foreground application,
+  // so it must be switched as soon as commands of another session arrive.
+  // This also covers the remaining session after the active one has been deleted
+  XCUIApplication *application = session.testedApplication;
+  if (nil != application && application.state == XCUIApplicationStateRunningBackground) {
+    [application activate];
+  }
+}
+
++ (NSArray<FBSession *> *)allSessions
+{
+  @synchronized (self.registry) {
+    return self.registry.allValues;
+  }
 }
 
 + (instancetype)sessionWithIdentifier:(NSString *)identifier
@@ -47,44 +96,306 @@ static FBSession *_activeSession = nil;
   if (!identifier) {
     return nil;
   }
-  if (![identifier isEqualToString:_activeSession.identifier]) {
-    return nil;
+  @synchronized (self.registry) {
+    return [self.registry objectForKey:identifier];
+  }
+}
+
++ (void)killAllSessions
+{
+  for (FBSession *session in self.allSessions) {
+    [session kill];
   }
-  return _activeSession;
 }
 
 + (instancetype)initWithApplication:(XCUIApplication *)application
 {
+  return [self initWithApplication:application concurrent:NO];
+}
+
++ (instancetype)initWithApplication:(XCUIApplication *)application concurrent:(BOOL)concurrent
+{
+  if (!concurrent) {
+    [self killAllSessions];
+  }
   FBSession *session = [FBSession new];
   session.identifier = [[NSUUID UUID] UUIDString];
   session.testedApplication = application;
   session.elementCache = [FBElementCache new];
+  session.searchPredicatesCache = [[LRUCache alloc] initWithCapacity:SEARCH_PREDICATES_CACHE_SIZE];
+  session.actionsSequences = [[LRUCache alloc] initWithCapacity:ACTIONS_SEQUENCES_CACHE_SIZE];
+  session.actionsOperations = [[LRUCache alloc] initWithCapacity:ACTIONS_OPERATIONS_CACHE_SIZE];
+  @synchronized (self.registry) {
+    [self.registry setObject:session forKey:session.identifier];
+  }
   [FBSession markSessionActive:session];
   return session;
 }
 
++ (dispatch_group_t)teardownGroup
+{
+  static dispatch_group_t group;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    group = dispatch_group_create();
+  });
+  return group;
+}
+
++ (NSCountedSet<NSString *> *)terminatingBundleIds
+{
+  static NSCountedSet<NSString *> *bundleIds;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    bundleIds = [NSCountedSet set];
+  });
+  return bundleIds;
+}
+
++ (void)waitForTerminationOfApplicationWithBundleId:(NSString *)bundleId
+{
+  if (nil == bundleId) {
+    return;
+  }
+  NSCountedSet<NSString *> *bundleIds = self.terminatingBundleIds;
+  [[[FBRunLoopSpinner new]
+    timeout:APP_TERMINATION_TIMEOUT]
+   spinUntilTrue:^BOOL{
+    @synchronized (bundleIds) {
+      return 0 == [bundleIds countForObject:bundleId];
+    }
+  }];
+}
+
++ (NSMutableSet<AMActionsOperation *> *)abandonedActionsOperations
+{
+  static NSMutableSet<AMActionsOperation *> *operations;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    operations = [NSMutableSet set];
+  });
+  return operations;
+}
+
++ (void)finishAbandonedActionsOperation:(nullable AMActionsOperation *)operation
+{
+  if (nil == operation) {
+    return;
+  }
+  if (![operation waitUntilFinishedWithTimeout:ACTIONS_OPERATION_ABANDON_TIMEOUT]) {
+    NSLog(@"The actions operation '%@' is still running after %@ seconds", operation.identifier, @(ACTIONS_OPERATION_ABANDON_TIMEOUT));
+  }
+  @synchronized (self.abandonedActionsOperations) {
+    [self.abandonedActionsOperations removeObject:operation];
+  }
+}
+
++ (void)terminateApplication:(NSRunningApplication *)application
+{
+  pid_t pid = application.processIdentifier;
+  if (![application forceTerminate]) {
+    NSLog(@"Could not terminate the application '%@' (pid %d)", application.bundleIdentifier, pid);
+    return;
+  }
+  // NSRunningApplication properties are only updated on the main run loop,
+  // so the process is polled directly
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:APP_TERMINATION_TIMEOUT];
+  while (0 == kill(pid, 0) && [deadline timeIntervalSinceNow] > 0) {
+    usleep(APP_TERMINATION_POLL_INTERVAL_USEC);
+  }
+}
+
++ (BOOL)waitForPendingTeardownsWithTimeout:(NSTimeInterval)timeout
+{
+  // The recording finalization reply might be delivered to the main run loop,
+  // so it must keep spinning while waiting
+  return [[[FBRunLoopSpinner new]
+           timeout:timeout]
+          spinUntilTrue:^BOOL{
+    return 0 == dispatch_group_wait(self.teardownGroup, DISPATCH_TIME_NOW);
+  }];
+}
+
 - (void)kill
 {
-  if (!self.skipAppTermination
-      && nil != self.testedApplication
-      && self.testedApplication.state > XCUIApplicationStateNotRunning
-      && ![self.testedApplication.am_bundleID isEqualToString:FINDER_BUNDLE_ID]) {
-    [self.testedApplication terminate];
+  // Events of a running gesture cannot be recalled. The operation is finished in background,
+  // while input commands of other sessions are rejected until it is done
+  AMActionsOperation *abandonedOperation = self.lastActionsOperation;
+  if (AMActionsOperationStateRunning == abandonedOperation.state) {
+    [abandonedOperation abandon];
+    @synchronized (FBSession.abandonedActionsOperations) {
+      [FBSession.abandonedActionsOperations addObject:abandonedOperation];
+    }
+  } else {
+    abandonedOperation = nil;
   }
-  self.testedApplication = nil;
+  self.lastActionsOperation = nil;
+  // Only detach the session state here. Everything slow happens in background,
+  // so the next session could be created without waiting for it
+  NSRunningApplication *applicationToTerminate = [self detachTestedApplication];
+  BOOL isLastSession;
+  @synchronized (FBSession.registry) {
+    [FBSession.registry removeObjectForKey:self.identifier];
+    if (_activeSession == self) {
+      _activeSession = nil;
+    }
+    isLastSession = 0 == FBSession.registry.count;
+  }
+  // The screen recording is shared between concurrent sessions
   FBScreenRecordingContainer *screenRecordingContainer = FBScreenRecordingContainer.sharedInstance;
-  NSUUID *videoRecordingId = screenRecordingContainer.screenRecordingPromise.identifier;
+  NSUUID *videoRecordingId = nil;
+  if (isLastSession && nil != screenRecordingContainer.screenRecordingPromise) {
+    videoRecordingId = screenRecordingContainer.screenRecordingPromise.identifier;
+    [screenRecordingContainer reset];
+  }
+  FBElementCache *elementCache = self.elementCache;
+  self.elementCache = [FBElementCache new];
+  @synchronized (self.actionsSequences) {
+    [self.actionsSequences removeAllObjects];
+  }
+
+  dispatch_group_t group = FBSession.teardownGroup;
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+  NSCountedSet<NSString *> *terminatingBundleIds = FBSession.terminatingBundleIds;
+  NSString *terminatingBundleId = applicationToTerminate.bundleIdentifier;
+  if (nil != terminatingBundleId) {
+    @synchronized (terminatingBundleIds) {
+      [terminatingBundleIds addObject:terminatingBundleId];
+    }
+  }
+  if (nil != terminatingBundleId || nil != abandonedOperation) {
+    dispatch_group_async(group, queue, ^{
+      // The rest of the abandoned gesture is still delivered to the application being torn down
+      [FBSession finishAbandonedActionsOperation:abandonedOperation];
+      if (nil == terminatingBundleId) {
+        return;
+      }
+      [FBSession terminateApplication:(id)applicationToTerminate];
+      @synchronized (terminatingBundleIds) {
+        [terminatingBundleIds removeObject:terminatingBundleId];
+      }
+    });
+  }
   if (nil != videoRecordingId) {
-    NSError *error;
-    if (![AMVideoRecorder.sharedInstance stopScreenRecordingWithUUID:videoRecordingId error:&error]) {
-      NSLog(@"Could not stop the active video recording. Original error: %@", error.description);
+    dispatch_group_enter(group);
+    [AMVideoRecorder.sharedInstance stopScreenRecordingWithUUID:(id)videoRecordingId completion:^(NSError *error) {
+      if (nil != error) {
+        NSLog(@"Could not stop the active video recording. Original error: %@", error.description);
+      }
+      dispatch_group_leave(group);
+    }];
+  }
+  // Releasing cached elements might take a while if there are many of them
+  dispatch_group_async(group, queue, ^{
+    [elementCache reset];
+  });
+}
+
+/**
+ Detaches the application under test from the session
+
+ @return The process of the application under test, which must be terminated, or nil.
+ The process handle is bound to the pid of the instance this session has been working with,
+ so it could be terminated off the main thread without affecting any other instance of the same app
+ */
+- (nullable NSRunningApplication *)detachTestedApplication
+{
+  XCUIApplication *application = self.testedApplication;
+  self.testedApplication = nil;
+  if (self.skipAppTermination || nil == application) {
+    return nil;
+  }
+  NSString *bundleId = application.am_bundleID;
+  if (nil == bundleId || [bundleId isEqualToString:FINDER_BUNDLE_ID]) {
+    return nil;
+  }
+  for (FBSession *session in FBSession.allSessions) {
+    if (session != self && [session.testedApplication.am_bundleID isEqualToString:bundleId]) {
+      // The application is still in use by a concurrent session
+      return nil;
     }
   }
-  if (nil != screenRecordingContainer.screenRecordingPromise) {
-    [screenRecordingContainer reset];
+  pid_t pid = application.am_processID;
+  NSRunningApplication *runningApplication = pid > 0
+    ? [NSRunningApplication runningApplicationWithProcessIdentifier:pid]
+    : nil;
+  if (nil == runningApplication || [AMApplicationPool.sharedPool recycleApplication:application]) {
+    return nil;
+  }
+  return runningApplication;
+}
+
+- (NSPredicate *)searchPredicateWithFormat:(NSString *)format
+{
+  NSPredicate *result;
+  @synchronized (self.searchPredicatesCache) {
+    result = [self.searchPredicatesCache objectForKey:format];
+  }
+  if (nil != result) {
+    return result;
+  }
+  result = [NSPredicate fb_formatSearchPredicate:[NSPredicate predicateWithFormat:format]];
+  @synchronized (self.searchPredicatesCache) {
+    [self.searchPredicatesCache setObject:result forKey:format.copy];
+  }
+  return result;
+}
+
+- (void)registerActionsSequence:(AMW3CActionsSequence *)sequence
+{
+  @synchronized (self.actionsSequences) {
+    [self.actionsSequences setObject:sequence forKey:sequence.identifier];
+  }
+}
+
+- (AMW3CActionsSequence *)actionsSequenceWithIdentifier:(NSString *)identifier
+{
+  @synchronized (self.actionsSequences) {
+    return [self.actionsSequences objectForKey:identifier];
+  }
+}
+
+- (BOOL)unregisterActionsSequenceWithIdentifier:(NSString *)identifier
+{
+  @synchronized (self.actionsSequences) {
+    return nil != [self.actionsSequences removeObjectForKey:identifier];
+  }
+}
+
+- (void)registerActionsOperation:(AMActionsOperation *)operation
+{
+  NSParameterAssert(operation);
+  if (nil == operation) {
+    return;
+  }
+  @synchronized (self.actionsOperations) {
+    [self.actionsOperations setObject:operation forKey:operation.identifier];
+  }
+  self.lastActionsOperation = operation;
+}
+
+- (AMActionsOperation *)runningActionsOperation
+{
+  AMActionsOperation *operation = self.lastActionsOperation;
+  if (AMActionsOperationStateRunning == operation.state) {
+    return operation;
+  }
+  // Gestures of killed sessions still deliver events to whatever application is in foreground
+  @synchronized (FBSession.abandonedActionsOperations) {
+    for (AMActionsOperation *abandonedOperation in FBSession.abandonedActionsOperations) {
+      if (AMActionsOperationStateRunning == abandonedOperation.state) {
+        return abandonedOperation;
+      }
+    }
+  }
+  return nil;
+}
+
+- (AMActionsOperation *)actionsOperationWithIdentifier:(NSString *)identifier
+{
+  @synchronized (self.actionsOperations) {
+    return [self.actionsOperations objectForKey:identifier];
   }
-  [self.elementCache reset];
-  _activeSession = nil;
 }
 
 - (XCUIApplication *)currentApplication
@@ -105,10 +416,13 @@ static FBSession *_activeSession = nil;
                                        environment:(nullable NSDictionary <NSString *, NSString *> *)environment
 {
   XCUIApplication *app = [self applicationWithBundleId:bundleIdentifier orPath:path];
-  if (app.state <= XCUIApplicationStateNotRunning) {
+  [FBSession waitForTerminationOfApplicationWithBundleId:app.am_bundleID];
+  // Pooled applications are running by definition, although their launch options must still be matched
+  if (app.state <= XCUIApplicationStateNotRunning
+      || [AMApplicationPool.sharedPool containsApplicationWithBundleId:app.am_bundleID]) {
     app.launchArguments = arguments ?: @[];
     app.launchEnvironment = environment ?: @{};
-    [app launch];
+    [AMApplicationPool.sharedPool launchApplication:app];
   } else {
     [app activate];
   }
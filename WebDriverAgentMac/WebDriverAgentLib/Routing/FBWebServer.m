@@ -12,6 +12,10 @@
 #import "RoutingConnection.h"
 #import "RoutingHTTPServer.h"
 
+#import "AMApplicationPool.h"
+#import "AMHistogram.h"
+#import "AMRouteMetrics.h"
+#import "AMTrace.h"
 #import "FBCommandHandler.h"
 #import "FBErrorBuilder.h"
 #import "FBExceptionHandler.h"
@@ -24,6 +28,7 @@
 
 static NSString *const FBServerURLBeginMarker = @"ServerURLHere->";
 static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
+static const NSTimeInterval SESSION_TEARDOWN_TIMEOUT = 30.0;
 
 @interface FBHTTPConnection : RoutingConnection
 @end
@@ -87,6 +92,12 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
   [self registerRouteHandlers:[self.class collectCommandHandlerClasses]];
   [self registerServerKeyRouteHandlers];
 
+  NSString *unixSocketPath = FBConfiguration.sharedConfiguration.serverUnixSocketPath;
+  if (nil != unixSocketPath) {
+    [self startHTTPServerOnUnixSocketWithPath:unixSocketPath];
+    return;
+  }
+
   NSRange serverPortRange = FBConfiguration.sharedConfiguration.bindingPortRange;
   NSError *error;
   BOOL serverStarted = NO;
@@ -104,18 +115,37 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
   }
 
   if (!serverStarted) {
-    [FBLogger logFmt:@"Last attempt to start web server failed with error %@", [error description]];
+    [FBLogger logWithLevel:FBLogLevelError message:[NSString stringWithFormat:@"Last attempt to start web server failed with error %@", [error description]]];
+    [FBLogger flush];
     abort();
   }
   [FBLogger logFmt:@"%@http://%@:%d%@", FBServerURLBeginMarker, @"localhost", [self.server port], FBServerURLEndMarker];
 }
 
+- (void)startHTTPServerOnUnixSocketWithPath:(NSString *)path
+{
+  // There is no need to iterate over a range of ports here, since the socket path
+  // is owned by the launching process and a stale socket file is simply replaced
+  NSURL *socketUrl = [NSURL fileURLWithPath:path];
+  [self.server setUnixSocketUrl:socketUrl];
+  NSError *error;
+  if (![self.server start:&error]) {
+    [FBLogger logWithLevel:FBLogLevelError message:[NSString stringWithFormat:@"Failed to start web server on the unix socket '%@' with error %@", path, [error description]]];
+    [FBLogger flush];
+    abort();
+  }
+  [FBLogger logFmt:@"%@unix://%@%@", FBServerURLBeginMarker, socketUrl.path, FBServerURLEndMarker];
+}
+
 - (void)stopServing
 {
-  [FBSession.activeSession kill];
+  [FBSession killAllSessions];
+  [AMApplicationPool.sharedPool drain];
+  [FBSession waitForPendingTeardownsWithTimeout:SESSION_TEARDOWN_TIMEOUT];
   if (self.server.isRunning) {
     [self.server stop:NO];
   }
+  [FBLogger flush];
   self.keepAlive = NO;
 }
 
@@ -147,9 +177,15 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
   for (Class<FBCommandHandler> commandHandler in commandHandlerClasses) {
     NSArray *routes = [commandHandler routes];
     for (FBRoute *route in routes) {
+      AMRouteMetrics *metrics = [AMRouteMetrics metricsForRouteWithVerb:route.verb path:route.path];
+      route.metrics = metrics;
       [self.server handleMethod:route.verb
                        withPath:route.path
                           block:^(RouteRequest *request, RouteResponse *response) {
+        uint64_t parsingStartedAt = AMMonotonicTimestamp();
+        [metrics.queueWait recordValue:parsingStartedAt - request.receivedAt];
+        AMTrace *trace = [self.class startTraceForRequest:request];
+        AMTraceSpan *routeSpan = [AMTrace beginSpanWithName:[NSString stringWithFormat:@"%@ %@", route.verb, route.path]];
         NSDictionary *arguments = nil;
         if ([request.body length]) {
           NSError *error = nil;
@@ -164,9 +200,23 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
           routeRequestWithURL:request.url
           parameters:request.params
           arguments:arguments ?: @{}
+          headers:request.headers ?: @{}
         ];
-
-        [FBLogger verboseLog:routeParams.description];
+        [metrics.requestParsing recordValue:AMMonotonicTimestamp() - parsingStartedAt];
+
+        if ([FBLogger isLevelEnabled:FBLogLevelVerbose]) {
+          // Only immutable values could be captured, since the message is built asynchronously
+          NSURL *url = request.url;
+          NSDictionary *params = [request.params copy];
+          NSData *body = request.body;
+          [FBLogger logWithLevel:FBLogLevelVerbose messageBlock:^NSString *{
+            NSString *bodyString = 0 == body.length
+              ? @"{}"
+              : [[NSString alloc] initWithData:body encoding:NSUTF8StringEncoding];
+            return [NSString stringWithFormat:@"Request URL %@ | Params %@ | Arguments %@",
+                    url, params, bodyString ?: [NSString stringWithFormat:@"<%lu bytes>", (unsigned long)body.length]];
+          }];
+        }
 
         @try {
           [route mountRequest:routeParams intoResponse:response];
@@ -174,11 +224,36 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
         @catch (NSException *exception) {
           [self handleException:exception forResponse:response];
         }
+
+        [routeSpan end];
+        if (nil != trace) {
+          [AMTrace finishCurrentTrace];
+          [response setHeader:AM_TRACE_SPANS_HEADER value:trace.chromeTraceEventsJSONString];
+        }
       }];
     }
   }
 }
 
++ (nullable AMTrace *)startTraceForRequest:(RouteRequest *)request
+{
+  NSString *traceId = [request header:AM_TRACE_ID_HEADER];
+  if (0 == traceId.length) {
+    return nil;
+  }
+  // The identifier is echoed back in a header value, so only accept safe characters
+  static NSCharacterSet *forbiddenCharacters;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    forbiddenCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdefABCDEFghijklmnopqrstuvwxyzGHIJKLMNOPQRSTUVWXYZ-_."] invertedSet];
+  });
+  if (traceId.length > 128 || [traceId rangeOfCharacterFromSet:forbiddenCharacters].location != NSNotFound) {
+    [FBLogger logFmt:@"Ignoring the invalid %@ header value '%@'", AM_TRACE_ID_HEADER, traceId];
+    return nil;
+  }
+  return [AMTrace startTraceWithIdentifier:traceId];
+}
+
 - (void)handleException:(NSException *)exception forResponse:(RouteResponse *)response
 {
   [self.exceptionHandler handleException:exception forResponse:response];
@@ -190,9 +265,16 @@ static NSString *const FBServerURLEndMarker = @"<-ServerURLHere";
     [response respondWithString:@"I-AM-ALIVE"];
   }];
 
+  [self.server get:@"/wda/metrics" withBlock:^(RouteRequest *request, RouteResponse *response) {
+    [response setHeader:@"Content-Type" value:@"text/plain; version=0.0.4; charset=utf-8"];
+    [response respondWithString:AMRouteMetrics.prometheusText];
+  }];
+
   [self.server delete:@"/" withBlock:^(RouteRequest *request, RouteResponse *response) {
     @try {
-      [FBSession.activeSession kill];
+      [FBSession killAllSessions];
+      [AMApplicationPool.sharedPool drain];
+      [FBSession waitForPendingTeardownsWithTimeout:SESSION_TEARDOWN_TIMEOUT];
     } @finally {
       [response respondWithString:@"Shutting down"];
       [self.delegate webServerDidRequestShutdown:self];
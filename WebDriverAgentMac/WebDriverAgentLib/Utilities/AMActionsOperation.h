@@ -0,0 +1,74 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class XCSynthesizedEventRecord;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSUInteger, AMActionsOperationState) {
+  AMActionsOperationStateRunning,
+  AMActionsOperationStateSucceeded,
+  AMActionsOperationStateFailed,
+};
+
+/**
+ Event synthesis, which runs in background, so the route queue is not blocked
+ for the whole duration of a long gesture
+ */
+@interface AMActionsOperation : NSObject
+
+/*! Unique identifier of the operation */
+@property (nonatomic, readonly) NSString *identifier;
+/*! The current state of the operation */
+@property (atomic, readonly) AMActionsOperationState state;
+/*! The synthesis error if the operation has failed */
+@property (atomic, readonly, nullable) NSError *error;
+
+/**
+ Starts synthesizing the given event record and returns immediately
+
+ @param eventRecord The event record to synthesize
+ @return The started operation
+ */
++ (instancetype)startedOperationWithEventRecord:(XCSynthesizedEventRecord *)eventRecord;
+
+/**
+ Blocks the current thread until the operation is finished
+
+ @param timeout The maximum amount of seconds to wait
+ @return YES if the operation has finished within the given timeout
+ */
+- (BOOL)waitUntilFinishedWithTimeout:(NSTimeInterval)timeout;
+
+/**
+ Marks the running operation as abandoned by its session, so it is reported as failed once finished.
+ This does not stop the synthesis: events, which have been already passed to the daemon,
+ cannot be recalled, so the operation keeps running until all of them are delivered
+ */
+- (void)abandon;
+
+/**
+ Transforms the operation status to a dictionary.
+
+ @return The dictionary with id, state, error and duration (in seconds) entries
+ */
+- (NSDictionary<NSString *, id> *)toDictionary;
+
+@end
+
+NS_ASSUME_NONNULL_END
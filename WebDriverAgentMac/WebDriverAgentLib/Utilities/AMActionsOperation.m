@@ -0,0 +1,101 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMActionsOperation.h"
+
+#import "AMXCUIDeviceWrapper.h"
+#import "FBErrorBuilder.h"
+
+@interface AMActionsOperation ()
+@property (atomic, readwrite) AMActionsOperationState state;
+@property (atomic, readwrite, nullable) NSError *error;
+@property (atomic, nullable) NSDate *finishedAt;
+@property (nonatomic) BOOL abandoned;
+@property (nonatomic) NSDate *startedAt;
+@property (nonatomic) dispatch_group_t group;
+@end
+
+@implementation AMActionsOperation
+
+- (instancetype)init
+{
+  if ((self = [super init])) {
+    _identifier = [[NSUUID UUID] UUIDString];
+    _state = AMActionsOperationStateRunning;
+    _group = dispatch_group_create();
+  }
+  return self;
+}
+
++ (instancetype)startedOperationWithEventRecord:(XCSynthesizedEventRecord *)eventRecord
+{
+  AMActionsOperation *operation = [[self alloc] init];
+  operation.startedAt = [NSDate date];
+  dispatch_group_enter(operation.group);
+  [AMXCUIDeviceWrapper.sharedDevice synthesizeEvent:eventRecord
+                                         completion:^(NSError *error) {
+    @synchronized (operation) {
+      if (operation.abandoned) {
+        [[[FBErrorBuilder builder]
+          withDescriptionFormat:@"The actions operation '%@' has been abandoned by its session", operation.identifier]
+         buildError:&error];
+      }
+      operation.error = error;
+      operation.finishedAt = [NSDate date];
+      operation.state = nil == error ? AMActionsOperationStateSucceeded : AMActionsOperationStateFailed;
+    }
+    dispatch_group_leave(operation.group);
+  }];
+  return operation;
+}
+
+- (BOOL)waitUntilFinishedWithTimeout:(NSTimeInterval)timeout
+{
+  return 0 == dispatch_group_wait(self.group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)));
+}
+
+- (void)abandon
+{
+  @synchronized (self) {
+    if (AMActionsOperationStateRunning == self.state) {
+      self.abandoned = YES;
+    }
+  }
+}
+
+- (NSDictionary<NSString *, id> *)toDictionary
+{
+  static NSDictionary<NSNumber *, NSString *> *stateNames;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    stateNames = @{
+      @(AMActionsOperationStateRunning): @"running",
+      @(AMActionsOperationStateSucceeded): @"succeeded",
+      @(AMActionsOperationStateFailed): @"failed",
+    };
+  });
+  // The state must be read before the finish date, since both are set from another thread
+  AMActionsOperationState state = self.state;
+  NSDate *finishedAt = self.finishedAt ?: [NSDate date];
+  return @{
+    @"id": self.identifier,
+    @"state": stateNames[@(state)],
+    @"error": self.error.localizedDescription ?: NSNull.null,
+    @"duration": @([finishedAt timeIntervalSinceDate:self.startedAt]),
+  };
+}
+
+@end
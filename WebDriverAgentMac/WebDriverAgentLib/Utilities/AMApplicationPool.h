@@ -0,0 +1,86 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Keeps applications under test running between sessions, so they could be handed out
+ without waiting for the whole launch sequence. Applications are matched by their bundle
+ identifier, launch arguments and launch environment. Since macOS only runs a single instance
+ of each application, the pool contains at most one entry per bundle identifier.
+ The maximum amount of entries is defined by the applicationPoolSize setting.
+ */
+@interface AMApplicationPool : NSObject
+
+/**
+ @return The shared pool instance
+ */
++ (instancetype)sharedPool;
+
+/**
+ @param bundleId The bundle identifier of the application
+ @return YES if the pool contains an entry for the given application, even if it is still being relaunched
+ */
+- (BOOL)containsApplicationWithBundleId:(NSString *)bundleId;
+
+/**
+ Launches the given application or just activates it if the pool contains a warm instance
+ of it, which has been launched with the same arguments and environment.
+ A pooled instance started with other arguments or environment is terminated first.
+ The pool entry of the application is removed
+
+ @param application The application to launch. Launch arguments and environment
+ must be already assigned
+ */
+- (void)launchApplication:(XCUIApplication *)application;
+
+/**
+ Puts the given application into the pool instead of terminating it. The application
+ is relaunched in background via NSWorkspace, so neither the current nor the following
+ commands wait for it. A session requiring the application while it is still being
+ relaunched only waits for the rest of the relaunch
+
+ @param application The running application to recycle
+ @return NO if the pool is disabled or full. The caller is responsible for the application termination then
+ */
+- (BOOL)recycleApplication:(XCUIApplication *)application;
+
+/**
+ Launches the given application and puts it into the pool
+
+ @param application The application to warm up. Launch arguments and environment
+ must be already assigned
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return YES if the application has been successfully put into the pool
+ */
+- (BOOL)warmUpApplication:(XCUIApplication *)application error:(NSError **)error;
+
+/**
+ Terminates all pooled applications and empties the pool.
+ Relaunches in progress are awaited first
+ */
+- (void)drain;
+
+/**
+ @return The list of pooled entries. Each entry contains bundleId, arguments, environment and ready keys
+ */
+- (NSArray<NSDictionary<NSString *, id> *> *)toArray;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,298 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMApplicationPool.h"
+
+#import <AppKit/AppKit.h>
+
+#import "FBConfiguration.h"
+#import "FBErrorBuilder.h"
+#import "FBLogger.h"
+#import "FBRunLoopSpinner.h"
+#import "XCUIApplication+AMHelpers.h"
+
+static const NSTimeInterval APP_TERMINATION_TIMEOUT = 10.0;
+static const NSTimeInterval APP_RELAUNCH_TIMEOUT = 60.0;
+static const useconds_t APP_TERMINATION_POLL_INTERVAL_USEC = 50000;
+
+@interface AMApplicationPool ()
+/*! Pooled applications keyed by [bundleId, arguments, environment] arrays */
+@property (nonatomic, readonly) NSMutableDictionary<NSArray *, XCUIApplication *> *applications;
+/*! Keys of pooled applications, which are waiting to be relaunched */
+@property (nonatomic, readonly) NSMutableSet<NSArray *> *pendingRelaunches;
+@end
+
+@implementation AMApplicationPool
+
++ (instancetype)sharedPool
+{
+  static AMApplicationPool *instance;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    instance = [[self alloc] init];
+  });
+  return instance;
+}
+
+- (instancetype)init
+{
+  if ((self = [super init])) {
+    _applications = [NSMutableDictionary dictionary];
+    _pendingRelaunches = [NSMutableSet set];
+  }
+  return self;
+}
+
++ (nullable NSArray *)keyForApplication:(XCUIApplication *)application
+{
+  NSString *bundleId = application.am_bundleID;
+  if (nil == bundleId) {
+    return nil;
+  }
+  return @[bundleId, application.launchArguments ?: @[], application.launchEnvironment ?: @{}];
+}
+
+- (void)removeEntriesWithBundleId:(NSString *)bundleId
+{
+  for (NSArray *key in self.applications.allKeys) {
+    if ([key.firstObject isEqualToString:bundleId]) {
+      [self.applications removeObjectForKey:key];
+      [self.pendingRelaunches removeObject:key];
+    }
+  }
+}
+
+- (nullable NSArray *)entryKeyWithBundleId:(NSString *)bundleId
+{
+  @synchronized (self.applications) {
+    for (NSArray *key in self.applications) {
+      if ([key.firstObject isEqualToString:bundleId]) {
+        return key;
+      }
+    }
+    return nil;
+  }
+}
+
+- (BOOL)isRelaunchPendingForKey:(NSArray *)key
+{
+  @synchronized (self.applications) {
+    return [self.pendingRelaunches containsObject:key];
+  }
+}
+
+- (BOOL)containsApplicationWithBundleId:(NSString *)bundleId
+{
+  return nil != [self entryKeyWithBundleId:bundleId];
+}
+
+- (void)launchApplication:(XCUIApplication *)application
+{
+  NSArray *key = [self.class keyForApplication:application];
+  NSArray *entryKey = nil == key ? nil : [self entryKeyWithBundleId:key.firstObject];
+  if (nil == entryKey) {
+    [application launch];
+    return;
+  }
+
+  if ([self isRelaunchPendingForKey:entryKey]) {
+    // Only wait for the remaining part of the relaunch, which is already running in background.
+    // Otherwise the instance handed out or replaced here might be terminated by it
+    [FBLogger logFmt:@"Waiting for '%@' to be relaunched in the application pool", key.firstObject];
+    [[[FBRunLoopSpinner new] timeout:APP_RELAUNCH_TIMEOUT] spinUntilTrue:^BOOL{
+      return ![self isRelaunchPendingForKey:entryKey];
+    }];
+  }
+  BOOL isReady;
+  @synchronized (self.applications) {
+    isReady = nil != [self.applications objectForKey:entryKey] && ![self.pendingRelaunches containsObject:entryKey];
+    [self removeEntriesWithBundleId:key.firstObject];
+  }
+  NSArray<NSRunningApplication *> *instances = [NSRunningApplication runningApplicationsWithBundleIdentifier:key.firstObject];
+  if (isReady && [entryKey isEqual:key] && instances.count > 0) {
+    [FBLogger logFmt:@"Handing out the warm instance of '%@' from the application pool", key.firstObject];
+    [application activate];
+    return;
+  }
+  // The pooled instance has been started with other arguments or environment, or it is not up
+  [FBLogger logFmt:@"Replacing the pooled instance of '%@' with a fresh launch", key.firstObject];
+  for (NSRunningApplication *instance in instances) {
+    [self terminateProcessWithID:instance.processIdentifier];
+  }
+  [application launch];
+}
+
+- (BOOL)recycleApplication:(XCUIApplication *)application
+{
+  NSUInteger capacity = FBConfiguration.sharedConfiguration.applicationPoolSize;
+  NSArray *key = [self.class keyForApplication:application];
+  if (0 == capacity || nil == key) {
+    return NO;
+  }
+  pid_t processID = application.am_processID;
+  NSString *path = application.am_path;
+  NSURL *url = nil != path
+    ? [NSURL fileURLWithPath:path]
+    : [NSWorkspace.sharedWorkspace URLForApplicationWithBundleIdentifier:key.firstObject];
+  if (0 == processID || nil == url) {
+    return NO;
+  }
+  @synchronized (self.applications) {
+    [self removeEntriesWithBundleId:key.firstObject];
+    if (self.applications.count >= capacity) {
+      return NO;
+    }
+    [self.applications setObject:application forKey:key];
+    [self.pendingRelaunches addObject:key];
+  }
+  // XCTest launches are bound to the main queue, which also serves routes. The relaunch goes
+  // through NSWorkspace instead, so neither the current nor the following commands wait for it
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    [self relaunchApplicationWithKey:key processID:processID url:url];
+  });
+  return YES;
+}
+
+- (void)relaunchApplicationWithKey:(NSArray *)key processID:(pid_t)processID url:(NSURL *)url
+{
+  [FBLogger logFmt:@"Relaunching '%@' in the application pool", key.firstObject];
+  if (![self terminateProcessWithID:processID]) {
+    [FBLogger logFmt:@"Cannot terminate the process %d of '%@'. Removing it from the application pool",
+     processID, key.firstObject];
+    [self discardPendingEntryWithKey:key];
+    return;
+  }
+  if (![self isRelaunchPendingForKey:key]) {
+    // The entry has been already handed out or drained
+    return;
+  }
+  NSWorkspaceOpenConfiguration *configuration = [NSWorkspaceOpenConfiguration configuration];
+  configuration.arguments = key[1];
+  configuration.environment = key[2];
+  // Do not steal the focus from the application of a running session
+  configuration.activates = NO;
+  configuration.addsToRecentItems = NO;
+  [NSWorkspace.sharedWorkspace openApplicationAtURL:url
+                                      configuration:configuration
+                                  completionHandler:^(NSRunningApplication *app, NSError *error) {
+    if (nil == app) {
+      [FBLogger logFmt:@"Cannot relaunch '%@' in the application pool: %@",
+       key.firstObject, error.localizedDescription];
+      [self discardPendingEntryWithKey:key];
+      return;
+    }
+    @synchronized (self.applications) {
+      [self.pendingRelaunches removeObject:key];
+    }
+  }];
+}
+
+- (BOOL)terminateProcessWithID:(pid_t)processID
+{
+  NSRunningApplication *app = [NSRunningApplication runningApplicationWithProcessIdentifier:processID];
+  if (nil != app && ![app forceTerminate]) {
+    return NO;
+  }
+  // NSRunningApplication properties are only updated on the main run loop,
+  // so the process is polled directly
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:APP_TERMINATION_TIMEOUT];
+  while (0 == kill(processID, 0)) {
+    if ([deadline timeIntervalSinceNow] <= 0) {
+      return NO;
+    }
+    usleep(APP_TERMINATION_POLL_INTERVAL_USEC);
+  }
+  return YES;
+}
+
+- (void)discardPendingEntryWithKey:(NSArray *)key
+{
+  @synchronized (self.applications) {
+    if ([self.pendingRelaunches containsObject:key]) {
+      [self.pendingRelaunches removeObject:key];
+      [self.applications removeObjectForKey:key];
+    }
+  }
+}
+
+- (BOOL)warmUpApplication:(XCUIApplication *)application error:(NSError **)error
+{
+  NSUInteger capacity = FBConfiguration.sharedConfiguration.applicationPoolSize;
+  NSArray *key = [self.class keyForApplication:application];
+  if (nil == key) {
+    return [[[FBErrorBuilder builder]
+             withDescription:@"The bundle identifier of the application cannot be determined"]
+            buildError:error];
+  }
+  @synchronized (self.applications) {
+    [self removeEntriesWithBundleId:key.firstObject];
+    if (self.applications.count >= capacity) {
+      return [[[FBErrorBuilder builder]
+               withDescriptionFormat:@"The application pool cannot contain more than %lu entries. Consider changing the 'applicationPoolSize' setting value",
+               (unsigned long)capacity]
+              buildError:error];
+    }
+  }
+  [application launch];
+  if (application.state <= XCUIApplicationStateNotRunning) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"Failed to launch '%@' application", key.firstObject]
+            buildError:error];
+  }
+  @synchronized (self.applications) {
+    [self.applications setObject:application forKey:key];
+  }
+  return YES;
+}
+
+- (void)drain
+{
+  // Relaunched instances must be up to be terminated. Otherwise they would outlive the pool
+  [[[FBRunLoopSpinner new] timeout:APP_RELAUNCH_TIMEOUT] spinUntilTrue:^BOOL{
+    @synchronized (self.applications) {
+      return 0 == self.pendingRelaunches.count;
+    }
+  }];
+  NSArray<XCUIApplication *> *applications;
+  @synchronized (self.applications) {
+    applications = self.applications.allValues;
+    [self.applications removeAllObjects];
+    [self.pendingRelaunches removeAllObjects];
+  }
+  for (XCUIApplication *application in applications) {
+    if (application.state > XCUIApplicationStateNotRunning) {
+      [application terminate];
+    }
+  }
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)toArray
+{
+  NSMutableArray<NSDictionary<NSString *, id> *> *result = [NSMutableArray array];
+  @synchronized (self.applications) {
+    for (NSArray *key in self.applications) {
+      [result addObject:@{
+        @"bundleId": key[0],
+        @"arguments": key[1],
+        @"environment": key[2],
+        @"ready": @(![self.pendingRelaunches containsObject:key]),
+      }];
+    }
+  }
+  return result.copy;
+}
+
+@end
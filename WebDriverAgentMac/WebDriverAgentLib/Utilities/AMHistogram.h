@@ -0,0 +1,61 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Histogram with fixed bucket boundaries, which could be updated concurrently
+ from multiple threads without locking. All values are unsigned integers
+ (like nanoseconds or bytes), which are scaled to the base unit on rendering.
+ */
+@interface AMHistogram : NSObject
+
+/**
+ Creates a new histogram
+
+ @param upperBounds Sorted list of inclusive bucket upper bounds in base units (like seconds).
+ The implicit +Inf bucket is always added
+ @param unitScale The multiplier to convert recorded integer values to base units,
+ for example 1e-9 if nanoseconds are recorded while the histogram is rendered in seconds
+ */
+- (instancetype)initWithUpperBounds:(NSArray<NSNumber *> *)upperBounds unitScale:(double)unitScale;
+
+/**
+ Records the given value. This method is lock-free and thread-safe.
+
+ @param value The value to record in recorded units
+ */
+- (void)recordValue:(uint64_t)value;
+
+/*! The total count of recorded values */
+@property (nonatomic, readonly) uint64_t count;
+
+/**
+ Appends samples of this histogram in Prometheus text exposition format
+
+ @param name The metric name
+ @param labels Comma-separated list of labels in Prometheus format, e.g. 'route="/status"'
+ @param output The string to append the samples to
+ */
+- (void)appendPrometheusSamplesWithName:(NSString *)name
+                                 labels:(NSString *)labels
+                               toString:(NSMutableString *)output;
+
+@end
+
+NS_ASSUME_NONNULL_END
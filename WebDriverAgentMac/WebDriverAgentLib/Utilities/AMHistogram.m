@@ -0,0 +1,100 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMHistogram.h"
+
+#import <stdatomic.h>
+
+@interface AMHistogram ()
+@property (nonatomic, readonly) NSArray<NSNumber *> *upperBounds;
+@property (nonatomic, readonly) double unitScale;
+@end
+
+@implementation AMHistogram
+{
+  // Bucket upper bounds converted to recorded units
+  uint64_t *_rawUpperBounds;
+  NSUInteger _boundsCount;
+  // The last item is the +Inf bucket
+  _Atomic(uint64_t) *_buckets;
+  _Atomic(uint64_t) _sum;
+}
+
+- (instancetype)initWithUpperBounds:(NSArray<NSNumber *> *)upperBounds unitScale:(double)unitScale
+{
+  if ((self = [super init])) {
+    _upperBounds = upperBounds.copy;
+    _unitScale = unitScale;
+    _boundsCount = upperBounds.count;
+    _rawUpperBounds = calloc(_boundsCount, sizeof(uint64_t));
+    for (NSUInteger i = 0; i < _boundsCount; i++) {
+      _rawUpperBounds[i] = (uint64_t)llround(upperBounds[i].doubleValue / unitScale);
+    }
+    _buckets = calloc(_boundsCount + 1, sizeof(_Atomic(uint64_t)));
+    for (NSUInteger i = 0; i <= _boundsCount; i++) {
+      atomic_init(&_buckets[i], 0);
+    }
+    atomic_init(&_sum, 0);
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  free(_rawUpperBounds);
+  free((void *)_buckets);
+}
+
+- (void)recordValue:(uint64_t)value
+{
+  // The amount of buckets is small, so the linear search is faster than the binary one
+  NSUInteger index = 0;
+  while (index < _boundsCount && value > _rawUpperBounds[index]) {
+    index++;
+  }
+  atomic_fetch_add_explicit(&_buckets[index], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&_sum, value, memory_order_relaxed);
+}
+
+- (uint64_t)count
+{
+  uint64_t result = 0;
+  for (NSUInteger i = 0; i <= _boundsCount; i++) {
+    result += atomic_load_explicit(&_buckets[i], memory_order_relaxed);
+  }
+  return result;
+}
+
+- (void)appendPrometheusSamplesWithName:(NSString *)name
+                                 labels:(NSString *)labels
+                               toString:(NSMutableString *)output
+{
+  NSString *separator = labels.length > 0 ? @"," : @"";
+  uint64_t cumulativeCount = 0;
+  for (NSUInteger i = 0; i <= _boundsCount; i++) {
+    cumulativeCount += atomic_load_explicit(&_buckets[i], memory_order_relaxed);
+    NSString *bound = i < _boundsCount ? [NSString stringWithFormat:@"%g", self.upperBounds[i].doubleValue] : @"+Inf";
+    [output appendFormat:@"%@_bucket{%@%@le=\"%@\"} %llu\n", name, labels, separator, bound, cumulativeCount];
+  }
+  double sum = (double)atomic_load_explicit(&_sum, memory_order_relaxed) * self.unitScale;
+  NSString *sampleLabels = labels.length > 0 ? [NSString stringWithFormat:@"{%@}", labels] : @"";
+  [output appendFormat:@"%@_sum%@ %.9g\n", name, sampleLabels, sum];
+  // Using the +Inf bucket value keeps the count consistent with buckets
+  // even if new values are being recorded concurrently
+  [output appendFormat:@"%@_count%@ %llu\n", name, sampleLabels, cumulativeCount];
+}
+
+@end
@@ -26,4 +26,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 NSString *_Nullable AMKeyValueForName(NSString *name);
 
+/**
+ Calculates the typing speed for synthesized keyboard events based on the typingFrequency setting
+
+ @return The amount of characters to type per second
+ */
+NSUInteger AMTypingSpeed(void);
+
 NS_ASSUME_NONNULL_END
@@ -16,6 +16,11 @@
 
 #import "AMKeyboardUtils.h"
 
+#import "FBConfiguration.h"
+
+// The delay between keystrokes is below the resolution of the event synthesizer at this speed
+#define AM_MAXIMUM_TYPING_SPEED 1000
+
 NSString *AMKeyValueForName(NSString *name)
 {
   static dispatch_once_t onceKeys;
@@ -76,3 +81,9 @@ NSString *AMKeyValueForName(NSString *name)
   });
   return keysMapping[name];
 }
+
+NSUInteger AMTypingSpeed(void)
+{
+  NSUInteger frequency = FBConfiguration.sharedConfiguration.typingFrequency;
+  return 0 == frequency ? AM_MAXIMUM_TYPING_SPEED : MIN(frequency, AM_MAXIMUM_TYPING_SPEED);
+}
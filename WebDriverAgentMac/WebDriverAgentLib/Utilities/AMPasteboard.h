@@ -41,6 +41,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSData *)dataForType:(NSString *)type error:(NSError **)error;
 
+/**
+ Makes a deep copy of all items in the general pasteboard
+
+ @return The list of copied items, which could be passed to restoreItems:
+ */
++ (NSArray<NSPasteboardItem *> *)backupItems;
+
+/**
+ Replaces the content of the general pasteboard with the given items
+
+ @param items The list of items returned by backupItems
+ @return YES if the items have been written to the pasteboard
+ */
++ (BOOL)restoreItems:(NSArray<NSPasteboardItem *> *)items;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -125,4 +125,29 @@
   return [@"" dataUsingEncoding:NSUTF8StringEncoding];
 }
 
++ (NSArray<NSPasteboardItem *> *)backupItems
+{
+  // Pasteboard items cannot be written back once they have been read from a pasteboard,
+  // so their data must be copied into fresh instances
+  NSMutableArray<NSPasteboardItem *> *result = [NSMutableArray array];
+  for (NSPasteboardItem *item in NSPasteboard.generalPasteboard.pasteboardItems ?: @[]) {
+    NSPasteboardItem *itemCopy = [NSPasteboardItem new];
+    for (NSPasteboardType type in item.types) {
+      NSData *data = [item dataForType:type];
+      if (nil != data) {
+        [itemCopy setData:data forType:type];
+      }
+    }
+    [result addObject:itemCopy];
+  }
+  return result.copy;
+}
+
++ (BOOL)restoreItems:(NSArray<NSPasteboardItem *> *)items
+{
+  NSPasteboard *pb = NSPasteboard.generalPasteboard;
+  [pb clearContents];
+  return 0 == items.count || [pb writeObjects:items];
+}
+
 @end
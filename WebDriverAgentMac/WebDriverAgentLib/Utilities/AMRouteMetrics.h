@@ -0,0 +1,67 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class AMHistogram;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Returns the current value of the monotonic clock in nanoseconds
+ */
+uint64_t AMMonotonicTimestamp(void);
+
+/**
+ Latency and size histograms collected for a single route.
+ Instances are created once while routes are being registered and then
+ might be updated concurrently without any locking
+ */
+@interface AMRouteMetrics : NSObject
+
+/*! HTTP verb of the route */
+@property (nonatomic, readonly) NSString *verb;
+/*! Path pattern of the route */
+@property (nonatomic, readonly) NSString *path;
+
+/*! The time between the request has been received and its handling has been started, in nanoseconds */
+@property (nonatomic, readonly) AMHistogram *queueWait;
+/*! The time spent on parsing the request body, in nanoseconds */
+@property (nonatomic, readonly) AMHistogram *requestParsing;
+/*! The time spent in the route handler, in nanoseconds */
+@property (nonatomic, readonly) AMHistogram *handler;
+/*! The time spent on the response serialization, in nanoseconds */
+@property (nonatomic, readonly) AMHistogram *responseSerialization;
+/*! The size of the response body, in bytes */
+@property (nonatomic, readonly) AMHistogram *responseSize;
+
+/**
+ Returns metrics for the given route. A new instance is created and registered
+ if the route has not been seen before
+
+ @param verb HTTP verb of the route
+ @param path Path pattern of the route
+ */
++ (instancetype)metricsForRouteWithVerb:(NSString *)verb path:(NSString *)path;
+
+/**
+ Renders metrics of all registered routes in Prometheus text exposition format
+ */
++ (NSString *)prometheusText;
+
+@end
+
+NS_ASSUME_NONNULL_END
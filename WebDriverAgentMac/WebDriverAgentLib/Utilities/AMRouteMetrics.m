@@ -0,0 +1,127 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMRouteMetrics.h"
+
+#import "AMHistogram.h"
+
+static const double AMNanosecondsScale = 1e-9;
+
+uint64_t AMMonotonicTimestamp(void)
+{
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static NSArray<NSNumber *> *AMLatencyBuckets(void)
+{
+  return @[@0.0005, @0.001, @0.0025, @0.005, @0.01, @0.025, @0.05, @0.1,
+           @0.25, @0.5, @1, @2.5, @5, @10, @30, @60];
+}
+
+static NSArray<NSNumber *> *AMSizeBuckets(void)
+{
+  return @[@256, @1024, @4096, @16384, @65536, @262144,
+           @1048576, @4194304, @16777216, @67108864];
+}
+
+static NSString *AMPrometheusEscapedLabelValue(NSString *value)
+{
+  return [[[value stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"]
+           stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""]
+          stringByReplacingOccurrencesOfString:@"\n" withString:@"\\n"];
+}
+
+@implementation AMRouteMetrics
+
+- (instancetype)initWithVerb:(NSString *)verb path:(NSString *)path
+{
+  if ((self = [super init])) {
+    _verb = verb.copy;
+    _path = path.copy;
+    _queueWait = [[AMHistogram alloc] initWithUpperBounds:AMLatencyBuckets() unitScale:AMNanosecondsScale];
+    _requestParsing = [[AMHistogram alloc] initWithUpperBounds:AMLatencyBuckets() unitScale:AMNanosecondsScale];
+    _handler = [[AMHistogram alloc] initWithUpperBounds:AMLatencyBuckets() unitScale:AMNanosecondsScale];
+    _responseSerialization = [[AMHistogram alloc] initWithUpperBounds:AMLatencyBuckets() unitScale:AMNanosecondsScale];
+    _responseSize = [[AMHistogram alloc] initWithUpperBounds:AMSizeBuckets() unitScale:1];
+  }
+  return self;
+}
+
++ (NSMutableArray<AMRouteMetrics *> *)registry
+{
+  static NSMutableArray<AMRouteMetrics *> *registry;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    registry = [NSMutableArray array];
+  });
+  return registry;
+}
+
++ (instancetype)metricsForRouteWithVerb:(NSString *)verb path:(NSString *)path
+{
+  NSMutableArray<AMRouteMetrics *> *registry = self.registry;
+  @synchronized (registry) {
+    for (AMRouteMetrics *metrics in registry) {
+      if ([metrics.verb isEqualToString:verb] && [metrics.path isEqualToString:path]) {
+        return metrics;
+      }
+    }
+    AMRouteMetrics *metrics = [[AMRouteMetrics alloc] initWithVerb:verb path:path];
+    [registry addObject:metrics];
+    return metrics;
+  }
+}
+
++ (NSString *)prometheusText
+{
+  NSArray<AMRouteMetrics *> *routes;
+  NSMutableArray<AMRouteMetrics *> *registry = self.registry;
+  @synchronized (registry) {
+    routes = registry.copy;
+  }
+
+  NSArray<NSArray *> *families = @[
+    @[@"wda_route_queue_wait_seconds", @"Time between receiving a request and starting its handling",
+      NSStringFromSelector(@selector(queueWait))],
+    @[@"wda_route_request_parse_seconds", @"Time spent on parsing the request body",
+      NSStringFromSelector(@selector(requestParsing))],
+    @[@"wda_route_handler_seconds", @"Time spent in the route handler",
+      NSStringFromSelector(@selector(handler))],
+    @[@"wda_route_response_serialization_seconds", @"Time spent on serializing the response",
+      NSStringFromSelector(@selector(responseSerialization))],
+    @[@"wda_route_response_size_bytes", @"Size of the response body",
+      NSStringFromSelector(@selector(responseSize))],
+  ];
+  NSMutableString *output = [NSMutableString string];
+  for (NSArray *family in families) {
+    NSString *name = family[0];
+    [output appendFormat:@"# HELP %@ %@\n", name, family[1]];
+    [output appendFormat:@"# TYPE %@ histogram\n", name];
+    for (AMRouteMetrics *metrics in routes) {
+      AMHistogram *histogram = [metrics valueForKey:family[2]];
+      if (0 == histogram.count) {
+        continue;
+      }
+      NSString *labels = [NSString stringWithFormat:@"method=\"%@\",route=\"%@\"",
+                          AMPrometheusEscapedLabelValue(metrics.verb),
+                          AMPrometheusEscapedLabelValue(metrics.path)];
+      [histogram appendPrometheusSamplesWithName:name labels:labels toString:output];
+    }
+  }
+  return output.copy;
+}
+
+@end
@@ -36,5 +36,7 @@ extern NSString* const AM_APP_TIME_ZONE_CAPABILITY;
 extern NSString* const AM_APP_LOCALE_CAPABILITY;
 /** Deeplink URL to start the session with */
 extern NSString* const AM_INITIAL_DEEPLINK_URL_CAPABILITY;
+/** Whether to keep other active sessions alive when the new session is created */
+extern NSString* const AM_CONCURRENT_SESSIONS_CAPABILITY;
 
 NS_ASSUME_NONNULL_END
@@ -25,3 +25,4 @@ NSString* const AM_APP_PATH_CAPABILITY = @"appPath";
 NSString* const AM_APP_TIME_ZONE_CAPABILITY = @"appTimeZone";
 NSString* const AM_APP_LOCALE_CAPABILITY = @"appLocale";
 NSString* const AM_INITIAL_DEEPLINK_URL_CAPABILITY = @"initialDeeplinkUrl";
+NSString* const AM_CONCURRENT_SESSIONS_CAPABILITY = @"concurrentSessions";
@@ -28,4 +28,22 @@ extern NSString* const AM_USE_DEFAULT_UI_INTERRUPTIONS_HANDLING_SETTING;
 /*! Whether to use custom snapshotting mechanism to fetch full element's text payload instead of the first 512 chars  */
 extern NSString* const AM_FETCH_FULL_TEXT;
 
+/*! The minimum size of a JSON response in bytes to be compressed if the client accepts it. Zero or negative values disable compression */
+extern NSString* const AM_RESPONSE_COMPRESSION_THRESHOLD;
+
+/*! Whether to evaluate XPath queries natively over snapshots instead of building an XML document (YES by default) */
+extern NSString* const AM_USE_NATIVE_XPATH_ENGINE;
+
+/*! The default way to enter text into elements. See XCUIElement+AMEditable for the list of supported modes */
+extern NSString* const AM_TEXT_INPUT_MODE;
+
+/*! The maximum amount of characters typed per second. Zero means typing at the maximum possible speed */
+extern NSString* const AM_TYPING_FREQUENCY;
+
+/*! The maximum deviation in points allowed while merging consecutive pointer moves. Zero disables merging */
+extern NSString* const AM_POINTER_MOVE_TOLERANCE;
+
+/*! The maximum amount of applications kept running between sessions. Zero disables the pool */
+extern NSString* const AM_APPLICATION_POOL_SIZE;
+
 NS_ASSUME_NONNULL_END
@@ -19,3 +19,9 @@
 NSString* const AM_BOUND_ELEMENTS_BY_INDEX_SETTING = @"boundElementsByIndex";
 NSString* const AM_USE_DEFAULT_UI_INTERRUPTIONS_HANDLING_SETTING = @"useDefaultUiInterruptionsHandling";
 NSString* const AM_FETCH_FULL_TEXT = @"fetchFullText";
+NSString* const AM_RESPONSE_COMPRESSION_THRESHOLD = @"responseCompressionThreshold";
+NSString* const AM_USE_NATIVE_XPATH_ENGINE = @"useNativeXPathEngine";
+NSString* const AM_TEXT_INPUT_MODE = @"textInputMode";
+NSString* const AM_TYPING_FREQUENCY = @"typingFrequency";
+NSString* const AM_POINTER_MOVE_TOLERANCE = @"pointerMoveTolerance";
+NSString* const AM_APPLICATION_POOL_SIZE = @"applicationPoolSize";
@@ -0,0 +1,188 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The value used as a node index if there is no such node (e.g. the parent of the root node) */
+extern const NSUInteger AMSnapshotTreeNoNode;
+
+/*! The identifier of a missing string value */
+extern const uint32_t AMSnapshotTreeNoString;
+
+/*! String attributes of tree nodes. Their values are stored in the shared strings table */
+typedef NS_ENUM(NSUInteger, AMSnapshotTreeStringAttribute) {
+  AMSnapshotTreeStringAttributeIdentifier,
+  AMSnapshotTreeStringAttributeValue,
+  AMSnapshotTreeStringAttributeLabel,
+  AMSnapshotTreeStringAttributeTitle,
+  AMSnapshotTreeStringAttributePlaceholderValue,
+};
+
+/*! The total count of string attributes */
+#define AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT 5
+
+/*! Plain description of a single tree node, which is used to create trees from recorded data */
+typedef struct {
+  // The parent node index or AMSnapshotTreeNoNode for the root node
+  NSUInteger parent;
+  XCUIElementType elementType;
+  CGRect frame;
+  BOOL enabled;
+  BOOL selected;
+  // Identifiers of strings in the strings table indexed by AMSnapshotTreeStringAttribute
+  uint32_t stringIds[AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT];
+} AMSnapshotTreeNodeRecord;
+
+/*! The parent index of the root node in tree columns */
+extern const uint32_t AMSnapshotTreeNoParentIndex;
+
+/*! Bits of node flags in tree columns */
+extern const uint8_t AMSnapshotTreeNodeFlagEnabled;
+extern const uint8_t AMSnapshotTreeNodeFlagSelected;
+
+/*! Raw node property arrays of a tree. Each array contains exactly one item per node */
+typedef struct {
+  // Parent node indexes in document order. The root node has AMSnapshotTreeNoParentIndex
+  const uint32_t *parents;
+  const uint16_t *elementTypes;
+  // Combination of AMSnapshotTreeNodeFlag* bits
+  const uint8_t *flags;
+  const CGRect *frames;
+  // String identifiers indexed by AMSnapshotTreeStringAttribute
+  const uint32_t *stringIds[AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT];
+} AMSnapshotTreeColumns;
+
+/**
+ Immutable, flat representation of a snapshot tree, which keeps each node property
+ in a separate continuous array (struct of arrays).
+
+ Nodes are stored in document (depth-first pre-order) order, so the root node has zero index
+ and all descendants of a node occupy the continuous range of indexes right after it.
+ Relations between nodes are precomputed and string values are interned into a single table,
+ so equal strings are only stored and sanitized once and could be compared by their identifiers.
+ This makes tree traversals and attribute lookups cheap compared to the dynamic dispatch
+ of snapshot objects.
+ */
+@interface AMSnapshotTree : NSObject
+
+/*! The total count of nodes in the tree */
+@property (nonatomic, readonly) NSUInteger count;
+
+/*! The total count of unique strings in the strings table */
+@property (nonatomic, readonly) NSUInteger stringsCount;
+
+/**
+ Converts the given snapshot tree in one pass
+
+ @param rootSnapshot The root snapshot of the tree
+ */
+- (instancetype)initWithRootSnapshot:(id<XCUIElementSnapshot>)rootSnapshot;
+
+/**
+ Creates a tree from plain node records. Trees created this way have no snapshots attached
+
+ @param strings The strings table. The string at index N has the identifier N + 1,
+ since AMSnapshotTreeNoString is reserved for missing values. Strings must be XML-safe
+ @param nodes Node records in document order
+ @param count The count of node records
+ @param error Is set if records do not describe a valid tree
+ @return The tree instance or nil in case of failure
+ */
+- (nullable instancetype)initWithStrings:(NSArray<NSString *> *)strings
+                                   nodes:(const AMSnapshotTreeNodeRecord *)nodes
+                                   count:(NSUInteger)count
+                                   error:(NSError **)error;
+
+/**
+ Creates a tree over existing node property arrays without copying them,
+ for example arrays from a memory-mapped file. Only node relations are calculated
+
+ @param strings The strings table. See initWithStrings:nodes:count:error: for more details
+ @param columns Node property arrays, which must stay valid while the backing storage is alive
+ @param count The count of nodes
+ @param backingStorage The object owning column arrays. It is retained by the tree
+ @param error Is set if columns do not describe a valid tree
+ @return The tree instance or nil in case of failure
+ */
+- (nullable instancetype)initWithStrings:(NSArray<NSString *> *)strings
+                                 columns:(AMSnapshotTreeColumns)columns
+                                   count:(NSUInteger)count
+                          backingStorage:(id)backingStorage
+                                   error:(NSError **)error;
+
+/*! Raw node property arrays of the tree. These are only valid while the tree is alive */
+@property (nonatomic, readonly) AMSnapshotTreeColumns columns;
+
+/*! Returns the parent index of the given node or AMSnapshotTreeNoNode for the root */
+- (NSUInteger)parentOfNode:(NSUInteger)node;
+
+/*! Returns the index of the first child of the given node or AMSnapshotTreeNoNode */
+- (NSUInteger)firstChildOfNode:(NSUInteger)node;
+
+/*! Returns the index of the next sibling of the given node or AMSnapshotTreeNoNode */
+- (NSUInteger)nextSiblingOfNode:(NSUInteger)node;
+
+/*! Returns the index of the previous sibling of the given node or AMSnapshotTreeNoNode */
+- (NSUInteger)previousSiblingOfNode:(NSUInteger)node;
+
+/*! Returns the index right after the last descendant of the given node */
+- (NSUInteger)subtreeEndOfNode:(NSUInteger)node;
+
+/*! Returns the element type of the given node */
+- (XCUIElementType)elementTypeOfNode:(NSUInteger)node;
+
+/*! Returns the element type name of the given node, for example XCUIElementTypeButton */
+- (NSString *)typeNameOfNode:(NSUInteger)node;
+
+/*! Returns the frame of the given node */
+- (CGRect)frameOfNode:(NSUInteger)node;
+
+/*! Returns the enabled state of the given node */
+- (BOOL)isNodeEnabled:(NSUInteger)node;
+
+/*! Returns the selected state of the given node */
+- (BOOL)isNodeSelected:(NSUInteger)node;
+
+/*! Returns the identifier of the given string attribute value or AMSnapshotTreeNoString */
+- (uint32_t)stringIdOfAttribute:(AMSnapshotTreeStringAttribute)attribute ofNode:(NSUInteger)node;
+
+/*! Returns the string with the given identifier or nil for AMSnapshotTreeNoString */
+- (nullable NSString *)stringWithId:(uint32_t)stringId;
+
+/*! Returns the XML-safe value of the given string attribute or nil if it is not set */
+- (nullable NSString *)stringAttribute:(AMSnapshotTreeStringAttribute)attribute ofNode:(NSUInteger)node;
+
+/**
+ Returns the value of the given attribute of the given node
+ as it is represented in the XML page source
+
+ @param name One of the attribute names of the XML page source, for example 'label' or 'x'
+ @param node The node index
+ @return The attribute value or nil if the attribute is not set or is unknown
+ */
+- (nullable NSString *)attributeValueWithName:(NSString *)name ofNode:(NSUInteger)node;
+
+/*! Returns the original snapshot of the given node or nil if the tree has been created from records */
+- (nullable id<XCUIElementSnapshot>)snapshotOfNode:(NSUInteger)node;
+
+/*! The list of attribute names in the order they are written to the XML page source */
++ (NSArray<NSString *> *)attributeNames;
+
+@end
+
+NS_ASSUME_NONNULL_END
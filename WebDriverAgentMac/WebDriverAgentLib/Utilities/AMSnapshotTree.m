@@ -0,0 +1,408 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMSnapshotTree.h"
+
+#import "AMGeometryUtils.h"
+#import "FBElementTypeTransformer.h"
+#import "FBElementUtils.h"
+#import "FBErrorBuilder.h"
+#import "NSString+FBXMLSafeString.h"
+
+const NSUInteger AMSnapshotTreeNoNode = NSNotFound;
+const uint32_t AMSnapshotTreeNoString = 0;
+// Node indexes are stored as 32-bit integers to keep columns compact
+const uint32_t AMSnapshotTreeNoParentIndex = UINT32_MAX;
+const uint8_t AMSnapshotTreeNodeFlagEnabled = 1 << 0;
+const uint8_t AMSnapshotTreeNodeFlagSelected = 1 << 1;
+
+static inline NSUInteger AMNodeWithIndex(uint32_t index)
+{
+  return index == AMSnapshotTreeNoParentIndex ? AMSnapshotTreeNoNode : index;
+}
+
+@implementation AMSnapshotTree
+{
+  AMSnapshotTreeColumns _columns;
+  // The owner of column arrays or nil if these are owned by the tree itself
+  id _backingStorage;
+  uint32_t *_firstChildren;
+  uint32_t *_nextSiblings;
+  uint32_t *_previousSiblings;
+  uint32_t *_subtreeEnds;
+  NSArray<NSString *> *_strings;
+  NSArray<id<XCUIElementSnapshot>> *_snapshots;
+}
+
++ (NSArray<NSString *> *)attributeNames
+{
+  return @[@"elementType", @"identifier", @"value", @"label", @"title", @"placeholderValue",
+           @"enabled", @"selected", @"x", @"y", @"width", @"height"];
+}
+
+- (instancetype)initWithRootSnapshot:(id<XCUIElementSnapshot>)rootSnapshot
+{
+  if ((self = [super init])) {
+    NSMutableArray<id<XCUIElementSnapshot>> *snapshots = [NSMutableArray array];
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    // Raw values are used as keys, so each unique value is only sanitized once
+    NSMutableDictionary<NSString *, NSNumber *> *stringIds = [NSMutableDictionary dictionary];
+    uint32_t (^intern)(NSString *) = ^uint32_t(NSString *value) {
+      if (nil == value) {
+        return AMSnapshotTreeNoString;
+      }
+      NSNumber *stringId = stringIds[value];
+      if (nil == stringId) {
+        [strings addObject:[value fb_xmlSafeStringWithReplacement:@""]];
+        stringId = @(strings.count);
+        stringIds[value] = stringId;
+      }
+      return stringId.unsignedIntValue;
+    };
+
+    NSUInteger capacity = 256;
+    AMSnapshotTreeNodeRecord *records = malloc(capacity * sizeof(AMSnapshotTreeNodeRecord));
+    // Flatten the tree in pre-order using an explicit stack to avoid deep recursion
+    NSMutableArray<NSArray *> *stack = [NSMutableArray arrayWithObject:@[rootSnapshot, @(AMSnapshotTreeNoNode)]];
+    while (stack.count > 0) {
+      NSArray *item = stack.lastObject;
+      [stack removeLastObject];
+      id<XCUIElementSnapshot> snapshot = item[0];
+      NSUInteger index = snapshots.count;
+      [snapshots addObject:snapshot];
+      if (index == capacity) {
+        capacity *= 2;
+        records = realloc(records, capacity * sizeof(AMSnapshotTreeNodeRecord));
+      }
+      AMSnapshotTreeNodeRecord *record = records + index;
+      record->parent = [item[1] unsignedIntegerValue];
+      record->elementType = snapshot.elementType;
+      record->frame = snapshot.frame;
+      record->enabled = snapshot.enabled;
+      record->selected = snapshot.selected;
+      record->stringIds[AMSnapshotTreeStringAttributeIdentifier] = intern(snapshot.identifier);
+      record->stringIds[AMSnapshotTreeStringAttributeValue] = intern([FBElementUtils stringValueWithValue:snapshot.value]);
+      record->stringIds[AMSnapshotTreeStringAttributeLabel] = intern(snapshot.label);
+      record->stringIds[AMSnapshotTreeStringAttributeTitle] = intern(snapshot.title);
+      record->stringIds[AMSnapshotTreeStringAttributePlaceholderValue] = intern(snapshot.placeholderValue);
+
+      NSArray<id<XCUIElementSnapshot>> *children = snapshot.children;
+      for (id<XCUIElementSnapshot> child in children.reverseObjectEnumerator) {
+        [stack addObject:@[child, @(index)]];
+      }
+    }
+    // Snapshots always form a valid tree, so there is no need to check the result
+    [self setUpWithStrings:strings.copy nodes:records count:snapshots.count error:nil];
+    free(records);
+    _snapshots = snapshots.copy;
+  }
+  return self;
+}
+
+- (nullable instancetype)initWithStrings:(NSArray<NSString *> *)strings
+                                   nodes:(const AMSnapshotTreeNodeRecord *)nodes
+                                   count:(NSUInteger)count
+                                   error:(NSError **)error
+{
+  if ((self = [super init])) {
+    if (![self setUpWithStrings:strings nodes:nodes count:count error:error]) {
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (nullable instancetype)initWithStrings:(NSArray<NSString *> *)strings
+                                 columns:(AMSnapshotTreeColumns)columns
+                                   count:(NSUInteger)count
+                          backingStorage:(id)backingStorage
+                                   error:(NSError **)error
+{
+  if ((self = [super init])) {
+    _columns = columns;
+    _backingStorage = backingStorage;
+    if (![self setUpRelationsWithStrings:strings count:count error:error]) {
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (BOOL)setUpWithStrings:(NSArray<NSString *> *)strings
+                   nodes:(const AMSnapshotTreeNodeRecord *)nodes
+                   count:(NSUInteger)count
+                   error:(NSError **)error
+{
+  uint32_t *parents = malloc(MAX(count, 1) * sizeof(uint32_t));
+  uint16_t *elementTypes = malloc(MAX(count, 1) * sizeof(uint16_t));
+  uint8_t *flags = malloc(MAX(count, 1) * sizeof(uint8_t));
+  CGRect *frames = malloc(MAX(count, 1) * sizeof(CGRect));
+  uint32_t *stringIds[AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT];
+  for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+    stringIds[attribute] = malloc(MAX(count, 1) * sizeof(uint32_t));
+  }
+  for (NSUInteger i = 0; i < count; i++) {
+    const AMSnapshotTreeNodeRecord *record = nodes + i;
+    // Out of range parents are rejected by the document order check
+    parents[i] = record->parent >= AMSnapshotTreeNoParentIndex
+      ? AMSnapshotTreeNoParentIndex
+      : (uint32_t)record->parent;
+    elementTypes[i] = (uint16_t)record->elementType;
+    flags[i] = (record->enabled ? AMSnapshotTreeNodeFlagEnabled : 0)
+      | (record->selected ? AMSnapshotTreeNodeFlagSelected : 0);
+    frames[i] = record->frame;
+    for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+      stringIds[attribute][i] = record->stringIds[attribute];
+    }
+  }
+  _columns.parents = parents;
+  _columns.elementTypes = elementTypes;
+  _columns.flags = flags;
+  _columns.frames = frames;
+  for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+    _columns.stringIds[attribute] = stringIds[attribute];
+  }
+  return [self setUpRelationsWithStrings:strings count:count error:error];
+}
+
+- (BOOL)setUpRelationsWithStrings:(NSArray<NSString *> *)strings
+                            count:(NSUInteger)count
+                            error:(NSError **)error
+{
+  if (0 == count || count >= AMSnapshotTreeNoParentIndex || strings.count >= UINT32_MAX) {
+    return [[[FBErrorBuilder builder]
+             withDescriptionFormat:@"The count of tree nodes must be in range 1..%u", AMSnapshotTreeNoParentIndex - 1]
+            buildError:error];
+  }
+
+  _count = count;
+  _stringsCount = strings.count;
+  _strings = strings;
+  _firstChildren = malloc(count * sizeof(uint32_t));
+  _nextSiblings = malloc(count * sizeof(uint32_t));
+  _previousSiblings = malloc(count * sizeof(uint32_t));
+  _subtreeEnds = malloc(count * sizeof(uint32_t));
+  uint32_t *lastChildren = malloc(count * sizeof(uint32_t));
+  // Ancestors of the previous node. The parent of each node must be one of them in pre-order
+  uint32_t *ancestors = malloc(count * sizeof(uint32_t));
+  NSUInteger ancestorsCount = 0;
+  NSString *errorMessage = nil;
+
+  for (uint32_t i = 0; i < count && nil == errorMessage; i++) {
+    uint32_t parent = _columns.parents[i];
+    if (0 == i) {
+      if (parent != AMSnapshotTreeNoParentIndex) {
+        errorMessage = @"The first node must be the root node";
+        break;
+      }
+    } else {
+      while (ancestorsCount > 0 && ancestors[ancestorsCount - 1] != parent) {
+        ancestorsCount--;
+      }
+      if (0 == ancestorsCount) {
+        errorMessage = [NSString stringWithFormat:@"The node #%u is not in document order", i];
+        break;
+      }
+    }
+    ancestors[ancestorsCount++] = i;
+    for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+      uint32_t stringId = _columns.stringIds[attribute][i];
+      if (stringId > strings.count) {
+        errorMessage = [NSString stringWithFormat:@"The node #%u refers to an unknown string #%u", i, stringId];
+        break;
+      }
+    }
+
+    _firstChildren[i] = AMSnapshotTreeNoParentIndex;
+    _nextSiblings[i] = AMSnapshotTreeNoParentIndex;
+    _previousSiblings[i] = AMSnapshotTreeNoParentIndex;
+    lastChildren[i] = AMSnapshotTreeNoParentIndex;
+    _subtreeEnds[i] = i + 1;
+    if (AMSnapshotTreeNoParentIndex != parent) {
+      if (AMSnapshotTreeNoParentIndex == _firstChildren[parent]) {
+        _firstChildren[parent] = i;
+      } else {
+        _nextSiblings[lastChildren[parent]] = i;
+        _previousSiblings[i] = lastChildren[parent];
+      }
+      lastChildren[parent] = i;
+    }
+  }
+  free(lastChildren);
+  free(ancestors);
+  if (nil != errorMessage) {
+    return [[[FBErrorBuilder builder] withDescription:errorMessage] buildError:error];
+  }
+
+  // Descendants always follow their ancestors in pre-order,
+  // so subtree ends could be propagated backwards in a single pass
+  for (NSUInteger node = count - 1; node > 0; node--) {
+    uint32_t parent = _columns.parents[node];
+    _subtreeEnds[parent] = MAX(_subtreeEnds[parent], _subtreeEnds[node]);
+  }
+  return YES;
+}
+
+- (void)dealloc
+{
+  if (nil == _backingStorage) {
+    free((void *)_columns.parents);
+    free((void *)_columns.elementTypes);
+    free((void *)_columns.flags);
+    free((void *)_columns.frames);
+    for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+      free((void *)_columns.stringIds[attribute]);
+    }
+  }
+  free(_firstChildren);
+  free(_nextSiblings);
+  free(_previousSiblings);
+  free(_subtreeEnds);
+}
+
+- (AMSnapshotTreeColumns)columns
+{
+  return _columns;
+}
+
+- (NSUInteger)parentOfNode:(NSUInteger)node
+{
+  return AMNodeWithIndex(_columns.parents[node]);
+}
+
+- (NSUInteger)firstChildOfNode:(NSUInteger)node
+{
+  return AMNodeWithIndex(_firstChildren[node]);
+}
+
+- (NSUInteger)nextSiblingOfNode:(NSUInteger)node
+{
+  return AMNodeWithIndex(_nextSiblings[node]);
+}
+
+- (NSUInteger)previousSiblingOfNode:(NSUInteger)node
+{
+  return AMNodeWithIndex(_previousSiblings[node]);
+}
+
+- (NSUInteger)subtreeEndOfNode:(NSUInteger)node
+{
+  return _subtreeEnds[node];
+}
+
+- (XCUIElementType)elementTypeOfNode:(NSUInteger)node
+{
+  return (XCUIElementType)_columns.elementTypes[node];
+}
+
+- (NSString *)typeNameOfNode:(NSUInteger)node
+{
+  return [FBElementTypeTransformer stringWithElementType:(XCUIElementType)_columns.elementTypes[node]];
+}
+
+- (CGRect)frameOfNode:(NSUInteger)node
+{
+  return _columns.frames[node];
+}
+
+- (BOOL)isNodeEnabled:(NSUInteger)node
+{
+  return 0 != (_columns.flags[node] & AMSnapshotTreeNodeFlagEnabled);
+}
+
+- (BOOL)isNodeSelected:(NSUInteger)node
+{
+  return 0 != (_columns.flags[node] & AMSnapshotTreeNodeFlagSelected);
+}
+
+- (uint32_t)stringIdOfAttribute:(AMSnapshotTreeStringAttribute)attribute ofNode:(NSUInteger)node
+{
+  return _columns.stringIds[attribute][node];
+}
+
+- (nullable NSString *)stringWithId:(uint32_t)stringId
+{
+  return AMSnapshotTreeNoString == stringId ? nil : _strings[stringId - 1];
+}
+
+- (nullable NSString *)stringAttribute:(AMSnapshotTreeStringAttribute)attribute ofNode:(NSUInteger)node
+{
+  return [self stringWithId:_columns.stringIds[attribute][node]];
+}
+
+- (nullable id<XCUIElementSnapshot>)snapshotOfNode:(NSUInteger)node
+{
+  return [_snapshots objectAtIndex:node];
+}
+
+- (nullable NSString *)attributeValueWithName:(NSString *)name ofNode:(NSUInteger)node
+{
+  // Formatting rules must be kept in sync with FBXPath attributes
+  switch (name.length > 0 ? [name characterAtIndex:0] : 0) {
+    case 'e':
+      if ([name isEqualToString:@"elementType"]) {
+        return [NSString stringWithFormat:@"%lu", (unsigned long)_columns.elementTypes[node]];
+      }
+      if ([name isEqualToString:@"enabled"]) {
+        return [self isNodeEnabled:node] ? @"true" : @"false";
+      }
+      break;
+    case 'i':
+      if ([name isEqualToString:@"identifier"]) {
+        return [self stringAttribute:AMSnapshotTreeStringAttributeIdentifier ofNode:node];
+      }
+      break;
+    case 'v':
+      if ([name isEqualToString:@"value"]) {
+        return [self stringAttribute:AMSnapshotTreeStringAttributeValue ofNode:node];
+      }
+      break;
+    case 'l':
+      if ([name isEqualToString:@"label"]) {
+        return [self stringAttribute:AMSnapshotTreeStringAttributeLabel ofNode:node];
+      }
+      break;
+    case 't':
+      if ([name isEqualToString:@"title"]) {
+        return [self stringAttribute:AMSnapshotTreeStringAttributeTitle ofNode:node];
+      }
+      break;
+    case 'p':
+      if ([name isEqualToString:@"placeholderValue"]) {
+        return [self stringAttribute:AMSnapshotTreeStringAttributePlaceholderValue ofNode:node];
+      }
+      break;
+    case 's':
+      if ([name isEqualToString:@"selected"]) {
+        return [self isNodeSelected:node] ? @"true" : @"false";
+      }
+      break;
+    case 'x':
+    case 'y':
+    case 'w':
+    case 'h':
+      if ([name isEqualToString:@"x"] || [name isEqualToString:@"y"]
+          || [name isEqualToString:@"width"] || [name isEqualToString:@"height"]) {
+        return [NSString stringWithFormat:@"%@", [AMCGRectToDict(_columns.frames[node]) objectForKey:name]];
+      }
+      break;
+    default:
+      break;
+  }
+  return nil;
+}
+
+@end
@@ -0,0 +1,78 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class AMSnapshotTree;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The version of archives produced by AMSnapshotTreeArchive */
+extern const uint32_t AMSnapshotTreeArchiveVersion;
+
+/*! The recommended file extension for snapshot tree archives */
+extern NSString *const AMSnapshotTreeArchiveFileExtension;
+
+/**
+ Compact binary format of snapshot trees, which is designed to be memory-mapped.
+
+ An archive starts with a fixed header containing the magic bytes, the format version
+ and item counts, followed by node property arrays in the same layout AMSnapshotTree uses
+ in memory, followed by the strings table as UTF-8 bytes with their offsets.
+ All numbers are little-endian and all sections are aligned to 8 bytes, so loaded trees
+ refer to node properties directly in the mapped file without parsing or copying them.
+ */
+@interface AMSnapshotTreeArchive : NSObject
+
+/**
+ Serializes the given tree into the archive format
+
+ @param tree The tree to serialize
+ @return The archive data
+ */
++ (NSData *)dataWithTree:(AMSnapshotTree *)tree;
+
+/**
+ Loads a tree from the given archive data. The tree refers to the data without copying it
+
+ @param data The archive data
+ @param error Is set if the data is not a valid archive or has an unsupported version
+ @return The loaded tree or nil in case of failure
+ */
++ (nullable AMSnapshotTree *)treeWithData:(NSData *)data error:(NSError **)error;
+
+/**
+ Writes the archive of the given tree to a file
+
+ @param tree The tree to archive
+ @param path The full path to the destination file
+ @param error Is set if the file cannot be written
+ @return YES if the file has been successfully written
+ */
++ (BOOL)writeTree:(AMSnapshotTree *)tree toFile:(NSString *)path error:(NSError **)error;
+
+/**
+ Maps the given archive file into memory and loads the tree from it
+
+ @param path The full path to the archive file
+ @param error Is set if the file cannot be mapped or is not a valid archive
+ @return The loaded tree or nil in case of failure
+ */
++ (nullable AMSnapshotTree *)treeWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
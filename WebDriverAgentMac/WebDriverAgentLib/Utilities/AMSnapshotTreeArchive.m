@@ -0,0 +1,221 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMSnapshotTreeArchive.h"
+
+#import "AMSnapshotTree.h"
+#import "FBErrorBuilder.h"
+
+const uint32_t AMSnapshotTreeArchiveVersion = 1;
+NSString *const AMSnapshotTreeArchiveFileExtension = @"amtree";
+
+static const char AM_ARCHIVE_MAGIC[8] = {'A', 'M', 'S', 'T', 'R', 'E', 'E', '\0'};
+static const NSUInteger AM_ARCHIVE_ALIGNMENT = 8;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t nodesCount;
+  uint64_t stringsCount;
+  uint64_t stringBytesCount;
+} AMSnapshotTreeArchiveHeader;
+
+// Frames are stored as four doubles, which is the in-memory layout of CGRect on 64-bit platforms
+_Static_assert(sizeof(CGRect) == 4 * sizeof(double), "CGRect must consist of four doubles");
+_Static_assert(sizeof(AMSnapshotTreeArchiveHeader) % 8 == 0, "The header size must be aligned");
+
+/*! Offsets of archive sections, which only depend on item counts */
+typedef struct {
+  uint64_t parents;
+  uint64_t elementTypes;
+  uint64_t flags;
+  uint64_t frames;
+  uint64_t stringIds[AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT];
+  uint64_t stringOffsets;
+  uint64_t stringBytes;
+  uint64_t end;
+} AMSnapshotTreeArchiveLayout;
+
+static uint64_t AMAlignedOffset(uint64_t offset)
+{
+  return (offset + AM_ARCHIVE_ALIGNMENT - 1) / AM_ARCHIVE_ALIGNMENT * AM_ARCHIVE_ALIGNMENT;
+}
+
+static AMSnapshotTreeArchiveLayout AMArchiveLayout(uint64_t nodesCount, uint64_t stringsCount, uint64_t stringBytesCount)
+{
+  AMSnapshotTreeArchiveLayout layout;
+  uint64_t offset = sizeof(AMSnapshotTreeArchiveHeader);
+  layout.parents = offset;
+  offset = AMAlignedOffset(offset + nodesCount * sizeof(uint32_t));
+  layout.elementTypes = offset;
+  offset = AMAlignedOffset(offset + nodesCount * sizeof(uint16_t));
+  layout.flags = offset;
+  offset = AMAlignedOffset(offset + nodesCount * sizeof(uint8_t));
+  layout.frames = offset;
+  offset = AMAlignedOffset(offset + nodesCount * sizeof(CGRect));
+  for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+    layout.stringIds[attribute] = offset;
+    offset = AMAlignedOffset(offset + nodesCount * sizeof(uint32_t));
+  }
+  // One more offset marks the end of the last string
+  layout.stringOffsets = offset;
+  offset = AMAlignedOffset(offset + (stringsCount + 1) * sizeof(uint64_t));
+  layout.stringBytes = offset;
+  layout.end = offset + stringBytesCount;
+  return layout;
+}
+
+@implementation AMSnapshotTreeArchive
+
++ (BOOL)isHostLittleEndian
+{
+  return CFByteOrderGetCurrent() == CFByteOrderLittleEndian;
+}
+
++ (NSData *)dataWithTree:(AMSnapshotTree *)tree
+{
+  NSAssert(self.isHostLittleEndian, @"Snapshot tree archives could only be created on little-endian hosts");
+  NSUInteger count = tree.count;
+  NSMutableData *stringBytes = [NSMutableData data];
+  uint64_t *stringOffsets = malloc((tree.stringsCount + 1) * sizeof(uint64_t));
+  for (uint32_t stringId = 1; stringId <= tree.stringsCount; stringId++) {
+    stringOffsets[stringId - 1] = stringBytes.length;
+    NSData *utf8 = [(NSString *)[tree stringWithId:stringId] dataUsingEncoding:NSUTF8StringEncoding];
+    [stringBytes appendData:utf8];
+  }
+  stringOffsets[tree.stringsCount] = stringBytes.length;
+
+  AMSnapshotTreeArchiveLayout layout = AMArchiveLayout(count, tree.stringsCount, stringBytes.length);
+  NSMutableData *data = [NSMutableData dataWithLength:(NSUInteger)layout.end];
+  uint8_t *bytes = data.mutableBytes;
+  AMSnapshotTreeArchiveHeader header = {
+    .version = AMSnapshotTreeArchiveVersion,
+    .headerSize = sizeof(AMSnapshotTreeArchiveHeader),
+    .nodesCount = count,
+    .stringsCount = tree.stringsCount,
+    .stringBytesCount = stringBytes.length,
+  };
+  memcpy(header.magic, AM_ARCHIVE_MAGIC, sizeof(AM_ARCHIVE_MAGIC));
+  memcpy(bytes, &header, sizeof(header));
+
+  AMSnapshotTreeColumns columns = tree.columns;
+  memcpy(bytes + layout.parents, columns.parents, count * sizeof(uint32_t));
+  memcpy(bytes + layout.elementTypes, columns.elementTypes, count * sizeof(uint16_t));
+  memcpy(bytes + layout.flags, columns.flags, count * sizeof(uint8_t));
+  memcpy(bytes + layout.frames, columns.frames, count * sizeof(CGRect));
+  for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+    memcpy(bytes + layout.stringIds[attribute], columns.stringIds[attribute], count * sizeof(uint32_t));
+  }
+  memcpy(bytes + layout.stringOffsets, stringOffsets, (tree.stringsCount + 1) * sizeof(uint64_t));
+  memcpy(bytes + layout.stringBytes, stringBytes.bytes, stringBytes.length);
+  free(stringOffsets);
+  return data.copy;
+}
+
++ (nullable AMSnapshotTree *)failWithDescription:(NSString *)description error:(NSError **)error
+{
+  [[[FBErrorBuilder builder]
+    withDescriptionFormat:@"The snapshot tree archive is invalid: %@", description]
+   buildError:error];
+  return nil;
+}
+
++ (nullable AMSnapshotTree *)treeWithData:(NSData *)data error:(NSError **)error
+{
+  if (!self.isHostLittleEndian) {
+    return [self failWithDescription:@"Archives could only be loaded on little-endian hosts" error:error];
+  }
+  AMSnapshotTreeArchiveHeader header;
+  if (data.length < sizeof(header)) {
+    return [self failWithDescription:@"The data is too short" error:error];
+  }
+  const uint8_t *bytes = data.bytes;
+  memcpy(&header, bytes, sizeof(header));
+  if (0 != memcmp(header.magic, AM_ARCHIVE_MAGIC, sizeof(AM_ARCHIVE_MAGIC))) {
+    return [self failWithDescription:@"The magic bytes do not match" error:error];
+  }
+  if (header.version != AMSnapshotTreeArchiveVersion || header.headerSize != sizeof(header)) {
+    return [self failWithDescription:[NSString stringWithFormat:@"The version %u is not supported. Only version %u could be loaded",
+                                      header.version, AMSnapshotTreeArchiveVersion]
+                               error:error];
+  }
+  // Prevent overflows in the layout calculation
+  if (header.nodesCount >= UINT32_MAX || header.stringsCount >= UINT32_MAX || header.stringBytesCount > data.length) {
+    return [self failWithDescription:@"Item counts are out of range" error:error];
+  }
+  AMSnapshotTreeArchiveLayout layout = AMArchiveLayout(header.nodesCount, header.stringsCount, header.stringBytesCount);
+  if (layout.end != data.length) {
+    return [self failWithDescription:[NSString stringWithFormat:@"The expected length is %llu bytes, but the actual one is %lu bytes",
+                                      layout.end, (unsigned long)data.length]
+                               error:error];
+  }
+  if (0 != ((uintptr_t)bytes % AM_ARCHIVE_ALIGNMENT)) {
+    // Mapped files are always page-aligned, but arbitrary data might be not
+    NSData *alignedData = [NSData dataWithBytes:bytes length:data.length];
+    if (0 != ((uintptr_t)alignedData.bytes % AM_ARCHIVE_ALIGNMENT)) {
+      return [self failWithDescription:@"The data cannot be aligned" error:error];
+    }
+    data = alignedData;
+    bytes = data.bytes;
+  }
+
+  const uint64_t *stringOffsets = (const uint64_t *)(bytes + layout.stringOffsets);
+  const char *stringBytes = (const char *)(bytes + layout.stringBytes);
+  NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:(NSUInteger)header.stringsCount];
+  for (uint64_t i = 0; i < header.stringsCount; i++) {
+    uint64_t start = stringOffsets[i];
+    uint64_t end = stringOffsets[i + 1];
+    if (start > end || end > header.stringBytesCount) {
+      return [self failWithDescription:[NSString stringWithFormat:@"The string #%llu is out of bounds", i + 1] error:error];
+    }
+    NSString *string = [[NSString alloc] initWithBytes:stringBytes + start
+                                                length:(NSUInteger)(end - start)
+                                              encoding:NSUTF8StringEncoding];
+    if (nil == string) {
+      return [self failWithDescription:[NSString stringWithFormat:@"The string #%llu is not valid UTF-8", i + 1] error:error];
+    }
+    [strings addObject:string];
+  }
+
+  AMSnapshotTreeColumns columns = {
+    .parents = (const uint32_t *)(bytes + layout.parents),
+    .elementTypes = (const uint16_t *)(bytes + layout.elementTypes),
+    .flags = (const uint8_t *)(bytes + layout.flags),
+    .frames = (const CGRect *)(bytes + layout.frames),
+  };
+  for (NSUInteger attribute = 0; attribute < AM_SNAPSHOT_TREE_STRING_ATTRIBUTES_COUNT; attribute++) {
+    columns.stringIds[attribute] = (const uint32_t *)(bytes + layout.stringIds[attribute]);
+  }
+  return [[AMSnapshotTree alloc] initWithStrings:strings.copy
+                                         columns:columns
+                                           count:(NSUInteger)header.nodesCount
+                                  backingStorage:data
+                                           error:error];
+}
+
++ (BOOL)writeTree:(AMSnapshotTree *)tree toFile:(NSString *)path error:(NSError **)error
+{
+  return [[self dataWithTree:tree] writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
++ (nullable AMSnapshotTree *)treeWithContentsOfFile:(NSString *)path error:(NSError **)error
+{
+  NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:error];
+  return nil == data ? nil : [self treeWithData:data error:error];
+}
+
+@end
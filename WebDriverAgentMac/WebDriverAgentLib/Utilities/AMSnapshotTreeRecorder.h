@@ -0,0 +1,72 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class AMSnapshotTree;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The version of recorded tree representations produced by AMSnapshotTreeRecorder */
+extern const NSUInteger AMSnapshotTreeRecordVersion;
+
+/**
+ Converts snapshot trees to JSON-compatible records and back, so trees recorded
+ on a live system could be replayed later, for example in benchmarks, on any machine.
+ Records keep the columnar layout of AMSnapshotTree: each node property is stored
+ as a separate array and string attributes refer to the shared strings table.
+ */
+@interface AMSnapshotTreeRecorder : NSObject
+
+/**
+ Creates a JSON-compatible record of the given tree
+
+ @param tree The tree to record
+ @return The record dictionary
+ */
++ (NSDictionary<NSString *, id> *)recordWithTree:(AMSnapshotTree *)tree;
+
+/**
+ Restores a tree from its record
+
+ @param record The record previously created by recordWithTree:
+ @param error Is set if the record is malformed or has an unsupported version
+ @return The restored tree or nil in case of failure
+ */
++ (nullable AMSnapshotTree *)treeWithRecord:(NSDictionary<NSString *, id> *)record error:(NSError **)error;
+
+/**
+ Writes the record of the given tree to a JSON file
+
+ @param tree The tree to record
+ @param path The full path to the destination file
+ @param error Is set if the file cannot be written
+ @return YES if the file has been successfully written
+ */
++ (BOOL)writeTree:(AMSnapshotTree *)tree toFile:(NSString *)path error:(NSError **)error;
+
+/**
+ Restores a tree from a JSON file created by writeTree:toFile:error:
+
+ @param path The full path to the source file
+ @param error Is set if the file cannot be read or parsed
+ @return The restored tree or nil in case of failure
+ */
++ (nullable AMSnapshotTree *)treeWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
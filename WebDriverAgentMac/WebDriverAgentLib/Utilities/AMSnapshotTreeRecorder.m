@@ -0,0 +1,199 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMSnapshotTreeRecorder.h"
+
+#import "AMSnapshotTree.h"
+#import "FBErrorBuilder.h"
+
+const NSUInteger AMSnapshotTreeRecordVersion = 1;
+
+static NSString *const AM_RECORD_VERSION_KEY = @"version";
+static NSString *const AM_RECORD_STRINGS_KEY = @"strings";
+static NSString *const AM_RECORD_PARENTS_KEY = @"parent";
+static NSString *const AM_RECORD_ELEMENT_TYPES_KEY = @"elementType";
+static NSString *const AM_RECORD_FRAMES_KEY = @"frame";
+static NSString *const AM_RECORD_ENABLED_KEY = @"enabled";
+static NSString *const AM_RECORD_SELECTED_KEY = @"selected";
+
+// The root node has no parent
+static const NSInteger AM_RECORD_NO_PARENT = -1;
+
+@implementation AMSnapshotTreeRecorder
+
++ (NSArray<NSString *> *)stringAttributeKeys
+{
+  // The order must match AMSnapshotTreeStringAttribute values
+  return @[@"identifier", @"value", @"label", @"title", @"placeholderValue"];
+}
+
++ (NSDictionary<NSString *, id> *)recordWithTree:(AMSnapshotTree *)tree
+{
+  NSUInteger count = tree.count;
+  NSMutableArray<NSNumber *> *parents = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray<NSNumber *> *elementTypes = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray<NSNumber *> *frames = [NSMutableArray arrayWithCapacity:count * 4];
+  NSMutableArray<NSNumber *> *enabled = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray<NSNumber *> *selected = [NSMutableArray arrayWithCapacity:count];
+  NSArray<NSString *> *stringAttributeKeys = self.stringAttributeKeys;
+  NSMutableArray<NSMutableArray<NSNumber *> *> *stringIds = [NSMutableArray array];
+  for (NSUInteger attribute = 0; attribute < stringAttributeKeys.count; attribute++) {
+    [stringIds addObject:[NSMutableArray arrayWithCapacity:count]];
+  }
+
+  for (NSUInteger node = 0; node < count; node++) {
+    NSUInteger parent = [tree parentOfNode:node];
+    [parents addObject:@(parent == AMSnapshotTreeNoNode ? AM_RECORD_NO_PARENT : (NSInteger)parent)];
+    [elementTypes addObject:@([tree elementTypeOfNode:node])];
+    CGRect frame = [tree frameOfNode:node];
+    [frames addObjectsFromArray:@[@(frame.origin.x), @(frame.origin.y), @(frame.size.width), @(frame.size.height)]];
+    [enabled addObject:@([tree isNodeEnabled:node])];
+    [selected addObject:@([tree isNodeSelected:node])];
+    for (NSUInteger attribute = 0; attribute < stringAttributeKeys.count; attribute++) {
+      [stringIds[attribute] addObject:@([tree stringIdOfAttribute:attribute ofNode:node])];
+    }
+  }
+
+  NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:tree.stringsCount];
+  for (uint32_t stringId = 1; stringId <= tree.stringsCount; stringId++) {
+    [strings addObject:(NSString *)[tree stringWithId:stringId]];
+  }
+
+  NSMutableDictionary<NSString *, id> *record = [@{
+    AM_RECORD_VERSION_KEY: @(AMSnapshotTreeRecordVersion),
+    AM_RECORD_STRINGS_KEY: strings.copy,
+    AM_RECORD_PARENTS_KEY: parents.copy,
+    AM_RECORD_ELEMENT_TYPES_KEY: elementTypes.copy,
+    AM_RECORD_FRAMES_KEY: frames.copy,
+    AM_RECORD_ENABLED_KEY: enabled.copy,
+    AM_RECORD_SELECTED_KEY: selected.copy,
+  } mutableCopy];
+  for (NSUInteger attribute = 0; attribute < stringAttributeKeys.count; attribute++) {
+    record[stringAttributeKeys[attribute]] = stringIds[attribute].copy;
+  }
+  return record.copy;
+}
+
++ (BOOL)buildError:(NSError **)error withDescription:(NSString *)description
+{
+  return [[[FBErrorBuilder builder]
+           withDescriptionFormat:@"The snapshot tree record is invalid: %@", description]
+          buildError:error];
+}
+
++ (nullable NSArray<NSNumber *> *)numbersWithKey:(NSString *)key
+                                        inRecord:(NSDictionary<NSString *, id> *)record
+                                           count:(NSUInteger)count
+                                           error:(NSError **)error
+{
+  id value = record[key];
+  if (![value isKindOfClass:NSArray.class] || [value count] != count) {
+    [self buildError:error withDescription:[NSString stringWithFormat:@"'%@' must be an array of %lu items", key, (unsigned long)count]];
+    return nil;
+  }
+  for (id item in (NSArray *)value) {
+    if (![item isKindOfClass:NSNumber.class]) {
+      [self buildError:error withDescription:[NSString stringWithFormat:@"'%@' must only contain numbers", key]];
+      return nil;
+    }
+  }
+  return value;
+}
+
++ (nullable AMSnapshotTree *)treeWithRecord:(NSDictionary<NSString *, id> *)record error:(NSError **)error
+{
+  id version = record[AM_RECORD_VERSION_KEY];
+  if (![version isKindOfClass:NSNumber.class] || [version unsignedIntegerValue] != AMSnapshotTreeRecordVersion) {
+    [self buildError:error withDescription:[NSString stringWithFormat:@"The version %@ is not supported. Only version %lu could be loaded", version, (unsigned long)AMSnapshotTreeRecordVersion]];
+    return nil;
+  }
+  NSArray<NSString *> *strings = record[AM_RECORD_STRINGS_KEY];
+  if (![strings isKindOfClass:NSArray.class]) {
+    [self buildError:error withDescription:@"'strings' must be an array"];
+    return nil;
+  }
+  for (id string in strings) {
+    if (![string isKindOfClass:NSString.class]) {
+      [self buildError:error withDescription:@"'strings' must only contain strings"];
+      return nil;
+    }
+  }
+  NSArray *parentsValue = record[AM_RECORD_PARENTS_KEY];
+  if (![parentsValue isKindOfClass:NSArray.class]) {
+    [self buildError:error withDescription:@"'parent' must be an array"];
+    return nil;
+  }
+  NSUInteger count = parentsValue.count;
+  NSArray<NSNumber *> *parents = [self numbersWithKey:AM_RECORD_PARENTS_KEY inRecord:record count:count error:error];
+  NSArray<NSNumber *> *elementTypes = [self numbersWithKey:AM_RECORD_ELEMENT_TYPES_KEY inRecord:record count:count error:error];
+  NSArray<NSNumber *> *frames = [self numbersWithKey:AM_RECORD_FRAMES_KEY inRecord:record count:count * 4 error:error];
+  NSArray<NSNumber *> *enabled = [self numbersWithKey:AM_RECORD_ENABLED_KEY inRecord:record count:count error:error];
+  NSArray<NSNumber *> *selected = [self numbersWithKey:AM_RECORD_SELECTED_KEY inRecord:record count:count error:error];
+  if (nil == parents || nil == elementTypes || nil == frames || nil == enabled || nil == selected) {
+    return nil;
+  }
+  NSArray<NSString *> *stringAttributeKeys = self.stringAttributeKeys;
+  NSMutableArray<NSArray<NSNumber *> *> *stringIds = [NSMutableArray array];
+  for (NSString *key in stringAttributeKeys) {
+    NSArray<NSNumber *> *ids = [self numbersWithKey:key inRecord:record count:count error:error];
+    if (nil == ids) {
+      return nil;
+    }
+    [stringIds addObject:ids];
+  }
+
+  AMSnapshotTreeNodeRecord *nodes = calloc(MAX(count, 1), sizeof(AMSnapshotTreeNodeRecord));
+  for (NSUInteger node = 0; node < count; node++) {
+    NSInteger parent = parents[node].integerValue;
+    nodes[node].parent = parent < 0 ? AMSnapshotTreeNoNode : (NSUInteger)parent;
+    nodes[node].elementType = elementTypes[node].unsignedIntegerValue;
+    nodes[node].frame = CGRectMake(frames[node * 4].doubleValue, frames[node * 4 + 1].doubleValue,
+                                   frames[node * 4 + 2].doubleValue, frames[node * 4 + 3].doubleValue);
+    nodes[node].enabled = enabled[node].boolValue;
+    nodes[node].selected = selected[node].boolValue;
+    for (NSUInteger attribute = 0; attribute < stringAttributeKeys.count; attribute++) {
+      nodes[node].stringIds[attribute] = stringIds[attribute][node].unsignedIntValue;
+    }
+  }
+  AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithStrings:strings nodes:nodes count:count error:error];
+  free(nodes);
+  return tree;
+}
+
++ (BOOL)writeTree:(AMSnapshotTree *)tree toFile:(NSString *)path error:(NSError **)error
+{
+  NSData *data = [NSJSONSerialization dataWithJSONObject:[self recordWithTree:tree] options:0 error:error];
+  return nil != data && [data writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
++ (nullable AMSnapshotTree *)treeWithContentsOfFile:(NSString *)path error:(NSError **)error
+{
+  NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+  if (nil == data) {
+    return nil;
+  }
+  id record = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+  if (nil == record) {
+    return nil;
+  }
+  if (![record isKindOfClass:NSDictionary.class]) {
+    [self buildError:error withDescription:@"The root item must be an object"];
+    return nil;
+  }
+  return [self treeWithRecord:record error:error];
+}
+
+@end
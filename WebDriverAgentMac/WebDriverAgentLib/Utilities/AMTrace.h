@@ -0,0 +1,86 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! The name of the request header containing the trace identifier */
+extern NSString *const AM_TRACE_ID_HEADER;
+/*! The name of the response header containing recorded spans as Chrome trace events JSON */
+extern NSString *const AM_TRACE_SPANS_HEADER;
+
+/**
+ A single measured span of a trace
+ */
+@interface AMTraceSpan : NSObject
+
+/**
+ Finishes the span and adds it to the trace it has been started in.
+ Calling this method more than once has no effect
+ */
+- (void)end;
+
+@end
+
+/**
+ Spans recorded while handling a single request, which has been marked with a trace identifier.
+ The trace is bound to the thread the request is handled on, so spans from other threads are ignored.
+ If no trace is active then span-related calls do nothing and return nil,
+ which makes the instrumentation practically free if tracing is not requested.
+ */
+@interface AMTrace : NSObject
+
+/*! The trace identifier provided by the client */
+@property (nonatomic, readonly) NSString *identifier;
+
+/**
+ Starts a new trace on the current thread
+
+ @param identifier The trace identifier provided by the client
+ @return The started trace instance
+ */
++ (instancetype)startTraceWithIdentifier:(NSString *)identifier;
+
+/**
+ Finishes the trace bound to the current thread
+
+ @return The finished trace or nil if no trace has been started on the current thread
+ */
++ (nullable AMTrace *)finishCurrentTrace;
+
+/**
+ Starts a new span in the trace bound to the current thread
+
+ @param name The span name
+ @return The span instance or nil if there is no active trace
+ */
++ (nullable AMTraceSpan *)beginSpanWithName:(NSString *)name;
+
+/**
+ Returns recorded spans in Chrome trace event format, so they could be loaded
+ into chrome://tracing or Perfetto. Timestamps are Unix epoch microseconds.
+ */
+- (NSArray<NSDictionary<NSString *, id> *> *)chromeTraceEvents;
+
+/**
+ Returns recorded spans as a compact JSON string suitable for a header value
+ */
+- (NSString *)chromeTraceEventsJSONString;
+
+@end
+
+NS_ASSUME_NONNULL_END
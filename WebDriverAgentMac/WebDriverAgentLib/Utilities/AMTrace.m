@@ -0,0 +1,144 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMTrace.h"
+
+#import <pthread.h>
+
+NSString *const AM_TRACE_ID_HEADER = @"X-Trace-Id";
+NSString *const AM_TRACE_SPANS_HEADER = @"X-Trace-Spans";
+
+static NSString *const AMCurrentTraceKey = @"AMCurrentTrace";
+// Keeps the header value reasonably small
+static const NSUInteger AMMaxSpansCount = 64;
+
+static uint64_t AMEpochMicroseconds(void)
+{
+  return (uint64_t)(NSDate.date.timeIntervalSince1970 * USEC_PER_SEC);
+}
+
+@interface AMTrace ()
+@property (nonatomic, readonly) NSMutableArray<NSDictionary<NSString *, id> *> *events;
+@property (nonatomic) NSUInteger droppedSpansCount;
+- (void)addSpanWithName:(NSString *)name startedAt:(uint64_t)startedAt duration:(uint64_t)duration;
+@end
+
+@interface AMTraceSpan ()
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) uint64_t startedAt;
+@property (nonatomic, weak, nullable) AMTrace *trace;
+@end
+
+@implementation AMTraceSpan
+
+- (instancetype)initWithName:(NSString *)name trace:(AMTrace *)trace
+{
+  if ((self = [super init])) {
+    _name = name;
+    _trace = trace;
+    _startedAt = AMEpochMicroseconds();
+  }
+  return self;
+}
+
+- (void)end
+{
+  AMTrace *trace = self.trace;
+  if (nil == trace) {
+    return;
+  }
+  self.trace = nil;
+  uint64_t now = AMEpochMicroseconds();
+  [trace addSpanWithName:self.name startedAt:self.startedAt duration:now > self.startedAt ? now - self.startedAt : 0];
+}
+
+@end
+
+@implementation AMTrace
+
+- (instancetype)initWithIdentifier:(NSString *)identifier
+{
+  if ((self = [super init])) {
+    _identifier = identifier.copy;
+    _events = [NSMutableArray array];
+  }
+  return self;
+}
+
++ (instancetype)startTraceWithIdentifier:(NSString *)identifier
+{
+  AMTrace *trace = [[AMTrace alloc] initWithIdentifier:identifier];
+  NSThread.currentThread.threadDictionary[AMCurrentTraceKey] = trace;
+  return trace;
+}
+
++ (nullable AMTrace *)finishCurrentTrace
+{
+  NSMutableDictionary *threadDictionary = NSThread.currentThread.threadDictionary;
+  AMTrace *trace = threadDictionary[AMCurrentTraceKey];
+  [threadDictionary removeObjectForKey:AMCurrentTraceKey];
+  return trace;
+}
+
++ (nullable AMTraceSpan *)beginSpanWithName:(NSString *)name
+{
+  AMTrace *trace = NSThread.currentThread.threadDictionary[AMCurrentTraceKey];
+  return nil == trace ? nil : [[AMTraceSpan alloc] initWithName:name trace:trace];
+}
+
+- (void)addSpanWithName:(NSString *)name startedAt:(uint64_t)startedAt duration:(uint64_t)duration
+{
+  if (self.events.count >= AMMaxSpansCount) {
+    self.droppedSpansCount++;
+    return;
+  }
+  [self.events addObject:@{
+    @"name": name,
+    @"cat": @"wda",
+    @"ph": @"X",
+    @"ts": @(startedAt),
+    @"dur": @(duration),
+    @"pid": @(NSProcessInfo.processInfo.processIdentifier),
+    @"tid": @(pthread_mach_thread_np(pthread_self())),
+    @"args": @{@"traceId": self.identifier},
+  }];
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)chromeTraceEvents
+{
+  if (0 == self.droppedSpansCount) {
+    return self.events.copy;
+  }
+  NSMutableArray *result = self.events.mutableCopy;
+  [result addObject:@{
+    @"name": @"droppedSpans",
+    @"cat": @"wda",
+    @"ph": @"i",
+    @"s": @"p",
+    @"ts": @(AMEpochMicroseconds()),
+    @"pid": @(NSProcessInfo.processInfo.processIdentifier),
+    @"args": @{@"traceId": self.identifier, @"count": @(self.droppedSpansCount)},
+  }];
+  return result.copy;
+}
+
+- (NSString *)chromeTraceEventsJSONString
+{
+  NSData *data = [NSJSONSerialization dataWithJSONObject:self.chromeTraceEvents options:0 error:nil];
+  return nil == data ? @"[]" : [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+@end
@@ -45,6 +45,17 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)stopScreenRecordingWithUUID:(NSUUID *)uuid
                               error:(NSError **)error;
 
+/**
+ Stops native video recording without blocking the current thread
+
+ @param uuid The unique identifier of the recording process
+ @param completion The block, which is called once the recording is finalized.
+ The error argument is nil if the recording has been successfully stopped.
+ The block might be called on an arbitrary queue
+ */
+- (void)stopScreenRecordingWithUUID:(NSUUID *)uuid
+                         completion:(void (^)(NSError * _Nullable error))completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -23,6 +23,12 @@
 #import "AMXCTRunnerDaemonSessionWrapper.h"
 #import "AMXCTRunnerDaemonSession.h"
 
+static const NSTimeInterval PENDING_STOP_TIMEOUT = 30.0;
+
+@interface AMVideoRecorder ()
+/*! Tracks recordings, which are being finalized asynchronously */
+@property (nonatomic, readonly) dispatch_group_t pendingStops;
+@end
 
 @implementation AMVideoRecorder
 
@@ -36,6 +42,14 @@
   return instance;
 }
 
+- (instancetype)init
+{
+  if ((self = [super init])) {
+    _pendingStops = dispatch_group_create();
+  }
+  return self;
+}
+
 - (FBScreenRecordingPromise *)startScreenRecordingWithRequest:(FBScreenRecordingRequest *)request
                                                         error:(NSError *__autoreleasing*)error
 {
@@ -57,6 +71,14 @@
   if (nil == nativeRequest) {
     return nil;
   }
+  // The daemon only supports a single recording at a time,
+  // so the previous one must be finalized first
+  dispatch_group_t pendingStops = self.pendingStops;
+  [[[FBRunLoopSpinner new]
+    timeout:PENDING_STOP_TIMEOUT]
+   spinUntilTrue:^BOOL{
+    return 0 == dispatch_group_wait(pendingStops, DISPATCH_TIME_NOW);
+  }];
 
   __block id futureMetadata = nil;
   __block NSError *innerError = nil;
@@ -81,25 +103,10 @@
 
 - (BOOL)stopScreenRecordingWithUUID:(NSUUID *)uuid error:(NSError *__autoreleasing*)error
 {
-  AMXCTRunnerDaemonSessionWrapper *wrapper = AMXCTRunnerDaemonSessionWrapper.sharedInstance;
-  if (!wrapper.canRecordVideo) {
-    return [[[FBErrorBuilder builder]
-             withDescriptionFormat:@"The current Xcode SDK does not support screen recording. Consider upgrading to Xcode 15+"]
-            buildError:error];
-
-  }
-  if (![wrapper.daemonSession supportsScreenRecording]) {
-    return [[[FBErrorBuilder builder]
-             withDescriptionFormat:@"Your device does not support screen recording"]
-            buildError:error];
-  }
-
   __block NSError *innerError = nil;
   [FBRunLoopSpinner spinUntilCompletion:^(void(^completion)(void)){
-    [wrapper.daemonSession stopScreenRecordingWithUUID:uuid withReply:^(NSError *invokeError) {
-      if (nil != invokeError) {
-        innerError = invokeError;
-      }
+    [self stopScreenRecordingWithUUID:uuid completion:^(NSError *stopError) {
+      innerError = stopError;
       completion();
     }];
   }];
@@ -109,4 +116,32 @@
   return nil == innerError;
 }
 
+- (void)stopScreenRecordingWithUUID:(NSUUID *)uuid
+                         completion:(void (^)(NSError * _Nullable error))completion
+{
+  AMXCTRunnerDaemonSessionWrapper *wrapper = AMXCTRunnerDaemonSessionWrapper.sharedInstance;
+  NSError *error;
+  if (!wrapper.canRecordVideo) {
+    [[[FBErrorBuilder builder]
+      withDescriptionFormat:@"The current Xcode SDK does not support screen recording. Consider upgrading to Xcode 15+"]
+     buildError:&error];
+    completion(error);
+    return;
+  }
+  if (![wrapper.daemonSession supportsScreenRecording]) {
+    [[[FBErrorBuilder builder]
+      withDescriptionFormat:@"Your device does not support screen recording"]
+     buildError:&error];
+    completion(error);
+    return;
+  }
+
+  dispatch_group_t pendingStops = self.pendingStops;
+  dispatch_group_enter(pendingStops);
+  [wrapper.daemonSession stopScreenRecordingWithUUID:uuid withReply:^(NSError *invokeError) {
+    completion(invokeError);
+    dispatch_group_leave(pendingStops);
+  }];
+}
+
 @end
@@ -0,0 +1,65 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <XCTest/XCTest.h>
+
+@class FBElementCache, XCSynthesizedEventRecord;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ W3C actions chain, which has been validated once and could be replayed multiple times.
+ Event records are cached per position offset, so repeated replays skip parsing and compilation.
+ Positions of element origins are resolved on each replay, since elements might move between them,
+ and the chain is only compiled again if any of these positions has changed.
+ */
+@interface AMW3CActionsSequence : NSObject
+
+/*! Unique identifier of the sequence */
+@property (nonatomic, readonly) NSString *identifier;
+/*! Raw actions chain the sequence has been created from */
+@property (nonatomic, readonly) NSArray *actions;
+/*! Whether any of the pointer move items is relative to an element */
+@property (nonatomic, readonly) BOOL hasElementOrigins;
+
+/**
+ Validates the given actions chain and creates a new sequence from it
+
+ @param actions Array of dictionaries, whose format is described in W3C spec
+ @param application The application instance to validate the chain against
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return The sequence instance or nil if the chain is not valid
+ */
++ (nullable instancetype)sequenceWithActions:(NSArray *)actions
+                                 application:(XCUIApplication *)application
+                                       error:(NSError **)error;
+
+/**
+ Returns the event record, which performs the sequence
+
+ @param application Current application instance
+ @param elementCache Elements cache to resolve element origins with
+ @param positionOffset Offset to be added to coordinates of all pointer move items with the viewport origin
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return The event record or nil in case of failure
+ */
+- (nullable XCSynthesizedEventRecord *)eventRecordWithApplication:(XCUIApplication *)application
+                                                     elementCache:(nullable FBElementCache *)elementCache
+                                                   positionOffset:(CGVector)positionOffset
+                                                            error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,264 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "AMW3CActionsSequence.h"
+
+#import "FBConfiguration.h"
+#import "FBElementCache.h"
+#import "FBProtocolHelpers.h"
+#import "FBW3CActionsSynthesizer.h"
+#import "LRUCache.h"
+#import "XCUIElement+AMHitPoint.h"
+
+static const NSUInteger EVENT_RECORDS_CACHE_SIZE = 16;
+
+static NSString *const FB_ACTION_ITEM_KEY_ORIGIN = @"origin";
+static NSString *const FB_ACTION_ITEM_KEY_X = @"x";
+static NSString *const FB_ACTION_ITEM_KEY_Y = @"y";
+static NSString *const FB_ORIGIN_TYPE_VIEWPORT = @"viewport";
+static NSString *const FB_ORIGIN_TYPE_POINTER = @"pointer";
+
+static BOOL AMIsElementOrigin(id origin)
+{
+  return nil != origin
+    && !([origin isKindOfClass:NSString.class]
+         && ([origin isEqualToString:FB_ORIGIN_TYPE_VIEWPORT] || [origin isEqualToString:FB_ORIGIN_TYPE_POINTER]));
+}
+
+@interface AMW3CActionsSequence ()
+@property (nonatomic) LRUCache *eventRecordsCache;
+/*! Distinct element origins of the chain in order of their appearance */
+@property (nonatomic) NSArray *elementOrigins;
+/*! Whether the origin with the same index is used by any item without x and y offsets */
+@property (nonatomic) NSArray<NSNumber *> *elementOriginHitPointFlags;
+@end
+
+@implementation AMW3CActionsSequence
+
+- (instancetype)initWithActions:(NSArray *)actions
+                 elementOrigins:(NSArray *)elementOrigins
+     elementOriginHitPointFlags:(NSArray<NSNumber *> *)elementOriginHitPointFlags
+{
+  if ((self = [super init])) {
+    _identifier = [[NSUUID UUID] UUIDString];
+    _actions = actions;
+    _hasElementOrigins = elementOrigins.count > 0;
+    _elementOrigins = elementOrigins;
+    _elementOriginHitPointFlags = elementOriginHitPointFlags;
+    _eventRecordsCache = [[LRUCache alloc] initWithCapacity:EVENT_RECORDS_CACHE_SIZE];
+  }
+  return self;
+}
+
+/**
+ Replaces element origins with the viewport one, so the structure of the chain
+ could be validated without resolving elements
+
+ @param elementOrigins Collects distinct element origins of the chain
+ @param elementOriginHitPointFlags Collects whether each of the collected origins is used without offsets
+ @return The patched actions chain or nil if the chain has no element origins
+ */
++ (nullable NSArray *)actionsWithoutElementOrigins:(NSArray *)actions
+                                    elementOrigins:(NSMutableArray *)elementOrigins
+                        elementOriginHitPointFlags:(NSMutableArray<NSNumber *> *)elementOriginHitPointFlags
+{
+  BOOL hasElementOrigins = NO;
+  NSMutableArray *result = [NSMutableArray arrayWithCapacity:actions.count];
+  for (id action in actions) {
+    NSArray *actionItems = [action isKindOfClass:NSDictionary.class] ? [action objectForKey:@"actions"] : nil;
+    if (![actionItems isKindOfClass:NSArray.class]) {
+      [result addObject:action];
+      continue;
+    }
+    NSMutableArray *patchedItems = [NSMutableArray arrayWithCapacity:actionItems.count];
+    for (id actionItem in actionItems) {
+      if (![actionItem isKindOfClass:NSDictionary.class]
+          || !AMIsElementOrigin([actionItem objectForKey:FB_ACTION_ITEM_KEY_ORIGIN])) {
+        [patchedItems addObject:actionItem];
+        continue;
+      }
+      hasElementOrigins = YES;
+      id origin = [actionItem objectForKey:FB_ACTION_ITEM_KEY_ORIGIN];
+      NSUInteger originIndex = [elementOrigins indexOfObject:origin];
+      if (NSNotFound == originIndex) {
+        originIndex = elementOrigins.count;
+        [elementOrigins addObject:origin];
+        [elementOriginHitPointFlags addObject:@NO];
+      }
+      NSMutableDictionary *patchedItem = [actionItem mutableCopy];
+      [patchedItem setObject:FB_ORIGIN_TYPE_VIEWPORT forKey:FB_ACTION_ITEM_KEY_ORIGIN];
+      if (nil == [patchedItem objectForKey:FB_ACTION_ITEM_KEY_X] && nil == [patchedItem objectForKey:FB_ACTION_ITEM_KEY_Y]) {
+        [patchedItem setObject:@0 forKey:FB_ACTION_ITEM_KEY_X];
+        [patchedItem setObject:@0 forKey:FB_ACTION_ITEM_KEY_Y];
+        [elementOriginHitPointFlags replaceObjectAtIndex:originIndex withObject:@YES];
+      }
+      [patchedItems addObject:patchedItem.copy];
+    }
+    NSMutableDictionary *patchedAction = [action mutableCopy];
+    [patchedAction setObject:patchedItems.copy forKey:@"actions"];
+    [result addObject:patchedAction.copy];
+  }
+  return hasElementOrigins ? result.copy : nil;
+}
+
++ (nullable XCSynthesizedEventRecord *)eventRecordWithActions:(NSArray *)actions
+                                                  application:(XCUIApplication *)application
+                                                 elementCache:(nullable FBElementCache *)elementCache
+                                               positionOffset:(CGVector)positionOffset
+                                                        error:(NSError **)error
+{
+  FBW3CActionsSynthesizer *synthesizer = [[FBW3CActionsSynthesizer alloc] initWithActions:actions
+                                                                           forApplication:application
+                                                                             elementCache:elementCache
+                                                                                    error:error];
+  if (nil == synthesizer) {
+    return nil;
+  }
+  synthesizer.positionOffset = positionOffset;
+  return [synthesizer synthesizeWithError:error];
+}
+
++ (instancetype)sequenceWithActions:(NSArray *)actions
+                        application:(XCUIApplication *)application
+                              error:(NSError **)error
+{
+  NSArray *actionsCopy = [actions copy];
+  NSMutableArray *elementOrigins = [NSMutableArray array];
+  NSMutableArray<NSNumber *> *elementOriginHitPointFlags = [NSMutableArray array];
+  NSArray *validationActions = [self actionsWithoutElementOrigins:actionsCopy
+                                                   elementOrigins:elementOrigins
+                                       elementOriginHitPointFlags:elementOriginHitPointFlags];
+  BOOL hasElementOrigins = nil != validationActions;
+  XCSynthesizedEventRecord *eventRecord = [self eventRecordWithActions:validationActions ?: actionsCopy
+                                                           application:application
+                                                          elementCache:nil
+                                                        positionOffset:CGVectorMake(0, 0)
+                                                                 error:error];
+  if (nil == eventRecord) {
+    return nil;
+  }
+  AMW3CActionsSequence *sequence = [[self alloc] initWithActions:actionsCopy
+                                                  elementOrigins:elementOrigins.copy
+                                      elementOriginHitPointFlags:elementOriginHitPointFlags.copy];
+  if (!hasElementOrigins) {
+    [sequence cacheEventRecord:eventRecord forPositionOffset:CGVectorMake(0, 0)];
+  }
+  return sequence;
+}
+
++ (NSArray *)cacheKeyWithPositionOffset:(CGVector)positionOffset
+{
+  // Synthesized events also depend on the pointer move tolerance and the typing frequency,
+  // which could be changed between calls
+  return @[@(positionOffset.dx), @(positionOffset.dy),
+           @(FBConfiguration.sharedConfiguration.pointerMoveTolerance),
+           @(FBConfiguration.sharedConfiguration.typingFrequency)];
+}
+
++ (nullable XCUIElement *)elementWithOrigin:(id)origin elementCache:(nullable FBElementCache *)elementCache
+{
+  if ([origin isKindOfClass:NSDictionary.class]) {
+    origin = FBExtractElement(origin) ?: origin;
+  }
+  if ([origin isKindOfClass:XCUIElement.class]) {
+    return origin;
+  }
+  if ([origin isKindOfClass:NSString.class] && nil != elementCache) {
+    return [elementCache elementForUUID:(NSString *)origin];
+  }
+  return nil;
+}
+
+/**
+ Resolves the positions of element origins, which define the coordinates of the synthesized events
+
+ @return The array of resolved frames and hit points or nil if any of the origins could not be resolved
+ */
+- (nullable NSArray *)elementOriginPositionsWithElementCache:(nullable FBElementCache *)elementCache
+{
+  NSMutableArray *result = [NSMutableArray array];
+  for (NSUInteger index = 0; index < self.elementOrigins.count; index++) {
+    XCUIElement *element = [self.class elementWithOrigin:self.elementOrigins[index] elementCache:elementCache];
+    if (nil == element || !element.exists) {
+      return nil;
+    }
+    CGRect frame = element.frame;
+    [result addObjectsFromArray:@[@(frame.origin.x), @(frame.origin.y), @(frame.size.width), @(frame.size.height)]];
+    if (!self.elementOriginHitPointFlags[index].boolValue) {
+      continue;
+    }
+    XCUICoordinate *hitPoint = element.am_hitPointCoordinate;
+    if (nil == hitPoint) {
+      [result addObject:NSNull.null];
+    } else {
+      CGPoint screenPoint = hitPoint.screenPoint;
+      [result addObjectsFromArray:@[@(screenPoint.x), @(screenPoint.y)]];
+    }
+  }
+  return result.copy;
+}
+
+- (void)cacheEventRecord:(XCSynthesizedEventRecord *)eventRecord forKey:(NSArray *)key
+{
+  @synchronized (self.eventRecordsCache) {
+    [self.eventRecordsCache setObject:eventRecord forKey:key];
+  }
+}
+
+- (void)cacheEventRecord:(XCSynthesizedEventRecord *)eventRecord forPositionOffset:(CGVector)positionOffset
+{
+  [self cacheEventRecord:eventRecord forKey:[self.class cacheKeyWithPositionOffset:positionOffset]];
+}
+
+- (XCSynthesizedEventRecord *)eventRecordWithApplication:(XCUIApplication *)application
+                                            elementCache:(FBElementCache *)elementCache
+                                          positionOffset:(CGVector)positionOffset
+                                                   error:(NSError **)error
+{
+  NSArray *cacheKey = [self.class cacheKeyWithPositionOffset:positionOffset];
+  if (self.hasElementOrigins) {
+    // Only the element positions are resolved on replay. The chain is compiled again
+    // only if any of them has changed since the previous replay
+    NSArray *elementOriginPositions = [self elementOriginPositionsWithElementCache:elementCache];
+    if (nil == elementOriginPositions) {
+      // Let the synthesizer report the actual problem
+      return [self.class eventRecordWithActions:self.actions
+                                    application:application
+                                   elementCache:elementCache
+                                 positionOffset:positionOffset
+                                          error:error];
+    }
+    cacheKey = [cacheKey arrayByAddingObjectsFromArray:elementOriginPositions];
+  }
+
+  XCSynthesizedEventRecord *eventRecord;
+  @synchronized (self.eventRecordsCache) {
+    eventRecord = [self.eventRecordsCache objectForKey:cacheKey];
+  }
+  if (nil != eventRecord) {
+    return eventRecord;
+  }
+  eventRecord = [self.class eventRecordWithActions:self.actions
+                                       application:application
+                                      elementCache:elementCache
+                                    positionOffset:positionOffset
+                                             error:error];
+  if (nil != eventRecord) {
+    [self cacheEventRecord:eventRecord forKey:cacheKey];
+  }
+  return eventRecord;
+}
+
+@end
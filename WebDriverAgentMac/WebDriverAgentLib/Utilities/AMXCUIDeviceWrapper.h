@@ -67,6 +67,16 @@ withApplication:(NSString *)bundleId
 - (BOOL)synthesizeEvent:(XCSynthesizedEventRecord *)event
                   error:(NSError **)error;
 
+/**
+ Starts synthesizing an input event according to the given event spec without waiting for it to finish
+
+ @param event The event spec
+ @param completion The block, which is called on an arbitrary queue once the event has been synthesized.
+ The error argument is set if the operation has failed
+ */
+- (void)synthesizeEvent:(XCSynthesizedEventRecord *)event
+             completion:(void (^)(NSError *_Nullable error))completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
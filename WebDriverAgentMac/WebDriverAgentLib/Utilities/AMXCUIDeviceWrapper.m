@@ -16,6 +16,7 @@
 
 #import "AMXCUIDeviceWrapper.h"
 
+#import "AMTrace.h"
 #import "FBErrorBuilder.h"
 #import "FBRunLoopSpinner.h"
 #import "XCSynthesizedEventRecord.h"
@@ -125,15 +126,13 @@ withApplication:(NSString *)bundleId
 {
   __block NSError *internalError = nil;
   dispatch_semaphore_t sem = dispatch_semaphore_create(0);
-  id<XCUIEventSynthesizing> eventSynthesizer = [self eventSynthesizer];
-  [eventSynthesizer synthesizeEvent:event
-                         completion:(id)^(BOOL result, NSError *invokeError) {
-    if (!result) {
-      internalError = invokeError;
-    }
+  AMTraceSpan *synthesisSpan = [AMTrace beginSpanWithName:@"synthesizeEvent"];
+  [self synthesizeEvent:event completion:^(NSError *invokeError) {
+    internalError = invokeError;
     dispatch_semaphore_signal(sem);
   }];
   BOOL didTimeout = 0 != dispatch_semaphore_wait(sem, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX_ACTIONS_DURATION_SEC * NSEC_PER_SEC)));
+  [synthesisSpan end];
   if (didTimeout) {
     return [[[FBErrorBuilder builder]
              withDescriptionFormat:@"Cannot perform actions within %@ seconds timeout", @(MAX_ACTIONS_DURATION_SEC)]
@@ -149,4 +148,24 @@ withApplication:(NSString *)bundleId
   return YES;
 }
 
+- (void)synthesizeEvent:(XCSynthesizedEventRecord *)event
+             completion:(void (^)(NSError *_Nullable error))completion
+{
+  id<XCUIEventSynthesizing> eventSynthesizer = [self eventSynthesizer];
+  [eventSynthesizer synthesizeEvent:event
+                         completion:(id)^(BOOL result, NSError *invokeError) {
+    if (result) {
+      completion(nil);
+      return;
+    }
+    NSError *error = invokeError;
+    if (nil == error) {
+      [[[FBErrorBuilder builder]
+        withDescriptionFormat:@"Cannot synthesize the '%@' event for an unknown reason", event.name]
+       buildError:&error];
+    }
+    completion(error);
+  }];
+}
+
 @end
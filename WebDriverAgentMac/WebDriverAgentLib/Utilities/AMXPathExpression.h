@@ -0,0 +1,63 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class AMSnapshotTree;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Compiled XPath expression, which is evaluated directly over AMSnapshotTree
+ without building the intermediate XML document.
+
+ The engine implements the XPath 1.0 grammar with all axes except namespace and the core
+ function library extended with commonly used XPath 2.0 string functions,
+ like ends-with, lower-case, upper-case and matches. Element nodes of the tree have names
+ of their element types and attributes have the same names and values as in the XML page source.
+
+ Constructs, which are not supported, as well as expressions whose results could differ
+ from the reference NSXMLElement-based implementation, are reported as errors
+ at compile or evaluation time, so the caller could fall back to the reference implementation.
+ */
+@interface AMXPathExpression : NSObject
+
+/*! The source of the compiled expression */
+@property (nonatomic, readonly) NSString *query;
+
+/**
+ Compiles the given XPath query. Compiled expressions are cached and shared,
+ since they are immutable
+
+ @param query XPath query. The root node of the query is the root node of the evaluated tree
+ @param error Is set if the query cannot be compiled
+ @return The compiled expression or nil if the query is invalid or is not supported
+ */
++ (nullable instancetype)expressionWithQuery:(NSString *)query error:(NSError **)error;
+
+/**
+ Evaluates the expression over the given tree
+
+ @param tree The tree to evaluate the expression over
+ @param error Is set if the expression cannot be evaluated natively
+ @return Indexes of element nodes matched by the expression. Non-element matches, like attributes,
+ are omitted. nil is returned if the evaluation has failed
+ */
+- (nullable NSIndexSet *)matchingNodesInTree:(AMSnapshotTree *)tree error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
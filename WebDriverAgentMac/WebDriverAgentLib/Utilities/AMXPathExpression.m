@@ -0,0 +1,1639 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * See the NOTICE file distributed with this work for additional
+ * information regarding copyright ownership.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "AMXPathExpression.h"
+
+#import <math.h>
+
+#import "AMSnapshotTree.h"
+#import "FBErrorBuilder.h"
+#import "LRUCache.h"
+
+static NSString *const AMXPathUnsupportedException = @"AMXPathUnsupportedException";
+
+static void AMXPathRaiseUnsupported(NSString *reason) __attribute__((noreturn));
+
+static void AMXPathRaiseUnsupported(NSString *reason)
+{
+  @throw [NSException exceptionWithName:AMXPathUnsupportedException reason:reason userInfo:nil];
+}
+
+#pragma mark - Values
+
+typedef NS_ENUM(NSUInteger, AMXPathValueType) {
+  AMXPathValueTypeNodeSet,
+  // Attribute values are the only non-element nodes of the tree, so they are kept as strings
+  AMXPathValueTypeAttributeSet,
+  AMXPathValueTypeNumber,
+  AMXPathValueTypeBoolean,
+  AMXPathValueTypeString,
+};
+
+@interface AMXPathValue : NSObject
+@property (nonatomic, readonly) AMXPathValueType type;
+@property (nonatomic, readonly) NSIndexSet *nodes;
+@property (nonatomic, readonly) NSArray<NSString *> *attributeValues;
+@property (nonatomic, readonly) double number;
+@property (nonatomic, readonly) BOOL boolean;
+@property (nonatomic, readonly) NSString *string;
+@end
+
+@implementation AMXPathValue
+
++ (instancetype)valueWithNodes:(NSIndexSet *)nodes
+{
+  AMXPathValue *value = [self new];
+  value->_type = AMXPathValueTypeNodeSet;
+  value->_nodes = nodes;
+  return value;
+}
+
++ (instancetype)valueWithAttributeValues:(NSArray<NSString *> *)attributeValues
+{
+  AMXPathValue *value = [self new];
+  value->_type = AMXPathValueTypeAttributeSet;
+  value->_attributeValues = attributeValues;
+  return value;
+}
+
++ (instancetype)valueWithNumber:(double)number
+{
+  AMXPathValue *value = [self new];
+  value->_type = AMXPathValueTypeNumber;
+  value->_number = number;
+  return value;
+}
+
++ (instancetype)valueWithBoolean:(BOOL)boolean
+{
+  static AMXPathValue *trueValue;
+  static AMXPathValue *falseValue;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    trueValue = [self new];
+    trueValue->_type = AMXPathValueTypeBoolean;
+    trueValue->_boolean = YES;
+    falseValue = [self new];
+    falseValue->_type = AMXPathValueTypeBoolean;
+    falseValue->_boolean = NO;
+  });
+  return boolean ? trueValue : falseValue;
+}
+
++ (instancetype)valueWithString:(NSString *)string
+{
+  AMXPathValue *value = [self new];
+  value->_type = AMXPathValueTypeString;
+  value->_string = string;
+  return value;
+}
+
+- (BOOL)isSet
+{
+  return self.type == AMXPathValueTypeNodeSet || self.type == AMXPathValueTypeAttributeSet;
+}
+
+/*! The string values of set items. The string value of an element node is always empty */
+- (NSArray<NSString *> *)itemStrings
+{
+  if (self.type == AMXPathValueTypeAttributeSet) {
+    return self.attributeValues;
+  }
+  NSMutableArray<NSString *> *result = [NSMutableArray arrayWithCapacity:self.nodes.count];
+  for (NSUInteger i = 0; i < self.nodes.count; i++) {
+    [result addObject:@""];
+  }
+  return result.copy;
+}
+
+- (NSUInteger)itemsCount
+{
+  return self.type == AMXPathValueTypeAttributeSet ? self.attributeValues.count : self.nodes.count;
+}
+
+@end
+
+static NSString *AMXPathStringWithNumber(double number)
+{
+  if (isnan(number)) {
+    return @"NaN";
+  }
+  if (isinf(number)) {
+    return number > 0 ? @"Infinity" : @"-Infinity";
+  }
+  if (number == floor(number) && fabs(number) < 1e15) {
+    return [NSString stringWithFormat:@"%lld", (long long)number];
+  }
+  return @(number).stringValue;
+}
+
+static double AMXPathNumberWithString(NSString *string)
+{
+  NSString *trimmed = [string stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceAndNewlineCharacterSet];
+  NSUInteger length = trimmed.length;
+  NSUInteger index = 0;
+  if (index < length && [trimmed characterAtIndex:index] == '-') {
+    index++;
+  }
+  BOOL hasDigits = NO;
+  BOOL hasDot = NO;
+  for (; index < length; index++) {
+    unichar c = [trimmed characterAtIndex:index];
+    if (c >= '0' && c <= '9') {
+      hasDigits = YES;
+    } else if (c == '.' && !hasDot) {
+      hasDot = YES;
+    } else {
+      return NAN;
+    }
+  }
+  return hasDigits ? trimmed.doubleValue : NAN;
+}
+
+/*! Sequences of more than one item cannot be atomized by XPath 2.0, so these are not supported */
+static AMXPathValue *AMXPathSingleItemValue(AMXPathValue *value)
+{
+  if (value.isSet && value.itemsCount > 1) {
+    AMXPathRaiseUnsupported(@"A sequence of more than one item cannot be converted to a single value");
+  }
+  return value;
+}
+
+static NSString *AMXPathStringValue(AMXPathValue *value)
+{
+  switch (value.type) {
+    case AMXPathValueTypeNodeSet:
+      AMXPathSingleItemValue(value);
+      return @"";
+    case AMXPathValueTypeAttributeSet:
+      AMXPathSingleItemValue(value);
+      return value.attributeValues.firstObject ?: @"";
+    case AMXPathValueTypeNumber:
+      return AMXPathStringWithNumber(value.number);
+    case AMXPathValueTypeBoolean:
+      return value.boolean ? @"true" : @"false";
+    case AMXPathValueTypeString:
+      return value.string;
+  }
+}
+
+static double AMXPathNumberValue(AMXPathValue *value)
+{
+  switch (value.type) {
+    case AMXPathValueTypeNumber:
+      return value.number;
+    case AMXPathValueTypeBoolean:
+      return value.boolean ? 1 : 0;
+    default:
+      return AMXPathNumberWithString(AMXPathStringValue(value));
+  }
+}
+
+static BOOL AMXPathBooleanValue(AMXPathValue *value)
+{
+  switch (value.type) {
+    case AMXPathValueTypeNodeSet:
+    case AMXPathValueTypeAttributeSet:
+      return value.itemsCount > 0;
+    case AMXPathValueTypeNumber:
+      return value.number != 0 && !isnan(value.number);
+    case AMXPathValueTypeBoolean:
+      return value.boolean;
+    case AMXPathValueTypeString:
+      return value.string.length > 0;
+  }
+}
+
+/**
+ Untyped values are cast to numbers in arithmetic and relational expressions.
+ XPath 2.0 fails on values, which are not numeric, while XPath 1.0 uses NaN
+ */
+static double AMXPathNumberWithUntypedString(NSString *string)
+{
+  double result = AMXPathNumberWithString(string);
+  if (isnan(result)) {
+    AMXPathRaiseUnsupported([NSString stringWithFormat:@"'%@' cannot be cast to a number", string]);
+  }
+  return result;
+}
+
+#pragma mark - Evaluation context
+
+typedef struct {
+  __unsafe_unretained AMSnapshotTree *tree;
+  NSUInteger node;
+  NSUInteger position;
+  NSUInteger size;
+  // Compiled regular expressions keyed by [pattern, options]. Shared by the whole evaluation
+  __unsafe_unretained NSMutableDictionary<NSArray *, NSRegularExpression *> *regexCache;
+} AMXPathContext;
+
+typedef struct {
+  NSUInteger *items;
+  NSUInteger count;
+  NSUInteger capacity;
+} AMXPathNodeBuffer;
+
+static void AMXPathNodeBufferAppend(AMXPathNodeBuffer *buffer, NSUInteger node)
+{
+  if (buffer->count == buffer->capacity) {
+    buffer->capacity = MAX(16, buffer->capacity * 2);
+    buffer->items = realloc(buffer->items, buffer->capacity * sizeof(NSUInteger));
+  }
+  buffer->items[buffer->count++] = node;
+}
+
+#pragma mark - Syntax tree
+
+@interface AMXPathExpr : NSObject
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context;
+@end
+
+@implementation AMXPathExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  @throw [NSException exceptionWithName:NSInternalInconsistencyException
+                                 reason:[NSString stringWithFormat:@"%@ must be overridden", NSStringFromSelector(_cmd)]
+                               userInfo:nil];
+}
+
+@end
+
+@interface AMXPathLiteralExpr : AMXPathExpr
+@property (nonatomic) AMXPathValue *value;
+@end
+
+@implementation AMXPathLiteralExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  return self.value;
+}
+
+@end
+
+typedef NS_ENUM(NSUInteger, AMXPathOperator) {
+  AMXPathOperatorOr,
+  AMXPathOperatorAnd,
+  AMXPathOperatorEqual,
+  AMXPathOperatorNotEqual,
+  AMXPathOperatorLess,
+  AMXPathOperatorLessOrEqual,
+  AMXPathOperatorGreater,
+  AMXPathOperatorGreaterOrEqual,
+  AMXPathOperatorPlus,
+  AMXPathOperatorMinus,
+  AMXPathOperatorMultiply,
+  AMXPathOperatorDivide,
+  AMXPathOperatorModulo,
+  AMXPathOperatorUnion,
+};
+
+static BOOL AMXPathCompareNumbers(AMXPathOperator op, double left, double right)
+{
+  switch (op) {
+    case AMXPathOperatorEqual: return left == right;
+    case AMXPathOperatorNotEqual: return left != right;
+    case AMXPathOperatorLess: return left < right;
+    case AMXPathOperatorLessOrEqual: return left <= right;
+    case AMXPathOperatorGreater: return left > right;
+    case AMXPathOperatorGreaterOrEqual: return left >= right;
+    default: return NO;
+  }
+}
+
+static BOOL AMXPathIsEqualityOperator(AMXPathOperator op)
+{
+  return op == AMXPathOperatorEqual || op == AMXPathOperatorNotEqual;
+}
+
+static BOOL AMXPathCompareStrings(AMXPathOperator op, NSString *left, NSString *right)
+{
+  BOOL isEqual = [left isEqualToString:right];
+  return op == AMXPathOperatorEqual ? isEqual : !isEqual;
+}
+
+/*! Compares an item of a set with an atomic value using XPath general comparison rules */
+static BOOL AMXPathCompareItemWithValue(AMXPathOperator op, NSString *item, AMXPathValue *value)
+{
+  if (value.type == AMXPathValueTypeNumber) {
+    return AMXPathCompareNumbers(op, AMXPathNumberWithUntypedString(item), value.number);
+  }
+  if (!AMXPathIsEqualityOperator(op)) {
+    // XPath 2.0 compares strings lexicographically, while XPath 1.0 converts them to numbers
+    AMXPathRaiseUnsupported(@"Relational comparison of strings is not supported");
+  }
+  return AMXPathCompareStrings(op, item, value.string);
+}
+
+static BOOL AMXPathCompareValues(AMXPathOperator op, AMXPathValue *left, AMXPathValue *right)
+{
+  if (left.isSet || right.isSet) {
+    if ((left.isSet && right.type == AMXPathValueTypeBoolean)
+        || (right.isSet && left.type == AMXPathValueTypeBoolean)) {
+      AMXPathRaiseUnsupported(@"Comparison of sequences with boolean values is not supported");
+    }
+    if (left.isSet && right.isSet) {
+      if (!AMXPathIsEqualityOperator(op)) {
+        AMXPathRaiseUnsupported(@"Relational comparison of sequences is not supported");
+      }
+      NSArray<NSString *> *rightItems = right.itemStrings;
+      for (NSString *leftItem in left.itemStrings) {
+        for (NSString *rightItem in rightItems) {
+          if (AMXPathCompareStrings(op, leftItem, rightItem)) {
+            return YES;
+          }
+        }
+      }
+      return NO;
+    }
+    BOOL isLeftSet = left.isSet;
+    AMXPathValue *set = isLeftSet ? left : right;
+    AMXPathValue *atomic = isLeftSet ? right : left;
+    AMXPathOperator effectiveOp = op;
+    if (!isLeftSet) {
+      // Mirror the operator, so the set item is always the left operand
+      switch (op) {
+        case AMXPathOperatorLess: effectiveOp = AMXPathOperatorGreater; break;
+        case AMXPathOperatorLessOrEqual: effectiveOp = AMXPathOperatorGreaterOrEqual; break;
+        case AMXPathOperatorGreater: effectiveOp = AMXPathOperatorLess; break;
+        case AMXPathOperatorGreaterOrEqual: effectiveOp = AMXPathOperatorLessOrEqual; break;
+        default: break;
+      }
+    }
+    for (NSString *item in set.itemStrings) {
+      if (AMXPathCompareItemWithValue(effectiveOp, item, atomic)) {
+        return YES;
+      }
+    }
+    return NO;
+  }
+
+  if (AMXPathIsEqualityOperator(op)) {
+    if (left.type == AMXPathValueTypeBoolean || right.type == AMXPathValueTypeBoolean) {
+      BOOL isEqual = AMXPathBooleanValue(left) == AMXPathBooleanValue(right);
+      return op == AMXPathOperatorEqual ? isEqual : !isEqual;
+    }
+    if (left.type == AMXPathValueTypeNumber || right.type == AMXPathValueTypeNumber) {
+      return AMXPathCompareNumbers(op, AMXPathNumberValue(left), AMXPathNumberValue(right));
+    }
+    return AMXPathCompareStrings(op, AMXPathStringValue(left), AMXPathStringValue(right));
+  }
+  if (left.type != AMXPathValueTypeNumber || right.type != AMXPathValueTypeNumber) {
+    AMXPathRaiseUnsupported(@"Relational comparison of non-numeric values is not supported");
+  }
+  return AMXPathCompareNumbers(op, left.number, right.number);
+}
+
+static double AMXPathArithmeticOperand(AMXPathValue *value)
+{
+  if (value.isSet) {
+    if (1 != value.itemsCount) {
+      AMXPathRaiseUnsupported(@"Arithmetic operations are only supported for single items");
+    }
+    return AMXPathNumberWithUntypedString(value.itemStrings.firstObject);
+  }
+  return AMXPathNumberValue(value);
+}
+
+@interface AMXPathBinaryExpr : AMXPathExpr
+@property (nonatomic) AMXPathOperator op;
+@property (nonatomic) AMXPathExpr *left;
+@property (nonatomic) AMXPathExpr *right;
+@end
+
+@implementation AMXPathBinaryExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  AMXPathValue *left = [self.left evaluateWithContext:context];
+  switch (self.op) {
+    case AMXPathOperatorOr:
+      return AMXPathBooleanValue(left)
+        ? [AMXPathValue valueWithBoolean:YES]
+        : [AMXPathValue valueWithBoolean:AMXPathBooleanValue([self.right evaluateWithContext:context])];
+    case AMXPathOperatorAnd:
+      return AMXPathBooleanValue(left)
+        ? [AMXPathValue valueWithBoolean:AMXPathBooleanValue([self.right evaluateWithContext:context])]
+        : [AMXPathValue valueWithBoolean:NO];
+    default:
+      break;
+  }
+
+  AMXPathValue *right = [self.right evaluateWithContext:context];
+  switch (self.op) {
+    case AMXPathOperatorEqual:
+    case AMXPathOperatorNotEqual:
+    case AMXPathOperatorLess:
+    case AMXPathOperatorLessOrEqual:
+    case AMXPathOperatorGreater:
+    case AMXPathOperatorGreaterOrEqual:
+      return [AMXPathValue valueWithBoolean:AMXPathCompareValues(self.op, left, right)];
+    case AMXPathOperatorUnion: {
+      if (left.type != AMXPathValueTypeNodeSet || right.type != AMXPathValueTypeNodeSet) {
+        AMXPathRaiseUnsupported(@"Only element sets could be united");
+      }
+      NSMutableIndexSet *result = left.nodes.mutableCopy;
+      [result addIndexes:right.nodes];
+      return [AMXPathValue valueWithNodes:result.copy];
+    }
+    default:
+      break;
+  }
+
+  double leftNumber = AMXPathArithmeticOperand(left);
+  double rightNumber = AMXPathArithmeticOperand(right);
+  switch (self.op) {
+    case AMXPathOperatorPlus:
+      return [AMXPathValue valueWithNumber:leftNumber + rightNumber];
+    case AMXPathOperatorMinus:
+      return [AMXPathValue valueWithNumber:leftNumber - rightNumber];
+    case AMXPathOperatorMultiply:
+      return [AMXPathValue valueWithNumber:leftNumber * rightNumber];
+    case AMXPathOperatorDivide:
+      return [AMXPathValue valueWithNumber:leftNumber / rightNumber];
+    case AMXPathOperatorModulo:
+      return [AMXPathValue valueWithNumber:fmod(leftNumber, rightNumber)];
+    default:
+      AMXPathRaiseUnsupported(@"Unknown operator");
+      return nil;
+  }
+}
+
+@end
+
+@interface AMXPathNegateExpr : AMXPathExpr
+@property (nonatomic) AMXPathExpr *operand;
+@end
+
+@implementation AMXPathNegateExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  return [AMXPathValue valueWithNumber:-AMXPathArithmeticOperand([self.operand evaluateWithContext:context])];
+}
+
+@end
+
+typedef NS_ENUM(NSUInteger, AMXPathAxis) {
+  AMXPathAxisChild,
+  AMXPathAxisDescendant,
+  AMXPathAxisDescendantOrSelf,
+  AMXPathAxisSelf,
+  AMXPathAxisParent,
+  AMXPathAxisAncestor,
+  AMXPathAxisAncestorOrSelf,
+  AMXPathAxisFollowingSibling,
+  AMXPathAxisPrecedingSibling,
+  AMXPathAxisFollowing,
+  AMXPathAxisPreceding,
+  AMXPathAxisAttribute,
+};
+
+typedef NS_ENUM(NSUInteger, AMXPathNodeTest) {
+  // Matches nodes with the given name
+  AMXPathNodeTestName,
+  // Matches all nodes of the principal node type (*)
+  AMXPathNodeTestAny,
+  // Matches all nodes (node())
+  AMXPathNodeTestNode,
+  // Matches nothing, since there are no text, comment or processing instruction nodes
+  AMXPathNodeTestNone,
+};
+
+@interface AMXPathStep : NSObject
+@property (nonatomic) AMXPathAxis axis;
+@property (nonatomic) AMXPathNodeTest nodeTest;
+@property (nonatomic) NSString *name;
+@property (nonatomic) NSArray<AMXPathExpr *> *predicates;
+@end
+
+@implementation AMXPathStep
+
+- (BOOL)matchesNode:(NSUInteger)node inTree:(AMSnapshotTree *)tree
+{
+  switch (self.nodeTest) {
+    case AMXPathNodeTestName:
+      return [[tree typeNameOfNode:node] isEqualToString:(NSString *)self.name];
+    case AMXPathNodeTestAny:
+    case AMXPathNodeTestNode:
+      return YES;
+    case AMXPathNodeTestNone:
+      return NO;
+  }
+}
+
+- (void)collectNodesFromNode:(NSUInteger)node inTree:(AMSnapshotTree *)tree intoBuffer:(AMXPathNodeBuffer *)buffer
+{
+#define AM_XPATH_COLLECT(candidate) \
+  if ([self matchesNode:(candidate) inTree:tree]) { AMXPathNodeBufferAppend(buffer, (candidate)); }
+
+  // Nodes are always collected in the axis order, so predicate positions are correct
+  switch (self.axis) {
+    case AMXPathAxisChild:
+      for (NSUInteger child = [tree firstChildOfNode:node];
+           child != AMSnapshotTreeNoNode;
+           child = [tree nextSiblingOfNode:child]) {
+        AM_XPATH_COLLECT(child);
+      }
+      break;
+    case AMXPathAxisDescendant:
+    case AMXPathAxisDescendantOrSelf: {
+      NSUInteger end = [tree subtreeEndOfNode:node];
+      for (NSUInteger i = self.axis == AMXPathAxisDescendant ? node + 1 : node; i < end; i++) {
+        AM_XPATH_COLLECT(i);
+      }
+      break;
+    }
+    case AMXPathAxisSelf:
+      AM_XPATH_COLLECT(node);
+      break;
+    case AMXPathAxisParent: {
+      NSUInteger parent = [tree parentOfNode:node];
+      if (parent != AMSnapshotTreeNoNode) {
+        AM_XPATH_COLLECT(parent);
+      }
+      break;
+    }
+    case AMXPathAxisAncestor:
+    case AMXPathAxisAncestorOrSelf:
+      for (NSUInteger ancestor = self.axis == AMXPathAxisAncestor ? [tree parentOfNode:node] : node;
+           ancestor != AMSnapshotTreeNoNode;
+           ancestor = [tree parentOfNode:ancestor]) {
+        AM_XPATH_COLLECT(ancestor);
+      }
+      break;
+    case AMXPathAxisFollowingSibling:
+      for (NSUInteger sibling = [tree nextSiblingOfNode:node];
+           sibling != AMSnapshotTreeNoNode;
+           sibling = [tree nextSiblingOfNode:sibling]) {
+        AM_XPATH_COLLECT(sibling);
+      }
+      break;
+    case AMXPathAxisPrecedingSibling:
+      for (NSUInteger sibling = [tree previousSiblingOfNode:node];
+           sibling != AMSnapshotTreeNoNode;
+           sibling = [tree previousSiblingOfNode:sibling]) {
+        AM_XPATH_COLLECT(sibling);
+      }
+      break;
+    case AMXPathAxisFollowing:
+      for (NSUInteger i = [tree subtreeEndOfNode:node]; i < tree.count; i++) {
+        AM_XPATH_COLLECT(i);
+      }
+      break;
+    case AMXPathAxisPreceding: {
+      // Preceding nodes are all nodes before the given one in document order except of ancestors
+      NSUInteger nextAncestor = [tree parentOfNode:node];
+      for (NSUInteger i = node; i > 0; i--) {
+        NSUInteger candidate = i - 1;
+        if (candidate == nextAncestor) {
+          nextAncestor = [tree parentOfNode:candidate];
+          continue;
+        }
+        AM_XPATH_COLLECT(candidate);
+      }
+      break;
+    }
+    case AMXPathAxisAttribute:
+      break;
+  }
+#undef AM_XPATH_COLLECT
+}
+
+- (BOOL)isDescendantAxis
+{
+  return self.axis == AMXPathAxisDescendant || self.axis == AMXPathAxisDescendantOrSelf;
+}
+
+- (AMXPathValue *)evaluateFromNodes:(NSIndexSet *)nodes withContext:(AMXPathContext)context
+{
+  AMSnapshotTree *tree = context.tree;
+  if (self.axis == AMXPathAxisAttribute) {
+    NSArray<NSString *> *names = self.nodeTest == AMXPathNodeTestName
+      ? @[(NSString *)self.name]
+      : (self.nodeTest == AMXPathNodeTestNone ? @[] : AMSnapshotTree.attributeNames);
+    NSMutableArray<NSString *> *values = [NSMutableArray array];
+    [nodes enumerateIndexesUsingBlock:^(NSUInteger node, BOOL *stop) {
+      for (NSString *name in names) {
+        NSString *value = [tree attributeValueWithName:name ofNode:node];
+        if (nil != value) {
+          [values addObject:value];
+        }
+      }
+    }];
+    return [AMXPathValue valueWithAttributeValues:values.copy];
+  }
+
+  NSMutableIndexSet *result = [NSMutableIndexSet indexSet];
+  AMXPathNodeBuffer buffer = {NULL, 0, 0};
+  // Subtrees of nodes, which are descendants of already visited nodes, are already collected
+  BOOL canSkipCoveredNodes = self.isDescendantAxis && 0 == self.predicates.count;
+  NSUInteger coveredEnd = 0;
+  @try {
+    for (NSUInteger node = nodes.firstIndex; node != NSNotFound; node = [nodes indexGreaterThanIndex:node]) {
+      if (canSkipCoveredNodes) {
+        if (node < coveredEnd) {
+          continue;
+        }
+        coveredEnd = [tree subtreeEndOfNode:node];
+      }
+      buffer.count = 0;
+      [self collectNodesFromNode:node inTree:tree intoBuffer:&buffer];
+      for (AMXPathExpr *predicate in self.predicates) {
+        NSUInteger size = buffer.count;
+        NSUInteger matchedCount = 0;
+        for (NSUInteger i = 0; i < size; i++) {
+          AMXPathContext predicateContext = {tree, buffer.items[i], i + 1, size, context.regexCache};
+          AMXPathValue *value = [predicate evaluateWithContext:predicateContext];
+          BOOL isMatch = value.type == AMXPathValueTypeNumber
+            ? value.number == (double)(i + 1)
+            : AMXPathBooleanValue(value);
+          if (isMatch) {
+            buffer.items[matchedCount++] = buffer.items[i];
+          }
+        }
+        buffer.count = matchedCount;
+      }
+      for (NSUInteger i = 0; i < buffer.count; i++) {
+        [result addIndex:buffer.items[i]];
+      }
+    }
+  } @finally {
+    free(buffer.items);
+  }
+  return [AMXPathValue valueWithNodes:result.copy];
+}
+
+@end
+
+@interface AMXPathPathExpr : AMXPathExpr
+// The primary expression the path starts from or nil for location paths
+@property (nonatomic) AMXPathExpr *filter;
+@property (nonatomic) NSArray<AMXPathExpr *> *filterPredicates;
+@property (nonatomic) BOOL isAbsolute;
+@property (nonatomic) NSArray<AMXPathStep *> *steps;
+@end
+
+@implementation AMXPathPathExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  AMXPathValue *current;
+  if (nil != self.filter) {
+    current = [self.filter evaluateWithContext:context];
+    if (self.filterPredicates.count > 0 || self.steps.count > 0) {
+      if (current.type != AMXPathValueTypeNodeSet) {
+        AMXPathRaiseUnsupported(@"Only element sets could be filtered");
+      }
+      NSIndexSet *nodes = current.nodes;
+      for (AMXPathExpr *predicate in self.filterPredicates) {
+        NSMutableIndexSet *filtered = [NSMutableIndexSet indexSet];
+        __block NSUInteger position = 0;
+        NSUInteger size = nodes.count;
+        [nodes enumerateIndexesUsingBlock:^(NSUInteger node, BOOL *stop) {
+          position++;
+          AMXPathContext predicateContext = {context.tree, node, position, size, context.regexCache};
+          AMXPathValue *value = [predicate evaluateWithContext:predicateContext];
+          BOOL isMatch = value.type == AMXPathValueTypeNumber
+            ? value.number == (double)position
+            : AMXPathBooleanValue(value);
+          if (isMatch) {
+            [filtered addIndex:node];
+          }
+        }];
+        nodes = filtered.copy;
+      }
+      current = [AMXPathValue valueWithNodes:nodes];
+    }
+  } else {
+    // The root node of the tree acts as the document root
+    current = [AMXPathValue valueWithNodes:[NSIndexSet indexSetWithIndex:self.isAbsolute ? 0 : context.node]];
+  }
+  for (AMXPathStep *step in self.steps) {
+    current = [step evaluateFromNodes:current.nodes withContext:context];
+  }
+  return current;
+}
+
+@end
+
+typedef AMXPathValue *(^AMXPathFunction)(NSArray<AMXPathValue *> *arguments, AMXPathContext context);
+
+@interface AMXPathFunctionExpr : AMXPathExpr
+@property (nonatomic) AMXPathFunction function;
+@property (nonatomic) NSArray<AMXPathExpr *> *arguments;
+@end
+
+@implementation AMXPathFunctionExpr
+
+- (AMXPathValue *)evaluateWithContext:(AMXPathContext)context
+{
+  NSMutableArray<AMXPathValue *> *values = [NSMutableArray arrayWithCapacity:self.arguments.count];
+  for (AMXPathExpr *argument in self.arguments) {
+    [values addObject:[argument evaluateWithContext:context]];
+  }
+  return self.function(values, context);
+}
+
+@end
+
+#pragma mark - Function library
+
+@interface AMXPathFunctionDefinition : NSObject
+@property (nonatomic) NSUInteger minArguments;
+@property (nonatomic) NSUInteger maxArguments;
+@property (nonatomic) AMXPathFunction function;
+@end
+
+@implementation AMXPathFunctionDefinition
+@end
+
+static NSString *AMXPathStringArgument(NSArray<AMXPathValue *> *arguments, NSUInteger index)
+{
+  return AMXPathStringValue(arguments[index]);
+}
+
+/*! Returns the string value of the first argument or of the context node if the argument is omitted */
+static NSString *AMXPathOptionalStringArgument(NSArray<AMXPathValue *> *arguments)
+{
+  return arguments.count > 0 ? AMXPathStringValue(arguments[0]) : @"";
+}
+
+static NSString *AMXPathNodeName(NSArray<AMXPathValue *> *arguments, AMXPathContext context)
+{
+  if (0 == arguments.count) {
+    return [context.tree typeNameOfNode:context.node];
+  }
+  AMXPathValue *value = arguments[0];
+  if (value.type != AMXPathValueTypeNodeSet) {
+    AMXPathRaiseUnsupported(@"Names are only supported for elements");
+  }
+  AMXPathSingleItemValue(value);
+  return 0 == value.nodes.count ? @"" : [context.tree typeNameOfNode:value.nodes.firstIndex];
+}
+
+static NSDictionary<NSString *, AMXPathFunctionDefinition *> *AMXPathFunctions(void)
+{
+  static NSDictionary<NSString *, AMXPathFunctionDefinition *> *functions;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSMutableDictionary<NSString *, AMXPathFunctionDefinition *> *result = [NSMutableDictionary dictionary];
+    void (^define)(NSString *, NSUInteger, NSUInteger, AMXPathFunction) =
+    ^(NSString *name, NSUInteger minArguments, NSUInteger maxArguments, AMXPathFunction function) {
+      AMXPathFunctionDefinition *definition = [AMXPathFunctionDefinition new];
+      definition.minArguments = minArguments;
+      definition.maxArguments = maxArguments;
+      definition.function = function;
+      result[name] = definition;
+    };
+
+    define(@"last", 0, 0, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:context.size];
+    });
+    define(@"position", 0, 0, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:context.position];
+    });
+    define(@"count", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      if (!args[0].isSet) {
+        AMXPathRaiseUnsupported(@"count() expects a sequence");
+      }
+      return [AMXPathValue valueWithNumber:args[0].itemsCount];
+    });
+    define(@"not", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:!AMXPathBooleanValue(args[0])];
+    });
+    define(@"true", 0, 0, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:YES];
+    });
+    define(@"false", 0, 0, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:NO];
+    });
+    define(@"boolean", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:AMXPathBooleanValue(args[0])];
+    });
+    define(@"string", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithString:AMXPathOptionalStringArgument(args)];
+    });
+    define(@"number", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:args.count > 0
+              ? AMXPathNumberValue(AMXPathSingleItemValue(args[0]))
+              : NAN];
+    });
+    define(@"concat", 2, NSUIntegerMax, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSMutableString *result = [NSMutableString string];
+      for (AMXPathValue *arg in args) {
+        [result appendString:AMXPathStringValue(arg)];
+      }
+      return [AMXPathValue valueWithString:result.copy];
+    });
+    define(@"contains", 2, 2, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *needle = AMXPathStringArgument(args, 1);
+      return [AMXPathValue valueWithBoolean:0 == needle.length
+              || [AMXPathStringArgument(args, 0) rangeOfString:needle].location != NSNotFound];
+    });
+    define(@"starts-with", 2, 2, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:[AMXPathStringArgument(args, 0) hasPrefix:AMXPathStringArgument(args, 1)]
+              || 0 == AMXPathStringArgument(args, 1).length];
+    });
+    define(@"ends-with", 2, 2, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithBoolean:[AMXPathStringArgument(args, 0) hasSuffix:AMXPathStringArgument(args, 1)]
+              || 0 == AMXPathStringArgument(args, 1).length];
+    });
+    define(@"string-length", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *string = AMXPathOptionalStringArgument(args);
+      // XPath counts characters rather than UTF-16 code units
+      NSUInteger length = string.length;
+      for (NSUInteger i = 0; i + 1 < string.length; i++) {
+        if (CFStringIsSurrogateHighCharacter([string characterAtIndex:i])
+            && CFStringIsSurrogateLowCharacter([string characterAtIndex:i + 1])) {
+          length--;
+        }
+      }
+      return [AMXPathValue valueWithNumber:length];
+    });
+    define(@"normalize-space", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSArray<NSString *> *words = [AMXPathOptionalStringArgument(args)
+                                    componentsSeparatedByCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@" \t\r\n"]];
+      NSPredicate *nonEmpty = [NSPredicate predicateWithFormat:@"length > 0"];
+      return [AMXPathValue valueWithString:[[words filteredArrayUsingPredicate:nonEmpty] componentsJoinedByString:@" "]];
+    });
+    define(@"translate", 3, 3, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *source = AMXPathStringArgument(args, 0);
+      NSString *from = AMXPathStringArgument(args, 1);
+      NSString *to = AMXPathStringArgument(args, 2);
+      NSMutableString *result = [NSMutableString stringWithCapacity:source.length];
+      for (NSUInteger i = 0; i < source.length; i++) {
+        unichar c = [source characterAtIndex:i];
+        NSUInteger index = [from rangeOfString:[NSString stringWithCharacters:&c length:1]].location;
+        if (index == NSNotFound) {
+          [result appendFormat:@"%C", c];
+        } else if (index < to.length) {
+          [result appendFormat:@"%C", [to characterAtIndex:index]];
+        }
+      }
+      return [AMXPathValue valueWithString:result.copy];
+    });
+    define(@"substring", 2, 3, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *source = AMXPathStringArgument(args, 0);
+      // See https://www.w3.org/TR/xpath-10/#function-substring for the rounding rules
+      double start = round(AMXPathNumberValue(args[1]));
+      double end = args.count > 2 ? start + round(AMXPathNumberValue(args[2])) : INFINITY;
+      double first = MAX(start, 1);
+      double last = MIN(end, (double)source.length + 1);
+      if (isnan(first) || isnan(last) || first >= last) {
+        return [AMXPathValue valueWithString:@""];
+      }
+      NSRange range = NSMakeRange((NSUInteger)first - 1, (NSUInteger)(last - first));
+      return [AMXPathValue valueWithString:[source substringWithRange:range]];
+    });
+    define(@"substring-before", 2, 2, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *source = AMXPathStringArgument(args, 0);
+      NSRange range = [source rangeOfString:AMXPathStringArgument(args, 1)];
+      return [AMXPathValue valueWithString:range.location == NSNotFound ? @"" : [source substringToIndex:range.location]];
+    });
+    define(@"substring-after", 2, 2, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSString *source = AMXPathStringArgument(args, 0);
+      NSString *separator = AMXPathStringArgument(args, 1);
+      if (0 == separator.length) {
+        return [AMXPathValue valueWithString:source];
+      }
+      NSRange range = [source rangeOfString:separator];
+      return [AMXPathValue valueWithString:range.location == NSNotFound ? @"" : [source substringFromIndex:NSMaxRange(range)]];
+    });
+    define(@"lower-case", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithString:AMXPathStringArgument(args, 0).lowercaseString];
+    });
+    define(@"upper-case", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithString:AMXPathStringArgument(args, 0).uppercaseString];
+    });
+    define(@"name", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithString:AMXPathNodeName(args, context)];
+    });
+    define(@"local-name", 0, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithString:AMXPathNodeName(args, context)];
+    });
+    define(@"floor", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:floor(AMXPathArithmeticOperand(args[0]))];
+    });
+    define(@"ceiling", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:ceil(AMXPathArithmeticOperand(args[0]))];
+    });
+    define(@"round", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      return [AMXPathValue valueWithNumber:floor(AMXPathArithmeticOperand(args[0]) + 0.5)];
+    });
+    define(@"sum", 1, 1, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      if (!args[0].isSet) {
+        AMXPathRaiseUnsupported(@"sum() expects a sequence");
+      }
+      double result = 0;
+      for (NSString *item in args[0].itemStrings) {
+        result += AMXPathNumberWithUntypedString(item);
+      }
+      return [AMXPathValue valueWithNumber:result];
+    });
+    define(@"matches", 2, 3, ^(NSArray<AMXPathValue *> *args, AMXPathContext context) {
+      NSRegularExpressionOptions options = 0;
+      NSString *flags = args.count > 2 ? AMXPathStringArgument(args, 2) : @"";
+      for (NSUInteger i = 0; i < flags.length; i++) {
+        switch ([flags characterAtIndex:i]) {
+          case 'i': options |= NSRegularExpressionCaseInsensitive; break;
+          case 'm': options |= NSRegularExpressionAnchorsMatchLines; break;
+          case 's': options |= NSRegularExpressionDotMatchesLineSeparators; break;
+          case 'x': options |= NSRegularExpressionAllowCommentsAndWhitespace; break;
+          default: AMXPathRaiseUnsupported([NSString stringWithFormat:@"Unknown regular expression flags '%@'", flags]);
+        }
+      }
+      NSString *pattern = AMXPathStringArgument(args, 1);
+      NSArray *cacheKey = @[pattern, @(options)];
+      NSRegularExpression *regex = [context.regexCache objectForKey:cacheKey];
+      if (nil == regex) {
+        regex = [NSRegularExpression regularExpressionWithPattern:pattern options:options error:nil];
+        if (nil == regex) {
+          AMXPathRaiseUnsupported(@"Invalid regular expression");
+        }
+        [context.regexCache setObject:regex forKey:cacheKey];
+      }
+      NSString *input = AMXPathStringArgument(args, 0);
+      return [AMXPathValue valueWithBoolean:[regex firstMatchInString:input
+                                                              options:0
+                                                                range:NSMakeRange(0, input.length)] != nil];
+    });
+    functions = result.copy;
+  });
+  return functions;
+}
+
+#pragma mark - Tokenizer
+
+typedef NS_ENUM(NSUInteger, AMXPathTokenType) {
+  // Punctuation and operators, including operator names and the multiply operator
+  AMXPathTokenTypeSymbol,
+  AMXPathTokenTypeName,
+  // The name test wildcard
+  AMXPathTokenTypeStar,
+  AMXPathTokenTypeLiteral,
+  AMXPathTokenTypeNumber,
+};
+
+@interface AMXPathToken : NSObject
+@property (nonatomic) AMXPathTokenType type;
+@property (nonatomic) NSString *text;
+@end
+
+@implementation AMXPathToken
+@end
+
+static BOOL AMXPathIsNameStartChar(unichar c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+static BOOL AMXPathIsNameChar(unichar c)
+{
+  return AMXPathIsNameStartChar(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+static BOOL AMXPathIsDigit(unichar c)
+{
+  return c >= '0' && c <= '9';
+}
+
+/*! See https://www.w3.org/TR/xpath-10/#exprlex for the disambiguation rules */
+static BOOL AMXPathIsPrecededByOperand(AMXPathToken *previous)
+{
+  if (nil == previous) {
+    return NO;
+  }
+  if (previous.type != AMXPathTokenTypeSymbol) {
+    return YES;
+  }
+  static NSSet<NSString *> *nonOperandSymbols;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    nonOperandSymbols = [NSSet setWithArray:@[@"@", @"::", @"(", @"[", @",", @"and", @"or", @"mod", @"div",
+                                              @"*", @"/", @"//", @"|", @"+", @"-", @"=", @"!=", @"<", @"<=", @">", @">="]];
+  });
+  return ![nonOperandSymbols containsObject:previous.text];
+}
+
+static NSArray<AMXPathToken *> *AMXPathTokenize(NSString *query, NSString **errorMessage)
+{
+  NSMutableArray<AMXPathToken *> *tokens = [NSMutableArray array];
+  NSUInteger length = query.length;
+  unichar *chars = malloc(MAX(length, 1) * sizeof(unichar));
+  [query getCharacters:chars range:NSMakeRange(0, length)];
+  NSUInteger index = 0;
+
+  AMXPathToken *(^addToken)(AMXPathTokenType, NSString *) = ^AMXPathToken *(AMXPathTokenType type, NSString *text) {
+    AMXPathToken *token = [AMXPathToken new];
+    token.type = type;
+    token.text = text;
+    [tokens addObject:token];
+    return token;
+  };
+
+  while (index < length) {
+    unichar c = chars[index];
+    unichar next = index + 1 < length ? chars[index + 1] : 0;
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      index++;
+      continue;
+    }
+    BOOL isPrecededByOperand = AMXPathIsPrecededByOperand(tokens.lastObject);
+    if (c == '\'' || c == '"') {
+      NSUInteger end = index + 1;
+      while (end < length && chars[end] != c) {
+        end++;
+      }
+      if (end >= length) {
+        *errorMessage = @"Unterminated string literal";
+        free(chars);
+        return nil;
+      }
+      addToken(AMXPathTokenTypeLiteral, [NSString stringWithCharacters:chars + index + 1 length:end - index - 1]);
+      index = end + 1;
+      continue;
+    }
+    if (AMXPathIsDigit(c) || (c == '.' && AMXPathIsDigit(next))) {
+      NSUInteger end = index;
+      BOOL hasDot = NO;
+      while (end < length && (AMXPathIsDigit(chars[end]) || (chars[end] == '.' && !hasDot))) {
+        hasDot = hasDot || chars[end] == '.';
+        end++;
+      }
+      addToken(AMXPathTokenTypeNumber, [NSString stringWithCharacters:chars + index length:end - index]);
+      index = end;
+      continue;
+    }
+    if (AMXPathIsNameStartChar(c)) {
+      NSUInteger end = index;
+      while (end < length) {
+        if (AMXPathIsNameChar(chars[end])) {
+          end++;
+        } else if (chars[end] == ':' && end + 1 < length && AMXPathIsNameStartChar(chars[end + 1])) {
+          // Qualified name, but not an axis separator
+          end++;
+        } else {
+          break;
+        }
+      }
+      NSString *name = [NSString stringWithCharacters:chars + index length:end - index];
+      BOOL isOperatorName = [name isEqualToString:@"and"] || [name isEqualToString:@"or"]
+        || [name isEqualToString:@"mod"] || [name isEqualToString:@"div"];
+      addToken(isPrecededByOperand && isOperatorName ? AMXPathTokenTypeSymbol : AMXPathTokenTypeName, name);
+      index = end;
+      continue;
+    }
+    if (c == '*') {
+      addToken(isPrecededByOperand ? AMXPathTokenTypeSymbol : AMXPathTokenTypeStar, @"*");
+      index++;
+      continue;
+    }
+    NSString *twoChars = index + 1 < length ? [NSString stringWithCharacters:chars + index length:2] : nil;
+    if (nil != twoChars
+        && [@[@"//", @"::", @"..", @"!=", @"<=", @">="] containsObject:twoChars]) {
+      addToken(AMXPathTokenTypeSymbol, twoChars);
+      index += 2;
+      continue;
+    }
+    if ([@"/|+-=<>()[].@,$" rangeOfString:[NSString stringWithCharacters:&c length:1]].location != NSNotFound) {
+      addToken(AMXPathTokenTypeSymbol, [NSString stringWithCharacters:&c length:1]);
+      index++;
+      continue;
+    }
+    *errorMessage = [NSString stringWithFormat:@"Unexpected character '%C' at position %lu", c, (unsigned long)index];
+    free(chars);
+    return nil;
+  }
+  free(chars);
+  return tokens.copy;
+}
+
+#pragma mark - Parser
+
+static NSString *const AMXPathSyntaxException = @"AMXPathSyntaxException";
+
+@interface AMXPathParser : NSObject
+@property (nonatomic) NSArray<AMXPathToken *> *tokens;
+@property (nonatomic) NSUInteger index;
+@end
+
+@implementation AMXPathParser
+
+- (void)failWithMessage:(NSString *)message
+{
+  @throw [NSException exceptionWithName:AMXPathSyntaxException reason:message userInfo:nil];
+}
+
+- (AMXPathToken *)peekAtOffset:(NSUInteger)offset
+{
+  NSUInteger index = self.index + offset;
+  return index < self.tokens.count ? self.tokens[index] : nil;
+}
+
+- (AMXPathToken *)peek
+{
+  return [self peekAtOffset:0];
+}
+
+- (BOOL)isSymbol:(NSString *)symbol atOffset:(NSUInteger)offset
+{
+  AMXPathToken *token = [self peekAtOffset:offset];
+  return nil != token && token.type == AMXPathTokenTypeSymbol && [token.text isEqualToString:symbol];
+}
+
+- (BOOL)consumeSymbol:(NSString *)symbol
+{
+  if ([self isSymbol:symbol atOffset:0]) {
+    self.index++;
+    return YES;
+  }
+  return NO;
+}
+
+- (void)expectSymbol:(NSString *)symbol
+{
+  if (![self consumeSymbol:symbol]) {
+    [self failWithMessage:[NSString stringWithFormat:@"'%@' is expected at token %lu", symbol, (unsigned long)self.index]];
+  }
+}
+
+- (AMXPathExpr *)parse
+{
+  AMXPathExpr *expr = [self parseOr];
+  if (nil != self.peek) {
+    [self failWithMessage:[NSString stringWithFormat:@"Unexpected token '%@'", self.peek.text]];
+  }
+  return expr;
+}
+
+- (AMXPathExpr *)binaryWithOperator:(AMXPathOperator)op left:(AMXPathExpr *)left right:(AMXPathExpr *)right
+{
+  AMXPathBinaryExpr *expr = [AMXPathBinaryExpr new];
+  expr.op = op;
+  expr.left = left;
+  expr.right = right;
+  return expr;
+}
+
+- (AMXPathExpr *)parseOr
+{
+  AMXPathExpr *expr = [self parseAnd];
+  while ([self consumeSymbol:@"or"]) {
+    expr = [self binaryWithOperator:AMXPathOperatorOr left:expr right:[self parseAnd]];
+  }
+  return expr;
+}
+
+- (AMXPathExpr *)parseAnd
+{
+  AMXPathExpr *expr = [self parseEquality];
+  while ([self consumeSymbol:@"and"]) {
+    expr = [self binaryWithOperator:AMXPathOperatorAnd left:expr right:[self parseEquality]];
+  }
+  return expr;
+}
+
+- (AMXPathExpr *)parseEquality
+{
+  AMXPathExpr *expr = [self parseRelational];
+  while (YES) {
+    if ([self consumeSymbol:@"="]) {
+      expr = [self binaryWithOperator:AMXPathOperatorEqual left:expr right:[self parseRelational]];
+    } else if ([self consumeSymbol:@"!="]) {
+      expr = [self binaryWithOperator:AMXPathOperatorNotEqual left:expr right:[self parseRelational]];
+    } else {
+      return expr;
+    }
+  }
+}
+
+- (AMXPathExpr *)parseRelational
+{
+  AMXPathExpr *expr = [self parseAdditive];
+  while (YES) {
+    if ([self consumeSymbol:@"<"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorLess left:expr right:[self parseAdditive]];
+    } else if ([self consumeSymbol:@"<="]) {
+      expr = [self binaryWithOperator:AMXPathOperatorLessOrEqual left:expr right:[self parseAdditive]];
+    } else if ([self consumeSymbol:@">"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorGreater left:expr right:[self parseAdditive]];
+    } else if ([self consumeSymbol:@">="]) {
+      expr = [self binaryWithOperator:AMXPathOperatorGreaterOrEqual left:expr right:[self parseAdditive]];
+    } else {
+      return expr;
+    }
+  }
+}
+
+- (AMXPathExpr *)parseAdditive
+{
+  AMXPathExpr *expr = [self parseMultiplicative];
+  while (YES) {
+    if ([self consumeSymbol:@"+"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorPlus left:expr right:[self parseMultiplicative]];
+    } else if ([self consumeSymbol:@"-"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorMinus left:expr right:[self parseMultiplicative]];
+    } else {
+      return expr;
+    }
+  }
+}
+
+- (AMXPathExpr *)parseMultiplicative
+{
+  AMXPathExpr *expr = [self parseUnary];
+  while (YES) {
+    if ([self consumeSymbol:@"*"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorMultiply left:expr right:[self parseUnary]];
+    } else if ([self consumeSymbol:@"div"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorDivide left:expr right:[self parseUnary]];
+    } else if ([self consumeSymbol:@"mod"]) {
+      expr = [self binaryWithOperator:AMXPathOperatorModulo left:expr right:[self parseUnary]];
+    } else {
+      return expr;
+    }
+  }
+}
+
+- (AMXPathExpr *)parseUnary
+{
+  if ([self consumeSymbol:@"-"]) {
+    AMXPathNegateExpr *expr = [AMXPathNegateExpr new];
+    expr.operand = [self parseUnary];
+    return expr;
+  }
+  return [self parseUnion];
+}
+
+- (AMXPathExpr *)parseUnion
+{
+  AMXPathExpr *expr = [self parsePath];
+  while ([self consumeSymbol:@"|"]) {
+    expr = [self binaryWithOperator:AMXPathOperatorUnion left:expr right:[self parsePath]];
+  }
+  return expr;
+}
+
++ (NSSet<NSString *> *)nodeTypes
+{
+  static NSSet<NSString *> *nodeTypes;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    nodeTypes = [NSSet setWithArray:@[@"node", @"text", @"comment", @"processing-instruction"]];
+  });
+  return nodeTypes;
+}
+
+- (BOOL)isAtStepStart
+{
+  AMXPathToken *token = self.peek;
+  if (nil == token) {
+    return NO;
+  }
+  switch (token.type) {
+    case AMXPathTokenTypeStar:
+      return YES;
+    case AMXPathTokenTypeName:
+      // Function calls are primary expressions
+      return ![self isSymbol:@"(" atOffset:1] || [self.class.nodeTypes containsObject:token.text];
+    case AMXPathTokenTypeSymbol:
+      return [token.text isEqualToString:@"."] || [token.text isEqualToString:@".."]
+        || [token.text isEqualToString:@"@"];
+    default:
+      return NO;
+  }
+}
+
+- (AMXPathStep *)descendantOrSelfStep
+{
+  AMXPathStep *step = [AMXPathStep new];
+  step.axis = AMXPathAxisDescendantOrSelf;
+  step.nodeTest = AMXPathNodeTestNode;
+  step.predicates = @[];
+  return step;
+}
+
+/**
+ The leading slash of the query is replaced by FBXPath with the root element reference
+ while other absolute paths are evaluated from the document node
+ */
+- (BOOL)isAtQueryStart
+{
+  for (NSUInteger i = 0; i < self.index; i++) {
+    if (![self.tokens[i].text isEqualToString:@"("] || self.tokens[i].type != AMXPathTokenTypeSymbol) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+- (AMXPathExpr *)parsePath
+{
+  AMXPathPathExpr *path = [AMXPathPathExpr new];
+  path.filterPredicates = @[];
+  NSMutableArray<AMXPathStep *> *steps = [NSMutableArray array];
+  if (([self isSymbol:@"/" atOffset:0] || [self isSymbol:@"//" atOffset:0]) && !self.isAtQueryStart) {
+    AMXPathRaiseUnsupported(@"Only the leading location path of the query could be absolute");
+  }
+  if ([self consumeSymbol:@"/"]) {
+    path.isAbsolute = YES;
+    if (self.isAtStepStart) {
+      [self parseRelativePathIntoSteps:steps];
+    }
+  } else if ([self consumeSymbol:@"//"]) {
+    path.isAbsolute = YES;
+    [steps addObject:self.descendantOrSelfStep];
+    [self parseRelativePathIntoSteps:steps];
+  } else if (self.isAtStepStart) {
+    [self parseRelativePathIntoSteps:steps];
+  } else {
+    path.filter = [self parsePrimary];
+    path.filterPredicates = [self parsePredicates];
+    if ([self consumeSymbol:@"/"]) {
+      [self parseRelativePathIntoSteps:steps];
+    } else if ([self consumeSymbol:@"//"]) {
+      [steps addObject:self.descendantOrSelfStep];
+      [self parseRelativePathIntoSteps:steps];
+    } else if (0 == path.filterPredicates.count) {
+      return (AMXPathExpr *)path.filter;
+    }
+  }
+  for (NSUInteger i = 0; i < steps.count; i++) {
+    AMXPathStep *step = steps[i];
+    // Attributes have no children and could not be context nodes of predicates
+    if (step.axis == AMXPathAxisAttribute && (i + 1 < steps.count || step.predicates.count > 0)) {
+      AMXPathRaiseUnsupported(@"Attributes are only supported as the last step of a location path");
+    }
+  }
+  path.steps = steps.copy;
+  return path;
+}
+
+- (void)parseRelativePathIntoSteps:(NSMutableArray<AMXPathStep *> *)steps
+{
+  [steps addObject:[self parseStep]];
+  while (YES) {
+    if ([self consumeSymbol:@"/"]) {
+      [steps addObject:[self parseStep]];
+    } else if ([self consumeSymbol:@"//"]) {
+      [steps addObject:self.descendantOrSelfStep];
+      [steps addObject:[self parseStep]];
+    } else {
+      return;
+    }
+  }
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)axes
+{
+  static NSDictionary<NSString *, NSNumber *> *axes;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    axes = @{
+      @"child": @(AMXPathAxisChild),
+      @"descendant": @(AMXPathAxisDescendant),
+      @"descendant-or-self": @(AMXPathAxisDescendantOrSelf),
+      @"self": @(AMXPathAxisSelf),
+      @"parent": @(AMXPathAxisParent),
+      @"ancestor": @(AMXPathAxisAncestor),
+      @"ancestor-or-self": @(AMXPathAxisAncestorOrSelf),
+      @"following-sibling": @(AMXPathAxisFollowingSibling),
+      @"preceding-sibling": @(AMXPathAxisPrecedingSibling),
+      @"following": @(AMXPathAxisFollowing),
+      @"preceding": @(AMXPathAxisPreceding),
+      @"attribute": @(AMXPathAxisAttribute),
+    };
+  });
+  return axes;
+}
+
+- (AMXPathStep *)parseStep
+{
+  AMXPathStep *step = [AMXPathStep new];
+  step.axis = AMXPathAxisChild;
+  if ([self consumeSymbol:@"."]) {
+    step.axis = AMXPathAxisSelf;
+    step.nodeTest = AMXPathNodeTestNode;
+    step.predicates = @[];
+    return step;
+  }
+  if ([self consumeSymbol:@".."]) {
+    step.axis = AMXPathAxisParent;
+    step.nodeTest = AMXPathNodeTestNode;
+    step.predicates = @[];
+    return step;
+  }
+  if ([self consumeSymbol:@"@"]) {
+    step.axis = AMXPathAxisAttribute;
+  } else if (self.peek.type == AMXPathTokenTypeName && [self isSymbol:@"::" atOffset:1]) {
+    NSNumber *axis = self.class.axes[self.peek.text];
+    if (nil == axis) {
+      AMXPathRaiseUnsupported([NSString stringWithFormat:@"The axis '%@' is not supported", self.peek.text]);
+    }
+    step.axis = axis.unsignedIntegerValue;
+    self.index += 2;
+  }
+
+  AMXPathToken *token = self.peek;
+  if (nil == token) {
+    [self failWithMessage:@"A node test is expected"];
+  }
+  if (token.type == AMXPathTokenTypeStar) {
+    step.nodeTest = AMXPathNodeTestAny;
+    self.index++;
+  } else if (token.type == AMXPathTokenTypeName) {
+    self.index++;
+    if ([self.class.nodeTypes containsObject:token.text] && [self consumeSymbol:@"("]) {
+      [self expectSymbol:@")"];
+      step.nodeTest = [token.text isEqualToString:@"node"] ? AMXPathNodeTestNode : AMXPathNodeTestNone;
+    } else {
+      if ([token.text rangeOfString:@":"].location != NSNotFound) {
+        AMXPathRaiseUnsupported(@"Qualified names are not supported");
+      }
+      step.nodeTest = AMXPathNodeTestName;
+      step.name = token.text;
+    }
+  } else {
+    [self failWithMessage:[NSString stringWithFormat:@"Unexpected token '%@' in a location step", token.text]];
+  }
+  step.predicates = [self parsePredicates];
+  return step;
+}
+
+- (NSArray<AMXPathExpr *> *)parsePredicates
+{
+  NSMutableArray<AMXPathExpr *> *predicates = [NSMutableArray array];
+  while ([self consumeSymbol:@"["]) {
+    [predicates addObject:[self parseOr]];
+    [self expectSymbol:@"]"];
+  }
+  return predicates.copy;
+}
+
+- (AMXPathExpr *)parsePrimary
+{
+  AMXPathToken *token = self.peek;
+  if (nil == token) {
+    [self failWithMessage:@"An expression is expected"];
+  }
+  if ([self consumeSymbol:@"("]) {
+    AMXPathExpr *expr = [self parseOr];
+    [self expectSymbol:@")"];
+    return expr;
+  }
+  if (token.type == AMXPathTokenTypeLiteral) {
+    self.index++;
+    AMXPathLiteralExpr *expr = [AMXPathLiteralExpr new];
+    expr.value = [AMXPathValue valueWithString:token.text];
+    return expr;
+  }
+  if (token.type == AMXPathTokenTypeNumber) {
+    self.index++;
+    AMXPathLiteralExpr *expr = [AMXPathLiteralExpr new];
+    expr.value = [AMXPathValue valueWithNumber:token.text.doubleValue];
+    return expr;
+  }
+  if (token.type == AMXPathTokenTypeName && [self isSymbol:@"(" atOffset:1]) {
+    return [self parseFunctionCall];
+  }
+  if ([token.text isEqualToString:@"$"]) {
+    AMXPathRaiseUnsupported(@"Variable references are not supported");
+  }
+  [self failWithMessage:[NSString stringWithFormat:@"Unexpected token '%@'", token.text]];
+  return nil;
+}
+
+- (AMXPathExpr *)parseFunctionCall
+{
+  NSString *name = self.peek.text;
+  if ([name hasPrefix:@"fn:"]) {
+    name = [name substringFromIndex:3];
+  }
+  self.index += 2;
+  NSMutableArray<AMXPathExpr *> *arguments = [NSMutableArray array];
+  if (![self consumeSymbol:@")"]) {
+    do {
+      [arguments addObject:[self parseOr]];
+    } while ([self consumeSymbol:@","]);
+    [self expectSymbol:@")"];
+  }
+  AMXPathFunctionDefinition *definition = AMXPathFunctions()[name];
+  if (nil == definition) {
+    AMXPathRaiseUnsupported([NSString stringWithFormat:@"The function '%@' is not supported", name]);
+  }
+  if (arguments.count < definition.minArguments || arguments.count > definition.maxArguments) {
+    [self failWithMessage:[NSString stringWithFormat:@"Invalid number of arguments for '%@'", name]];
+  }
+  AMXPathFunctionExpr *expr = [AMXPathFunctionExpr new];
+  expr.function = definition.function;
+  expr.arguments = arguments.copy;
+  return expr;
+}
+
+@end
+
+#pragma mark - Expression
+
+@interface AMXPathExpression ()
+@property (nonatomic) AMXPathExpr *root;
+@end
+
+@implementation AMXPathExpression
+
+static LRUCache *compiledExpressionsCache = nil;
+static const NSUInteger COMPILED_EXPRESSIONS_CACHE_SIZE = 256;
+
++ (void)initialize
+{
+  if (nil == compiledExpressionsCache) {
+    compiledExpressionsCache = [[LRUCache alloc] initWithCapacity:COMPILED_EXPRESSIONS_CACHE_SIZE];
+  }
+}
+
++ (BOOL)buildError:(NSError **)error withDescription:(NSString *)description forQuery:(NSString *)query
+{
+  return [[[FBErrorBuilder builder]
+           withDescriptionFormat:@"The XPath expression \"%@\" cannot be evaluated natively: %@", query, description]
+          buildError:error];
+}
+
++ (nullable instancetype)expressionWithQuery:(NSString *)query error:(NSError **)error
+{
+  AMXPathExpression *result;
+  @synchronized (compiledExpressionsCache) {
+    result = [compiledExpressionsCache objectForKey:query];
+  }
+  if (nil != result) {
+    return result;
+  }
+
+  NSString *errorMessage;
+  NSArray<AMXPathToken *> *tokens = AMXPathTokenize(query, &errorMessage);
+  if (nil == tokens) {
+    [self buildError:error withDescription:errorMessage forQuery:query];
+    return nil;
+  }
+  AMXPathParser *parser = [AMXPathParser new];
+  parser.tokens = tokens;
+  AMXPathExpr *root;
+  @try {
+    root = [parser parse];
+  } @catch (NSException *e) {
+    if (![e.name isEqualToString:AMXPathSyntaxException] && ![e.name isEqualToString:AMXPathUnsupportedException]) {
+      @throw;
+    }
+    [self buildError:error withDescription:(NSString *)e.reason forQuery:query];
+    return nil;
+  }
+
+  result = [AMXPathExpression new];
+  result->_query = query.copy;
+  result.root = root;
+  @synchronized (compiledExpressionsCache) {
+    [compiledExpressionsCache setObject:result forKey:result.query];
+  }
+  return result;
+}
+
+- (nullable NSIndexSet *)matchingNodesInTree:(AMSnapshotTree *)tree error:(NSError **)error
+{
+  AMXPathValue *value;
+  NSMutableDictionary<NSArray *, NSRegularExpression *> *regexCache = [NSMutableDictionary dictionary];
+  @try {
+    AMXPathContext context = {tree, 0, 1, 1, regexCache};
+    value = [self.root evaluateWithContext:context];
+  } @catch (NSException *e) {
+    if (![e.name isEqualToString:AMXPathUnsupportedException]) {
+      @throw;
+    }
+    [self.class buildError:error withDescription:(NSString *)e.reason forQuery:self.query];
+    return nil;
+  }
+  switch (value.type) {
+    case AMXPathValueTypeNodeSet:
+      return value.nodes;
+    case AMXPathValueTypeAttributeSet:
+      return [NSIndexSet indexSet];
+    default:
+      [self.class buildError:error withDescription:@"The expression does not select nodes" forQuery:self.query];
+      return nil;
+  }
+}
+
+@end
@@ -91,6 +91,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)addItem:(FBBaseActionItem *)item;
 
+/**
+ Precomputes the state of each item, which depends on other items in the chain,
+ so event paths could be built in linear time. This method is called by asEventPathsWithError:
+ and does nothing by default.
+
+ @param error If there is an error, upon return contains an NSError object that describes the problem
+ @return YES if the chain is valid
+ */
+- (BOOL)compileWithError:(NSError **)error;
+
 /**
  Represents the chain as XCPointerEventPath instance.
  
@@ -98,6 +98,11 @@
   @throw [[FBErrorBuilder.builder withDescription:@"Override this method in subclasses"] build];
 }
 
+- (BOOL)compileWithError:(NSError **)error
+{
+  return YES;
+}
+
 - (nullable NSArray<XCPointerEventPath *> *)asEventPathsWithError:(NSError **)error
 {
   if (0 == self.items.count) {
@@ -106,14 +111,18 @@
     }
     return nil;
   }
-  
+  if (![self compileWithError:error]) {
+    return nil;
+  }
+
+  NSArray<FBBaseActionItem *> *allItems = self.items.copy;
   NSMutableArray<XCPointerEventPath *> *result = [NSMutableArray array];
   XCPointerEventPath *previousEventPath = nil;
   XCPointerEventPath *currentEventPath = nil;
   NSUInteger index = 0;
-  for (FBBaseActionItem *item in self.items.copy) {
+  for (FBBaseActionItem *item in allItems) {
     NSArray<XCPointerEventPath *> *currentEventPaths = [item addToEventPath:currentEventPath
-                                                                   allItems:self.items.copy
+                                                                   allItems:allItems
                                                            currentItemIndex:index++
                                                                       error:error];
     if (currentEventPaths == nil) {
@@ -83,7 +83,8 @@ NS_ASSUME_NONNULL_BEGIN
 @interface FBClassChainQueryParser : NSObject
 
 /**
- Method used to interpret class chain queries
+ Method used to interpret class chain queries. Successfully parsed chains are immutable,
+ so they are kept in a LRU cache keyed by the query string and are reused for repeated queries
 
  @param classChainQuery class chain query as string. See the documentation of
    XCUIElement+FBClassChain category for more details about the expected query format
@@ -95,6 +96,18 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable FBClassChain*)parseQuery:(NSString*)classChainQuery error:(NSError **)error;
 
+/**
+ Same as parseQuery:error:, but always parses the query from scratch
+ and neither consults nor updates the cache
+
+ @param classChainQuery class chain query as string
+ @param error standard NSError object, which is going to be initialized if
+   there are query parsing errors
+ @return parsed chain or nil in case of parsing error
+ @throws FBUnknownAttributeException if any of predicates in the chain contains unknown attribute
+ */
++ (nullable FBClassChain*)parseQueryWithoutCache:(NSString*)classChainQuery error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -11,6 +11,7 @@
 #import "FBErrorBuilder.h"
 #import "FBElementTypeTransformer.h"
 #import "FBExceptions.h"
+#import "LRUCache.h"
 #import "NSPredicate+FBFormat.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -425,12 +426,17 @@ static NSString *const FBAbstractMethodInvocationException = @"FBAbstractMethodI
 @implementation FBClassChainQueryParser
 
 static NSNumberFormatter *numberFormatter = nil;
+static LRUCache *parsedQueriesCache = nil;
+static const NSUInteger PARSED_QUERIES_CACHE_SIZE = 512;
 
 + (void)initialize {
   if (nil == numberFormatter) {
     numberFormatter = [[NSNumberFormatter alloc] init];
     numberFormatter.numberStyle = NSNumberFormatterDecimalStyle;
   }
+  if (nil == parsedQueriesCache) {
+    parsedQueriesCache = [[LRUCache alloc] initWithCapacity:PARSED_QUERIES_CACHE_SIZE];
+  }
 }
 
 + (NSError *)tokenizationErrorWithIndex:(NSUInteger)index originalQuery:(NSString *)originalQuery
@@ -613,6 +619,25 @@ static NSNumberFormatter *numberFormatter = nil;
 }
 
 + (FBClassChain *)parseQuery:(NSString*)classChainQuery error:(NSError **)error
+{
+  FBClassChain *result;
+  @synchronized (parsedQueriesCache) {
+    result = [parsedQueriesCache objectForKey:classChainQuery];
+  }
+  if (nil != result) {
+    return result;
+  }
+  // Failed queries are not cached, so the error is always reported with the same details
+  result = [self.class parseQueryWithoutCache:classChainQuery error:error];
+  if (nil != result) {
+    @synchronized (parsedQueriesCache) {
+      [parsedQueriesCache setObject:result forKey:classChainQuery.copy];
+    }
+  }
+  return result;
+}
+
++ (FBClassChain *)parseQueryWithoutCache:(NSString*)classChainQuery error:(NSError **)error
 {
   NSAssert(classChainQuery.length > 0, @"Query length should be greater than zero", nil);
   NSArray *tokenizedQuery = [self.class tokenizedQueryWithQuery:classChainQuery error:error];
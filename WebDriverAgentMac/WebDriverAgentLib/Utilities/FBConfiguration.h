@@ -33,6 +33,27 @@ NS_ASSUME_NONNULL_BEGIN
 /*! Whether to use custom snapshotting mechanism to fetch full element's text payload instead of the first 512 chars  */
 @property BOOL fetchFullText;
 
+/*! The minimum size of a JSON response in bytes to be compressed if the client accepts gzip or deflate encoding.
+ Zero or a negative value disables response compression */
+@property NSInteger responseCompressionThreshold;
+
+/*! Whether to evaluate XPath queries natively over snapshot trees. Queries, which are not supported
+ by the native engine, are always evaluated over the XML representation */
+@property BOOL useNativeXPathEngine;
+
+/*! The default text input mode for element values. See XCUIElement+AMEditable for the list of supported modes */
+@property (nonatomic, copy) NSString *textInputMode;
+
+/*! The maximum amount of characters typed per second. Zero means typing at the maximum possible speed.
+ The XCTest default typing frequency is used unless the value has been changed */
+@property NSUInteger typingFrequency;
+
+/*! The maximum deviation in points allowed while merging consecutive W3C pointer moves. Zero disables merging */
+@property double pointerMoveTolerance;
+
+/*! The maximum amount of applications kept running between sessions. Zero disables the pool */
+@property NSUInteger applicationPoolSize;
+
 /**
  The range of ports that the HTTP Server should attempt to bind on launch
  */
@@ -48,6 +69,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, nullable) NSString *serverInterface;
 
+/**
+ * The path to a unix domain socket file the server should listen on instead of a TCP port.
+ * nil means the server listens on one of ports from bindingPortRange (the default behavior).
+ *
+ * The value could be passed via the '--unix-socket' process argument
+ * or via the USE_UNIX_SOCKET environment variable.
+ */
+@property (readonly, nullable) NSString *serverUnixSocketPath;
+
 /**
  YES if verbose logging is enabled. NO otherwise.
  */
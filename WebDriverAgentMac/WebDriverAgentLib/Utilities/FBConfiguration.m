@@ -12,6 +12,14 @@
 static NSUInteger const DefaultStartingPort = 10100;
 static NSUInteger const DefaultPortRange = 100;
 static BOOL FBFetchFullText = NO;
+// Smaller responses are not worth the CPU time spent on compression
+static NSInteger FBResponseCompressionThreshold = 64 * 1024;
+static BOOL FBUseNativeXPathEngine = YES;
+static NSString *FBTextInputMode = @"typing";
+// A negative value means the XCTest default frequency
+static NSInteger FBTypingFrequency = -1;
+static double FBPointerMoveTolerance = 0;
+static NSUInteger FBApplicationPoolSize = 0;
 
 @implementation FBConfiguration
 
@@ -86,6 +94,71 @@ static FBConfiguration *instance;
   FBFetchFullText = fetchFullText;
 }
 
+- (NSInteger)responseCompressionThreshold
+{
+  return FBResponseCompressionThreshold;
+}
+
+- (void)setResponseCompressionThreshold:(NSInteger)responseCompressionThreshold
+{
+  FBResponseCompressionThreshold = responseCompressionThreshold;
+}
+
+- (BOOL)useNativeXPathEngine
+{
+  return FBUseNativeXPathEngine;
+}
+
+- (void)setUseNativeXPathEngine:(BOOL)useNativeXPathEngine
+{
+  FBUseNativeXPathEngine = useNativeXPathEngine;
+}
+
+- (NSString *)textInputMode
+{
+  return FBTextInputMode;
+}
+
+- (void)setTextInputMode:(NSString *)textInputMode
+{
+  FBTextInputMode = [textInputMode copy];
+}
+
+- (NSUInteger)typingFrequency
+{
+  if (FBTypingFrequency >= 0) {
+    return (NSUInteger)FBTypingFrequency;
+  }
+  NSInteger defaultFreq = [[NSUserDefaults standardUserDefaults]
+                           integerForKey:@"com.apple.xctest.iOSMaximumTypingFrequency"];
+  return defaultFreq > 0 ? (NSUInteger)defaultFreq : 60;
+}
+
+- (void)setTypingFrequency:(NSUInteger)typingFrequency
+{
+  FBTypingFrequency = (NSInteger)typingFrequency;
+}
+
+- (double)pointerMoveTolerance
+{
+  return FBPointerMoveTolerance;
+}
+
+- (void)setPointerMoveTolerance:(double)pointerMoveTolerance
+{
+  FBPointerMoveTolerance = pointerMoveTolerance;
+}
+
+- (NSUInteger)applicationPoolSize
+{
+  return FBApplicationPoolSize;
+}
+
+- (void)setApplicationPoolSize:(NSUInteger)applicationPoolSize
+{
+  FBApplicationPoolSize = applicationPoolSize;
+}
+
 - (NSRange)bindingPortRange
 {
   // 'WebDriverAgent --port 8080' can be passed via the arguments to the process
@@ -113,6 +186,20 @@ static FBConfiguration *instance;
   return @"127.0.0.1";
 }
 
+- (NSString *)serverUnixSocketPath
+{
+  // 'WebDriverAgent --unix-socket /tmp/wda.sock' can be passed via the arguments to the process
+  NSString *path = [self.class valueFromArguments:NSProcessInfo.processInfo.arguments
+                                           forKey:@"--unix-socket"];
+  if (nil != path && path.length > 0) {
+    return path;
+  }
+
+  // Existence of USE_UNIX_SOCKET in the environment is managed by the launching process.
+  path = NSProcessInfo.processInfo.environment[@"USE_UNIX_SOCKET"];
+  return (nil != path && path.length > 0) ? path : nil;
+}
+
 - (BOOL)verboseLoggingEnabled
 {
   return [NSProcessInfo.processInfo.environment[@"VERBOSE_LOGGING"] boolValue];
@@ -11,135 +11,259 @@
 
 #import "FBExceptions.h"
 
-@implementation FBElementTypeTransformer
+static NSString *const FB_ELEMENT_TYPE_PREFIX = @"XCUIElementType";
 
-static NSDictionary *ElementTypeToStringMapping;
-static NSDictionary *StringToElementTypeMapping;
+/**
+ Type names indexed by XCUIElementType values.
+ !!! This table should be updated if there are changes after each new XCTest release.
+ FBElementTypeNameSlots must be regenerated afterwards by scripts/generate-element-type-slots.mjs
+ */
+static NSString *const FBElementTypeNames[] = {
+  @"XCUIElementTypeAny",
+  @"XCUIElementTypeOther",
+  @"XCUIElementTypeApplication",
+  @"XCUIElementTypeGroup",
+  @"XCUIElementTypeWindow",
+  @"XCUIElementTypeSheet",
+  @"XCUIElementTypeDrawer",
+  @"XCUIElementTypeAlert",
+  @"XCUIElementTypeDialog",
+  @"XCUIElementTypeButton",
+  @"XCUIElementTypeRadioButton",
+  @"XCUIElementTypeRadioGroup",
+  @"XCUIElementTypeCheckBox",
+  @"XCUIElementTypeDisclosureTriangle",
+  @"XCUIElementTypePopUpButton",
+  @"XCUIElementTypeComboBox",
+  @"XCUIElementTypeMenuButton",
+  @"XCUIElementTypeToolbarButton",
+  @"XCUIElementTypePopover",
+  @"XCUIElementTypeKeyboard",
+  @"XCUIElementTypeKey",
+  @"XCUIElementTypeNavigationBar",
+  @"XCUIElementTypeTabBar",
+  @"XCUIElementTypeTabGroup",
+  @"XCUIElementTypeToolbar",
+  @"XCUIElementTypeStatusBar",
+  @"XCUIElementTypeTable",
+  @"XCUIElementTypeTableRow",
+  @"XCUIElementTypeTableColumn",
+  @"XCUIElementTypeOutline",
+  @"XCUIElementTypeOutlineRow",
+  @"XCUIElementTypeBrowser",
+  @"XCUIElementTypeCollectionView",
+  @"XCUIElementTypeSlider",
+  @"XCUIElementTypePageIndicator",
+  @"XCUIElementTypeProgressIndicator",
+  @"XCUIElementTypeActivityIndicator",
+  @"XCUIElementTypeSegmentedControl",
+  @"XCUIElementTypePicker",
+  @"XCUIElementTypePickerWheel",
+  @"XCUIElementTypeSwitch",
+  @"XCUIElementTypeToggle",
+  @"XCUIElementTypeLink",
+  @"XCUIElementTypeImage",
+  @"XCUIElementTypeIcon",
+  @"XCUIElementTypeSearchField",
+  @"XCUIElementTypeScrollView",
+  @"XCUIElementTypeScrollBar",
+  @"XCUIElementTypeStaticText",
+  @"XCUIElementTypeTextField",
+  @"XCUIElementTypeSecureTextField",
+  @"XCUIElementTypeDatePicker",
+  @"XCUIElementTypeTextView",
+  @"XCUIElementTypeMenu",
+  @"XCUIElementTypeMenuItem",
+  @"XCUIElementTypeMenuBar",
+  @"XCUIElementTypeMenuBarItem",
+  @"XCUIElementTypeMap",
+  @"XCUIElementTypeWebView",
+  @"XCUIElementTypeIncrementArrow",
+  @"XCUIElementTypeDecrementArrow",
+  @"XCUIElementTypeTimeline",
+  @"XCUIElementTypeRatingIndicator",
+  @"XCUIElementTypeValueIndicator",
+  @"XCUIElementTypeSplitGroup",
+  @"XCUIElementTypeSplitter",
+  @"XCUIElementTypeRelevanceIndicator",
+  @"XCUIElementTypeColorWell",
+  @"XCUIElementTypeHelpTag",
+  @"XCUIElementTypeMatte",
+  @"XCUIElementTypeDockItem",
+  @"XCUIElementTypeRuler",
+  @"XCUIElementTypeRulerMarker",
+  @"XCUIElementTypeGrid",
+  @"XCUIElementTypeLevelIndicator",
+  @"XCUIElementTypeCell",
+  @"XCUIElementTypeLayoutArea",
+  @"XCUIElementTypeLayoutItem",
+  @"XCUIElementTypeHandle",
+  @"XCUIElementTypeStepper",
+  @"XCUIElementTypeTab",
+  @"XCUIElementTypeTouchBar",
+  @"XCUIElementTypeStatusItem",
+};
+static const NSUInteger FBElementTypeNamesCount = sizeof(FBElementTypeNames) / sizeof(FBElementTypeNames[0]);
 
-static NSString const *FB_ELEMENT_TYPE_PREFIX = @"XCUIElementType";
+// Parameters of the perfect hash function for type names
+#define FB_ELEMENT_TYPE_NAME_HASH_SEED 838u
+#define FB_ELEMENT_TYPE_NAME_HASH_BITS 9
+// All known names fit into this length
+#define FB_ELEMENT_TYPE_NAME_MAX_LENGTH 48
+
+/**
+ Perfect hash table for type names.
+ Each slot contains the corresponding XCUIElementType value incremented by one
+ or zero if the slot is empty.
+ The slot of a name is calculated by FBElementTypeNameHash, and the seed has been picked,
+ so there are no collisions between any of the names in FBElementTypeNames.
+ Do not edit it manually, but run scripts/generate-element-type-slots.mjs instead
+ */
+static const uint8_t FBElementTypeNameSlots[1 << FB_ELEMENT_TYPE_NAME_HASH_BITS] = {
+  [0] = 48 + 1, // StaticText
+  [1] = 11 + 1, // RadioGroup
+  [7] = 63 + 1, // ValueIndicator
+  [11] = 34 + 1, // PageIndicator
+  [12] = 81 + 1, // TouchBar
+  [18] = 1 + 1, // Other
+  [28] = 6 + 1, // Drawer
+  [34] = 8 + 1, // Dialog
+  [51] = 35 + 1, // ProgressIndicator
+  [63] = 40 + 1, // Switch
+  [64] = 44 + 1, // Icon
+  [77] = 79 + 1, // Stepper
+  [80] = 0 + 1, // Any
+  [86] = 61 + 1, // Timeline
+  [101] = 18 + 1, // Popover
+  [102] = 12 + 1, // CheckBox
+  [105] = 38 + 1, // Picker
+  [128] = 19 + 1, // Keyboard
+  [142] = 26 + 1, // Table
+  [144] = 67 + 1, // ColorWell
+  [154] = 51 + 1, // DatePicker
+  [166] = 22 + 1, // TabBar
+  [167] = 50 + 1, // SecureTextField
+  [182] = 32 + 1, // CollectionView
+  [189] = 58 + 1, // WebView
+  [198] = 2 + 1, // Application
+  [208] = 65 + 1, // Splitter
+  [210] = 25 + 1, // StatusBar
+  [212] = 64 + 1, // SplitGroup
+  [236] = 21 + 1, // NavigationBar
+  [241] = 10 + 1, // RadioButton
+  [244] = 82 + 1, // StatusItem
+  [247] = 39 + 1, // PickerWheel
+  [251] = 72 + 1, // RulerMarker
+  [258] = 74 + 1, // LevelIndicator
+  [261] = 28 + 1, // TableColumn
+  [263] = 17 + 1, // ToolbarButton
+  [264] = 59 + 1, // IncrementArrow
+  [273] = 4 + 1, // Window
+  [275] = 77 + 1, // LayoutItem
+  [279] = 71 + 1, // Ruler
+  [288] = 56 + 1, // MenuBarItem
+  [300] = 60 + 1, // DecrementArrow
+  [304] = 52 + 1, // TextView
+  [306] = 54 + 1, // MenuItem
+  [307] = 29 + 1, // Outline
+  [313] = 37 + 1, // SegmentedControl
+  [318] = 76 + 1, // LayoutArea
+  [326] = 36 + 1, // ActivityIndicator
+  [334] = 53 + 1, // Menu
+  [358] = 27 + 1, // TableRow
+  [360] = 14 + 1, // PopUpButton
+  [367] = 49 + 1, // TextField
+  [370] = 69 + 1, // Matte
+  [372] = 3 + 1, // Group
+  [375] = 41 + 1, // Toggle
+  [378] = 43 + 1, // Image
+  [379] = 45 + 1, // SearchField
+  [380] = 70 + 1, // DockItem
+  [383] = 20 + 1, // Key
+  [401] = 46 + 1, // ScrollView
+  [418] = 78 + 1, // Handle
+  [419] = 57 + 1, // Map
+  [423] = 13 + 1, // DisclosureTriangle
+  [430] = 42 + 1, // Link
+  [435] = 75 + 1, // Cell
+  [441] = 7 + 1, // Alert
+  [446] = 31 + 1, // Browser
+  [450] = 24 + 1, // Toolbar
+  [451] = 16 + 1, // MenuButton
+  [453] = 68 + 1, // HelpTag
+  [454] = 47 + 1, // ScrollBar
+  [455] = 30 + 1, // OutlineRow
+  [459] = 73 + 1, // Grid
+  [463] = 66 + 1, // RelevanceIndicator
+  [464] = 80 + 1, // Tab
+  [488] = 55 + 1, // MenuBar
+  [497] = 23 + 1, // TabGroup
+  [501] = 62 + 1, // RatingIndicator
+  [502] = 15 + 1, // ComboBox
+  [503] = 33 + 1, // Slider
+  [505] = 5 + 1, // Sheet
+  [508] = 9 + 1, // Button
+};
 
-+ (void)createMapping
+/**
+ Calculates 32-bit FNV-1a hash of the name suffix after FB_ELEMENT_TYPE_PREFIX
+ and returns its top FB_ELEMENT_TYPE_NAME_HASH_BITS bits
+ */
+static NSUInteger FBElementTypeNameHash(const unichar *suffix, NSUInteger length)
 {
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    ElementTypeToStringMapping =
-    @{
-      @0 : @"XCUIElementTypeAny",
-      @1 : @"XCUIElementTypeOther",
-      @2 : @"XCUIElementTypeApplication",
-      @3 : @"XCUIElementTypeGroup",
-      @4 : @"XCUIElementTypeWindow",
-      @5 : @"XCUIElementTypeSheet",
-      @6 : @"XCUIElementTypeDrawer",
-      @7 : @"XCUIElementTypeAlert",
-      @8 : @"XCUIElementTypeDialog",
-      @9 : @"XCUIElementTypeButton",
-      @10 : @"XCUIElementTypeRadioButton",
-      @11 : @"XCUIElementTypeRadioGroup",
-      @12 : @"XCUIElementTypeCheckBox",
-      @13 : @"XCUIElementTypeDisclosureTriangle",
-      @14 : @"XCUIElementTypePopUpButton",
-      @15 : @"XCUIElementTypeComboBox",
-      @16 : @"XCUIElementTypeMenuButton",
-      @17 : @"XCUIElementTypeToolbarButton",
-      @18 : @"XCUIElementTypePopover",
-      @19 : @"XCUIElementTypeKeyboard",
-      @20 : @"XCUIElementTypeKey",
-      @21 : @"XCUIElementTypeNavigationBar",
-      @22 : @"XCUIElementTypeTabBar",
-      @23 : @"XCUIElementTypeTabGroup",
-      @24 : @"XCUIElementTypeToolbar",
-      @25 : @"XCUIElementTypeStatusBar",
-      @26 : @"XCUIElementTypeTable",
-      @27 : @"XCUIElementTypeTableRow",
-      @28 : @"XCUIElementTypeTableColumn",
-      @29 : @"XCUIElementTypeOutline",
-      @30 : @"XCUIElementTypeOutlineRow",
-      @31 : @"XCUIElementTypeBrowser",
-      @32 : @"XCUIElementTypeCollectionView",
-      @33 : @"XCUIElementTypeSlider",
-      @34 : @"XCUIElementTypePageIndicator",
-      @35 : @"XCUIElementTypeProgressIndicator",
-      @36 : @"XCUIElementTypeActivityIndicator",
-      @37 : @"XCUIElementTypeSegmentedControl",
-      @38 : @"XCUIElementTypePicker",
-      @39 : @"XCUIElementTypePickerWheel",
-      @40 : @"XCUIElementTypeSwitch",
-      @41 : @"XCUIElementTypeToggle",
-      @42 : @"XCUIElementTypeLink",
-      @43 : @"XCUIElementTypeImage",
-      @44 : @"XCUIElementTypeIcon",
-      @45 : @"XCUIElementTypeSearchField",
-      @46 : @"XCUIElementTypeScrollView",
-      @47 : @"XCUIElementTypeScrollBar",
-      @48 : @"XCUIElementTypeStaticText",
-      @49 : @"XCUIElementTypeTextField",
-      @50 : @"XCUIElementTypeSecureTextField",
-      @51 : @"XCUIElementTypeDatePicker",
-      @52 : @"XCUIElementTypeTextView",
-      @53 : @"XCUIElementTypeMenu",
-      @54 : @"XCUIElementTypeMenuItem",
-      @55 : @"XCUIElementTypeMenuBar",
-      @56 : @"XCUIElementTypeMenuBarItem",
-      @57 : @"XCUIElementTypeMap",
-      @58 : @"XCUIElementTypeWebView",
-      @59 : @"XCUIElementTypeIncrementArrow",
-      @60 : @"XCUIElementTypeDecrementArrow",
-      @61 : @"XCUIElementTypeTimeline",
-      @62 : @"XCUIElementTypeRatingIndicator",
-      @63 : @"XCUIElementTypeValueIndicator",
-      @64 : @"XCUIElementTypeSplitGroup",
-      @65 : @"XCUIElementTypeSplitter",
-      @66 : @"XCUIElementTypeRelevanceIndicator",
-      @67 : @"XCUIElementTypeColorWell",
-      @68 : @"XCUIElementTypeHelpTag",
-      @69 : @"XCUIElementTypeMatte",
-      @70 : @"XCUIElementTypeDockItem",
-      @71 : @"XCUIElementTypeRuler",
-      @72 : @"XCUIElementTypeRulerMarker",
-      @73 : @"XCUIElementTypeGrid",
-      @74 : @"XCUIElementTypeLevelIndicator",
-      @75 : @"XCUIElementTypeCell",
-      @76 : @"XCUIElementTypeLayoutArea",
-      @77 : @"XCUIElementTypeLayoutItem",
-      @78 : @"XCUIElementTypeHandle",
-      @79 : @"XCUIElementTypeStepper",
-      @80 : @"XCUIElementTypeTab",
-      @81 : @"XCUIElementTypeTouchBar",
-      @82 : @"XCUIElementTypeStatusItem",
-      // !!! This mapping should be updated if there are changes after each new XCTest release
-      };
-    NSMutableDictionary *swappedMapping = [NSMutableDictionary dictionary];
-    [ElementTypeToStringMapping enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-      swappedMapping[obj] = key;
-    }];
-    StringToElementTypeMapping = swappedMapping.copy;
-  });
+  uint32_t hash = FB_ELEMENT_TYPE_NAME_HASH_SEED;
+  for (NSUInteger i = 0; i < length; i++) {
+    hash ^= suffix[i];
+    hash *= 16777619;
+  }
+  return hash >> (32 - FB_ELEMENT_TYPE_NAME_HASH_BITS);
 }
 
+/**
+ Looks up the given name in the perfect hash table
+
+ @return The matching element type or NSNotFound if the name is unknown
+ */
+static NSUInteger FBElementTypeWithKnownName(NSString *typeName)
+{
+  NSUInteger prefixLength = FB_ELEMENT_TYPE_PREFIX.length;
+  NSUInteger length = typeName.length;
+  if (length <= prefixLength || length > FB_ELEMENT_TYPE_NAME_MAX_LENGTH) {
+    return NSNotFound;
+  }
+  unichar suffix[FB_ELEMENT_TYPE_NAME_MAX_LENGTH];
+  NSUInteger suffixLength = length - prefixLength;
+  [typeName getCharacters:suffix range:NSMakeRange(prefixLength, suffixLength)];
+  uint8_t slot = FBElementTypeNameSlots[FBElementTypeNameHash(suffix, suffixLength)];
+  if (0 == slot) {
+    return NSNotFound;
+  }
+  NSUInteger type = slot - 1;
+  return [FBElementTypeNames[type] isEqualToString:typeName] ? type : NSNotFound;
+}
+
+@implementation FBElementTypeTransformer
+
 + (XCUIElementType)elementTypeWithTypeName:(NSString *)typeName
 {
-  [self createMapping];
-  NSNumber *type = StringToElementTypeMapping[typeName];
-  if (nil == type) {
-    if ([typeName hasPrefix:(NSString *)FB_ELEMENT_TYPE_PREFIX] && typeName.length > FB_ELEMENT_TYPE_PREFIX.length) {
-      // Consider the element type is something new and has to be added into ElementTypeToStringMapping
+  NSUInteger type = nil == typeName ? NSNotFound : FBElementTypeWithKnownName(typeName);
+  if (NSNotFound == type) {
+    if ([typeName hasPrefix:FB_ELEMENT_TYPE_PREFIX] && typeName.length > FB_ELEMENT_TYPE_PREFIX.length) {
+      // Consider the element type is something new and has to be added into FBElementTypeNames
       return XCUIElementTypeOther;
     }
     NSString *reason = [NSString stringWithFormat:@"Invalid argument for class used '%@'. Did you mean %@%@?", typeName, FB_ELEMENT_TYPE_PREFIX, typeName];
     @throw [NSException exceptionWithName:FBInvalidArgumentException reason:reason userInfo:@{}];
   }
-  return (XCUIElementType) type.unsignedIntegerValue;
+  return (XCUIElementType)type;
 }
 
 + (NSString *)stringWithElementType:(XCUIElementType)type
 {
-  [self createMapping];
-  NSString *typeName = ElementTypeToStringMapping[@(type)];
-  return nil == typeName
-    // Consider the type name is something new and has to be added into ElementTypeToStringMapping
-    ? [NSString stringWithFormat:@"%@Other", FB_ELEMENT_TYPE_PREFIX]
-    : typeName;
+  return (NSUInteger)type < FBElementTypeNamesCount
+    ? FBElementTypeNames[type]
+    // Consider the type name is something new and has to be added into FBElementTypeNames
+    : FBElementTypeNames[XCUIElementTypeOther];
 }
 
 @end
@@ -11,8 +11,19 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+typedef NS_ENUM(NSUInteger, FBLogLevel) {
+  FBLogLevelError = 0,
+  FBLogLevelWarning,
+  FBLogLevelInfo,
+  /*! Only enabled if WDA is Verbose */
+  FBLogLevelVerbose,
+};
+
 /**
- A Global Logger object that understands log levels
+ A Global Logger object that understands log levels.
+ Messages are written asynchronously on a dedicated serial queue, so the calling
+ thread never waits for the output. Messages longer than a couple of kilobytes are truncated.
+ The most recent messages are also kept in a memory ring buffer.
  */
 @interface FBLogger : NSObject
 
@@ -28,6 +39,35 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)verboseLog:(NSString *)message;
 + (void)verboseLogFmt:(NSString *)format, ... NS_FORMAT_FUNCTION(1,2);
 
+/**
+ Log to stdout with the given level
+ */
++ (void)logWithLevel:(FBLogLevel)level message:(NSString *)message;
+
+/**
+ Log to stdout with the given level. The block is only called if the level is enabled,
+ and it is called on the logging queue, so it must only capture immutable objects.
+ Use this method for messages that are expensive to build.
+ */
++ (void)logWithLevel:(FBLogLevel)level messageBlock:(NSString *(^)(void))messageBlock;
+
+/**
+ Whether messages with the given level are going to be logged
+ */
++ (BOOL)isLevelEnabled:(FBLogLevel)level;
+
+/**
+ Blocks until all pending messages are written.
+ Must be called before the process is terminated on purpose.
+ */
++ (void)flush;
+
+/**
+ Returns the most recent log entries, oldest first. Each entry contains
+ `timestamp` (milliseconds since Unix epoch), `level` and `message` keys.
+ */
++ (NSArray<NSDictionary<NSString *, id> *> *)recentEntries;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,40 +9,162 @@
 
 #import "FBLogger.h"
 
+#import <stdatomic.h>
+
 #import "FBConfiguration.h"
 
+// Longer messages are truncated. Usually these are request payloads, like base64-encoded files
+static const NSUInteger FBLogMaxMessageLength = 4096;
+static const NSUInteger FBLogRingBufferCapacity = 1000;
+// Messages are dropped if the output cannot keep up with them, so the queue cannot grow infinitely
+static const NSUInteger FBLogMaxPendingMessagesCount = 10000;
+
+static dispatch_queue_t FBLogQueue;
+static _Atomic(NSUInteger) FBLogPendingMessagesCount;
+static _Atomic(NSUInteger) FBLogDroppedMessagesCount;
+// Must only be accessed on FBLogQueue
+static NSMutableArray<NSDictionary<NSString *, id> *> *FBLogRingBuffer;
+static NSUInteger FBLogRingBufferHead;
+
+static NSString *FBLogLevelName(FBLogLevel level)
+{
+  switch (level) {
+    case FBLogLevelError:
+      return @"SEVERE";
+    case FBLogLevelWarning:
+      return @"WARNING";
+    case FBLogLevelInfo:
+      return @"INFO";
+    case FBLogLevelVerbose:
+      return @"DEBUG";
+  }
+}
+
+static NSString *FBTruncatedLogMessage(NSString *message)
+{
+  if (message.length <= FBLogMaxMessageLength) {
+    return message;
+  }
+  // Make sure surrogate pairs and other composed characters are not cut in the middle
+  NSUInteger cutIndex = [message rangeOfComposedCharacterSequenceAtIndex:FBLogMaxMessageLength].location;
+  return [NSString stringWithFormat:@"%@... (%lu characters truncated)",
+          [message substringToIndex:cutIndex], (unsigned long)(message.length - cutIndex)];
+}
+
+static void FBRecordLogEntry(NSDictionary<NSString *, id> *entry)
+{
+  if (FBLogRingBuffer.count < FBLogRingBufferCapacity) {
+    [FBLogRingBuffer addObject:entry];
+    return;
+  }
+  FBLogRingBuffer[FBLogRingBufferHead] = entry;
+  FBLogRingBufferHead = (FBLogRingBufferHead + 1) % FBLogRingBufferCapacity;
+}
+
 @implementation FBLogger
 
++ (void)initialize
+{
+  if (self != FBLogger.class) {
+    return;
+  }
+  dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+  FBLogQueue = dispatch_queue_create("com.facebook.WebDriverAgent.logger", attributes);
+  FBLogRingBuffer = [NSMutableArray arrayWithCapacity:FBLogRingBufferCapacity];
+  atomic_init(&FBLogPendingMessagesCount, 0);
+  atomic_init(&FBLogDroppedMessagesCount, 0);
+}
+
 + (void)log:(NSString *)message
 {
-  NSLog(@"%@", message);
+  [self logWithLevel:FBLogLevelInfo message:message];
 }
 
 + (void)logFmt:(NSString *)format, ...
 {
   va_list args;
   va_start(args, format);
-  NSLogv(format, args);
+  NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
   va_end(args);
+  [self logWithLevel:FBLogLevelInfo message:message];
 }
 
 + (void)verboseLog:(NSString *)message
 {
-  if (!FBConfiguration.sharedConfiguration.verboseLoggingEnabled) {
-    return;
-  }
-  [self log:message];
+  [self logWithLevel:FBLogLevelVerbose message:message];
 }
 
 + (void)verboseLogFmt:(NSString *)format, ...
 {
-  if (!FBConfiguration.sharedConfiguration.verboseLoggingEnabled) {
+  if (![self isLevelEnabled:FBLogLevelVerbose]) {
     return;
   }
   va_list args;
   va_start(args, format);
-  NSLogv(format, args);
+  NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
   va_end(args);
+  [self logWithLevel:FBLogLevelVerbose message:message];
+}
+
++ (BOOL)isLevelEnabled:(FBLogLevel)level
+{
+  return level != FBLogLevelVerbose || FBConfiguration.sharedConfiguration.verboseLoggingEnabled;
+}
+
++ (void)logWithLevel:(FBLogLevel)level message:(NSString *)message
+{
+  NSString *messageCopy = message.copy;
+  [self logWithLevel:level messageBlock:^NSString *{
+    return messageCopy;
+  }];
+}
+
++ (void)logWithLevel:(FBLogLevel)level messageBlock:(NSString *(^)(void))messageBlock
+{
+  if (![self isLevelEnabled:level]) {
+    return;
+  }
+  // Errors are never dropped
+  if (atomic_fetch_add_explicit(&FBLogPendingMessagesCount, 1, memory_order_relaxed) >= FBLogMaxPendingMessagesCount
+      && level != FBLogLevelError) {
+    atomic_fetch_sub_explicit(&FBLogPendingMessagesCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&FBLogDroppedMessagesCount, 1, memory_order_relaxed);
+    return;
+  }
+  NSDate *timestamp = [NSDate date];
+  dispatch_async(FBLogQueue, ^{
+    NSUInteger droppedCount = atomic_exchange_explicit(&FBLogDroppedMessagesCount, 0, memory_order_relaxed);
+    if (droppedCount > 0) {
+      NSLog(@"%lu log messages have been dropped because the output could not keep up with them", (unsigned long)droppedCount);
+    }
+    NSString *message = FBTruncatedLogMessage(messageBlock() ?: @"");
+    NSLog(@"%@", message);
+    FBRecordLogEntry(@{
+      @"timestamp": @((long long)(timestamp.timeIntervalSince1970 * 1000)),
+      @"level": FBLogLevelName(level),
+      @"message": message,
+    });
+    atomic_fetch_sub_explicit(&FBLogPendingMessagesCount, 1, memory_order_relaxed);
+  });
+}
+
++ (void)flush
+{
+  dispatch_sync(FBLogQueue, ^{});
+}
+
++ (NSArray<NSDictionary<NSString *, id> *> *)recentEntries
+{
+  __block NSArray<NSDictionary<NSString *, id> *> *result;
+  dispatch_sync(FBLogQueue, ^{
+    NSUInteger count = FBLogRingBuffer.count;
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+      [entries addObject:FBLogRingBuffer[(FBLogRingBufferHead + i) % count]];
+    }
+    result = entries.copy;
+  });
+  return result;
 }
 
 @end
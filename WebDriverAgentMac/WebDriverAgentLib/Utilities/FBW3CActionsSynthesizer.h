@@ -13,6 +13,22 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface FBW3CActionsSynthesizer : FBBaseActionsSynthesizer
 
+/**
+ Offset added to x and y coordinates of all pointer move items with the viewport origin.
+ Items relative to elements or to the current pointer position are not affected.
+ Zero by default
+ */
+@property (nonatomic) CGVector positionOffset;
+
+/**
+ The maximum distance in points a pointer may deviate from the requested path
+ while consecutive pointer move items are merged into a single one.
+ Moves are only merged if every intermediate position is still reached within this distance
+ at its original time, so the speed and the shape of the gesture are preserved.
+ Zero disables merging. The pointerMoveTolerance setting value is used by default
+ */
+@property (nonatomic) double pointerMoveTolerance;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,6 +9,7 @@
 
 #import "FBW3CActionsSynthesizer.h"
 
+#import "AMKeyboardUtils.h"
 #import "FBErrorBuilder.h"
 #import "FBElementCache.h"
 #import "FBErrorBuilder.h"
@@ -65,7 +66,8 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
 @end
 
 @interface FBPointerMoveItem : FBW3CGestureItem
-
+/*! The button, which is pressed while moving, or nil. Set by the chain compilation */
+@property (nullable, nonatomic) NSNumber *dragButton;
 @end
 
 @interface FBPointerUpItem : FBW3CGestureItem
@@ -80,20 +82,23 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
 
 @property (nullable, readonly, nonatomic) FBW3CKeyItem *previousItem;
 
-- (NSUInteger)calculateModifiersForChain:(NSArray *)allItems
-                          lastItemIndex:(NSUInteger)lastItemIndex;
-
 @end
 
 @interface FBKeyUpItem : FBW3CKeyItem
 
 @property (readonly, nonatomic) NSString *value;
+/*! Whether the item closes a preceding Key Down one. Set by the chain compilation */
+@property (nonatomic) BOOL hasDownPair;
+/*! Modifier flags active at the moment of this item. Set by the chain compilation */
+@property (nonatomic) NSUInteger modifiers;
 
 @end
 
 @interface FBKeyDownItem : FBW3CKeyItem
 
 @property (readonly, nonatomic) NSString *value;
+/*! Whether the item is closed by a succeeding Key Up one. Set by the chain compilation */
+@property (nonatomic) BOOL hasUpPair;
 
 @end
 
@@ -323,21 +328,8 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
     return @[result];
   }
 
-  NSNumber *dragButton = nil;
-  if (currentItemIndex > 0) {
-    for (NSUInteger index = currentItemIndex - 1; currentItemIndex >= 0; --currentItemIndex) {
-      FBBaseGestureItem *preceedingItem = [allItems objectAtIndex:index];
-      if ([preceedingItem isKindOfClass:FBPointerUpItem.class]) {
-        break;
-      }
-      if ([preceedingItem isKindOfClass:FBPointerDownItem.class]) {
-        dragButton = [(FBPointerDownItem *)preceedingItem button];
-        break;
-      }
-    }
-  }
-  if (nil != dragButton) {
-    [eventPath dragWithButton:dragButton.unsignedIntValue
+  if (nil != self.dragButton) {
+    [eventPath dragWithButton:self.dragButton.unsignedIntValue
                       toPoint:self.atPosition
                      atOffset:FBMillisToSeconds(self.offset)
                      duration:FBMillisToSeconds(self.duration)];
@@ -436,31 +428,6 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   return self;
 }
 
-- (NSUInteger)calculateModifiersForChain:(NSArray *)allItems
-                          lastItemIndex:(NSUInteger)lastItemIndex
-{
-  NSUInteger result = 0;
-  for (NSUInteger index = 0; index <= lastItemIndex; index++) {
-    FBW3CKeyItem *item = [allItems objectAtIndex:index];
-    NSNumber *modifier = nil;
-    BOOL isKeyDown = [item isKindOfClass:FBKeyDownItem.class];
-    BOOL isKeyUp = !isKeyDown && [item isKindOfClass:FBKeyUpItem.class];
-    if (isKeyDown || isKeyUp) {
-      NSString *value = [item performSelector:@selector(value)];
-      modifier = AMToMetaModifier(value);
-    }
-    if (nil == modifier) {
-      continue;
-    }
-    if (isKeyDown) {
-      result |= [modifier unsignedIntValue];
-    } else {
-      result &= ~[modifier unsignedIntValue];
-    }
-  }
-  return result;
-}
-
 @end
 
 
@@ -492,42 +459,12 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   return FB_ACTION_ITEM_TYPE_KEY_UP;
 }
 
-- (BOOL)hasDownPairInItems:(NSArray *)allItems
-          currentItemIndex:(NSUInteger)currentItemIndex
-{
-  NSInteger balance = 1;
-  for (NSInteger index = currentItemIndex - 1; index >= 0; index--) {
-    FBW3CKeyItem *item = [allItems objectAtIndex:index];
-    BOOL isKeyDown = [item isKindOfClass:FBKeyDownItem.class];
-    BOOL isKeyUp = !isKeyDown && [item isKindOfClass:FBKeyUpItem.class];
-    if (!isKeyUp && !isKeyDown) {
-      continue;
-    }
-
-    NSString *value = [item performSelector:@selector(value)];
-    if (isKeyDown && [value isEqualToString:self.value]) {
-      balance--;
-    }
-    if (isKeyUp && [value isEqualToString:self.value]) {
-      balance++;
-    }
-  }
-  return 0 == balance;
-}
-
-+ (NSUInteger)defaultTypingFrequency
-{
-  NSInteger defaultFreq = [[NSUserDefaults standardUserDefaults]
-                           integerForKey:@"com.apple.xctest.iOSMaximumTypingFrequency"];
-  return defaultFreq > 0 ? defaultFreq : 60;
-}
-
 - (NSArray<XCPointerEventPath *> *)addToEventPath:(XCPointerEventPath *)eventPath
                                          allItems:(NSArray *)allItems
                                  currentItemIndex:(NSUInteger)currentItemIndex
                                             error:(NSError **)error
 {
-  if (![self hasDownPairInItems:allItems currentItemIndex:currentItemIndex]) {
+  if (!self.hasDownPair) {
     NSString *description = [NSString stringWithFormat:@"Key Up action '%@' is not balanced with a preceding Key Down one in '%@'", self.value, self.actionItem];
     if (error) {
       *error = [[FBErrorBuilder.builder withDescription:description] build];
@@ -544,7 +481,7 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   XCPointerEventPath *result = nil == eventPath ? [[XCPointerEventPath alloc] initForTextInput] : eventPath;
 
   NSString *specialKey = AMToSpecialKey(self.value);
-  NSUInteger modifiers = [self calculateModifiersForChain:allItems lastItemIndex:currentItemIndex];
+  NSUInteger modifiers = self.modifiers;
   if (nil != specialKey) {
     if (specialKey.length > 0) {
       [result typeKey:specialKey
@@ -571,7 +508,7 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
       // while the typeKey API can only enter keys
       [result typeText:oneChar
               atOffset:offsetSeconds
-           typingSpeed:[self.class defaultTypingFrequency]
+           typingSpeed:AMTypingSpeed()
           shouldRedact:NO];
     }
   }
@@ -609,35 +546,12 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   return FB_ACTION_ITEM_TYPE_KEY_DOWN;
 }
 
-- (BOOL)hasUpPairInItems:(NSArray *)allItems
-        currentItemIndex:(NSUInteger)currentItemIndex
-{
-  NSInteger balance = 1;
-  for (NSUInteger index = currentItemIndex + 1; index < allItems.count; index++) {
-    FBW3CKeyItem *item = [allItems objectAtIndex:index];
-    BOOL isKeyDown = [item isKindOfClass:FBKeyDownItem.class];
-    BOOL isKeyUp = !isKeyDown && [item isKindOfClass:FBKeyUpItem.class];
-    if (!isKeyUp && !isKeyDown) {
-      continue;
-    }
-
-    NSString *value = [item performSelector:@selector(value)];
-    if (isKeyUp && [value isEqualToString:self.value]) {
-      balance--;
-    }
-    if (isKeyDown && [value isEqualToString:self.value]) {
-      balance++;
-    }
-  }
-  return 0 == balance;
-}
-
 - (NSArray<XCPointerEventPath *> *)addToEventPath:(XCPointerEventPath *)eventPath
                                          allItems:(NSArray *)allItems
                                  currentItemIndex:(NSUInteger)currentItemIndex
                                             error:(NSError **)error
 {
-  if (![self hasUpPairInItems:allItems currentItemIndex:currentItemIndex]) {
+  if (!self.hasUpPair) {
     NSString *description = [NSString stringWithFormat:@"Key Down action '%@' must have a closing Key Up successor in '%@'", self.value, self.actionItem];
     if (error) {
       *error = [[FBErrorBuilder.builder withDescription:description] build];
@@ -689,8 +603,14 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
 @end
 
 
+// Limits the amount of items checked for each merged move, so the compilation stays linear
+#define MAX_COALESCED_POINTER_MOVES 256
+
 @interface FBW3CGestureItemsChain : FBBaseActionItemsChain
 
+/*! See FBW3CActionsSynthesizer.pointerMoveTolerance */
+@property (nonatomic) double pointerMoveTolerance;
+
 @end
 
 @implementation FBW3CGestureItemsChain
@@ -701,6 +621,100 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   [self.items addObject:item];
 }
 
+- (BOOL)compileWithError:(NSError **)error
+{
+  // Each move drags with the button pressed by the closest preceding Pointer Down item
+  // unless there is a Pointer Up one in between
+  NSNumber *pressedButton = nil;
+  for (FBBaseActionItem *item in self.items) {
+    if ([item isKindOfClass:FBPointerDownItem.class]) {
+      pressedButton = [(FBPointerDownItem *)item button];
+    } else if ([item isKindOfClass:FBPointerUpItem.class]) {
+      pressedButton = nil;
+    } else if ([item isKindOfClass:FBPointerMoveItem.class]) {
+      [(FBPointerMoveItem *)item setDragButton:pressedButton];
+    }
+  }
+  if (self.pointerMoveTolerance > 0) {
+    [self coalescePointerMoves];
+  }
+  return YES;
+}
+
+/**
+ Checks whether the linear move from startPosition to the position of the last item
+ passes all intermediate item positions within the tolerance at their original times.
+ Each move lasts at least 1ms, so the total duration of the range is never zero
+ */
+- (BOOL)canMergeMoves:(NSArray<FBBaseActionItem *> *)items
+              inRange:(NSRange)range
+         fromPosition:(CGPoint)startPosition
+{
+  FBPointerMoveItem *firstItem = (FBPointerMoveItem *)items[range.location];
+  FBPointerMoveItem *lastItem = (FBPointerMoveItem *)items[NSMaxRange(range) - 1];
+  double startTime = firstItem.offset;
+  double totalDuration = lastItem.offset + lastItem.duration - startTime;
+  CGPoint endPosition = lastItem.atPosition;
+  double toleranceSquared = self.pointerMoveTolerance * self.pointerMoveTolerance;
+  for (NSUInteger index = range.location; index < NSMaxRange(range) - 1; index++) {
+    FBPointerMoveItem *item = (FBPointerMoveItem *)items[index];
+    double progress = (item.offset + item.duration - startTime) / totalDuration;
+    double dx = startPosition.x + (endPosition.x - startPosition.x) * progress - item.atPosition.x;
+    double dy = startPosition.y + (endPosition.y - startPosition.y) * progress - item.atPosition.y;
+    if (dx * dx + dy * dy > toleranceSquared) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+/**
+ Greedily merges runs of consecutive pointer moves with the same drag button,
+ so each run only produces a single move event in the resulting path
+ */
+- (void)coalescePointerMoves
+{
+  NSArray<FBBaseActionItem *> *items = self.items.copy;
+  NSMutableArray<FBBaseActionItem *> *result = [NSMutableArray arrayWithCapacity:items.count];
+  NSUInteger index = 0;
+  while (index < items.count) {
+    FBBaseActionItem *item = items[index];
+    // The very first move defines the start position of the path and thus is never merged
+    if (0 == index || ![item isKindOfClass:FBPointerMoveItem.class]) {
+      [result addObject:item];
+      index++;
+      continue;
+    }
+
+    FBPointerMoveItem *firstItem = (FBPointerMoveItem *)item;
+    CGPoint startPosition = ((FBBaseGestureItem *)items[index - 1]).atPosition;
+    NSUInteger length = 1;
+    while (length < MAX_COALESCED_POINTER_MOVES && index + length < items.count) {
+      FBBaseActionItem *nextItem = items[index + length];
+      if (![nextItem isKindOfClass:FBPointerMoveItem.class]) {
+        break;
+      }
+      NSNumber *dragButton = [(FBPointerMoveItem *)nextItem dragButton];
+      if (firstItem.dragButton != dragButton && ![firstItem.dragButton isEqual:dragButton]) {
+        break;
+      }
+      if (![self canMergeMoves:items inRange:NSMakeRange(index, length + 1) fromPosition:startPosition]) {
+        break;
+      }
+      length++;
+    }
+
+    if (length > 1) {
+      FBPointerMoveItem *lastItem = (FBPointerMoveItem *)items[index + length - 1];
+      firstItem.duration = lastItem.offset + lastItem.duration - firstItem.offset;
+      firstItem.atPosition = lastItem.atPosition;
+    }
+    [result addObject:firstItem];
+    index += length;
+  }
+  [self.items setArray:result];
+}
+
 @end
 
 
@@ -715,11 +729,86 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   [self.items addObject:item];
 }
 
+- (BOOL)compileWithError:(NSError **)error
+{
+  // Key Up is paired if there is exactly one more Key Down with the same value before it
+  NSMutableDictionary<NSString *, NSNumber *> *balances = [NSMutableDictionary dictionary];
+  NSUInteger modifiers = 0;
+  for (FBBaseActionItem *item in self.items) {
+    if ([item isKindOfClass:FBKeyDownItem.class]) {
+      NSString *value = [(FBKeyDownItem *)item value];
+      balances[value] = @(balances[value].integerValue + 1);
+      modifiers |= AMToMetaModifier(value).unsignedIntValue;
+    } else if ([item isKindOfClass:FBKeyUpItem.class]) {
+      FBKeyUpItem *keyUpItem = (FBKeyUpItem *)item;
+      NSString *value = keyUpItem.value;
+      NSInteger balance = balances[value].integerValue;
+      keyUpItem.hasDownPair = 1 == balance;
+      balances[value] = @(balance - 1);
+      modifiers &= ~AMToMetaModifier(value).unsignedIntValue;
+      keyUpItem.modifiers = modifiers;
+    }
+  }
+
+  // Key Down is paired if there is exactly one more Key Up with the same value after it
+  [balances removeAllObjects];
+  for (FBBaseActionItem *item in self.items.reverseObjectEnumerator) {
+    if ([item isKindOfClass:FBKeyUpItem.class]) {
+      NSString *value = [(FBKeyUpItem *)item value];
+      balances[value] = @(balances[value].integerValue + 1);
+    } else if ([item isKindOfClass:FBKeyDownItem.class]) {
+      FBKeyDownItem *keyDownItem = (FBKeyDownItem *)item;
+      NSString *value = keyDownItem.value;
+      NSInteger balance = balances[value].integerValue;
+      keyDownItem.hasUpPair = 1 == balance;
+      balances[value] = @(balance - 1);
+    }
+  }
+  return YES;
+}
+
 @end
 
 
 @implementation FBW3CActionsSynthesizer
 
+- (nullable instancetype)initWithActions:(NSArray *)actions
+                          forApplication:(XCUIApplication *)application
+                            elementCache:(nullable FBElementCache *)elementCache
+                                   error:(NSError **)error
+{
+  self = [super initWithActions:actions
+                 forApplication:application
+                   elementCache:elementCache
+                          error:error];
+  if (self) {
+    _pointerMoveTolerance = FBConfiguration.sharedConfiguration.pointerMoveTolerance;
+  }
+  return self;
+}
+
+- (NSDictionary<NSString *, id> *)actionItemWithPositionOffset:(NSDictionary<NSString *, id> *)actionItem
+{
+  if (0 == self.positionOffset.dx && 0 == self.positionOffset.dy) {
+    return actionItem;
+  }
+  id actionItemType = [actionItem objectForKey:FB_ACTION_ITEM_KEY_TYPE];
+  id origin = [actionItem objectForKey:FB_ACTION_ITEM_KEY_ORIGIN] ?: FB_ORIGIN_TYPE_VIEWPORT;
+  NSNumber *x = [actionItem objectForKey:FB_ACTION_ITEM_KEY_X];
+  NSNumber *y = [actionItem objectForKey:FB_ACTION_ITEM_KEY_Y];
+  if (![FB_ACTION_ITEM_TYPE_POINTER_MOVE isEqual:actionItemType]
+      || ![FB_ORIGIN_TYPE_VIEWPORT isEqual:origin]
+      || ![x isKindOfClass:NSNumber.class]
+      || ![y isKindOfClass:NSNumber.class]) {
+    // Invalid items are reported later
+    return actionItem;
+  }
+  NSMutableDictionary<NSString *, id> *result = actionItem.mutableCopy;
+  [result setObject:@(x.doubleValue + self.positionOffset.dx) forKey:FB_ACTION_ITEM_KEY_X];
+  [result setObject:@(y.doubleValue + self.positionOffset.dy) forKey:FB_ACTION_ITEM_KEY_Y];
+  return result.copy;
+}
+
 - (NSArray<NSDictionary<NSString *, id> *> *)preprocessedActionItemsWith:(NSArray<NSDictionary<NSString *, id> *> *)actionItems
 {
   NSMutableArray<NSDictionary<NSString *, id> *> *result = [NSMutableArray array];
@@ -734,6 +823,7 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
       shouldCancelNextItem = YES;
       continue;
     }
+    actionItem = [self actionItemWithPositionOffset:actionItem];
 
     if (nil == self.elementCache) {
       [result addObject:actionItem];
@@ -882,6 +972,7 @@ static NSString *const FB_KEY_ACTIONS = @"actions";
   }
 
   FBW3CGestureItemsChain *chain = [[FBW3CGestureItemsChain alloc] init];
+  chain.pointerMoveTolerance = self.pointerMoveTolerance;
   NSArray<NSDictionary<NSString *, id> *> *processedItems = [self preprocessedActionItemsWith:actionItems];
   for (NSDictionary<NSString *, id> *actionItem in processedItems) {
     id actionItemType = [actionItem objectForKey:FB_ACTION_ITEM_KEY_TYPE];
@@ -9,6 +9,8 @@
 
 #import <XCTest/XCTest.h>
 
+@class AMSnapshotTree;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface FBXPath : NSObject
@@ -35,6 +37,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSString *)xmlStringWithRootElement:(XCUIElement *)root;
 
+/**
+ Gets XML representation of a flat snapshot tree, for example a recorded one.
+ The representation is the same as for live elements
+
+ @param tree the tree to serialize
+ @return valid XML document as string
+ */
++ (NSString *)xmlStringWithSnapshotTree:(AMSnapshotTree *)tree;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -10,7 +10,10 @@
 #import "FBXPath.h"
 
 #import "AMGeometryUtils.h"
+#import "AMSnapshotTree.h"
 #import "AMSnapshotUtils.h"
+#import "AMTrace.h"
+#import "AMXPathExpression.h"
 #import "FBConfiguration.h"
 #import "FBElementUtils.h"
 #import "FBExceptions.h"
@@ -20,14 +23,48 @@
 #import "XCUIElementQuery+AMHelpers.h"
 
 
+/**
+ Keeps XML-safe attribute strings created during a single serialization pass,
+ so values repeating across many nodes are only formatted and sanitized once
+ */
+@interface FBXMLStringInterner : NSObject
+
+/**
+ Returns the XML-safe representation of the given string
+
+ @param str The raw string value
+ @return The sanitized string, which is shared between all equal raw values
+ */
+- (NSString *)safeXmlStringWithString:(NSString *)str;
+
+/**
+ Returns the cached string for the given value or builds and caches a new one.
+ Strings of different kinds are cached separately, so equal values of different
+ kinds never share the same result
+
+ @param kind The kind of the value, for example the name of the attribute it belongs to
+ @param value The value, which must unambiguously define the resulting string within its kind
+ @param builder The block to create the string if it is not cached yet
+ @return The shared string instance
+ */
+- (NSString *)stringWithKind:(NSString *)kind
+                       value:(id<NSCopying>)value
+                     builder:(NSString *(NS_NOESCAPE ^)(void))builder;
+
+@end
+
 @interface FBElementAttribute : NSObject
 
 @property (nonatomic, readonly) id<XCUIElementSnapshot> element;
 
 + (nonnull NSString *)name;
 + (nullable NSString *)valueForElement:(id<XCUIElementSnapshot>)element;
++ (nullable NSString *)valueForElement:(id<XCUIElementSnapshot>)element
+                              interner:(FBXMLStringInterner *)interner;
 
-+ (void)recordWithNode:(NSXMLElement *)node forElement:(id<XCUIElementSnapshot>)element;
++ (void)recordWithNode:(NSXMLElement *)node
+            forElement:(id<XCUIElementSnapshot>)element
+              interner:(FBXMLStringInterner *)interner;
 
 + (NSArray<Class> *)supportedAttributes;
 
@@ -67,6 +104,8 @@
 
 @interface FBDimensionAttribute : FBElementAttribute
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame;
+
 @end
 
 @interface FBXAttribute : FBDimensionAttribute
@@ -121,6 +160,52 @@
 static NSString *const kXMLIndexPathKey = @"private_indexPath";
 
 
+@implementation FBXMLStringInterner
+{
+  NSMutableDictionary<NSString *, NSString *> *_safeStrings;
+  NSMutableDictionary<NSString *, NSMutableDictionary<id<NSCopying>, NSString *> *> *_builtStrings;
+}
+
+- (instancetype)init
+{
+  if ((self = [super init])) {
+    _safeStrings = [NSMutableDictionary dictionary];
+    _builtStrings = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (NSString *)safeXmlStringWithString:(NSString *)str
+{
+  NSString *result = [_safeStrings objectForKey:str];
+  if (nil == result) {
+    result = [FBXPath safeXmlStringWithString:str];
+    // Dictionary keys are copied, so mutable values cannot corrupt the table
+    [_safeStrings setObject:result forKey:str];
+  }
+  return result;
+}
+
+- (NSString *)stringWithKind:(NSString *)kind
+                       value:(id<NSCopying>)value
+                     builder:(NSString *(NS_NOESCAPE ^)(void))builder
+{
+  NSMutableDictionary<id<NSCopying>, NSString *> *strings = [_builtStrings objectForKey:kind];
+  if (nil == strings) {
+    strings = [NSMutableDictionary dictionary];
+    [_builtStrings setObject:strings forKey:kind];
+  }
+  NSString *result = [strings objectForKey:value];
+  if (nil == result) {
+    result = builder();
+    [strings setObject:result forKey:value];
+  }
+  return result;
+}
+
+@end
+
+
 @implementation FBXPath
 
 + (id)throwException:(NSString *)name forQuery:(NSString *)xpathQuery
@@ -133,7 +218,9 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
 + (nullable NSString *)xmlStringWithRootElement:(XCUIElement *)root
 {
   NSError *error;
+  AMTraceSpan *snapshotSpan = [AMTrace beginSpanWithName:@"snapshot"];
   id<XCUIElementSnapshot> snapshot = [root snapshotWithError:&error];
+  [snapshotSpan end];
   if (nil == snapshot) {
     [FBLogger logFmt:@"The snapshot of %@ cannot be taken. Original error: %@", root.description, error.description];
     return nil;
@@ -147,7 +234,9 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
                              includeOnlyFirstMatch:(BOOL)firstMatch
 {
   NSError *error;
+  AMTraceSpan *snapshotSpan = [AMTrace beginSpanWithName:@"snapshot"];
   id<XCUIElementSnapshot> snapshot = [root snapshotWithError:&error];
+  [snapshotSpan end];
   if (nil == snapshot) {
     NSString *reason = [NSString stringWithFormat:@"Cannot evaluate results for XPath expression \"%@\". Original error: %@", xpathQuery, error.description];
     @throw [NSException exceptionWithName:FBXPathQueryEvaluationException
@@ -155,8 +244,19 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
                                  userInfo:@{}];
   }
 
+  if (FBConfiguration.sharedConfiguration.useNativeXPathEngine) {
+    NSArray *nativeMatches = [self nativeMatchesWithRootElement:root
+                                                   rootSnapshot:snapshot
+                                                       forQuery:xpathQuery
+                                          includeOnlyFirstMatch:firstMatch];
+    if (nil != nativeMatches) {
+      return nativeMatches;
+    }
+  }
+
   NSXMLElement *rootElement = [self makeXmlWithRootSnapshot:snapshot
-                                                  indexPath:[AMSnapshotUtils hashWithSnapshot:snapshot]];
+                                                  indexPath:[AMSnapshotUtils hashWithSnapshot:snapshot]
+                                                   interner:[FBXMLStringInterner new]];
   NSArray<__kindof NSXMLNode *> *matches = [rootElement nodesForXPath:[xpathQuery fb_toFixedXPathQuery]
                                                                 error:&error];
   if (nil == matches) {
@@ -175,16 +275,50 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
   return matchingElements;
 }
 
+/**
+ Evaluates the query over the snapshot tree without building its XML representation
+
+ @return The list of matched elements or nil if the query is not supported by the native engine
+ */
++ (nullable NSArray<XCUIElement *> *)nativeMatchesWithRootElement:(XCUIElement *)root
+                                                     rootSnapshot:(id<XCUIElementSnapshot>)snapshot
+                                                         forQuery:(NSString *)xpathQuery
+                                            includeOnlyFirstMatch:(BOOL)firstMatch
+{
+  NSError *error;
+  AMXPathExpression *expression = [AMXPathExpression expressionWithQuery:xpathQuery error:&error];
+  if (nil == expression) {
+    [FBLogger verboseLog:error.localizedDescription];
+    return nil;
+  }
+  AMTraceSpan *evaluationSpan = [AMTrace beginSpanWithName:@"xpath (native)"];
+  AMSnapshotTree *tree = [[AMSnapshotTree alloc] initWithRootSnapshot:snapshot];
+  NSIndexSet *nodes = [expression matchingNodesInTree:tree error:&error];
+  [evaluationSpan end];
+  if (nil == nodes) {
+    [FBLogger verboseLog:error.localizedDescription];
+    return nil;
+  }
+
+  NSMutableSet<NSString *> *hashes = [NSMutableSet setWithCapacity:nodes.count];
+  [nodes enumerateIndexesUsingBlock:^(NSUInteger node, BOOL *stop) {
+    NSString *hash = [AMSnapshotUtils hashWithSnapshot:[tree snapshotOfNode:node]];
+    if (nil != hash) {
+      [hashes addObject:hash];
+    }
+  }];
+  return [self collectMatchingElementsWithHashes:hashes.copy
+                                     rootElement:root
+                                    rootSnapshot:snapshot
+                           includeOnlyFirstMatch:firstMatch];
+}
+
 + (NSArray *)collectMatchingElementsWithNodes:(NSArray<__kindof NSXMLNode *> *)nodes
                                   rootElement:(XCUIElement *)rootElement
                                  rootSnapshot:(id<XCUIElementSnapshot>)rootSnapshot
                         includeOnlyFirstMatch:(BOOL)firstMatch
 {
-  if (0 == nodes.count) {
-    return @[];
-  }
-
-  NSMutableArray<NSString *> *hashes = [NSMutableArray array];
+  NSMutableSet<NSString *> *hashes = [NSMutableSet set];
   for (NSXMLNode *node in nodes) {
     if (![node isKindOfClass:NSXMLElement.class]) {
       continue;
@@ -195,6 +329,21 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
     }
     [hashes addObject:attrValue];
   }
+  return [self collectMatchingElementsWithHashes:hashes.copy
+                                     rootElement:rootElement
+                                    rootSnapshot:rootSnapshot
+                           includeOnlyFirstMatch:firstMatch];
+}
+
++ (NSArray *)collectMatchingElementsWithHashes:(NSSet<NSString *> *)hashes
+                                   rootElement:(XCUIElement *)rootElement
+                                  rootSnapshot:(id<XCUIElementSnapshot>)rootSnapshot
+                         includeOnlyFirstMatch:(BOOL)firstMatch
+{
+  if (0 == hashes.count) {
+    return @[];
+  }
+
   NSMutableArray<XCUIElement *> *matchingElements = [NSMutableArray array];
   NSString *selfHash = [AMSnapshotUtils hashWithSnapshot:rootSnapshot];
   if ([hashes containsObject:selfHash]) {
@@ -214,13 +363,44 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
 
 + (NSXMLDocument *)xmlRepresentationWithSnapshot:(id<XCUIElementSnapshot>)root
 {
-  NSXMLElement *rootElement = [self makeXmlWithRootSnapshot:root indexPath:nil];
+  NSXMLElement *rootElement = [self makeXmlWithRootSnapshot:root
+                                                  indexPath:nil
+                                                   interner:[FBXMLStringInterner new]];
+  return [self xmlDocumentWithRootElement:rootElement];
+}
+
++ (NSXMLDocument *)xmlDocumentWithRootElement:(NSXMLElement *)rootElement
+{
   NSXMLDocument *xmlDoc = [[NSXMLDocument alloc] initWithRootElement:rootElement];
   [xmlDoc setVersion:@"1.0"];
   [xmlDoc setCharacterEncoding:@"UTF-8"];
   return xmlDoc;
 }
 
++ (NSString *)xmlStringWithSnapshotTree:(AMSnapshotTree *)tree
+{
+  NSXMLElement *rootElement = [self makeXmlWithSnapshotTree:tree node:0];
+  return [[self xmlDocumentWithRootElement:rootElement] XMLStringWithOptions:NSXMLNodePrettyPrint];
+}
+
++ (NSXMLElement *)makeXmlWithSnapshotTree:(AMSnapshotTree *)tree node:(NSUInteger)node
+{
+  NSXMLElement *element = [NSXMLElement elementWithName:[tree typeNameOfNode:node]];
+  // Tree strings are already XML-safe
+  for (NSString *name in AMSnapshotTree.attributeNames) {
+    NSString *value = [tree attributeValueWithName:name ofNode:node];
+    if (nil != value) {
+      [element addAttribute:[NSXMLNode attributeWithName:name stringValue:value]];
+    }
+  }
+  for (NSUInteger child = [tree firstChildOfNode:node];
+       child != AMSnapshotTreeNoNode;
+       child = [tree nextSiblingOfNode:child]) {
+    [element addChild:[self makeXmlWithSnapshotTree:tree node:child]];
+  }
+  return element;
+}
+
 + (nullable NSString *)safeXmlStringWithString:(nullable NSString *)str
 {
   return [str fb_xmlSafeStringWithReplacement:@""];
@@ -229,9 +409,10 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
 + (void)recordElementAttributes:(NSXMLElement *)node
                     forSnapshot:(id<XCUIElementSnapshot>)snapshot
                       indexPath:(nullable NSString *)indexPath
+                       interner:(FBXMLStringInterner *)interner
 {
   for (Class attributeCls in FBElementAttribute.supportedAttributes) {
-    [attributeCls recordWithNode:node forElement:snapshot];
+    [attributeCls recordWithNode:node forElement:snapshot interner:interner];
   }
 
   if (nil != indexPath) {
@@ -242,12 +423,14 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
 
 + (NSXMLElement *)makeXmlWithRootSnapshot:(id<XCUIElementSnapshot>)root
                                 indexPath:(nullable NSString *)indexPath
+                                 interner:(FBXMLStringInterner *)interner
 {
   NSString *type = [FBElementTypeTransformer stringWithElementType:root.elementType];
   NSXMLElement *rootElement = [NSXMLElement elementWithName:type];
   [self recordElementAttributes:rootElement
                     forSnapshot:root
-                      indexPath:indexPath];
+                      indexPath:indexPath
+                       interner:interner];
 
   NSArray<id<XCUIElementSnapshot>> *children = root.children;
   for (id<XCUIElementSnapshot> childSnapshot in children) {
@@ -255,7 +438,8 @@ static NSString *const kXMLIndexPathKey = @"private_indexPath";
       ? [AMSnapshotUtils hashWithSnapshot:childSnapshot]
       : nil;
     NSXMLElement *childElement = [self makeXmlWithRootSnapshot:childSnapshot
-                                                     indexPath:newIndexPath];
+                                                     indexPath:newIndexPath
+                                                      interner:interner];
     [rootElement addChild:childElement];
   }
   return rootElement;
@@ -289,16 +473,24 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   @throw [NSException exceptionWithName:FBAbstractMethodInvocationException reason:errMsg userInfo:nil];
 }
 
-+ (void)recordWithNode:(NSXMLElement *)node forElement:(id<XCUIElementSnapshot>)element
++ (NSString *)valueForElement:(id<XCUIElementSnapshot>)element
+                     interner:(FBXMLStringInterner *)interner
 {
-  NSString *value = [self valueForElement:element];
+  return [self valueForElement:element];
+}
+
++ (void)recordWithNode:(NSXMLElement *)node
+            forElement:(id<XCUIElementSnapshot>)element
+              interner:(FBXMLStringInterner *)interner
+{
+  NSString *value = [self valueForElement:element interner:interner];
   if (nil == value) {
     // Skip the attribute if the value equals to nil
     return;
   }
 
-  NSString *attrName = [FBXPath safeXmlStringWithString:self.name];
-  NSString *attrValue = [FBXPath safeXmlStringWithString:value];
+  NSString *attrName = [interner safeXmlStringWithString:self.name];
+  NSString *attrValue = [interner safeXmlStringWithString:value];
   [node addAttribute:[NSXMLNode attributeWithName:attrName stringValue:attrValue]];
 }
 
@@ -341,6 +533,14 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   return [NSString stringWithFormat:@"%lu", element.elementType];
 }
 
++ (NSString *)valueForElement:(id<XCUIElementSnapshot>)element
+                     interner:(FBXMLStringInterner *)interner
+{
+  return [interner stringWithKind:self.name value:@(element.elementType) builder:^NSString *{
+    return [self valueForElement:element];
+  }];
+}
+
 @end
 
 @implementation FBValueAttribute
@@ -401,11 +601,27 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
 
 @implementation FBDimensionAttribute
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame
+{
+  NSString *errMsg = [NSString stringWithFormat:@"The abstract method +(CGFloat)dimensionWithIntegralFrame: is expected to be overridden by %@", NSStringFromClass(self.class)];
+  @throw [NSException exceptionWithName:FBAbstractMethodInvocationException reason:errMsg userInfo:nil];
+}
+
 + (NSString *)valueForElement:(id<XCUIElementSnapshot>)element
 {
   return [NSString stringWithFormat:@"%@", [AMCGRectToDict(element.frame) objectForKey:self.name]];
 }
 
++ (NSString *)valueForElement:(id<XCUIElementSnapshot>)element
+                     interner:(FBXMLStringInterner *)interner
+{
+  // Must produce the same number as AMCGRectToDict does
+  NSNumber *dimension = @([self dimensionWithIntegralFrame:CGRectIntegral(element.frame)]);
+  return [interner stringWithKind:self.name value:dimension builder:^NSString *{
+    return [NSString stringWithFormat:@"%@", dimension];
+  }];
+}
+
 @end
 
 @implementation FBXAttribute
@@ -415,6 +631,11 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   return @"x";
 }
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame
+{
+  return CGRectGetMinX(frame);
+}
+
 @end
 
 @implementation FBYAttribute
@@ -424,6 +645,11 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   return @"y";
 }
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame
+{
+  return CGRectGetMinY(frame);
+}
+
 @end
 
 @implementation FBWidthAttribute
@@ -433,6 +659,11 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   return @"width";
 }
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame
+{
+  return CGRectGetWidth(frame);
+}
+
 @end
 
 @implementation FBHeightAttribute
@@ -442,6 +673,11 @@ static NSString *const FBAbstractMethodInvocationException = @"AbstractMethodInv
   return @"height";
 }
 
++ (CGFloat)dimensionWithIntegralFrame:(CGRect)frame
+{
+  return CGRectGetHeight(frame);
+}
+
 @end
 
 @implementation FBTitleAttribute : FBElementAttribute
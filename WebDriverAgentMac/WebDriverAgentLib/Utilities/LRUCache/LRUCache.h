@@ -47,6 +47,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable id)objectForKey:(id<NSCopying>)key;
 
+/**
+ Removes an object from the cache
+
+ @param key Object's key
+ @returns Either the removed instance or nil if no object has been stored for the given key
+ */
+- (nullable id)removeObjectForKey:(id<NSCopying>)key;
+
+/**
+ Removes all objects from the cache
+ */
+- (void)removeAllObjects;
+
 /**
  Retrieves all values from the cache ORDERED by recent bump. No bump is performed
 
@@ -57,6 +57,20 @@
   return [self moveNodeToHead:node].value;
 }
 
+- (id)removeObjectForKey:(id<NSCopying>)key
+{
+  LRUCacheNode *node = self.store[key];
+  [self removeNode:node];
+  return node.value;
+}
+
+- (void)removeAllObjects
+{
+  [self.store removeAllObjects];
+  self.headNode = nil;
+  self.tailNode = nil;
+}
+
 - (NSArray *)allObjects
 {
   NSMutableArray *result = [[NSMutableArray alloc] initWithCapacity:self.store.count];
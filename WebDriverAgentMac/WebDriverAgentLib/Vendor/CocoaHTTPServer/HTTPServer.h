@@ -34,6 +34,7 @@
   Class connectionClass;
   NSString *interface;
   UInt16 port;
+  NSURL *unixSocketUrl;
   
   // NSNetService and related variables
   NSNetService *netService;
@@ -106,6 +107,17 @@
 - (UInt16)listeningPort;
 - (void)setPort:(UInt16)value;
 
+/**
+ * The file url of a unix domain socket to listen for connections on.
+ * If set then the interface and port properties are ignored and the server only accepts
+ * connections from the local machine through the socket file at the given path.
+ * A stale socket file at the same path gets removed when the server starts.
+ *
+ * The default value is nil, which means the server listens on a TCP port.
+ **/
+- (NSURL *)unixSocketUrl;
+- (void)setUnixSocketUrl:(NSURL *)value;
+
 /**
  * Bonjour domain for publishing the service.
  * The default value is "local.".
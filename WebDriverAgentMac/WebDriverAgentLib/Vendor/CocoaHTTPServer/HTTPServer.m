@@ -250,6 +250,31 @@ static const int httpLogLevel = HTTP_LOG_LEVEL_INFO; // | HTTP_LOG_FLAG_TRACE;
   });
 }
 
+/**
+ * The unix domain socket to listen for connections on instead of the TCP port.
+ **/
+- (NSURL *)unixSocketUrl
+{
+  __block NSURL *result;
+  
+  dispatch_sync(serverQueue, ^{
+    result = unixSocketUrl;
+  });
+  
+  return result;
+}
+
+- (void)setUnixSocketUrl:(NSURL *)value
+{
+  HTTPLogTrace();
+  
+  NSURL *valueCopy = [value copy];
+  
+  dispatch_async(serverQueue, ^{
+    unixSocketUrl = valueCopy;
+  });
+}
+
 /**
  * Domain on which to broadcast this service via Bonjour.
  * The default domain is @"local".
@@ -407,10 +432,16 @@ static const int httpLogLevel = HTTP_LOG_LEVEL_INFO; // | HTTP_LOG_FLAG_TRACE;
   
   dispatch_sync(serverQueue, ^{ @autoreleasepool {
     
-    success = [asyncSocket acceptOnInterface:interface port:port error:&err];
+    if (unixSocketUrl)
+      success = [asyncSocket acceptOnUrl:unixSocketUrl error:&err];
+    else
+      success = [asyncSocket acceptOnInterface:interface port:port error:&err];
     if (success)
     {
-      HTTPLogInfo(@"%@: Started HTTP server on port %hu", THIS_FILE, [asyncSocket localPort]);
+      if (unixSocketUrl)
+        HTTPLogInfo(@"%@: Started HTTP server on %@", THIS_FILE, unixSocketUrl.path);
+      else
+        HTTPLogInfo(@"%@: Started HTTP server on port %hu", THIS_FILE, [asyncSocket localPort]);
       
       isRunning = YES;
       [self publishBonjour];
@@ -5,6 +5,8 @@
 
 @property (nonatomic, readonly) NSDictionary *headers;
 @property (nonatomic, readonly) NSDictionary *params;
+// Monotonic clock value in nanoseconds at the moment the request has been created
+@property (nonatomic, readonly) uint64_t receivedAt;
 
 - (id)initWithHTTPMessage:(HTTPMessage *)msg parameters:(NSDictionary *)params;
 - (NSString *)header:(NSString *)field;
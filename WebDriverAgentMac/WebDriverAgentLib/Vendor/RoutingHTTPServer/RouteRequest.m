@@ -1,5 +1,6 @@
 #import "RouteRequest.h"
 #import "HTTPMessage.h"
+#import <time.h>
 
 #pragma clang diagnostic ignored "-Wdirect-ivar-access"
 #pragma clang diagnostic ignored "-Widiomatic-parentheses"
@@ -9,11 +10,13 @@
 }
 
 @synthesize params;
+@synthesize receivedAt;
 
 - (id)initWithHTTPMessage:(HTTPMessage *)msg parameters:(NSDictionary *)parameters {
   if (self = [super init]) {
     params = parameters;
     message = msg;
+    receivedAt = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
   }
   return self;
 }
@@ -85,3 +85,39 @@ export async function macosQueryAppState(
 ): Promise<number> {
   return (await this.wda.proxy.command('/wda/apps/state', 'POST', {bundleId, path})) as number;
 }
+
+/**
+ * Launch an app and keep it in the application pool, so a later session
+ * requiring the same app with the same arguments and environment could start
+ * without waiting for the launch to complete. The pool must be enabled
+ * using the `applicationPoolSize` setting.
+ *
+ * @param bundleId - Bundle identifier of the app to be warmed up.
+ *                 Either this property or `path` must be provided
+ * @param path - Full path to the app bundle. Either this property or
+ *                 `bundleId` must be provided
+ * @param args - The list of command line arguments for the app to be launched with.
+ * @param environment - Environment variables mapping.
+ *                   Custom variables are added to the default process environment.
+ */
+export async function macosWarmUpApp(
+  this: Mac2Driver,
+  bundleId?: string,
+  path?: string,
+  args?: string[],
+  environment?: StringRecord,
+): Promise<unknown> {
+  return await this.wda.proxy.command('/wda/apps/pool', 'POST', {
+    arguments: args,
+    environment,
+    bundleId,
+    path,
+  });
+}
+
+/**
+ * Terminate all apps kept in the application pool and empty it.
+ */
+export async function macosDrainAppPool(this: Mac2Driver): Promise<unknown> {
+  return await this.wda.proxy.command('/wda/apps/pool', 'DELETE');
+}
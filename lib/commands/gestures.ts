@@ -1,13 +1,14 @@
 import {util} from 'appium/support.js';
 import {errors} from 'appium/driver.js';
 import type {Mac2Driver} from '../driver.js';
-import type {KeyOptions} from '../types.js';
+import type {ActionsOperationStatus, KeyOptions} from '../types.js';
+
+const DEFAULT_ACTIONS_WAIT_TIMEOUT_SEC = 30;
 
 /**
  * Set value to the given element.
- * Note:
- * This is not exposed as 'macos: setValue' because this is the same as
- * element.send_keys in W3C WebDriver spec.
+ * Unlike element.send_keys in W3C WebDriver spec, this also allows to choose
+ * the text input mode for a single call.
  *
  * @param elementId - Uuid of the element to set value for.
  * @param value - Value to set. Could also be an array.
@@ -16,6 +17,8 @@ import type {KeyOptions} from '../types.js';
  *                  be applied while the element value is being set. See
  *                  https://developer.apple.com/documentation/xctest/xcuikeymodifierflags
  *                  for more details.
+ * @param textInputMode - How the text is entered: `typing`, `paste` or `value`.
+ *                  The `textInputMode` setting value is used if not provided.
  */
 export async function macosSetValue(
   this: Mac2Driver,
@@ -23,11 +26,13 @@ export async function macosSetValue(
   value?: any,
   text?: string,
   keyModifierFlags?: number,
+  textInputMode?: string,
 ): Promise<unknown> {
   return await this.wda.proxy.command(`/element/${elementId}/value`, 'POST', {
     value,
     text,
     keyModifierFlags,
+    textInputMode,
   });
 }
 
@@ -365,6 +370,116 @@ export async function macosKeys(
   return await this.wda.proxy.command(url, 'POST', {keys});
 }
 
+/**
+ * Validate the given W3C actions chain and store it in scope of the current session,
+ * so it could be replayed multiple times without being parsed and compiled again
+ *
+ * @param actions - Array of W3C actions in the same format as for the Perform Actions endpoint.
+ *                 Element origins are resolved each time the sequence is performed.
+ * @returns The identifier of the registered sequence
+ */
+export async function macosRegisterActions(
+  this: Mac2Driver,
+  actions: Record<string, any>[],
+): Promise<string> {
+  const {id} = (await this.wda.proxy.command('/wda/actions/sequences', 'POST', {actions})) as {
+    id: string;
+  };
+  return id;
+}
+
+/**
+ * Perform the actions sequence previously registered by `macos: registerActions`
+ *
+ * @param id - The identifier of the sequence
+ * @param offsetX - Optional offset to add to X coordinates of all pointer moves with the viewport origin
+ * @param offsetY - Optional offset to add to Y coordinates of all pointer moves with the viewport origin
+ */
+export async function macosPerformRegisteredActions(
+  this: Mac2Driver,
+  id: string,
+  offsetX?: number,
+  offsetY?: number,
+): Promise<unknown> {
+  const offset =
+    offsetX === undefined && offsetY === undefined ? undefined : {x: offsetX ?? 0, y: offsetY ?? 0};
+  return await this.wda.proxy.command(`/wda/actions/sequences/${id}`, 'POST', {offset});
+}
+
+/**
+ * Remove the actions sequence previously registered by `macos: registerActions`
+ *
+ * @param id - The identifier of the sequence
+ */
+export async function macosUnregisterActions(this: Mac2Driver, id: string): Promise<unknown> {
+  return await this.wda.proxy.command(`/wda/actions/sequences/${id}`, 'DELETE');
+}
+
+/**
+ * Validate the given W3C actions chain and start performing it in background,
+ * so other commands could be executed while a long gesture is running
+ *
+ * @param actions - Array of W3C actions in the same format as for the Perform Actions endpoint
+ * @returns The identifier of the started operation
+ */
+export async function macosStartActions(
+  this: Mac2Driver,
+  actions: Record<string, any>[],
+): Promise<string> {
+  const {id} = (await this.wda.proxy.command('/actions', 'POST', {actions, async: true})) as {
+    id: string;
+  };
+  return id;
+}
+
+/**
+ * Get the status of the operation previously started by `macos: startActions`
+ *
+ * @param id - The identifier of the operation
+ * @returns The operation status
+ */
+export async function macosGetActionsStatus(
+  this: Mac2Driver,
+  id: string,
+): Promise<ActionsOperationStatus> {
+  return (await this.wda.proxy.command(
+    `/wda/actions/operations/${id}`,
+    'GET',
+  )) as ActionsOperationStatus;
+}
+
+/**
+ * Wait until the operation previously started by `macos: startActions` is finished.
+ * The server only waits for a short time per request, so the status is polled
+ * and other commands are not blocked while waiting
+ *
+ * @param id - The identifier of the operation
+ * @param timeout - The maximum amount of seconds to wait. 30 seconds by default
+ * @returns The operation status
+ * @throws {Error} If the operation has failed or is still running after the timeout
+ */
+export async function macosWaitForActions(
+  this: Mac2Driver,
+  id: string,
+  timeout: number = DEFAULT_ACTIONS_WAIT_TIMEOUT_SEC,
+): Promise<ActionsOperationStatus> {
+  const deadline = Date.now() + timeout * 1000;
+  while (true) {
+    const remaining = Math.max(0, (deadline - Date.now()) / 1000);
+    const status = (await this.wda.proxy.command(`/wda/actions/operations/${id}/wait`, 'POST', {
+      timeout: remaining,
+    })) as ActionsOperationStatus;
+    if (status.state !== 'running') {
+      return status;
+    }
+    if (remaining <= 0) {
+      throw new errors.TimeoutError(
+        `The actions operation '${id}' is still running after ${timeout} seconds`,
+      );
+    }
+  }
+}
+
 /**
  * Perform tap gesture on a Touch Bar element or by relative/absolute coordinates
  *
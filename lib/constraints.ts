@@ -7,6 +7,12 @@ const MAC2_CONSTRAINTS = {
   systemHost: {
     isString: true,
   },
+  systemSocketPath: {
+    isString: true,
+  },
+  traceFilePath: {
+    isString: true,
+  },
   showServerLogs: {
     isBoolean: true,
   },
@@ -52,6 +58,9 @@ const MAC2_CONSTRAINTS = {
   initialDeeplinkUrl: {
     isString: true,
   },
+  concurrentSessions: {
+    isBoolean: true,
+  },
 } as const satisfies Constraints;
 
 export default MAC2_CONSTRAINTS;
@@ -12,7 +12,7 @@ import type {
   W3CDriverCaps,
 } from '@appium/types';
 import {BaseDriver, DeviceSettings} from 'appium/driver.js';
-import {WDA_MAC_SERVER, type WDAMacServer} from './wda-mac.js';
+import {WDA_MAC_SERVER, type WDAMacSession} from './wda-mac.js';
 import MAC2_CONSTRAINTS, {type Mac2Constraints} from './constraints.js';
 import * as appManagemenetCommands from './commands/app-management.js';
 import * as appleScriptCommands from './commands/applescript.js';
@@ -66,6 +66,8 @@ export class Mac2Driver
   macosActivateApp = appManagemenetCommands.macosActivateApp;
   macosTerminateApp = appManagemenetCommands.macosTerminateApp;
   macosQueryAppState = appManagemenetCommands.macosQueryAppState;
+  macosWarmUpApp = appManagemenetCommands.macosWarmUpApp;
+  macosDrainAppPool = appManagemenetCommands.macosDrainAppPool;
 
   macosExecAppleScript = appleScriptCommands.macosExecAppleScript;
 
@@ -83,6 +85,12 @@ export class Mac2Driver
   macosClickAndDrag = gesturesCommands.macosClickAndDrag;
   macosClickAndDragAndHold = gesturesCommands.macosClickAndDragAndHold;
   macosKeys = gesturesCommands.macosKeys;
+  macosRegisterActions = gesturesCommands.macosRegisterActions;
+  macosPerformRegisteredActions = gesturesCommands.macosPerformRegisteredActions;
+  macosUnregisterActions = gesturesCommands.macosUnregisterActions;
+  macosStartActions = gesturesCommands.macosStartActions;
+  macosGetActionsStatus = gesturesCommands.macosGetActionsStatus;
+  macosWaitForActions = gesturesCommands.macosWaitForActions;
   macosPressAndHold = gesturesCommands.macosPressAndHold;
   macosTap = gesturesCommands.macosTap;
   macosDoubleTap = gesturesCommands.macosDoubleTap;
@@ -115,7 +123,7 @@ export class Mac2Driver
   public proxyReqRes!: (...args: any) => any;
 
   private isProxyActive: boolean = false;
-  private _wda: WDAMacServer | null = null;
+  private _wda: WDAMacSession | null = null;
 
   constructor(opts: InitialOpts = {} as InitialOpts) {
     super(opts);
@@ -139,7 +147,7 @@ export class Mac2Driver
     this.settings = new DeviceSettings({}, this.onSettingsUpdate.bind(this));
   }
 
-  get wda(): WDAMacServer {
+  get wda(): WDAMacSession {
     if (!this._wda) {
       throw new Error('WDA server is not initialized');
     }
@@ -198,7 +206,6 @@ export class Mac2Driver
     driverData?: DriverData[],
   ): Promise<DefaultCreateSessionResult<Mac2Constraints>> {
     const [sessionId, caps] = await super.createSession(w3cCaps1, w3cCaps2, w3cCaps3, driverData);
-    this._wda = WDA_MAC_SERVER;
     this.caps = caps as Mac2DriverCaps;
     this.opts = this.opts as Mac2DriverOpts;
     try {
@@ -216,14 +223,14 @@ export class Mac2Driver
           log.info(`Prerun script output: ${output}`);
         }
       }
-      await this._wda.startSession(caps, {
+      this._wda = await WDA_MAC_SERVER.startSession(caps, {
         reqBasePath: this.basePath,
       });
     } catch (e: any) {
       await this.deleteSession();
       throw e;
     }
-    this.proxyReqRes = this.wda.proxy.proxyReqRes.bind(this._wda.proxy);
+    this.proxyReqRes = this.wda.proxy.proxyReqRes.bind(this.wda.proxy);
     this.isProxyActive = true;
     return [sessionId, caps];
   }
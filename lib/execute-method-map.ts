@@ -70,6 +70,13 @@ export const executeMethodMap = {
       ],
     },
   },
+  'macos: setValue': {
+    command: 'macosSetValue',
+    params: {
+      required: ['elementId'],
+      optional: ['value', 'text', 'keyModifierFlags', 'textInputMode'],
+    },
+  },
   'macos: keys': {
     command: 'macosKeys',
     params: {
@@ -77,6 +84,44 @@ export const executeMethodMap = {
       optional: ['elementId'],
     },
   },
+  'macos: registerActions': {
+    command: 'macosRegisterActions',
+    params: {
+      required: ['actions'],
+    },
+  },
+  'macos: performRegisteredActions': {
+    command: 'macosPerformRegisteredActions',
+    params: {
+      required: ['id'],
+      optional: ['offsetX', 'offsetY'],
+    },
+  },
+  'macos: unregisterActions': {
+    command: 'macosUnregisterActions',
+    params: {
+      required: ['id'],
+    },
+  },
+  'macos: startActions': {
+    command: 'macosStartActions',
+    params: {
+      required: ['actions'],
+    },
+  },
+  'macos: getActionsStatus': {
+    command: 'macosGetActionsStatus',
+    params: {
+      required: ['id'],
+    },
+  },
+  'macos: waitForActions': {
+    command: 'macosWaitForActions',
+    params: {
+      required: ['id'],
+      optional: ['timeout'],
+    },
+  },
   'macos: tap': {
     command: 'macosTap',
     params: {
@@ -176,6 +221,15 @@ export const executeMethodMap = {
       optional: ['bundleId', 'path'],
     },
   },
+  'macos: warmUpApp': {
+    command: 'macosWarmUpApp',
+    params: {
+      optional: ['bundleId', 'path', 'arguments', 'environment'],
+    },
+  },
+  'macos: drainAppPool': {
+    command: 'macosDrainAppPool',
+  },
   'macos: startRecordingScreen': {
     command: 'macosStartRecordingScreen',
     params: {
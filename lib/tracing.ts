@@ -0,0 +1,120 @@
+import {AsyncLocalStorage} from 'node:async_hooks';
+import {randomUUID} from 'node:crypto';
+import {appendFile} from 'node:fs/promises';
+import {performance} from 'node:perf_hooks';
+import {fs} from 'appium/support.js';
+import log from './logger.js';
+
+/** The request header used to propagate the trace identifier to WDA */
+export const TRACE_ID_HEADER = 'X-Trace-Id';
+/** The response header WDA uses to return recorded spans */
+export const TRACE_SPANS_HEADER = 'X-Trace-Spans';
+
+/**
+ * A single event in Chrome trace event format.
+ * See https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ */
+export interface ChromeTraceEvent {
+  name: string;
+  ph: string;
+  ts: number;
+  pid: number;
+  cat?: string;
+  dur?: number;
+  tid?: number;
+  args?: Record<string, any>;
+}
+
+export interface TraceContext {
+  traceId: string;
+  events: ChromeTraceEvent[];
+}
+
+/**
+ * Keeps the context of the currently traced command across asynchronous calls,
+ * so the proxy could pick the trace identifier for outgoing requests
+ */
+export const traceStorage = new AsyncLocalStorage<TraceContext>();
+
+/**
+ * Returns the current epoch time in microseconds
+ */
+function epochMicroseconds(): number {
+  return Math.round((performance.timeOrigin + performance.now()) * 1000);
+}
+
+/**
+ * Parses the value of the spans response header returned by WDA
+ *
+ * @param value The raw header value
+ * @returns The list of parsed events or an empty list if the value is missing or malformed
+ */
+export function parseTraceSpansHeader(value: unknown): ChromeTraceEvent[] {
+  if (typeof value !== 'string' || !value) {
+    return [];
+  }
+  try {
+    const events = JSON.parse(value);
+    return Array.isArray(events) ? events : [];
+  } catch {
+    return [];
+  }
+}
+
+/**
+ * Appends the given events to a file in Chrome trace JSON array format.
+ * The closing bracket is intentionally never written, which is explicitly allowed by the format,
+ * so events could be appended to the same file from multiple commands.
+ * The resulting file could be loaded into chrome://tracing or https://ui.perfetto.dev
+ *
+ * @param filePath The full path to the trace file
+ * @param events The events to append
+ */
+export async function appendChromeTraceEvents(
+  filePath: string,
+  events: ChromeTraceEvent[],
+): Promise<void> {
+  if (!events.length) {
+    return;
+  }
+  const prefix = (await fs.exists(filePath)) ? '' : '[\n';
+  const content = events.map((event) => `${JSON.stringify(event)},\n`).join('');
+  await appendFile(filePath, `${prefix}${content}`, 'utf8');
+}
+
+/**
+ * Runs the given function within a new trace context and appends
+ * the driver-side span together with all spans returned by WDA to the trace file
+ *
+ * @param traceFilePath The full path to the trace file
+ * @param name The name of the driver-side span
+ * @param fn The function to trace
+ * @returns The result of the function
+ */
+export async function withTrace<T>(
+  traceFilePath: string,
+  name: string,
+  fn: () => Promise<T>,
+): Promise<T> {
+  const context: TraceContext = {traceId: randomUUID(), events: []};
+  const startedAt = epochMicroseconds();
+  try {
+    return await traceStorage.run(context, fn);
+  } finally {
+    context.events.unshift({
+      name,
+      cat: 'appium',
+      ph: 'X',
+      ts: startedAt,
+      dur: epochMicroseconds() - startedAt,
+      pid: process.pid,
+      tid: 0,
+      args: {traceId: context.traceId},
+    });
+    try {
+      await appendChromeTraceEvents(traceFilePath, context.events);
+    } catch (e) {
+      log.warn(`Cannot write the trace of '${name}' to '${traceFilePath}': ${(e as Error).message}`);
+    }
+  }
+}
@@ -26,3 +26,14 @@ export interface ScreenshotInfo {
 
 /** A dictionary where each key contains a unique display identifier */
 export type ScreenshotsInfo = StringRecord<ScreenshotInfo>;
+
+export interface ActionsOperationStatus {
+  /** The operation identifier */
+  id: string;
+  /** The current state of the operation */
+  state: 'running' | 'succeeded' | 'failed';
+  /** The error message if the operation has failed */
+  error: string | null;
+  /** The amount of seconds the operation has been running for */
+  duration: number;
+}
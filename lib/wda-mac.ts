@@ -1,5 +1,7 @@
 import path from 'node:path';
 import url from 'node:url';
+import http from 'node:http';
+import net from 'node:net';
 import axios from 'axios';
 import {setTimeout as delay} from 'node:timers/promises';
 import {JWProxy, errors} from 'appium/driver.js';
@@ -9,6 +11,13 @@ import {SubProcess, exec} from 'teen_process';
 import {waitForCondition} from 'asyncbox';
 import {checkPortStatus} from 'portscanner';
 import type {HTTPMethod, HTTPBody, ProxyResponse, ProxyOptions} from '@appium/types';
+import {
+  TRACE_ID_HEADER,
+  TRACE_SPANS_HEADER,
+  parseTraceSpansHeader,
+  traceStorage,
+  withTrace,
+} from './tracing.js';
 import {listChildrenProcessIds, getModuleRoot, clearArray, removeAllOccurrences} from './utils.js';
 
 const log = logger.getLogger('WebDriverAgentMac');
@@ -26,14 +35,58 @@ const DEFAULT_SHOW_SERVER_LOGS = false;
 const RUNNING_PROCESS_IDS: (string | number)[] = [];
 const RECENT_UPGRADE_TIMESTAMP_PATH = path.join('.appium', 'webdriveragent_mac', 'upgrade.time');
 const RECENT_MODULE_VERSION_ITEM_NAME = 'recentWdaModuleVersion';
+// Compressing responses only makes sense if the server is located on another host.
+// Loopback and socket transfers are faster than the compression itself
+const REMOTE_ACCEPT_ENCODING = 'gzip, deflate';
+const LOCAL_ACCEPT_ENCODING = 'identity';
 
 export interface SessionOptions {
   reqBasePath?: string;
 }
 
+export interface WDAMacProxyOptions extends ProxyOptions {
+  /**
+   * The full path to a unix domain socket file the WDA server is listening on.
+   * If set then all the proxied requests are sent through this socket
+   * and the server/port options are only used to build the Host header.
+   */
+  socketPath?: string;
+  /**
+   * The full path to the file where trace spans of all proxied commands are appended.
+   * Tracing is disabled if not set.
+   */
+  traceFilePath?: string;
+}
+
+/**
+ * HTTP agent, which sends all requests to a unix domain socket
+ * rather than to a TCP host/port pair.
+ */
+class UnixSocketAgent extends http.Agent {
+  private readonly _socketPath: string;
+
+  constructor(socketPath: string, opts: http.AgentOptions = {}) {
+    super(opts);
+    this._socketPath = socketPath;
+  }
+
+  override createConnection(
+    _opts: net.NetConnectOpts,
+    callback?: (err: Error | null, stream: net.Socket) => void,
+  ): net.Socket {
+    const socket = net.createConnection({path: this._socketPath});
+    if (callback) {
+      socket.once('connect', () => callback(null, socket));
+      socket.once('error', (err) => callback(err, socket));
+    }
+    return socket;
+  }
+}
+
 class WDAMacProcess {
   public port: number = DEFAULT_SYSTEM_PORT;
   public host: string = DEFAULT_SYSTEM_HOST;
+  public socketPath: string | null = null;
   public bootstrapRoot: string = DEFAULT_WDA_ROOT;
   public proc: SubProcess | null = null;
   private _showServerLogs: boolean = DEFAULT_SHOW_SERVER_LOGS;
@@ -119,6 +172,7 @@ class WDAMacProcess {
     this._showServerLogs = opts.showServerLogs ?? this._showServerLogs;
     this.port = opts.systemPort ?? this.port;
     this.host = opts.systemHost ?? this.host;
+    this.socketPath = opts.systemSocketPath ?? null;
     this.bootstrapRoot = opts.bootstrapRoot ?? this.bootstrapRoot;
 
     log.debug(`Using bootstrap root: ${this.bootstrapRoot}`);
@@ -145,43 +199,11 @@ class WDAMacProcess {
 
     await this.cleanupProjectIfFresh();
 
-    log.debug(`Using ${this.host} as server host`);
-    log.debug(`Using port ${this.port}`);
-    const isPortBusy = async (): Promise<boolean> =>
-      (await checkPortStatus(this.port, this.host)) === 'open';
-    if (await isPortBusy()) {
-      log.warn(
-        `The port #${this.port} at ${this.host} is busy. ` +
-          `Assuming it is an obsolete WDA server instance and ` +
-          `trying to terminate it in order to start a new one`,
-      );
-      const timer = new timing.Timer().start();
-      try {
-        await axios.delete(`http://${this.host}:${this.port}/`, {
-          timeout: 5000,
-        });
-        // Give the server some time to finish and stop listening
-        await delay(500);
-        await waitForCondition(async () => !(await isPortBusy()), {
-          waitMs: 3000,
-          intervalMs: 100,
-        });
-      } catch (e: any) {
-        log.warn(
-          `Did not know how to terminate the process at ${this.host}:${this.port}: ${e.message}. ` +
-            `Perhaps, it is not a WDA server, which is hogging the port?`,
-        );
-        throw new Error(
-          `The port #${this.port} at ${this.host} is busy. ` +
-            `Consider setting 'systemPort' capability to another free port number and/or ` +
-            `make sure previous driver sessions have been closed properly.`,
-          {cause: e},
-        );
-      }
-      log.info(
-        `The previously running WDA server has been successfully terminated after ` +
-          `${Math.round(timer.getDuration().asMilliSeconds)}ms`,
-      );
+    if (this.socketPath) {
+      log.debug(`Using the unix domain socket at '${this.socketPath}'`);
+      await this.terminateObsoleteSocketServer(this.socketPath);
+    } else {
+      await this.terminateObsoletePortServer();
     }
 
     const args = [
@@ -193,10 +215,13 @@ class WDAMacProcess {
       RUNNER_SCHEME,
       DISABLE_STORE_ARG,
     ];
-    const env = Object.assign({}, process.env, {
+    const env: NodeJS.ProcessEnv = Object.assign({}, process.env, {
       USE_PORT: `${this.port}`,
       USE_HOST: this.host,
     });
+    if (this.socketPath) {
+      env.USE_UNIX_SOCKET = this.socketPath;
+    }
     this.proc = new SubProcess(xcodebuild, args, {
       cwd: this.bootstrapRoot,
       env,
@@ -248,8 +273,76 @@ class WDAMacProcess {
     } catch {}
   }
 
+  private async terminateObsoleteSocketServer(socketPath: string): Promise<void> {
+    if (!(await fs.exists(socketPath))) {
+      return;
+    }
+
+    log.info(
+      `The socket file at '${socketPath}' already exists. ` +
+        `Assuming it belongs to an obsolete WDA server instance and ` +
+        `trying to terminate it in order to start a new one`,
+    );
+    try {
+      await axios.delete('http://localhost/', {
+        socketPath,
+        timeout: 5000,
+      });
+      // Give the server some time to finish and stop listening
+      await delay(500);
+    } catch (e: any) {
+      log.debug(`The socket at '${socketPath}' is not responsive: ${e.message}`);
+    }
+    // The server always replaces stale socket files on startup,
+    // although it is better to not leave them around if no server is going to use it
+    try {
+      await fs.rimraf(socketPath);
+    } catch {}
+  }
+
+  private async terminateObsoletePortServer(): Promise<void> {
+    log.debug(`Using ${this.host} as server host`);
+    log.debug(`Using port ${this.port}`);
+    const isPortBusy = async (): Promise<boolean> =>
+      (await checkPortStatus(this.port, this.host)) === 'open';
+    if (await isPortBusy()) {
+      log.warn(
+        `The port #${this.port} at ${this.host} is busy. ` +
+          `Assuming it is an obsolete WDA server instance and ` +
+          `trying to terminate it in order to start a new one`,
+      );
+      const timer = new timing.Timer().start();
+      try {
+        await axios.delete(`http://${this.host}:${this.port}/`, {
+          timeout: 5000,
+        });
+        // Give the server some time to finish and stop listening
+        await delay(500);
+        await waitForCondition(async () => !(await isPortBusy()), {
+          waitMs: 3000,
+          intervalMs: 100,
+        });
+      } catch (e: any) {
+        log.warn(
+          `Did not know how to terminate the process at ${this.host}:${this.port}: ${e.message}. ` +
+            `Perhaps, it is not a WDA server, which is hogging the port?`,
+        );
+        throw new Error(
+          `The port #${this.port} at ${this.host} is busy. ` +
+            `Consider setting 'systemPort' capability to another free port number and/or ` +
+            `make sure previous driver sessions have been closed properly.`,
+          {cause: e},
+        );
+      }
+      log.info(
+        `The previously running WDA server has been successfully terminated after ` +
+          `${Math.round(timer.getDuration().asMilliSeconds)}ms`,
+      );
+    }
+  }
+
   private hasSameOpts(opts: WDAMacProcessInitOptions): boolean {
-    const {showServerLogs, systemPort, systemHost, bootstrapRoot} = opts;
+    const {showServerLogs, systemPort, systemHost, systemSocketPath, bootstrapRoot} = opts;
     if (
       (typeof showServerLogs === 'boolean' && this._showServerLogs !== showServerLogs) ||
       (showServerLogs == null && this._showServerLogs !== DEFAULT_SHOW_SERVER_LOGS)
@@ -268,6 +361,9 @@ class WDAMacProcess {
     ) {
       return false;
     }
+    if ((systemSocketPath ?? null) !== this.socketPath) {
+      return false;
+    }
     if (
       (bootstrapRoot && this.bootstrapRoot !== bootstrapRoot) ||
       (!bootstrapRoot && this.bootstrapRoot !== DEFAULT_WDA_ROOT)
@@ -279,8 +375,59 @@ class WDAMacProcess {
   }
 }
 
+/**
+ * Returns a copy of the given proxy headers, which also carries the identifier of the trace
+ * the current asynchronous call belongs to. JWProxy copies its headers into every request
+ * it builds, so the identifier is resolved at that moment. Headers with undefined values
+ * are not sent, so calls outside of a trace context do not get it.
+ */
+function withTraceIdHeader(headers: ProxyOptions['headers'] = {}): ProxyOptions['headers'] {
+  return Object.defineProperty({...headers}, TRACE_ID_HEADER, {
+    enumerable: true,
+    get: () => traceStorage.getStore()?.traceId,
+  });
+}
+
 export class WDAMacProxy extends JWProxy {
   public didProcessExit: boolean = false;
+  public readonly socketPath: string | null;
+  public traceFilePath: string | null;
+
+  constructor(opts: WDAMacProxyOptions = {}) {
+    const {socketPath, traceFilePath, ...proxyOpts} = opts;
+    super({...proxyOpts, headers: withTraceIdHeader(proxyOpts.headers)});
+    this.socketPath = socketPath ?? null;
+    this.traceFilePath = traceFilePath ?? null;
+    if (this.socketPath) {
+      // JWProxy passes its agent instances to every request it makes,
+      // so replacing them is enough to route the whole traffic through the socket
+      (this as any).httpAgent = new UnixSocketAgent(this.socketPath, {
+        keepAlive: opts.keepAlive ?? true,
+      });
+    }
+  }
+
+  override async command(url: string, method: HTTPMethod, body: HTTPBody = null): Promise<any> {
+    return await this.withTrace(`${method} ${url}`, () => super.command(url, method, body));
+  }
+
+  override async proxyReqRes(...args: Parameters<JWProxy['proxyReqRes']>): Promise<void> {
+    const [req] = args;
+    return await this.withTrace(`${req.method} ${req.originalUrl}`, () =>
+      super.proxyReqRes(...args),
+    );
+  }
+
+  /**
+   * Runs the given proxy call within a new trace context if tracing is enabled.
+   * Nested calls are recorded as a part of the outer trace.
+   */
+  private async withTrace<T>(name: string, fn: () => Promise<T>): Promise<T> {
+    if (!this.traceFilePath || traceStorage.getStore()) {
+      return await fn();
+    }
+    return await withTrace(this.traceFilePath, name, fn);
+  }
 
   override async proxyCommand(
     url: string,
@@ -293,15 +440,40 @@ export class WDAMacProxy extends JWProxy {
           'its process is not running (probably crashed). Check the Appium log for more details',
       );
     }
-    return await super.proxyCommand(url, method, body);
+    const traceContext = traceStorage.getStore();
+    const [response, resBody] = await super.proxyCommand(url, method, body);
+    if (traceContext) {
+      const spansHeader = response.headers?.[TRACE_SPANS_HEADER.toLowerCase()];
+      traceContext.events.push(...parseTraceSpansHeader(spansHeader));
+    }
+    return [response, resBody];
+  }
+}
+
+/**
+ * A single WDA session created through the shared server.
+ * Each driver instance owns its proxy, so concurrent sessions
+ * never send commands to each other's WDA session.
+ */
+export class WDAMacSession {
+  constructor(
+    public readonly proxy: WDAMacProxy,
+    private readonly _server: WDAMacServer,
+  ) {}
+
+  async stopSession(): Promise<void> {
+    await this._server.stopSession(this.proxy);
   }
 }
 
 export class WDAMacServer {
   private _proxy: WDAMacProxy | null = null;
+  private _proxyOpts: WDAMacProxyOptions | null = null;
   private _process: WDAMacProcess | null = null;
   private _serverStartupTimeoutMs: number = STARTUP_TIMEOUT_MS;
   private _isProxyingToRemoteServer: boolean = false;
+  private _serverKey: string | null = null;
+  private readonly _sessionProxies: Set<WDAMacProxy> = new Set();
 
   get proxy(): WDAMacProxy {
     if (!this._proxy) {
@@ -310,7 +482,72 @@ export class WDAMacServer {
     return this._proxy;
   }
 
-  async startSession(caps: StartSessionCapabilities, opts: SessionOptions = {}): Promise<void> {
+  async startSession(
+    caps: StartSessionCapabilities,
+    opts: SessionOptions = {},
+  ): Promise<WDAMacSession> {
+    const serverKey = JSON.stringify([
+      caps.webDriverAgentMacUrl,
+      caps.systemHost,
+      caps.systemPort,
+      caps.systemSocketPath,
+      caps.bootstrapRoot,
+      caps.showServerLogs,
+      opts.reqBasePath,
+    ]);
+    // Restarting the server process or replacing the proxy would break the sessions still running
+    const canReuseServer =
+      !!caps.concurrentSessions &&
+      this._sessionProxies.size > 0 &&
+      this._serverKey === serverKey &&
+      !!this._proxy &&
+      !this._proxy.didProcessExit;
+    if (canReuseServer) {
+      log.info('Reusing the running server for a concurrent session');
+    } else {
+      await this.initServer(caps, opts);
+      this._serverKey = serverKey;
+    }
+
+    const sessionProxy = this.createProxy();
+    sessionProxy.traceFilePath = caps.traceFilePath ?? null;
+    await sessionProxy.command('/session', 'POST', {
+      capabilities: {
+        firstMatch: [{}],
+        alwaysMatch: caps,
+      },
+    });
+    this._sessionProxies.add(sessionProxy);
+    return new WDAMacSession(sessionProxy, this);
+  }
+
+  async stopSession(sessionProxy: WDAMacProxy): Promise<void> {
+    this._sessionProxies.delete(sessionProxy);
+    if (!this._isProxyingToRemoteServer && !this._process?.isRunning) {
+      log.info(`Mac2Driver session cannot be stopped, because the server is not running`);
+      return;
+    }
+
+    if (sessionProxy.sessionId) {
+      try {
+        await sessionProxy.command(`/session/${sessionProxy.sessionId}`, 'DELETE');
+      } catch (e: any) {
+        log.info(`Mac2Driver session cannot be deleted. Original error: ${e.message}`);
+      }
+    }
+  }
+
+  private createProxy(): WDAMacProxy {
+    const proxy = new WDAMacProxy({...this._proxyOpts});
+    if (this._process?.proc) {
+      this._process.proc.once('exit', () => {
+        proxy.didProcessExit = true;
+      });
+    }
+    return proxy;
+  }
+
+  private async initServer(caps: StartSessionCapabilities, opts: SessionOptions): Promise<void> {
     this._serverStartupTimeoutMs = caps.serverStartupTimeout ?? this._serverStartupTimeoutMs;
 
     this._isProxyingToRemoteServer = !!caps.webDriverAgentMacUrl;
@@ -331,27 +568,25 @@ export class WDAMacServer {
     }
 
     if (wasProcessInitNecessary || this._isProxyingToRemoteServer || !this._proxy) {
-      const {scheme, host, port, path} = this.parseProxyProperties(caps);
-      const proxyOpts: ProxyOptions = {
+      const {scheme, host, port, path, socketPath} = this.parseProxyProperties(caps);
+      const proxyOpts: WDAMacProxyOptions = {
         scheme,
         server: host,
         port,
         base: path,
         keepAlive: true,
+        socketPath,
+        headers: {
+          'Accept-Encoding': this._isProxyingToRemoteServer
+            ? REMOTE_ACCEPT_ENCODING
+            : LOCAL_ACCEPT_ENCODING,
+        },
       };
       if (caps.reqBasePath) {
         proxyOpts.reqBasePath = opts.reqBasePath;
       }
-      this._proxy = new WDAMacProxy(proxyOpts);
-      this._proxy.didProcessExit = false;
-
-      if (this._process?.proc) {
-        this._process.proc.on('exit', () => {
-          if (this._proxy) {
-            this._proxy.didProcessExit = true;
-          }
-        });
-      }
+      this._proxyOpts = proxyOpts;
+      this._proxy = this.createProxy();
 
       const timer = new timing.Timer().start();
       try {
@@ -392,28 +627,6 @@ export class WDAMacServer {
     } else {
       log.info('The host process has already been listening. Proceeding with session creation');
     }
-
-    await this._proxy.command('/session', 'POST', {
-      capabilities: {
-        firstMatch: [{}],
-        alwaysMatch: caps,
-      },
-    });
-  }
-
-  async stopSession(): Promise<void> {
-    if (!this._isProxyingToRemoteServer && !this._process?.isRunning) {
-      log.info(`Mac2Driver session cannot be stopped, because the server is not running`);
-      return;
-    }
-
-    if (this._proxy?.sessionId) {
-      try {
-        await this._proxy.command(`/session/${this._proxy.sessionId}`, 'DELETE');
-      } catch (e: any) {
-        log.info(`Mac2Driver session cannot be deleted. Original error: ${e.message}`);
-      }
-    }
   }
 
   private async isProxyReady(throwOnExit = true): Promise<boolean> {
@@ -442,11 +655,13 @@ export class WDAMacServer {
   private parseProxyProperties(caps: StartSessionCapabilities): ProxyProperties {
     let scheme = 'http';
     if (!caps.webDriverAgentMacUrl) {
+      const socketPath = this._process?.socketPath ?? caps.systemSocketPath;
       return {
         scheme,
         host: this._process?.host ?? caps.systemHost ?? DEFAULT_SYSTEM_HOST,
         port: this._process?.port ?? caps.systemPort ?? DEFAULT_SYSTEM_PORT,
         path: '',
+        ...(socketPath ? {socketPath} : {}),
       };
     }
 
@@ -518,6 +733,7 @@ interface WDAMacProcessInitOptions {
   showServerLogs?: boolean;
   systemPort?: number;
   systemHost?: string;
+  systemSocketPath?: string;
   bootstrapRoot?: string;
 }
 
@@ -526,13 +742,16 @@ interface ProxyProperties {
   host: string;
   port: number;
   path: string;
+  socketPath?: string;
 }
 
 interface StartSessionCapabilities {
   webDriverAgentMacUrl?: string;
   systemHost?: string;
   systemPort?: number;
+  systemSocketPath?: string;
   serverStartupTimeout?: number;
   reqBasePath?: string;
+  traceFilePath?: string;
   [key: string]: unknown;
 }
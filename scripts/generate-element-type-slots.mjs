@@ -0,0 +1,131 @@
+// Regenerates the perfect hash table of element type names in FBElementTypeTransformer.m
+// from its FBElementTypeNames list. Run it after the list has been changed:
+//
+//   node ./scripts/generate-element-type-slots.mjs
+//
+// Pass --check to only verify the committed table is up to date (exits with 1 otherwise).
+import path from 'node:path';
+import {readFile, writeFile} from 'node:fs/promises';
+import {fileURLToPath} from 'node:url';
+
+const SOURCE_PATH = path.join(
+  'WebDriverAgentMac',
+  'WebDriverAgentLib',
+  'Utilities',
+  'FBElementTypeTransformer.m',
+);
+const TYPE_PREFIX = 'XCUIElementType';
+const FNV_PRIME = 16777619;
+const MAX_SEED = 0xffff;
+
+function parseDefine(source, name) {
+  const match = new RegExp(`^#define ${name} (\\d+)u?$`, 'm').exec(source);
+  if (!match) {
+    throw new Error(`Cannot find the ${name} definition`);
+  }
+  return {value: Number(match[1]), match};
+}
+
+function parseTypeNames(source) {
+  const match = /FBElementTypeNames\[\] = \{\n([\s\S]*?)\n\};/.exec(source);
+  if (!match) {
+    throw new Error('Cannot find the FBElementTypeNames list');
+  }
+  return [...match[1].matchAll(/@"([^"]+)"/g)].map(([, name]) => name);
+}
+
+// Must be in sync with FBElementTypeNameHash
+function hashSuffix(suffix, seed, bits) {
+  let hash = seed >>> 0;
+  for (let i = 0; i < suffix.length; i++) {
+    hash = (hash ^ suffix.charCodeAt(i)) >>> 0;
+    hash = Math.imul(hash, FNV_PRIME) >>> 0;
+  }
+  return hash >>> (32 - bits);
+}
+
+function buildSlots(suffixes, seed, bits) {
+  const slots = new Map();
+  for (const [type, suffix] of suffixes.entries()) {
+    const slot = hashSuffix(suffix, seed, bits);
+    if (slots.has(slot)) {
+      return null;
+    }
+    slots.set(slot, type);
+  }
+  return slots;
+}
+
+function findSeed(suffixes, preferredSeed, bits) {
+  if (buildSlots(suffixes, preferredSeed, bits)) {
+    return preferredSeed;
+  }
+  for (let seed = 0; seed <= MAX_SEED; seed++) {
+    if (buildSlots(suffixes, seed, bits)) {
+      return seed;
+    }
+  }
+  throw new Error(
+    `There is no collision-free seed for ${suffixes.length} names in ${bits} bits. ` +
+      `Increase FB_ELEMENT_TYPE_NAME_HASH_BITS`,
+  );
+}
+
+function renderSlots(suffixes, slots) {
+  return [...slots.entries()]
+    .sort(([a], [b]) => a - b)
+    .map(([slot, type]) => `  [${slot}] = ${type} + 1, // ${suffixes[type]}`)
+    .join('\n');
+}
+
+async function generateElementTypeSlots() {
+  const isCheck = process.argv.includes('--check');
+  const __filename = fileURLToPath(import.meta.url);
+  const sourcePath = path.resolve(path.dirname(__filename), '..', SOURCE_PATH);
+  const source = await readFile(sourcePath, 'utf8');
+
+  const names = parseTypeNames(source);
+  const invalidName = names.find((name) => !name.startsWith(TYPE_PREFIX) || name === TYPE_PREFIX);
+  if (invalidName) {
+    throw new Error(`'${invalidName}' is not a valid element type name`);
+  }
+  // Slots store type values incremented by one in uint8_t
+  if (names.length > 0xff - 1) {
+    throw new Error(`${names.length} element types do not fit into uint8_t slots`);
+  }
+  const maxLength = parseDefine(source, 'FB_ELEMENT_TYPE_NAME_MAX_LENGTH').value;
+  const tooLongName = names.find((name) => name.length > maxLength);
+  if (tooLongName) {
+    throw new Error(`'${tooLongName}' is longer than FB_ELEMENT_TYPE_NAME_MAX_LENGTH (${maxLength})`);
+  }
+
+  const suffixes = names.map((name) => name.substring(TYPE_PREFIX.length));
+  const bits = parseDefine(source, 'FB_ELEMENT_TYPE_NAME_HASH_BITS').value;
+  const seedDefine = parseDefine(source, 'FB_ELEMENT_TYPE_NAME_HASH_SEED');
+  const seed = findSeed(suffixes, seedDefine.value, bits);
+  const slots = buildSlots(suffixes, seed, bits);
+
+  const tablePattern = /(FBElementTypeNameSlots\[[^\]]+\] = \{\n)[\s\S]*?(\n\};)/;
+  if (!tablePattern.test(source)) {
+    throw new Error('Cannot find the FBElementTypeNameSlots table');
+  }
+  const result = source
+    .replace(seedDefine.match[0], `#define FB_ELEMENT_TYPE_NAME_HASH_SEED ${seed}u`)
+    .replace(tablePattern, (_, head, tail) => `${head}${renderSlots(suffixes, slots)}${tail}`);
+  if (result === source) {
+    console.log(`The table of ${names.length} element type names is up to date`);
+    return;
+  }
+  if (isCheck) {
+    console.error(
+      `The table of element type names is out of date. ` +
+        `Run 'node ./scripts/generate-element-type-slots.mjs' to regenerate it`,
+    );
+    process.exitCode = 1;
+    return;
+  }
+  await writeFile(sourcePath, result, 'utf8');
+  console.log(`Regenerated the table of ${names.length} element type names with seed ${seed}`);
+}
+
+(async () => await generateElementTypeSlots())();
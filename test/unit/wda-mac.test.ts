@@ -1,6 +1,12 @@
-import {describe, it} from 'node:test';
+import {describe, it, before, after} from 'node:test';
 import assert from 'node:assert/strict';
-import {WDA_MAC_SERVER} from '../../lib/wda-mac.js';
+import http from 'node:http';
+import os from 'node:os';
+import path from 'node:path';
+import {readFile, rm} from 'node:fs/promises';
+import {WDA_MAC_SERVER, WDAMacProxy} from '../../lib/wda-mac.js';
+import {traceStorage, type TraceContext} from '../../lib/tracing.js';
+import {macosClick} from '../../lib/commands/gestures.js';
 
 describe('WDAMacServer', () => {
   describe('parseProxyProperties', () => {
@@ -31,6 +37,23 @@ describe('WDAMacServer', () => {
       );
     });
 
+    it('should follow systemSocketPath', () => {
+      assert.deepEqual(
+        (WDA_MAC_SERVER as any).parseProxyProperties({systemSocketPath: '/tmp/wda.sock'}),
+        {scheme: 'http', host: '127.0.0.1', port: 10100, path: '', socketPath: '/tmp/wda.sock'},
+      );
+    });
+
+    it('should ignore systemSocketPath if WebDriverAgentMacUrl is set', () => {
+      assert.deepEqual(
+        (WDA_MAC_SERVER as any).parseProxyProperties({
+          webDriverAgentMacUrl: 'http://customhost:9999',
+          systemSocketPath: '/tmp/wda.sock',
+        }),
+        {scheme: 'http', host: 'customhost', port: 9999, path: ''},
+      );
+    });
+
     it('should follow WebDriverAgentMacUrl with invalid url', () => {
       assert.throws(
         () => (WDA_MAC_SERVER as any).parseProxyProperties({webDriverAgentMacUrl: 'invalid url'}),
@@ -38,4 +61,96 @@ describe('WDAMacServer', () => {
       );
     });
   });
+
+  describe('WDAMacProxy', () => {
+    const socketPath = path.join(os.tmpdir(), `wda-mac-test-${process.pid}.sock`);
+    const requests: string[] = [];
+    let server: http.Server;
+
+    before(async () => {
+      server = http.createServer((req, res) => {
+        requests.push(`${req.method} ${req.url}`);
+        const traceId = req.headers['x-trace-id'];
+        const headers: Record<string, string> = {'Content-Type': 'application/json'};
+        if (traceId) {
+          headers['X-Trace-Spans'] = JSON.stringify([
+            {name: 'snapshot', ph: 'X', ts: 1, dur: 2, pid: 3, args: {traceId}},
+          ]);
+        }
+        res.writeHead(200, headers);
+        res.end(JSON.stringify({value: {ready: true}, sessionId: null}));
+      });
+      await new Promise<void>((resolve) => server.listen(socketPath, resolve));
+    });
+
+    after(async () => {
+      await new Promise((resolve) => server.close(resolve));
+    });
+
+    it('should send requests through the unix domain socket', async () => {
+      const proxy = new WDAMacProxy({
+        server: '127.0.0.1',
+        port: 1,
+        keepAlive: true,
+        socketPath,
+      });
+      assert.deepEqual(await proxy.command('/status', 'GET'), {ready: true});
+      assert.deepEqual(await proxy.command('/status', 'GET'), {ready: true});
+      assert.deepEqual(requests, ['GET /status', 'GET /status']);
+    });
+
+    it('should propagate the trace id and collect returned spans', async () => {
+      const proxy = new WDAMacProxy({
+        server: '127.0.0.1',
+        port: 1,
+        socketPath,
+      });
+      const context: TraceContext = {traceId: 'abc-123', events: []};
+      await traceStorage.run(context, () => proxy.command('/status', 'GET'));
+      assert.deepEqual(context.events, [
+        {name: 'snapshot', ph: 'X', ts: 1, dur: 2, pid: 3, args: {traceId: 'abc-123'}},
+      ]);
+      // No trace id must be sent outside of a trace context
+      await proxy.command('/status', 'GET');
+      assert.deepEqual(context.events.length, 1);
+    });
+
+    it('should trace driver commands and proxied routes', async () => {
+      const traceFilePath = path.join(os.tmpdir(), `wda-mac-trace-${process.pid}.json`);
+      await rm(traceFilePath, {force: true});
+      const proxy = new WDAMacProxy({
+        server: '127.0.0.1',
+        port: 1,
+        socketPath,
+        traceFilePath,
+      });
+      proxy.sessionId = 'abc';
+      try {
+        await macosClick.call({wda: {proxy}} as any, undefined, 10, 20);
+        const res: any = {
+          set: () => res,
+          setHeader: () => res,
+          header: () => res,
+          status: () => res,
+          send: () => res,
+          json: () => res,
+        };
+        await proxy.proxyReqRes(
+          {method: 'GET', originalUrl: '/status', body: {}, params: {}, headers: {}} as any,
+          res,
+        );
+        const content = await readFile(traceFilePath, 'utf8');
+        const events = JSON.parse(`${content.replace(/,\s*$/, '')}]`);
+        const driverSpans = events.filter(({cat}) => cat === 'appium').map(({name}) => name);
+        assert.deepEqual(driverSpans, ['POST /wda/click', 'GET /status']);
+        // Spans returned by WDA must belong to the same traces as the driver-side ones
+        assert.deepEqual(
+          events.filter(({name}) => name === 'snapshot').map(({args}) => args.traceId),
+          events.filter(({cat}) => cat === 'appium').map(({args}) => args.traceId),
+        );
+      } finally {
+        await rm(traceFilePath, {force: true});
+      }
+    });
+  });
 });